@@ -0,0 +1,35 @@
+const b = require('benny')
+const { gdal, rasterSize, runTest, suite } = require('./common')
+
+// Operations on the same dataset are serialized by its lock,
+// so each concurrent reader has its own dataset
+function readTest(size, concurrency) {
+  return runTest(async () => {
+    const bands = await Promise.all(new Array(concurrency).fill(0).map(() =>
+      gdal.openAsync('/vsimem/bench_raster.tif').then((ds) => ds.bands.getAsync(1))))
+    const windows = Math.floor(rasterSize / size)
+    let next = 0
+    return () => Promise.all(bands.map(() => {
+      const w = next++ % (windows * windows)
+      return bands[w % concurrency].pixels.readAsync((w % windows) * size, Math.floor(w / windows) * size, size, size)
+    }))
+  })
+}
+
+const tests = []
+for (const size of [ 64, 256, 1024 ]) {
+  for (const concurrency of [ 1, 4, 16 ]) {
+    tests.push(b.add(`pixels.readAsync ${size}x${size} x${concurrency}`, readTest(size, concurrency)))
+  }
+}
+
+tests.push(b.add('pixels.read 256x256', runTest(() => {
+  const band = gdal.open('/vsimem/bench_raster.tif').bands.get(1)
+  let w = 0
+  return () => {
+    const x = (w++ % (rasterSize / 256)) * 256
+    band.pixels.read(x, x, 256, 256)
+  }
+})))
+
+module.exports = suite('RasterBandPixels', 'pixels', ...tests)
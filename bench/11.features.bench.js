@@ -0,0 +1,43 @@
+const b = require('benny')
+const { gdal, runTest, suite } = require('./common')
+
+const open = () => gdal.open('/vsimem/bench_vector.gpkg').layers.get(0)
+
+module.exports = suite(
+  'LayerFeatures',
+  'features',
+
+  b.add('features.forEach', runTest(() => {
+    const layer = open()
+    return () => {
+      layer.features.forEach((f) => f.fid)
+    }
+  })),
+  b.add('features.first/next', runTest(() => {
+    const layer = open()
+    return () => {
+      for (let f = layer.features.first(); f; f = layer.features.next()) f.fields.get('value')
+    }
+  })),
+  b.add('features.firstAsync/nextAsync', runTest(() => {
+    const layer = open()
+    return async () => {
+      for (let f = await layer.features.firstAsync(); f; f = await layer.features.nextAsync()) f.fields.get('value')
+    }
+  })),
+  b.add('for await (features)', runTest(() => {
+    const layer = open()
+    return async () => {
+      for await (const f of layer.features) f.fields.get('value')
+    }
+  })),
+  b.add('features.forEach + toObject + toJSON', runTest(() => {
+    const layer = open()
+    return () => {
+      layer.features.forEach((f) => {
+        f.fields.toObject()
+        f.getGeometry().toJSON()
+      })
+    }
+  }))
+)
@@ -0,0 +1,63 @@
+const b = require('benny')
+const { gdal, polygon, runTest, suite } = require('./common')
+
+const count = 1000
+const polygons = () => new Array(count).fill(0).map((_, i) => polygon(i * 10, i * 10, 100, 64))
+
+module.exports = suite(
+  'Geometry',
+  'geometry',
+
+  b.add('Geometry.fromWKB', runTest(() => {
+    const wkb = polygons().map((p) => p.toWKB())
+    return () => {
+      for (const w of wkb) gdal.Geometry.fromWKB(w)
+    }
+  })),
+  b.add('Geometry.fromGeoJson', runTest(() => {
+    const json = polygons().map((p) => JSON.parse(p.toJSON()))
+    return () => {
+      for (const j of json) gdal.Geometry.fromGeoJson(j)
+    }
+  })),
+  b.add('Geometry.fromGeoJsonBuffer', runTest(() => {
+    const json = polygons().map((p) => Buffer.from(p.toJSON()))
+    return () => {
+      for (const j of json) gdal.Geometry.fromGeoJsonBuffer(j)
+    }
+  })),
+  b.add('geometry.toWKB', runTest(() => {
+    const geoms = polygons()
+    return () => {
+      for (const g of geoms) g.toWKB()
+    }
+  })),
+  b.add('geometry.toJSON', runTest(() => {
+    const geoms = polygons()
+    return () => {
+      for (const g of geoms) g.toJSON()
+    }
+  })),
+  b.add('geometry.buffer', runTest(() => {
+    const geoms = polygons()
+    return () => {
+      for (const g of geoms) g.buffer(5, 8)
+    }
+  })),
+  b.add('geometry.bufferAsync', runTest(() => {
+    const geoms = polygons()
+    return () => Promise.all(geoms.map((g) => g.bufferAsync(5, 8)))
+  })),
+  b.add('geometry.intersection', runTest(() => {
+    const geoms = polygons()
+    return () => {
+      for (let i = 1; i < geoms.length; i++) geoms[i].intersection(geoms[i - 1])
+    }
+  })),
+  b.add('geometry.simplify', runTest(() => {
+    const geoms = polygons()
+    return () => {
+      for (const g of geoms) g.simplify(10)
+    }
+  }))
+)
@@ -0,0 +1,32 @@
+const b = require('benny')
+const { gdal, runTest, suite } = require('./common')
+
+let out = 0
+const output = () => `/vsimem/bench_out_${out++}.tif`
+
+function release(ds) {
+  const files = ds.getFileList()
+  ds.close()
+  for (const f of files) gdal.vsimem.release(f)
+}
+
+module.exports = suite(
+  'Utils',
+  'utils',
+
+  b.add('translateAsync 50% average', runTest(async () => {
+    const src = await gdal.openAsync('/vsimem/bench_raster.tif')
+    return async () => release(await gdal.translateAsync(output(), src,
+      [ '-outsize', '50%', '50%', '-r', 'average' ]))
+  })),
+  b.add('translateAsync DEFLATE', runTest(async () => {
+    const src = await gdal.openAsync('/vsimem/bench_raster.tif')
+    return async () => release(await gdal.translateAsync(output(), src,
+      [ '-co', 'COMPRESS=DEFLATE', '-co', 'TILED=YES' ]))
+  })),
+  b.add('warpAsync EPSG:3857 1024x1024', runTest(async () => {
+    const src = await gdal.openAsync('/vsimem/bench_raster.tif')
+    return async () => release(await gdal.warpAsync(output(), null, [ src ],
+      [ '-t_srs', 'EPSG:3857', '-ts', '1024', '1024', '-r', 'bilinear' ]))
+  }))
+)
@@ -0,0 +1,55 @@
+const b = require('benny')
+const { gdal, polygon, runTest, suite } = require('./common')
+
+const count = 1000
+
+let out = 0
+function createLayer(driver) {
+  const ds = gdal.open(`/vsimem/bench_ingest_${out++}.${driver === 'GPKG' ? 'gpkg' : 'mem'}`, 'w', driver)
+  const layer = ds.layers.create('ingest', gdal.SpatialReference.fromEPSG(32631), gdal.wkbPolygon)
+  layer.fields.add(new gdal.FieldDefn('id', gdal.OFTInteger))
+  layer.fields.add(new gdal.FieldDefn('name', gdal.OFTString))
+  return { ds, layer }
+}
+
+function release({ ds }) {
+  const files = ds.getFileList()
+  ds.close()
+  for (const f of files) gdal.vsimem.release(f)
+}
+
+function feature(layer, i) {
+  const f = new gdal.Feature(layer)
+  f.fields.set({ id: i, name: `feature ${i}` })
+  f.setGeometry(polygon(i * 10, i * 10, 100, 16))
+  return f
+}
+
+function addTest(driver) {
+  return runTest(() => () => {
+    const target = createLayer(driver)
+    for (let i = 0; i < count; i++) target.layer.features.add(feature(target.layer, i))
+    release(target)
+  })
+}
+
+function addAsyncTest(driver) {
+  return runTest(() => async () => {
+    const target = createLayer(driver)
+    for (let i = 0; i < count; i++) {
+      // eslint-disable-next-line no-await-in-loop
+      await target.layer.features.addAsync(feature(target.layer, i))
+    }
+    release(target)
+  })
+}
+
+module.exports = suite(
+  'Vector ingest',
+  'ingest',
+
+  b.add('features.add Memory', addTest('Memory')),
+  b.add('features.addAsync Memory', addAsyncTest('Memory')),
+  b.add('features.add GPKG', addTest('GPKG')),
+  b.add('features.addAsync GPKG', addAsyncTest('GPKG'))
+)
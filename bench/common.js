@@ -0,0 +1,98 @@
+const path = require('path')
+const b = require('benny')
+
+const gdal = require('..')
+
+// The fixtures are generated in /vsimem/, no network and no files in the repository
+
+const rasterSize = 4096
+const features = 20000
+
+function createRaster() {
+  const mem = gdal.open('bench', 'w', 'MEM', rasterSize, rasterSize, 1, gdal.GDT_Byte)
+  const data = new Uint8Array(rasterSize * rasterSize)
+  for (let i = 0; i < data.length; i++) data[i] = (i % rasterSize + Math.floor(i / rasterSize)) & 0xff
+  mem.bands.get(1).pixels.write(0, 0, rasterSize, rasterSize, data)
+  mem.geoTransform = [ 500000, 10, 0, 5000000, 0, -10 ]
+  mem.srs = gdal.SpatialReference.fromEPSG(32631)
+  gdal.drivers.get('GTiff').createCopy('/vsimem/bench_raster.tif', mem,
+    { TILED: 'YES', BLOCKXSIZE: 256, BLOCKYSIZE: 256 }).close()
+}
+
+// A regular star polygon around x, y
+function polygon(x, y, r, n) {
+  const ring = new gdal.LinearRing()
+  for (let i = 0; i < n; i++) {
+    const a = 2 * Math.PI * i / n
+    const d = i % 2 ? r : r / 2
+    ring.points.add(x + d * Math.cos(a), y + d * Math.sin(a))
+  }
+  ring.closeRings()
+  const poly = new gdal.Polygon()
+  poly.rings.add(ring)
+  return poly
+}
+
+function createVector() {
+  const ds = gdal.open('/vsimem/bench_vector.gpkg', 'w', 'GPKG')
+  const layer = ds.layers.create('bench', gdal.SpatialReference.fromEPSG(32631), gdal.wkbPolygon)
+  layer.fields.add(new gdal.FieldDefn('id', gdal.OFTInteger))
+  layer.fields.add(new gdal.FieldDefn('name', gdal.OFTString))
+  layer.fields.add(new gdal.FieldDefn('value', gdal.OFTReal))
+  for (let i = 0; i < features; i++) {
+    const f = new gdal.Feature(layer)
+    f.fields.set({ id: i, name: `feature ${i}`, value: i / 10 })
+    f.setGeometry(polygon(500000 + (i % 200) * 200, 4960000 + Math.floor(i / 200) * 200, 90, 16))
+    layer.features.add(f)
+  }
+  ds.close()
+}
+
+// Done once by the first benchmark, benny runs the setup of all the benchmarks in parallel
+let fixturesDone = null
+function fixtures() {
+  if (!fixturesDone) {
+    fixturesDone = new Promise((resolve, reject) => {
+      try {
+        createRaster()
+        createVector()
+        resolve()
+      } catch (e) {
+        reject(e)
+      }
+    })
+  }
+  return fixturesDone
+}
+
+// This is to signal benny that we have an asynchronous initialization part that is not to be measured
+// the setup function returns the function to measure
+const runTest = (setup) => async () => {
+  await fixtures()
+  return setup()
+}
+
+// A benny suite that also saves its results as JSON for bench/run.js
+function suite(name, file, ...tests) {
+  const threads = process.env.UV_THREADPOOL_SIZE || 4
+  return b.suite(
+    name,
+    ...tests,
+    b.cycle(),
+    b.complete(),
+    b.save({
+      file: `${file}.uv${threads}`,
+      folder: process.env.BENCH_RESULTS || path.resolve(__dirname, 'results'),
+      format: 'json'
+    })
+  )
+}
+
+module.exports = {
+  gdal,
+  rasterSize,
+  features,
+  polygon,
+  runTest,
+  suite
+}
@@ -0,0 +1,32 @@
+// Microbenchmarks of the binding internals measured in C++
+//
+// npx node-pre-gyp configure build --enable_microbench=true
+// node bench/native.js [filter]
+//
+// The results are saved in bench/results/native-<version>.json
+
+const fs = require('fs')
+const os = require('os')
+const path = require('path')
+
+const gdal = require('..')
+const { version } = require('../package.json')
+
+const results = gdal._microbench(process.argv[2])
+for (const r of results) {
+  console.log(`${r.name.padEnd(60)} ${r.median.toFixed(1).padStart(12)} ns/op (min ${r.min.toFixed(1)})`)
+}
+
+const folder = process.env.BENCH_RESULTS || path.resolve(__dirname, 'results')
+fs.mkdirSync(folder, { recursive: true })
+const target = path.join(folder, `native-${version}.json`)
+fs.writeFileSync(target, JSON.stringify({
+  version,
+  gdal: gdal.version,
+  node: process.version,
+  platform: `${process.platform}-${process.arch}`,
+  cpus: os.cpus().length,
+  date: new Date().toISOString(),
+  results
+}, null, 2))
+console.log(`results written to ${target}`)
@@ -0,0 +1,64 @@
+// Runs the benchmarks with each libuv threadpool size and merges the results in one JSON file
+//
+// BENCH_THREADPOOL=1,4,16 node bench/run.js [pattern]
+//
+// UV_THREADPOOL_SIZE is read when libuv starts its threadpool,
+// so each size requires its own process
+
+const fs = require('fs')
+const os = require('os')
+const path = require('path')
+const { spawnSync } = require('child_process')
+
+const gdal = require('..')
+const { version } = require('../package.json')
+
+const threadpools = (process.env.BENCH_THREADPOOL || '1,4').split(',').map((s) => +s.trim())
+const pattern = process.argv[2]
+const results = path.resolve(__dirname, 'results')
+const raw = fs.mkdtempSync(path.join(os.tmpdir(), 'gdal-async-bench-'))
+
+const output = {
+  version,
+  gdal: gdal.version,
+  node: process.version,
+  platform: `${process.platform}-${process.arch}`,
+  cpus: os.cpus().length,
+  cpu: os.cpus()[0] && os.cpus()[0].model,
+  date: new Date().toISOString(),
+  results: []
+}
+
+for (const threadpool of threadpools) {
+  console.log(`UV_THREADPOOL_SIZE=${threadpool}`)
+  const run = spawnSync(process.execPath, [ path.resolve(__dirname, 'streams.js') ].concat(pattern ? [ pattern ] : []), {
+    env: Object.assign({}, process.env, { UV_THREADPOOL_SIZE: threadpool, BENCH_RESULTS: raw }),
+    stdio: 'inherit'
+  })
+  if (run.status !== 0) {
+    console.error(`benchmarks failed with UV_THREADPOOL_SIZE=${threadpool}`)
+    process.exit(1)
+  }
+}
+
+// Only the suites using bench/common.js save their results
+for (const file of fs.readdirSync(raw).filter((f) => f.match(/\.uv\d+\.json$/))) {
+  const threadpool = +file.match(/\.uv(\d+)\.json$/)[1]
+  const summary = JSON.parse(fs.readFileSync(path.join(raw, file), 'utf8'))
+  for (const r of summary.results) {
+    output.results.push({
+      threadpool,
+      suite: summary.name,
+      name: r.name,
+      ops: r.ops,
+      margin: r.margin,
+      samples: r.samples
+    })
+  }
+}
+fs.rmSync(raw, { recursive: true, force: true })
+
+fs.mkdirSync(results, { recursive: true })
+const target = path.join(results, `gdal-async-${version}.json`)
+fs.writeFileSync(target, JSON.stringify(output, null, 2))
+console.log(`results written to ${target}`)
@@ -1,6 +1,8 @@
 const fs = require('fs')
 
-const bench = fs.readdirSync(__dirname).filter((file) => file.match(/\.bench\.js$/));
+// node bench/streams.js [pattern] runs only the matching benchmarks
+const filter = process.argv[2] ? new RegExp(process.argv[2]) : null
+const bench = fs.readdirSync(__dirname).filter((file) => file.match(/\.bench\.js$/) && (!filter || file.match(filter)));
 
 (async () => {
   for (const b of bench) {
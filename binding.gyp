@@ -8,14 +8,26 @@
 		"enable_logging%": "false",
 		"enable_asan%": "false",
 		"enable_coverage%": "false",
+		"enable_microbench%": "false",
 		"sources_node_gdal": [
 				"src/utils/typed_array.cpp",
 				"src/utils/string_list.cpp",
 				"src/utils/number_list.cpp",
 				"src/utils/warp_options.cpp",
 				"src/utils/ptr_manager.cpp",
+				"src/utils/parallel.cpp",
+				"src/utils/expression.cpp",
+				"src/utils/pixel_functions.cpp",
+				"src/utils/tile_pyramid.cpp",
+				"src/utils/overview_builder.cpp",
+				"src/utils/zonal_stats.cpp",
+				"src/utils/raster_sampler.cpp",
 				"src/node_gdal.cpp",
 				"src/async.cpp",
+				"src/utils/job_stats.cpp",
+				"src/utils/sync_profile.cpp",
+				"src/utils/vsi_stats.cpp",
+				"src/utils/microbench.cpp",
 				"src/gdal_common.cpp",
 				"src/gdal_dataset.cpp",
 				"src/gdal_driver.cpp",
@@ -41,14 +53,19 @@
 				"src/geometry/gdal_multilinestring.cpp",
 				"src/geometry/gdal_multicurve.cpp",
 				"src/geometry/gdal_multipolygon.cpp",
+				"src/geometry/gdal_geometrybatch.cpp",
+				"src/geometry/gdal_geometrycursor.cpp",
+				"src/geometry/gdal_geometrypipeline.cpp",
 				"src/gdal_layer.cpp",
 				"src/gdal_coordinate_transformation.cpp",
 				"src/gdal_spatial_reference.cpp",
 				"src/gdal_warper.cpp",
+				"src/gdal_warp_context.cpp",
 				"src/gdal_algorithms.cpp",
 				"src/gdal_memfile.cpp",
 				"src/gdal_utils.cpp",
 				"src/gdal_fs.cpp",
+				"src/gdal_block_cache.cpp",
 				"src/collections/dataset_bands.cpp",
 				"src/collections/dataset_layers.cpp",
 				"src/collections/layer_features.cpp",
@@ -126,6 +143,11 @@
 						"ENABLE_LOGGING=1"
 					]
 				}],
+				["enable_microbench == 'true'", {
+					"defines": [
+						"ENABLE_MICROBENCH=1"
+					]
+				}],
 				["shared_gdal == 'false'", {
 					"defines": [
 						"BUNDLED_GDAL=1"
@@ -25,8 +25,8 @@
  * It internally uses a {@link RasterTransform} which can also be used directly for
  * a finer-grained control over the transformation.
  *
- * You can check the `gdal-exprtk` plugin for an alternative implementation which uses
- * an ExprTk expression instead of a JS function and performs only O(1) operations on the main thread
+ * You can check {@link calcExprAsync} or the `gdal-exprtk` plugin for alternative implementations
+ * which use an expression instead of a JS function and perform only O(1) operations on the main thread
  *
  * There is no sync version
  *
@@ -148,68 +148,34 @@ gdal.RasterTransform = muxStream.RasterTransform
 
 gdal.calcAsync = require('./calc')(gdal)
 
+gdal.processTilesAsync = require('./tiles')(gdal)
+
 gdal.wrapVRT = require('./wrapVRT')
 
 /**
- * Create a GDAL pixel function from a JS expression for one pixel.
- *
- * Higher-level API of `gdal.toPixelFunc`.
+ * Create a {@link GeometryBatch} for applying the same operation
+ * to many geometries in a single multi-threaded job.
  *
  * @static
- * @method createPixelFunc
+ * @method geometryBatch
  *
  * @example
- * // This example will register a new GDAL pixel function called sum2
- * // that requires a VRT dataset with 2 values per pixel
- * gdal.addPixelFunc('sum2', gdal.createPixelFunc((a, b) => a + b));
+ * const { geometries, errors } = await gdal.geometryBatch(polygons).simplifyAsync(0.1)
  *
- * @param {(...sources: number[]) => void} pixelFn
- * @returns {PixelFunction}
+ * @param {Geometry[]} geometries
+ * @returns {GeometryBatch}
  */
-gdal.createPixelFunc = function createPixelFunc(fn) {
-  if (typeof fn !== 'function') throw TypeError('pixelFn must be a function')
-
-  const makeThunk = `
-    return function(sources, buffer) {
-      for (let i = 0; i < buffer.length; i++)
-        buffer[i] = fn(${Array(fn.length).fill(0).map((x, i) => `sources[${i}][i]`).join(',')});
-    }
-  `
-  const thunk = new Function('fn', makeThunk)(fn)
-
-  return gdal.toPixelFunc(thunk)
+gdal.geometryBatch = function geometryBatch(geometries) {
+  return new gdal.GeometryBatch(geometries)
 }
 
-/**
- * Create a GDAL pixel function from a JS expression for one pixel.
- *
- * Same as `gdal.createPixelFunc` but passes an object with the static arguments from
- * the VRT descriptor.
- *
- * @static
- * @method createPixelFuncWithArgs
- *
- * @example
- * // This example will register a new GDAL pixel function called sum2
- * // that requires a VRT dataset with 2 values per pixel
- * gdal.addPixelFunc('sum2', gdal.createPixelFuncWithArgs((args, a, b) => args.k + a + b));
- *
- * @param {(args: Record<string, string|number>,...sources: number[]) => void} pixelFn
- * @returns {PixelFunction}
- */
-gdal.createPixelFuncWithArgs = function createPixelFunc(fn) {
-  if (typeof fn !== 'function') throw TypeError('pixelFn must be a function')
+gdal.GeometryPipeline = require('./pipeline.js')(gdal)
 
-  const makeThunk = `
-    return function(sources, buffer, args) {
-      for (let i = 0; i < buffer.length; i++)
-        buffer[i] = fn(args, ${Array(Math.max(fn.length-1, 0)).fill(0).map((x, i) => `sources[${i}][i]`).join(',')});
-    }
-  `
-  const thunk = new Function('fn', makeThunk)(fn)
+gdal.DatasetPool = require('./pool.js')(gdal)
 
-  return gdal.toPixelFunc(thunk)
-}
+require('./pixelfunc.js')(gdal)
+
+require('./stats.js')(gdal)
 
 /**
  * @interface xyz
@@ -762,6 +728,7 @@ const promisifiables = {
   Dataset: {
     flushAsync: 0,
     buildOverviewsAsync: 4,
+    sampleAsync: 3,
     executeSQLAsync: 3,
     getMetadataAsync: 1,
     setMetadataAsync: 2
@@ -782,6 +749,7 @@ const promisifiables = {
     readBlockAsync: 3,
     writeBlockAsync: 3,
     clampBlockAsync: 2,
+    sampleAsync: 3,
     getAsync: 2,
     setAsync: 3
   },
@@ -816,6 +784,8 @@ const promisifiables = {
     $fromWKBAsync: 2,
     $fromGeoJsonAsync: 1,
     $fromGeoJsonBufferAsync: 1,
+    $fromWKBArrayAsync: 3,
+    $fromWKTArrayAsync: 3,
     toKMLAsync: 0,
     toGMLAsync: 0,
     toWKTAsync: 0,
@@ -854,6 +824,17 @@ const promisifiables = {
     transformAsync: 1,
     transformToAsync: 1
   },
+  GeometryBatch: {
+    bufferAsync: 2,
+    simplifyAsync: 1,
+    simplifyPreserveTopologyAsync: 1,
+    makeValidAsync: 0,
+    centroidAsync: 0,
+    transformAsync: 1
+  },
+  WarpContext: {
+    renderWindowAsync: 4
+  },
   SpatialReference: {
     $fromURLAsync: 1,
     $fromCRSURLAsync: 1,
@@ -864,7 +845,13 @@ const promisifiables = {
   },
   fs: {
     $statAsync: 2,
-    $readDirAsync: 1
+    $readDirAsync: 1,
+    $ioStatsAsync: 1
+  },
+  blockCache: {
+    $statsAsync: 1,
+    $flushDatasetAsync: 1,
+    $pinAsync: 2
   },
   GroupArrays: GroupCollection,
   GroupDimensions: GroupCollection,
@@ -878,15 +865,23 @@ const promisifiables = {
     $sieveFilterAsync: 1,
     $checksumImageAsync: 5,
     $polygonizeAsync: 1,
+    $spatialJoinAsync: 3,
+    $zonalStatsAsync: 3,
+    $calcExprAsync: 4,
+    $_processTilesAsync: 4,
     $reprojectImageAsync: 1,
     $suggestedWarpOutputAsync: 1,
+    $buildTilePyramidAsync: 2,
     $translateAsync: 4,
+    $translateToBufferAsync: 4,
     $vectorTranslateAsync: 4,
     $infoAsync: 2,
     $warpAsync: 5,
+    $warpToBufferAsync: 4,
     $buildVRTAsync: 4,
     $rasterizeAsync: 4,
     $demAsync: 6,
+    $_geometryPipelineAsync: 3,
     $_acquireLocksAsync: 3
   }
 }
@@ -903,9 +898,72 @@ const argMangle = {
   }
 }
 
+// Returns the AbortSignal of the first plain object argument that has one,
+// the object is replaced by a copy without it as most options objects
+// are converted to GDAL options
+const takeSignal = (args) => {
+  for (let i = 0; i < args.length; i++) {
+    const arg = args[i]
+    if (arg && typeof arg === 'object' && arg.signal instanceof AbortSignal &&
+      Object.getPrototypeOf(arg) === Object.prototype) {
+      const { signal, ...rest } = arg
+      args[i] = rest
+      return signal
+    }
+  }
+  return undefined
+}
+
+const abortError = (signal) => {
+  const err = new Error('The operation was aborted')
+  err.name = 'AbortError'
+  err.code = 'ABORT_ERR'
+  if (signal.reason !== undefined) err.cause = signal.reason
+  return err
+}
+
+// The C++ job receives the abort flag through gdal._setAbortFlag(), it is dropped
+// if it has not started when the signal is aborted, otherwise it is stopped
+// by its progress callback if the GDAL operation supports it
+const callAbortable = (signal, callback, call) => {
+  if (signal.aborted) {
+    const err = abortError(signal)
+    if (callback) {
+      process.nextTick(callback, err)
+      return undefined
+    }
+    return Promise.reject(err)
+  }
+
+  const flag = new Int32Array(1)
+  const onAbort = () => Atomics.store(flag, 0, 1)
+  signal.addEventListener('abort', onAbort, { once: true })
+  const settle = (err) => {
+    signal.removeEventListener('abort', onAbort)
+    return err && signal.aborted ? abortError(signal) : err
+  }
+
+  gdal._setAbortFlag(flag)
+  try {
+    if (callback) return call((err, result) => callback(settle(err), result))
+    return call().then((result) => {
+      settle()
+      return result
+    }, (err) => {
+      throw settle(err)
+    })
+  } catch (err) {
+    settle()
+    throw err
+  } finally {
+    gdal._setAbortFlag(null)
+  }
+}
+
 // For each *Async function create a function that checks if the last parameter is a callback
 // Then call either the original, either the promisified version with the callback
 // placed at the right argument number since the C++ code does not support floating callbacks
+// An options object with an AbortSignal can be passed as any argument
 for (const c of Object.keys(promisifiables)) {
   const klass = c === '$' ? gdal : gdal[c]
   if (klass === undefined) {
@@ -929,13 +987,18 @@ for (const c of Object.keys(promisifiables)) {
           callback = arguments[arguments.length - 1]
           arguments[arguments.length - 1] = undefined
         }
+        const signal = takeSignal(arguments)
         let args = Array.prototype.slice.call(mangle(arguments), 0, cbArg)
-        if (callback) {
-          args[cbArg] = callback
-          return original.apply(this, args)
+        const call = (cb) => {
+          if (cb) {
+            args[cbArg] = cb
+            return original.apply(this, args)
+          }
+          args = Object.assign(new Array(cbArg).fill(undefined), args)
+          return promisified.apply(this, args)
         }
-        args = Object.assign(new Array(cbArg).fill(undefined), args)
-        return promisified.apply(this, args)
+        if (signal) return callAbortable(signal, callback, call)
+        return call(callback)
       }
     })()
   }
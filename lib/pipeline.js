@@ -0,0 +1,332 @@
+module.exports = function (gdal) {
+  /**
+   * @typedef {object} GeometryPipelineResult
+   * @property {(Geometry|Buffer|string|null)[]} results The output of the pipeline, `null` for the failed elements and for features without geometry
+   * @property {(string|null)[]} errors The error messages, `null` for the successful elements
+   * @property {number[]} [fids] The feature ids, only when the source is a layer
+   */
+
+  /**
+   * A chain of geometry operations executed in C++ in a single job, without
+   * creating any intermediate Geometry objects.
+   *
+   * The source can be a single geometry, an array of geometries or a layer.
+   * The source geometries are never modified.
+   *
+   * For a single geometry, `run()` returns the output and throws on error.
+   * For an array or a layer, `run()` returns a {@link GeometryPipelineResult}
+   * with per-element errors and the geometries are processed on `GDAL_NUM_THREADS` threads.
+   * A layer is read from the start, honoring its spatial and attribute filters.
+   *
+   * Obtained with `geometry.pipeline()`, `layer.pipeline()` or `gdal.geometryPipeline(array)`.
+   *
+   * @example
+   * const wkb = await geom.pipeline()
+   *   .transformTo(gdal.SpatialReference.fromEPSG(3857))
+   *   .makeValid()
+   *   .simplify(1)
+   *   .buffer(5)
+   *   .toWKB()
+   *   .runAsync()
+   *
+   * @constructor
+   * @class GeometryPipeline
+   * @param {Geometry|Geometry[]|Layer} source
+   */
+  const GeometryPipeline = function GeometryPipeline(source) {
+    this.source = source
+    this.steps = []
+    this.output = { format: 'geometry' }
+  }
+
+  const step = (op, params) => function () {
+    const s = { op }
+    if (params) {
+      params.forEach((p, i) => {
+        if (arguments[i] !== undefined) s[p] = arguments[i]
+      })
+    }
+    this.steps.push(s)
+    return this
+  }
+
+  /**
+   * Adds a coordinate transformation step.
+   *
+   * @method transform
+   * @instance
+   * @memberof GeometryPipeline
+   * @param {CoordinateTransformation} transformation
+   * @return {GeometryPipeline}
+   */
+  GeometryPipeline.prototype.transform = step('transform', [ 'transformation' ])
+
+  /**
+   * Adds a reprojection step to the given spatial reference,
+   * the geometries must have a spatial reference.
+   *
+   * @method transformTo
+   * @instance
+   * @memberof GeometryPipeline
+   * @param {SpatialReference} srs
+   * @return {GeometryPipeline}
+   */
+  GeometryPipeline.prototype.transformTo = step('transformTo', [ 'srs' ])
+
+  /**
+   * Adds a makeValid step.
+   * Requires GDAL 3.0
+   *
+   * @method makeValid
+   * @instance
+   * @memberof GeometryPipeline
+   * @return {GeometryPipeline}
+   */
+  GeometryPipeline.prototype.makeValid = step('makeValid')
+
+  /**
+   * Adds a simplify step.
+   *
+   * @method simplify
+   * @instance
+   * @memberof GeometryPipeline
+   * @param {number} tolerance
+   * @return {GeometryPipeline}
+   */
+  GeometryPipeline.prototype.simplify = step('simplify', [ 'tolerance' ])
+
+  /**
+   * Adds a simplifyPreserveTopology step.
+   *
+   * @method simplifyPreserveTopology
+   * @instance
+   * @memberof GeometryPipeline
+   * @param {number} tolerance
+   * @return {GeometryPipeline}
+   */
+  GeometryPipeline.prototype.simplifyPreserveTopology = step('simplifyPreserveTopology', [ 'tolerance' ])
+
+  /**
+   * Adds a buffer step.
+   *
+   * @method buffer
+   * @instance
+   * @memberof GeometryPipeline
+   * @param {number} distance
+   * @param {number} [segments=30]
+   * @return {GeometryPipeline}
+   */
+  GeometryPipeline.prototype.buffer = step('buffer', [ 'distance', 'segments' ])
+
+  /**
+   * Adds a centroid step.
+   *
+   * @method centroid
+   * @instance
+   * @memberof GeometryPipeline
+   * @return {GeometryPipeline}
+   */
+  GeometryPipeline.prototype.centroid = step('centroid')
+
+  /**
+   * Adds a convexHull step.
+   *
+   * @method convexHull
+   * @instance
+   * @memberof GeometryPipeline
+   * @return {GeometryPipeline}
+   */
+  GeometryPipeline.prototype.convexHull = step('convexHull')
+
+  /**
+   * Adds a boundary step.
+   *
+   * @method boundary
+   * @instance
+   * @memberof GeometryPipeline
+   * @return {GeometryPipeline}
+   */
+  GeometryPipeline.prototype.boundary = step('boundary')
+
+  /**
+   * Adds an intersection step.
+   *
+   * @method intersection
+   * @instance
+   * @memberof GeometryPipeline
+   * @param {Geometry} geometry
+   * @return {GeometryPipeline}
+   */
+  GeometryPipeline.prototype.intersection = step('intersection', [ 'geometry' ])
+
+  /**
+   * Adds an union step.
+   *
+   * @method union
+   * @instance
+   * @memberof GeometryPipeline
+   * @param {Geometry} geometry
+   * @return {GeometryPipeline}
+   */
+  GeometryPipeline.prototype.union = step('union', [ 'geometry' ])
+
+  /**
+   * Adds a difference step.
+   *
+   * @method difference
+   * @instance
+   * @memberof GeometryPipeline
+   * @param {Geometry} geometry
+   * @return {GeometryPipeline}
+   */
+  GeometryPipeline.prototype.difference = step('difference', [ 'geometry' ])
+
+  /**
+   * Adds a symDifference step.
+   *
+   * @method symDifference
+   * @instance
+   * @memberof GeometryPipeline
+   * @param {Geometry} geometry
+   * @return {GeometryPipeline}
+   */
+  GeometryPipeline.prototype.symDifference = step('symDifference', [ 'geometry' ])
+
+  /**
+   * Adds a flattenTo2D step.
+   *
+   * @method flattenTo2D
+   * @instance
+   * @memberof GeometryPipeline
+   * @return {GeometryPipeline}
+   */
+  GeometryPipeline.prototype.flattenTo2D = step('flattenTo2D')
+
+  /**
+   * Adds a swapXY step.
+   *
+   * @method swapXY
+   * @instance
+   * @memberof GeometryPipeline
+   * @return {GeometryPipeline}
+   */
+  GeometryPipeline.prototype.swapXY = step('swapXY')
+
+  /**
+   * Adds a segmentize step.
+   *
+   * @method segmentize
+   * @instance
+   * @memberof GeometryPipeline
+   * @param {number} length
+   * @return {GeometryPipeline}
+   */
+  GeometryPipeline.prototype.segmentize = step('segmentize', [ 'length' ])
+
+  /**
+   * Outputs WKB buffers instead of geometries.
+   *
+   * @method toWKB
+   * @instance
+   * @memberof GeometryPipeline
+   * @param {string} [byte_order="MSB"] {@link wkbByteOrder|see options}
+   * @param {string} [variant="OGC"] ({@link wkbVariant|see options})
+   * @return {GeometryPipeline}
+   */
+  GeometryPipeline.prototype.toWKB = function (byteOrder, variant) {
+    this.output = { format: 'wkb', byteOrder: byteOrder || 'MSB', variant: variant || 'OGC' }
+    return this
+  }
+
+  /**
+   * Outputs WKT strings instead of geometries.
+   *
+   * @method toWKT
+   * @instance
+   * @memberof GeometryPipeline
+   * @return {GeometryPipeline}
+   */
+  GeometryPipeline.prototype.toWKT = function () {
+    this.output = { format: 'wkt' }
+    return this
+  }
+
+  /**
+   * Outputs GeoJSON strings instead of geometries.
+   *
+   * @method toJSON
+   * @instance
+   * @memberof GeometryPipeline
+   * @return {GeometryPipeline}
+   */
+  GeometryPipeline.prototype.toJSON = function () {
+    this.output = { format: 'json' }
+    return this
+  }
+
+  /**
+   * Runs the pipeline.
+   *
+   * @method run
+   * @instance
+   * @memberof GeometryPipeline
+   * @throws {Error}
+   * @return {Geometry|Buffer|string|GeometryPipelineResult}
+   */
+  GeometryPipeline.prototype.run = function () {
+    return gdal._geometryPipeline(this.source, this.steps, this.output)
+  }
+
+  /**
+   * Runs the pipeline.
+   * @async
+   *
+   * @method runAsync
+   * @instance
+   * @memberof GeometryPipeline
+   * @throws {Error}
+   * @param {callback<Geometry|Buffer|string|GeometryPipelineResult>} [callback=undefined]
+   * @return {Promise<Geometry|Buffer|string|GeometryPipelineResult>}
+   */
+  GeometryPipeline.prototype.runAsync = function (callback) {
+    return gdal._geometryPipelineAsync(this.source, this.steps, this.output, callback)
+  }
+
+  /**
+   * Creates a {@link GeometryPipeline} with this geometry as source.
+   *
+   * @method pipeline
+   * @instance
+   * @memberof Geometry
+   * @return {GeometryPipeline}
+   */
+  gdal.Geometry.prototype.pipeline = function () {
+    return new GeometryPipeline(this)
+  }
+
+  /**
+   * Creates a {@link GeometryPipeline} with the geometries of the features of this layer as source.
+   *
+   * @method pipeline
+   * @instance
+   * @memberof Layer
+   * @return {GeometryPipeline}
+   */
+  gdal.Layer.prototype.pipeline = function () {
+    return new GeometryPipeline(this)
+  }
+
+  /**
+   * Creates a {@link GeometryPipeline} with an array of geometries as source.
+   *
+   * @static
+   * @method geometryPipeline
+   * @param {Geometry|Geometry[]|Layer} source
+   * @return {GeometryPipeline}
+   */
+  gdal.geometryPipeline = function geometryPipeline(source) {
+    return new GeometryPipeline(source)
+  }
+
+  return GeometryPipeline
+}
@@ -0,0 +1,200 @@
+const { Worker } = require('worker_threads')
+
+// The code of the worker threads evaluating the JS pixel functions,
+// fn is the source code of the pixel function
+const workerCode = (fn) => `
+  const { parentPort } = require('worker_threads')
+  const fn = (${fn})
+  parentPort.on('message', ({ sources, buffer, args, width, height }) => {
+    try {
+      fn(sources, buffer, args, width, height)
+      parentPort.postMessage(null)
+    } catch (e) {
+      parentPort.postMessage(String(e && e.message || e))
+    }
+  })
+`
+
+// Copies a TypedArray to a new TypedArray of the same type in shared memory
+const toShared = (array) => {
+  const shared = new array.constructor(new SharedArrayBuffer(array.byteLength))
+  shared.set(array)
+  return shared
+}
+
+class PixelFuncPool {
+  constructor(code, size) {
+    this.idle = []
+    this.queue = []
+    this.error = null
+    this.alive = size
+    for (let i = 0; i < size; i++) this.spawn(code)
+  }
+
+  spawn(code) {
+    const worker = new Worker(workerCode(code), { eval: true })
+    worker.on('message', (err) => {
+      const job = worker.job
+      worker.job = null
+      if (err === null) job.resolve()
+      else job.reject(new Error(err))
+      this.release(worker)
+    })
+    worker.on('error', (err) => {
+      if (worker.job) worker.job.reject(err)
+      worker.job = null
+      // An invalid function fails all the workers in the same way
+      this.error = err
+      this.failQueue(err)
+    })
+    // A worker can also exit without an error (ie process.exit() in the pixel function),
+    // its job would never complete
+    worker.on('exit', (code) => {
+      const err = new Error(`Pixel function worker exited with code ${code}`)
+      if (worker.job) worker.job.reject(err)
+      worker.job = null
+      this.idle = this.idle.filter((w) => w !== worker)
+      this.alive--
+      if (this.alive === 0) {
+        if (!this.error) this.error = err
+        this.failQueue(this.error)
+      }
+    })
+    // Idle workers must not keep the process alive
+    worker.unref()
+    this.idle.push(worker)
+  }
+
+  failQueue(err) {
+    for (const job of this.queue) job.reject(err)
+    this.queue = []
+  }
+
+  release(worker) {
+    const job = this.queue.shift()
+    if (job) this.start(worker, job)
+    else {
+      worker.unref()
+      this.idle.push(worker)
+    }
+  }
+
+  start(worker, job) {
+    worker.ref()
+    worker.job = job
+    worker.postMessage(job.message)
+  }
+
+  run(message) {
+    return new Promise((resolve, reject) => {
+      if (this.error) {
+        reject(this.error)
+        return
+      }
+      const job = { message, resolve, reject }
+      const worker = this.idle.pop()
+      if (worker) this.start(worker, job)
+      else this.queue.push(job)
+    })
+  }
+}
+
+// Creates a deferred pixel function: in async mode the native code waits
+// for done() instead of the return of the JS function
+const toWorkerPixelFunc = (toPixelFunc, fn, code, workers) => {
+  if (typeof workers !== 'number' || workers < 1) throw new TypeError('workers must be a positive number')
+  const pool = new PixelFuncPool(code, Math.floor(workers))
+
+  const dispatch = (sources, buffer, args, width, height, done) => {
+    // sync mode, the main thread cannot wait
+    if (!done) {
+      fn(sources, buffer, args, width, height)
+      return
+    }
+    const shared = toShared(buffer)
+    pool.run({ sources: sources.map(toShared), buffer: shared, args, width, height })
+      .then(() => {
+        buffer.set(shared)
+        done()
+      })
+      .catch((e) => done(e.message))
+  }
+
+  return toPixelFunc(dispatch, true)
+}
+
+// The code of the thunk calling a per-pixel function, it must be self-contained
+// as it is also transferred to the worker threads
+const thunkCode = (withArgs, nargs) => `(function (fn) {
+    return function (sources, buffer, args) {
+      for (let i = 0; i < buffer.length; i++)
+        buffer[i] = fn(${withArgs ? 'args, ' : ''}${Array(nargs).fill(0).map((x, i) => `sources[${i}][i]`).join(',')});
+    }
+  })`
+
+module.exports = function (gdal) {
+  const toPixelFunc = gdal.toPixelFunc
+
+  gdal.toPixelFunc = function (fn, options) {
+    if (options && options.workers !== undefined) {
+      if (typeof fn !== 'function') throw new TypeError('pixelFn must be a function')
+      return toWorkerPixelFunc(toPixelFunc, fn, fn.toString(), options.workers)
+    }
+    return toPixelFunc(fn)
+  }
+
+  const makePixelFunc = (fn, options, withArgs) => {
+    if (typeof fn !== 'function') throw TypeError('pixelFn must be a function')
+
+    const code = thunkCode(withArgs, withArgs ? Math.max(fn.length - 1, 0) : fn.length)
+    const thunk = new Function(`return ${code}`)()(fn)
+    if (options && options.workers !== undefined) {
+      return toWorkerPixelFunc(toPixelFunc, thunk, `${code}(${fn.toString()})`, options.workers)
+    }
+
+    return toPixelFunc(thunk)
+  }
+
+  /**
+   * Create a GDAL pixel function from a JS expression for one pixel.
+   *
+   * Higher-level API of `gdal.toPixelFunc`.
+   *
+   * @static
+   * @method createPixelFunc
+   *
+   * @example
+   * // This example will register a new GDAL pixel function called sum2
+   * // that requires a VRT dataset with 2 values per pixel
+   * gdal.addPixelFunc('sum2', gdal.createPixelFunc((a, b) => a + b));
+   *
+   * @param {(...sources: number[]) => void} pixelFn
+   * @param {PixelFuncOptions} [options] See `gdal.toPixelFunc`
+   * @returns {PixelFunction}
+   */
+  gdal.createPixelFunc = function createPixelFunc(fn, options) {
+    return makePixelFunc(fn, options, false)
+  }
+
+  /**
+   * Create a GDAL pixel function from a JS expression for one pixel.
+   *
+   * Same as `gdal.createPixelFunc` but passes an object with the static arguments from
+   * the VRT descriptor.
+   *
+   * @static
+   * @method createPixelFuncWithArgs
+   *
+   * @example
+   * // This example will register a new GDAL pixel function called sum2
+   * // that requires a VRT dataset with 2 values per pixel
+   * gdal.addPixelFunc('sum2', gdal.createPixelFuncWithArgs((args, a, b) => args.k + a + b));
+   *
+   * @param {(args: Record<string, string|number>,...sources: number[]) => void} pixelFn
+   * @param {PixelFuncOptions} [options] See `gdal.toPixelFunc`
+   * @returns {PixelFunction}
+   */
+  gdal.createPixelFuncWithArgs = function createPixelFuncWithArgs(fn, options) {
+    return makePixelFunc(fn, options, true)
+  }
+}
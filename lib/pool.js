@@ -0,0 +1,300 @@
+module.exports = function (gdal) {
+  /**
+   * @typedef {object} DatasetPoolOptions
+   * @property {number} [max]
+   * @property {number} [maxPerKey]
+   * @property {number} [idleTimeout]
+   * @property {string} [mode]
+   * @property {string|string[]} [drivers]
+   */
+
+  /**
+   * @typedef {object} DatasetPoolStats
+   * @property {number} size
+   * @property {number} idle
+   * @property {number} leased
+   * @property {number} waiting
+   */
+
+  /**
+   * A pool of opened datasets keyed by their path, for applications that
+   * open the same files over and over - such as web servers opening a
+   * dataset for each request.
+   *
+   * Opening a dataset parses its headers (GeoTIFF IFDs, GPKG schemas,
+   * remote headers with `/vsicurl/`), which can take longer than the
+   * request itself. The pool keeps the datasets open between requests.
+   *
+   * `acquire()` leases a dataset exclusively until it is given back with `release()`:
+   * as the asynchronous operations on a dataset are serialized by its lock,
+   * a hot file gets up to `maxPerKey` datasets which can be used in parallel
+   * and the lock of a leased dataset is never contended.
+   * When all the datasets of a key are leased and no more can be opened,
+   * `acquire()` waits for a `release()`, in order.
+   *
+   * At most `max` datasets are open at the same time, the least recently used
+   * idle dataset being closed to make room for a new one. Idle datasets
+   * are closed after `idleTimeout` milliseconds.
+   *
+   * The datasets are opened read-only by default and must not be closed by the user.
+   *
+   * @example
+   * const pool = new gdal.DatasetPool({ max: 32, maxPerKey: 4 })
+   *
+   * app.get('/elevation', async (req, res) => {
+   *   const value = await pool.use('/vsicurl/https://example.com/dem.tif',
+   *     (ds) => ds.bands.get(1).pixels.getAsync(req.query.x, req.query.y))
+   *   res.json({ value })
+   * })
+   *
+   * @class DatasetPool
+   * @constructor
+   * @param {DatasetPoolOptions} [options]
+   * @param {number} [options.max=64] Maximum number of open datasets
+   * @param {number} [options.maxPerKey=4] Maximum number of open datasets for the same path
+   * @param {number} [options.idleTimeout=30000] Time in milliseconds after which an idle dataset is closed, `0` to never close it
+   * @param {string} [options.mode="r"] The mode used to open the datasets, `"r"` or `"r+"`
+   * @param {string|string[]} [options.drivers] Driver name, or list of driver names to attempt to use
+   */
+  class DatasetPool {
+    constructor(options) {
+      const { max, maxPerKey, idleTimeout, mode, drivers } = options || {}
+      if (max !== undefined && !(max >= 1)) throw new RangeError('max must be a positive number')
+      if (maxPerKey !== undefined && !(maxPerKey >= 1)) throw new RangeError('maxPerKey must be a positive number')
+      if (idleTimeout !== undefined && !(idleTimeout >= 0)) throw new RangeError('idleTimeout must not be negative')
+      if (mode !== undefined && mode !== 'r' && mode !== 'r+') throw new Error('mode must be "r" or "r+"')
+
+      this.max = max || 64
+      this.maxPerKey = maxPerKey || 4
+      this.idleTimeout = idleTimeout === undefined ? 30000 : idleTimeout
+      this.mode = mode || 'r'
+      this.drivers = drivers
+      this.closed = false
+
+      // key -> number of datasets open or opening and their idle entries, the most recent last
+      this.keys = new Map()
+      // all the idle entries, the least recently used first
+      this.idle = new Set()
+      // leased dataset -> entry
+      this.leases = new Map()
+      this.waiting = []
+      this.size = 0
+    }
+
+    key(path) {
+      let k = this.keys.get(path)
+      if (!k) {
+        k = { count: 0, idle: [] }
+        this.keys.set(path, k)
+      }
+      return k
+    }
+
+    lease(entry, waiter) {
+      this.leases.set(entry.ds, entry)
+      waiter.resolve(entry.ds)
+    }
+
+    // Removes an entry from the pool and closes its dataset
+    drop(entry) {
+      const k = this.keys.get(entry.key)
+      k.count--
+      this.size--
+      if (k.count === 0) this.keys.delete(entry.key)
+      try {
+        entry.ds.close()
+      } catch (e) {
+        /* already closed */
+      }
+    }
+
+    unidle(entry) {
+      clearTimeout(entry.timer)
+      entry.timer = null
+      this.idle.delete(entry)
+      const k = this.keys.get(entry.key)
+      k.idle.splice(k.idle.indexOf(entry), 1)
+    }
+
+    // Tries to serve a waiter, returns false if it must keep waiting
+    serve(waiter) {
+      const existing = this.keys.get(waiter.key)
+      if (existing && existing.idle.length > 0) {
+        const entry = existing.idle[existing.idle.length - 1]
+        this.unidle(entry)
+        this.lease(entry, waiter)
+        return true
+      }
+      if (existing && existing.count >= this.maxPerKey) return false
+      if (this.size >= this.max) {
+        // Make room by closing the least recently used idle dataset
+        const lru = this.idle.values().next().value
+        if (lru === undefined) return false
+        this.unidle(lru)
+        this.drop(lru)
+      }
+
+      const k = this.key(waiter.key)
+      k.count++
+      this.size++
+      gdal.openAsync(waiter.key, this.mode, this.drivers).then((ds) => {
+        const entry = { key: waiter.key, ds, timer: null }
+        if (this.closed) {
+          this.drop(entry)
+          waiter.reject(new Error('DatasetPool is closed'))
+          return
+        }
+        this.lease(entry, waiter)
+      }, (err) => {
+        k.count--
+        this.size--
+        if (k.count === 0 && k.idle.length === 0) this.keys.delete(waiter.key)
+        waiter.reject(err)
+        this.dispatch()
+      })
+      return true
+    }
+
+    dispatch() {
+      this.waiting = this.waiting.filter((waiter) => !this.serve(waiter))
+    }
+
+    /**
+     * Leases a dataset, opening it if there is no idle dataset for this path.
+     *
+     * @method acquire
+     * @instance
+     * @memberof DatasetPool
+     * @param {string} path
+     * @return {Promise<Dataset>}
+     */
+    acquire(path) {
+      if (this.closed) return Promise.reject(new Error('DatasetPool is closed'))
+      if (typeof path !== 'string') return Promise.reject(new TypeError('path must be a string'))
+      return new Promise((resolve, reject) => {
+        const waiter = { key: path, resolve, reject }
+        // Do not overtake the requests for the same path that are already waiting
+        if (this.waiting.some((w) => w.key === path) || !this.serve(waiter)) this.waiting.push(waiter)
+      })
+    }
+
+    /**
+     * Gives back a dataset obtained with `acquire()`.
+     *
+     * @method release
+     * @instance
+     * @memberof DatasetPool
+     * @throws {Error}
+     * @param {Dataset} ds
+     * @return {void}
+     */
+    release(ds) {
+      const entry = this.leases.get(ds)
+      if (!entry) throw new Error('Dataset is not leased from this pool')
+      this.leases.delete(ds)
+      if (this.closed) {
+        this.drop(entry)
+        return
+      }
+
+      const k = this.keys.get(entry.key)
+      k.idle.push(entry)
+      this.idle.add(entry)
+      if (this.idleTimeout > 0) {
+        entry.timer = setTimeout(() => {
+          this.unidle(entry)
+          this.drop(entry)
+        }, this.idleTimeout)
+        // Idle datasets must not keep the process alive
+        entry.timer.unref()
+      }
+      this.dispatch()
+    }
+
+    /**
+     * Gives back a dataset obtained with `acquire()` that must not be reused,
+     * for example after an I/O error. The dataset is closed.
+     *
+     * @method destroy
+     * @instance
+     * @memberof DatasetPool
+     * @throws {Error}
+     * @param {Dataset} ds
+     * @return {void}
+     */
+    destroy(ds) {
+      const entry = this.leases.get(ds)
+      if (!entry) throw new Error('Dataset is not leased from this pool')
+      this.leases.delete(ds)
+      this.drop(entry)
+      this.dispatch()
+    }
+
+    /**
+     * Leases a dataset for the duration of `fn`, releasing it
+     * when the returned `Promise` settles.
+     *
+     * @method use
+     * @instance
+     * @memberof DatasetPool
+     * @param {string} path
+     * @param {(ds: Dataset) => any} fn
+     * @return {Promise<any>} The value returned by `fn`
+     */
+    use(path, fn) {
+      return this.acquire(path).then((ds) => {
+        let r
+        try {
+          r = Promise.resolve(fn(ds))
+        } catch (e) {
+          r = Promise.reject(e)
+        }
+        return r.then((value) => {
+          this.release(ds)
+          return value
+        }, (err) => {
+          this.release(ds)
+          throw err
+        })
+      })
+    }
+
+    /**
+     * Returns the number of open, idle and leased datasets and the number of waiting requests.
+     *
+     * @method stats
+     * @instance
+     * @memberof DatasetPool
+     * @return {DatasetPoolStats}
+     */
+    stats() {
+      return {
+        size: this.size,
+        idle: this.idle.size,
+        leased: this.leases.size,
+        waiting: this.waiting.length
+      }
+    }
+
+    /**
+     * Closes the idle datasets and rejects the waiting requests,
+     * the leased datasets are closed when they are released.
+     *
+     * @method close
+     * @instance
+     * @memberof DatasetPool
+     * @return {void}
+     */
+    close() {
+      this.closed = true
+      for (const entry of Array.from(this.idle)) {
+        this.unidle(entry)
+        this.drop(entry)
+      }
+      for (const waiter of this.waiting) waiter.reject(new Error('DatasetPool is closed'))
+      this.waiting = []
+    }
+  }
+
+  return DatasetPool
+}
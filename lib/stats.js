@@ -0,0 +1,66 @@
+const diagnosticsChannel = require('diagnostics_channel')
+
+module.exports = function (gdal) {
+  const channel = diagnosticsChannel.channel('gdal-async:job')
+
+  /**
+   * @typedef {object} JobEvent
+   * @property {string} method
+   * @property {boolean} async
+   * @property {boolean} error
+   * @property {number[]} datasets The `uid` of the locked datasets
+   * @property {number} queue
+   * @property {number} lock
+   * @property {number} exec
+   * @property {number} rval
+   * @property {number} reads
+   * @property {number} bytesRead
+   */
+
+  /**
+   * Resets the statistics returned by {@link stats} and {@link stats.locks}.
+   *
+   * @static
+   * @method reset
+   * @memberof stats
+   * @return {void}
+   */
+  gdal.stats.reset = gdal._resetStats
+
+  gdal.stats.locks = gdal._lockStats
+
+  gdal.fs.ioStats.reset = gdal.fs._resetIOStats
+
+  // The call sites reported by gdal.syncProfile() are outside of lib/
+  gdal._setSyncProfileLib(__dirname)
+
+  /**
+   * Enables or disables the publishing of a {@link JobEvent} on the
+   * `gdal-async:job` `diagnostics_channel` at the end of each GDAL job,
+   * the times being in milliseconds.
+   *
+   * The events are produced on the main thread before the result
+   * is returned, so the subscribers should be fast.
+   *
+   * @example
+   * const diagnostics_channel = require('diagnostics_channel')
+   * const { createHistogram } = require('perf_hooks')
+   *
+   * const exec = createHistogram()
+   * diagnostics_channel.subscribe('gdal-async:job', (event) => {
+   *   if (event.method === 'RasterBandPixels::readAsync') exec.record(Math.ceil(event.exec * 1e6))
+   * })
+   * gdal.stats.publish(true)
+   *
+   * @static
+   * @method publish
+   * @memberof stats
+   * @param {boolean} enable
+   * @return {void}
+   */
+  gdal.stats.publish = function publish(enable) {
+    gdal._setJobHook(enable ? (event) => {
+      if (channel.hasSubscribers) channel.publish(event)
+    } : null)
+  }
+}
@@ -0,0 +1,193 @@
+const os = require('os')
+
+/**
+ * @typedef {object} TileInfo
+ * @property {number} x
+ * @property {number} y
+ * @property {number} width
+ * @property {number} height
+ */
+
+/**
+ * @typedef {object} ProcessTilesOptions
+ * @property {Record<string, RasterBand>} inputs
+ * @property {RasterBand} output
+ * @property {(inputs: Record<string, TypedArray>, output: TypedArray, tile: TileInfo) => void|Promise<void>} [fn]
+ * @property {string} [expr]
+ * @property {number} [tileSize]
+ * @property {number} [concurrency]
+ * @property {boolean} [convertNoData]
+ * @property {ProgressCb} [progress_cb]
+ */
+
+/**
+ * Process a raster tile by tile, computing an output band from given input bands.
+ *
+ * The raster is split in square tiles aligned on the blocks of the output band
+ * that are processed in parallel and written as soon as they are ready, in no particular order.
+ *
+ * With `expr`, everything happens in native code: each of `concurrency` threads
+ * reads, computes and writes its own tiles, the reading and the writing of each dataset
+ * being serialized, see {@link calcExpr} for the expression syntax. This is the
+ * fastest method and it should be able to use all the cores.
+ *
+ * With `fn`, the kernel runs on the main thread: it receives the input tiles and
+ * must fill the output tile, it can return a `Promise`. Up to `concurrency` tiles
+ * are in flight, so the reading and the writing happen in the background while
+ * the kernel is running. The input tiles have the data type of their band
+ * (`Float64Array` when `convertNoData` is set) and the output tile has the data type
+ * of the output band.
+ *
+ * There is no sync version
+ *
+ * @function processTilesAsync
+ * @param {ProcessTilesOptions} options
+ * @param {Record<string, RasterBand>} options.inputs An object containing all the input bands
+ * @param {RasterBand} options.output Output raster band
+ * @param {(inputs: Record<string, TypedArray>, output: TypedArray, tile: TileInfo) => void|Promise<void>} [options.fn] Function to apply on each tile, exclusive with `expr`
+ * @param {string} [options.expr] Expression to evaluate on each pixel, exclusive with `fn`
+ * @param {number} [options.tileSize=1024] Size of the tiles in pixels, rounded up to a multiple of the block size
+ * @param {number} [options.concurrency] Number of threads with `expr` (`GDAL_NUM_THREADS` by default) or of tiles in flight with `fn` (the number of CPUs by default)
+ * @param {boolean} [options.convertNoData=false] Input bands will have their NoData pixels converted to NaN and a NaN output value will be converted to a NoData pixel, provided that the output raster band has its `RasterBand.noDataValue` set
+ * @param {ProgressCb} [options.progress_cb=undefined] Progress callback
+ * @return {Promise<void>}
+ * @static
+ *
+ * @example
+ *
+ * // Espy's estimation for cloud base height
+ * await gdal.processTilesAsync({
+ *   inputs: { t: T2m.bands.get(1), td: D2m.bands.get(1) },
+ *   output: cloudBase.bands.get(1),
+ *   expr: '125 * (t - td)'
+ * });
+ *
+ * await gdal.processTilesAsync({
+ *   inputs: { t: T2m.bands.get(1), td: D2m.bands.get(1) },
+ *   output: cloudBase.bands.get(1),
+ *   fn: ({ t, td }, output) => {
+ *     for (let i = 0; i < output.length; i++) output[i] = 125 * (t[i] - td[i]);
+ *   }
+ * });
+ */
+
+const processTiles = (gdal) => function processTilesAsync(options) {
+  const { inputs, output, fn, expr, tileSize, concurrency, convertNoData } = options || {}
+  const progress = (options || {}).progress_cb
+
+  if (typeof inputs !== 'object' || inputs === null) return Promise.reject(new TypeError('inputs must be an object'))
+  for (const inp of Object.keys(inputs)) {
+    if (!(inputs[inp] instanceof gdal.RasterBand)) {
+      return Promise.reject(new TypeError('All inputs must be instances of gdal.RasterBand'))
+    }
+  }
+  if (!(output instanceof gdal.RasterBand)) {
+    return Promise.reject(new TypeError('output must be an instance of gdal.RasterBand'))
+  }
+  if ((fn === undefined) === (expr === undefined)) {
+    return Promise.reject(new TypeError('Exactly one of fn and expr must be specified'))
+  }
+  if (tileSize !== undefined && !(tileSize >= 1)) return Promise.reject(new RangeError('tileSize must be a positive number'))
+  if (concurrency !== undefined && !(concurrency >= 1)) {
+    return Promise.reject(new RangeError('concurrency must be a positive number'))
+  }
+  if (progress !== undefined && typeof progress !== 'function') {
+    return Promise.reject(new TypeError('progress_cb must be a function'))
+  }
+
+  if (expr !== undefined) {
+    const nativeOptions = { convertNoData: !!convertNoData }
+    if (tileSize !== undefined) nativeOptions.tileSize = tileSize
+    if (concurrency !== undefined) nativeOptions.concurrency = concurrency
+    if (progress !== undefined) nativeOptions.progress_cb = progress
+    return gdal._processTilesAsync(inputs, output, expr, nativeOptions)
+  }
+
+  if (typeof fn !== 'function') return Promise.reject(new TypeError('fn must be a function'))
+
+  const names = Object.keys(inputs)
+  const inSizesQ = names.map((inp) => inputs[inp].sizeAsync)
+  const inNoDataQ = names.map((inp) => inputs[inp].noDataValueAsync)
+
+  return Promise.all([
+    output.dataTypeAsync,
+    output.sizeAsync,
+    output.blockSizeAsync,
+    output.noDataValueAsync,
+    Promise.all(inSizesQ),
+    Promise.all(inNoDataQ)
+  ]).then(([ outType, size, blockSize, outNoData, inSizes, inNoData ]) => {
+    for (const inSize of inSizes) {
+      if (size.x != inSize.x || size.y != inSize.y) {
+        throw new RangeError('All raster bands dimensions must match')
+      }
+    }
+
+    const tile = tileSize || 1024
+    const tileX = Math.min(size.x, Math.ceil(tile / blockSize.x) * blockSize.x)
+    const tileY = Math.min(size.y, Math.ceil(tile / blockSize.y) * blockSize.y)
+    const tilesX = Math.ceil(size.x / tileX)
+    const total = tilesX * Math.ceil(size.y / tileY)
+    const readOptions = convertNoData ? { data_type: gdal.GDT_Float64 } : undefined
+    const OutArray = convertNoData ? Float64Array : gdal.fromDataType(outType)
+
+    const processTile = (t) => {
+      const info = {
+        x: (t % tilesX) * tileX,
+        y: Math.floor(t / tilesX) * tileY
+      }
+      info.width = Math.min(tileX, size.x - info.x)
+      info.height = Math.min(tileY, size.y - info.y)
+
+      return Promise.all(names.map((inp) =>
+        inputs[inp].pixels.readAsync(info.x, info.y, info.width, info.height, undefined, readOptions)))
+        .then((data) => {
+          const tiles = {}
+          for (let i = 0; i < names.length; i++) {
+            if (convertNoData && inNoData[i] !== null) {
+              const noData = inNoData[i]
+              const buffer = data[i]
+              for (let j = 0; j < buffer.length; j++) if (buffer[j] === noData) buffer[j] = NaN
+            }
+            tiles[names[i]] = data[i]
+          }
+          const result = new OutArray(info.width * info.height)
+          return Promise.resolve(fn(tiles, result, info)).then(() => result)
+        })
+        .then((result) => {
+          if (convertNoData && outNoData !== null) {
+            for (let j = 0; j < result.length; j++) if (isNaN(result[j])) result[j] = outNoData
+          }
+          return output.pixels.writeAsync(info.x, info.y, info.width, info.height, result)
+        })
+    }
+
+    return new Promise((resolve, reject) => {
+      let next = 0
+      let done = 0
+      let failed = false
+
+      const schedule = () => {
+        if (failed) return
+        if (done === total) {
+          resolve()
+          return
+        }
+        if (next >= total) return
+        processTile(next++).then(() => {
+          done++
+          if (progress) progress(done / total)
+          schedule()
+        }).catch((e) => {
+          failed = true
+          reject(e)
+        })
+      }
+
+      const inFlight = Math.max(1, Math.min(total, Math.floor(concurrency || os.cpus().length)))
+      for (let i = 0; i < inFlight; i++) schedule()
+    })
+  })
+}
+
+module.exports = processTiles
@@ -4,8 +4,9 @@ const { fragment } = require('xmlbuilder2')
  * @typedef {object} VRTBandDescriptor
  * @property {RasterBand[]} sources Source data raster bands
  * @property {string} [pixelFunc] Pixel function to be applied when reading data,
- * must be a GDAL builtin function or a registered user function
+ * must be a GDAL builtin function, a gdal-async native function (see {@link wrapVRT}) or a registered user function
  * @property {Record<string, string|number>} [pixelFuncArgs] Additional arguments for the pixel function
+ * @property {number} [noDataValue] NoData value of the band, also passed to the pixel functions that support it
  * @property {string} [dataType] Data type to convert the pixels to
  * @property {string} [sourceTransferType] Data type to be used as input of the pixel function
  * when reading from the source
@@ -23,6 +24,20 @@ const { fragment } = require('xmlbuilder2')
  *
  * Supports applying pixel functions.
  *
+ * Besides the GDAL builtin pixel functions (`sum`, `mul`, `norm_diff`, `min`, `max`...),
+ * gdal-async registers these native pixel functions which do not call JS
+ * and can be used from any thread (GDAL >= 3.5):
+ * - `weighted_sum`: `k + w1 * b1 + w2 * b2 + ...` with the arguments `weights`
+ *   (comma-separated, one per source, all `1` by default) and `k` (`0` by default)
+ * - `clamp`: clamps a single band between the arguments `min` and `max`
+ * - `lut`: applies a lookup table to a single band with linear interpolation,
+ *   the argument `lut` uses the VRT syntax: `"0:0,100:1,200:0"`
+ * - `bitmask`: extracts bits from a single band, `(b1 >> shift) & mask`
+ * - `nanmin`, `nanmax`, `nanmean`: minimum, maximum and mean of the valid values of all bands
+ *
+ * All of them treat `NaN` and the band `noDataValue` as NoData: `weighted_sum`
+ * returns NoData as soon as one of the sources is NoData, the others only when all of them are.
+ *
  * @example
  * // create a VRT dataset with a single band derived from the first
  * // band of the given dataset by applying the given pixel function
@@ -110,6 +125,7 @@ function wrapVRT(desc) {
       subClass: band.pixelFunc && 'VRTDerivedRasterBand'
     })
     if (description) xml.ele('Description').txt(description)
+    if (band.noDataValue !== undefined) xml.ele('NoDataValue').txt(String(band.noDataValue))
     if (band.pixelFunc) xml.ele('PixelFunctionType').txt(band.pixelFunc)
 
     if (band.pixelFuncArgs) {
@@ -4,6 +4,21 @@ namespace node_gdal {
 
 std::thread::id mainV8ThreadId;
 
+Nan::Persistent<v8::Int32Array> pendingAbortFlag;
+
+// The flag is consumed by the next async job, see GDALAsyncableJob::run()
+NAN_METHOD(setAbortFlag) {
+  if (info.Length() < 1 || info[0]->IsNull() || info[0]->IsUndefined()) {
+    pendingAbortFlag.Reset();
+    return;
+  }
+  if (!info[0]->IsInt32Array() || info[0].As<v8::Int32Array>()->Length() < 1) {
+    Nan::ThrowTypeError("flag must be an Int32Array");
+    return;
+  }
+  pendingAbortFlag.Reset(info[0].As<v8::Int32Array>());
+}
+
 // *message coming from GDAL points to a statically allocated buffer
 GDALProgressInfo::GDALProgressInfo(double complete, const char *message) : complete(complete), message(message) {
 }
@@ -17,13 +32,16 @@ GDALProgressInfo::GDALProgressInfo() : complete(0), message(nullptr) {
 // This is the GDAL form of the progress callback trampoline
 // It can be invoked both in the main thread (in sync mode) or in auxillary thread (in async mode)
 // It is essentially a gateway between the GDAL world and Node.js/V8 world
+// When the job can be aborted, it is installed even without a progress callback
 int ProgressTrampoline(double dfComplete, const char *pszMessage, void *pProgressArg) {
   GDALExecutionProgress *context = (GDALExecutionProgress *)pProgressArg;
-  // The dispatcher in async.hpp will delete it
-  GDALProgressInfo *info = new GDALProgressInfo(dfComplete, pszMessage);
-  // Go to the dispatcher
-  context->Send(info);
-  return 1;
+  if (context->hasCallback()) {
+    // The dispatcher in async.hpp will delete it
+    GDALProgressInfo *info = new GDALProgressInfo(dfComplete, pszMessage);
+    // Go to the dispatcher
+    context->Send(info);
+  }
+  return context->aborted() ? 0 : 1;
 }
 
 // From async.hpp:
@@ -31,9 +49,13 @@ int ProgressTrampoline(double dfComplete, const char *pszMessage, void *pProgres
 // typedef GDALAsyncProgressWorker::ExecutionProgress GDALAsyncExecutionProgress;
 // GDALAsyncExecutionProgress is an instance of a NAN templated class, in this case
 // the AsyncWorker is the final owner of the progress_callback
-GDALExecutionProgress::GDALExecutionProgress(const GDALAsyncExecutionProgress *async) : async(async), sync(nullptr) {
+GDALExecutionProgress::GDALExecutionProgress(
+  const GDALAsyncExecutionProgress *async, bool callback, const int32_t *abort)
+  : async(async), sync(nullptr), callback(callback), abort(abort) {
 }
-GDALExecutionProgress::GDALExecutionProgress(const GDALSyncExecutionProgress *sync) : async(nullptr), sync(sync) {
+// Sync jobs cannot be aborted
+GDALExecutionProgress::GDALExecutionProgress(const GDALSyncExecutionProgress *sync, bool callback)
+  : async(nullptr), sync(sync), callback(callback), abort(nullptr) {
 }
 
 GDALExecutionProgress::~GDALExecutionProgress() {
@@ -62,6 +84,7 @@ GDALSyncExecutionProgress::~GDALSyncExecutionProgress() {
 
 // Going back to JS in sync mode
 void GDALSyncExecutionProgress::Send(GDALProgressInfo *info) const {
+  if (progress_callback == nullptr) return;
   Nan::HandleScope scope;
   v8::Local<v8::Value> argv[] = {Nan::New<Number>(info->complete), SafeString::New(info->message)};
   Nan::TryCatch try_catch;
@@ -6,6 +6,9 @@
 #include <chrono>
 #include "nan-wrapper.h"
 #include "gdal_common.hpp"
+#include "utils/job_stats.hpp"
+#include "utils/vsi_stats.hpp"
+#include "utils/abort_flag.hpp"
 
 namespace node_gdal {
 
@@ -15,9 +18,11 @@ extern std::thread::id mainV8ThreadId;
 // This generates method definitions for 2 methods: sync and async version and a hidden common block
 #define GDAL_ASYNCABLE_DEFINE(method)                                                                                  \
   NAN_METHOD(method) {                                                                                                 \
+    node_gdal::JobStats::current = #method;                                                                            \
     method##_do(info, false);                                                                                          \
   }                                                                                                                    \
   NAN_METHOD(method##Async) {                                                                                          \
+    node_gdal::JobStats::current = #method;                                                                            \
     method##_do(info, true);                                                                                           \
   }                                                                                                                    \
   void method##_do(const Nan::FunctionCallbackInfo<v8::Value> &info, bool async)
@@ -25,9 +30,11 @@ extern std::thread::id mainV8ThreadId;
 // This generates getter definitions for 2 getters: sync and async version and a hidden common block
 #define GDAL_ASYNCABLE_GETTER_DEFINE(method)                                                                           \
   NAN_GETTER(method) {                                                                                                 \
+    node_gdal::JobStats::current = #method;                                                                            \
     method##_do(property, info, false);                                                                                \
   }                                                                                                                    \
   NAN_GETTER(method##Async) {                                                                                          \
+    node_gdal::JobStats::current = #method;                                                                            \
     method##_do(property, info, true);                                                                                 \
   }                                                                                                                    \
   Nan::NAN_GETTER_RETURN_TYPE method##_do(v8::Local<v8::String> property, Nan::NAN_GETTER_ARGS_TYPE info, bool async)
@@ -52,9 +59,11 @@ extern std::thread::id mainV8ThreadId;
 
 #define GDAL_ASYNCABLE_TEMPLATE(method)                                                                                \
   static NAN_METHOD(method) {                                                                                          \
+    node_gdal::JobStats::current = #method;                                                                            \
     method##_do(info, false);                                                                                          \
   }                                                                                                                    \
   static NAN_METHOD(method##Async) {                                                                                   \
+    node_gdal::JobStats::current = #method;                                                                            \
     method##_do(info, true);                                                                                           \
   }                                                                                                                    \
   static void method##_do(const Nan::FunctionCallbackInfo<v8::Value> &info, bool async)
@@ -92,11 +101,12 @@ class AsyncGuard {
   inline AsyncGuard(long uid) : locks(nullptr) {
     lock = object_store.lockDataset(uid);
   }
-  inline AsyncGuard(vector<long> uids) : lock(nullptr), locks(nullptr) {
+  // A job with an abort flag stops waiting for the locks when it is aborted
+  inline AsyncGuard(vector<long> uids, const int32_t *abort = nullptr) : lock(nullptr), locks(nullptr) {
     if (uids.size() == 1)
-      lock = object_store.lockDataset(uids[0]);
+      lock = object_store.lockDataset(uids[0], abort);
     else
-      locks = make_shared<vector<AsyncLock>>(object_store.lockDatasets(uids));
+      locks = make_shared<vector<AsyncLock>>(object_store.lockDatasets(uids, abort));
   }
   inline AsyncGuard(vector<long> uids, bool warning) : lock(nullptr), locks(nullptr) {
     if (uids.size() == 1) {
@@ -137,6 +147,11 @@ struct GDALProgressInfo {
   ~GDALProgressInfo() = default;
 };
 
+// The abort flag of the next async job, an Int32Array set by the wrappers of the async
+// methods in lib/gdal.js when they receive an AbortSignal, main thread only
+extern Nan::Persistent<v8::Int32Array> pendingAbortFlag;
+NAN_METHOD(setAbortFlag);
+
 class GDALSyncExecutionProgress {
   Nan::Callback *progress_callback;
 
@@ -158,19 +173,33 @@ class GDALExecutionProgress {
   // Only one of these is active at any given moment
   const GDALAsyncExecutionProgress *async;
   const GDALSyncExecutionProgress *sync;
+  const bool callback;
+  // Written from JS by Atomics.store() on the main thread, polled with IsAborted()
+  const int32_t *abort;
 
   GDALExecutionProgress() = delete;
 
     public:
-  GDALExecutionProgress(const GDALAsyncExecutionProgress *);
-  GDALExecutionProgress(const GDALSyncExecutionProgress *);
+  GDALExecutionProgress(const GDALAsyncExecutionProgress *, bool callback, const int32_t *abort);
+  GDALExecutionProgress(const GDALSyncExecutionProgress *, bool callback);
   ~GDALExecutionProgress();
   void Send(GDALProgressInfo *info) const;
+  inline bool hasCallback() const {
+    return callback;
+  }
+  // ProgressTrampoline must be given to GDAL when there is a progress callback or when the job can be aborted
+  inline bool active() const {
+    return callback || abort != nullptr;
+  }
+  inline bool aborted() const {
+    return IsAborted(abort);
+  }
 };
 
 // This is the progress callback trampoline
 // It can be invoked both in the main thread (in sync mode) or in auxillary thread (in async mode)
 // It is essentially a gateway between the GDAL world and Node.js/V8 world
+// It returns FALSE to make GDAL stop when the job has been aborted
 int ProgressTrampoline(double dfComplete, const char *pszMessage, void *pProgressArg);
 
 //
@@ -192,24 +221,31 @@ template <class GDALType> class GDALAsyncWorker : public GDALAsyncProgressWorker
 
     private:
   Nan::Callback *progressCallback;
+  const int32_t *abort;
   const GDALMainFunc doit;
   const GDALRValFunc rval;
   const std::vector<long> ds_uids;
   GDALType raw;
+  // Written by Execute() in the aux thread, read on the main thread once it has completed
+  JobTimings timings;
+  const JobClock::time_point enqueued;
 
     public:
   explicit GDALAsyncWorker(
     Nan::Callback *resultCallback,
     Nan::Callback *progressCallback,
+    const int32_t *abort,
     const GDALMainFunc &doit,
     const GDALRValFunc &rval,
     const std::map<std::string, v8::Local<v8::Object>> &objects,
-    const std::vector<long> &ds_uids);
+    const std::vector<long> &ds_uids,
+    const char *method);
 
   ~GDALAsyncWorker();
 
   void Execute(const ExecutionProgress &progress);
   Local<Value> ProduceRVal();
+  void RecordError();
   void HandleProgressCallback(const GDALProgressInfo *data, size_t count);
 };
 
@@ -217,17 +253,22 @@ template <class GDALType>
 GDALAsyncWorker<GDALType>::GDALAsyncWorker(
   Nan::Callback *resultCallback,
   Nan::Callback *progressCallback,
+  const int32_t *abort,
   const GDALMainFunc &doit,
   const GDALRValFunc &rval,
   const std::map<std::string, v8::Local<v8::Object>> &objects,
-  const std::vector<long> &ds_uids)
+  const std::vector<long> &ds_uids,
+  const char *method)
   : GDALAsyncProgressWorker(resultCallback, "node-gdal:GDALAsyncWorker"),
     progressCallback(progressCallback),
+    abort(abort),
     // These members are not references! These functions must be copied
     // as they will be executed in async context!
     doit(doit),
     rval(rval),
-    ds_uids(ds_uids) {
+    ds_uids(ds_uids),
+    timings({method, true, false, ds_uids, 0, 0, 0, 0, 0, 0}),
+    enqueued(JobClock::now()) {
   // Main thread with the JS world is not running
   // Get persistent handles
   for (auto i = objects.begin(); i != objects.end(); i++) SaveToPersistent(i->first.c_str(), i->second);
@@ -236,17 +277,37 @@ GDALAsyncWorker<GDALType>::GDALAsyncWorker(
 }
 
 template <class GDALType> Local<Value> GDALAsyncWorker<GDALType>::ProduceRVal() {
-  return rval(raw, [this](const char *key) { return this->GetFromPersistent(key); });
+  JobClock::time_point start = JobClock::now();
+  Local<Value> r = rval(raw, [this](const char *key) { return this->GetFromPersistent(key); });
+  timings.rval = JobStats::Elapsed(start, JobClock::now());
+  JobStats::Record(timings);
+  return r;
+}
+
+template <class GDALType> void GDALAsyncWorker<GDALType>::RecordError() {
+  timings.error = true;
+  JobStats::Record(timings);
 }
 
 template <class GDALType> void GDALAsyncWorker<GDALType>::Execute(const ExecutionProgress &progress) {
   // Aux thread with the JS world running
   // V8 objects are not acessible here
+  JobClock::time_point start = JobClock::now(), locked = start;
+  timings.queue = JobStats::Elapsed(enqueued, start);
+  const VSIStats::ThreadIO io = VSIStats::threadIO;
   try {
-    GDALExecutionProgress executionProgress(&progress);
-    AsyncGuard lock(ds_uids);
+    GDALExecutionProgress executionProgress(&progress, progressCallback != nullptr, abort);
+    // An aborted job is dropped before it starts, be it still in the queue or waiting for its locks
+    if (executionProgress.aborted()) throw abortedMessage;
+    AsyncGuard lock(ds_uids, abort);
+    locked = JobClock::now();
+    if (executionProgress.aborted()) throw abortedMessage;
     raw = doit(executionProgress);
   } catch (const char *err) { this->SetErrorMessage(err); }
+  timings.lock = JobStats::Elapsed(start, locked);
+  timings.exec = JobStats::Elapsed(locked, JobClock::now());
+  timings.reads = static_cast<double>(VSIStats::threadIO.reads - io.reads);
+  timings.bytesRead = static_cast<double>(VSIStats::threadIO.bytesRead - io.bytesRead);
 }
 
 template <class GDALType> GDALAsyncWorker<GDALType>::~GDALAsyncWorker() {
@@ -294,6 +355,7 @@ template <class GDALType> void GDALCallbackWorker<GDALType>::HandleOKCallback()
 template <class GDALType> void GDALCallbackWorker<GDALType>::HandleErrorCallback() {
   // Back to the main thread with the JS world not running
   Nan::HandleScope scope;
+  this->RecordError();
   v8::Local<v8::Value> argv[] = {Nan::Error(this->ErrorMessage())};
   this->callback->Call(1, argv, this->async_resource);
 }
@@ -314,7 +376,8 @@ template <class GDALType> class GDALPromiseWorker : public GDALAsyncWorker<GDALT
     const GDALMainFunc &doit,
     const GDALRValFunc &rval,
     const std::map<std::string, v8::Local<v8::Object>> &objects,
-    const std::vector<long> &ds_uids);
+    const std::vector<long> &ds_uids,
+    const char *method);
 
   ~GDALPromiseWorker();
 
@@ -331,8 +394,9 @@ GDALPromiseWorker<GDALType>::GDALPromiseWorker(
   const GDALMainFunc &doit,
   const GDALRValFunc &rval,
   const std::map<std::string, v8::Local<v8::Object>> &objects,
-  const std::vector<long> &ds_uids)
-  : GDALAsyncWorker<GDALType>(nullptr, nullptr, doit, rval, objects, ds_uids) {
+  const std::vector<long> &ds_uids,
+  const char *method)
+  : GDALAsyncWorker<GDALType>(nullptr, nullptr, nullptr, doit, rval, objects, ds_uids, method) {
   auto context = info.GetIsolate()->GetCurrentContext();
   context_handle = new Nan::Persistent<v8::Context>(context);
   auto resolver = v8::Promise::Resolver::New(context).ToLocalChecked();
@@ -348,6 +412,7 @@ template <class GDALType> void GDALPromiseWorker<GDALType>::HandleOKCallback() {
 
 template <class GDALType> void GDALPromiseWorker<GDALType>::HandleErrorCallback() {
   Nan::HandleScope scope;
+  this->RecordError();
   v8::Local<v8::Context> context = Nan::New(*context_handle);
   v8::Local<v8::Promise::Resolver> resolver = Nan::New(*resolver_handle);
   resolver->Reject(context, Nan::Error(this->ErrorMessage())).FromJust();
@@ -392,9 +457,10 @@ template <class GDALType> class GDALAsyncableJob {
   GDALRValFunc rval;
   Nan::Callback *progress;
 
-  GDALAsyncableJob(long ds_uid) : main(), rval(), progress(nullptr), persistent(), ds_uids({ds_uid}), autoIndex(0){};
+  GDALAsyncableJob(long ds_uid)
+    : main(), rval(), progress(nullptr), persistent(), ds_uids({ds_uid}), autoIndex(0), method(JobStats::current){};
   GDALAsyncableJob(std::vector<long> ds_uids)
-    : main(), rval(), progress(nullptr), persistent(), ds_uids(ds_uids), autoIndex(0){};
+    : main(), rval(), progress(nullptr), persistent(), ds_uids(ds_uids), autoIndex(0), method(JobStats::current){};
 
   inline void persist(const std::string &key, const v8::Local<v8::Object> &obj) {
     persistent[key] = obj;
@@ -419,41 +485,69 @@ template <class GDALType> class GDALAsyncableJob {
       if (progress) persist("progress_cb", progress->GetFunction());
       Nan::Callback *callback;
       NODE_ARG_CB(cb_arg, "callback", callback);
-      Nan::AsyncQueueWorker(new GDALCallbackWorker<GDALType>(callback, progress, main, rval, persistent, ds_uids));
+      // The abort flag belongs to this job only
+      const int32_t *abort = nullptr;
+      if (!pendingAbortFlag.IsEmpty()) {
+        v8::Local<v8::Int32Array> flag = Nan::New(pendingAbortFlag);
+        pendingAbortFlag.Reset();
+        persist("abort_flag", flag);
+        abort = *Nan::TypedArrayContents<int32_t>(flag);
+      }
+      Nan::AsyncQueueWorker(
+        new GDALCallbackWorker<GDALType>(callback, progress, abort, main, rval, persistent, ds_uids, method));
       return;
     }
-    try {
-      GDALExecutionProgress executionProgress(new GDALSyncExecutionProgress(progress));
-      AsyncGuard lock(ds_uids, eventLoopWarn);
-      GDALType obj = main(executionProgress);
-      // rval is the user function that will create the returned value
-      // we give it a lambda that can access the persistent storage created for this operation
-      info.GetReturnValue().Set(rval(obj, [this](const char *key) { return this->persistent[key]; }));
-    } catch (const char *err) { Nan::ThrowError(err); }
+    runSync(info);
   }
 
   void run(Nan::NAN_GETTER_ARGS_TYPE info, bool async) {
     if (!info.This().IsEmpty() && info.This()->IsObject()) persist("this", info.This());
     if (async) {
-      auto worker = new GDALPromiseWorker<GDALType>(info, main, rval, persistent, ds_uids);
+      auto worker = new GDALPromiseWorker<GDALType>(info, main, rval, persistent, ds_uids, method);
       info.GetReturnValue().Set(worker->Promise());
       Nan::AsyncQueueWorker(worker);
       return;
     }
+    runSync(info);
+  }
+
+    private:
+  std::map<std::string, v8::Local<v8::Object>> persistent;
+  const std::vector<long> ds_uids;
+  unsigned autoIndex;
+  const char *method;
+
+  template <typename INFO> void runSync(const INFO &info) {
+    JobTimings timings = {method, false, false, ds_uids, 0, 0, 0, 0, 0, 0};
+    JobClock::time_point start = JobClock::now(), locked = start, done = start;
+    const VSIStats::ThreadIO io = VSIStats::threadIO;
+    // The message of a GDAL error lives in a buffer that the hook could overwrite
+    std::string error;
+    bool failed = false;
     try {
-      GDALExecutionProgress executionProgress(new GDALSyncExecutionProgress(progress));
+      GDALExecutionProgress executionProgress(new GDALSyncExecutionProgress(progress), progress != nullptr);
       AsyncGuard lock(ds_uids, eventLoopWarn);
+      locked = JobClock::now();
       GDALType obj = main(executionProgress);
+      done = JobClock::now();
       // rval is the user function that will create the returned value
       // we give it a lambda that can access the persistent storage created for this operation
       info.GetReturnValue().Set(rval(obj, [this](const char *key) { return this->persistent[key]; }));
-    } catch (const char *err) { Nan::ThrowError(err); }
+    } catch (const char *err) {
+      error = err;
+      failed = true;
+    }
+    JobClock::time_point end = JobClock::now();
+    timings.error = failed;
+    timings.lock = JobStats::Elapsed(start, locked);
+    timings.exec = JobStats::Elapsed(locked, timings.error ? end : done);
+    timings.rval = timings.error ? 0 : JobStats::Elapsed(done, end);
+    timings.reads = static_cast<double>(VSIStats::threadIO.reads - io.reads);
+    timings.bytesRead = static_cast<double>(VSIStats::threadIO.bytesRead - io.bytesRead);
+    // The JS hook cannot be called with a pending exception
+    JobStats::Record(timings);
+    if (failed) Nan::ThrowError(error.c_str());
   }
-
-    private:
-  std::map<std::string, v8::Local<v8::Object>> persistent;
-  const std::vector<long> ds_uids;
-  unsigned autoIndex;
 };
 } // namespace node_gdal
 #endif
@@ -16,13 +16,13 @@ void ColorTable::Initialize(Local<Object> target) {
   lcons->InstanceTemplate()->SetInternalFieldCount(1);
   lcons->SetClassName(Nan::New("ColorTable").ToLocalChecked());
 
-  Nan::SetPrototypeMethod(lcons, "toString", toString);
-  Nan::SetPrototypeMethod(lcons, "isSame", isSame);
-  Nan::SetPrototypeMethod(lcons, "clone", clone);
-  Nan::SetPrototypeMethod(lcons, "count", count);
-  Nan::SetPrototypeMethod(lcons, "get", get);
-  Nan::SetPrototypeMethod(lcons, "set", set);
-  Nan::SetPrototypeMethod(lcons, "ramp", ramp);
+  Nan__SetPrototypeMethod(lcons, "toString", toString);
+  Nan__SetPrototypeMethod(lcons, "isSame", isSame);
+  Nan__SetPrototypeMethod(lcons, "clone", clone);
+  Nan__SetPrototypeMethod(lcons, "count", count);
+  Nan__SetPrototypeMethod(lcons, "get", get);
+  Nan__SetPrototypeMethod(lcons, "set", set);
+  Nan__SetPrototypeMethod(lcons, "ramp", ramp);
   ATTR(lcons, "interpretation", interpretationGetter, READ_ONLY_SETTER);
 
   ATTR_DONT_ENUM(lcons, "band", bandGetter, READ_ONLY_SETTER);
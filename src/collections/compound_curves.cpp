@@ -16,10 +16,10 @@ void CompoundCurveCurves::Initialize(Local<Object> target) {
   lcons->InstanceTemplate()->SetInternalFieldCount(1);
   lcons->SetClassName(Nan::New("CompoundCurveCurves").ToLocalChecked());
 
-  Nan::SetPrototypeMethod(lcons, "toString", toString);
-  Nan::SetPrototypeMethod(lcons, "count", count);
-  Nan::SetPrototypeMethod(lcons, "get", get);
-  Nan::SetPrototypeMethod(lcons, "add", add);
+  Nan__SetPrototypeMethod(lcons, "toString", toString);
+  Nan__SetPrototypeMethod(lcons, "count", count);
+  Nan__SetPrototypeMethod(lcons, "get", get);
+  Nan__SetPrototypeMethod(lcons, "add", add);
 
   Nan::Set(target, Nan::New("CompoundCurveCurves").ToLocalChecked(), Nan::GetFunction(lcons).ToLocalChecked());
 
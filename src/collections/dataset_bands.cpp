@@ -16,7 +16,7 @@ void DatasetBands::Initialize(Local<Object> target) {
   lcons->InstanceTemplate()->SetInternalFieldCount(1);
   lcons->SetClassName(Nan::New("DatasetBands").ToLocalChecked());
 
-  Nan::SetPrototypeMethod(lcons, "toString", toString);
+  Nan__SetPrototypeMethod(lcons, "toString", toString);
   Nan__SetPrototypeAsyncableMethod(lcons, "count", count);
   Nan__SetPrototypeAsyncableMethod(lcons, "create", create);
   Nan__SetPrototypeAsyncableMethod(lcons, "get", get);
@@ -17,7 +17,7 @@ void DatasetLayers::Initialize(Local<Object> target) {
   lcons->InstanceTemplate()->SetInternalFieldCount(1);
   lcons->SetClassName(Nan::New("DatasetLayers").ToLocalChecked());
 
-  Nan::SetPrototypeMethod(lcons, "toString", toString);
+  Nan__SetPrototypeMethod(lcons, "toString", toString);
   Nan__SetPrototypeAsyncableMethod(lcons, "count", count);
   Nan__SetPrototypeAsyncableMethod(lcons, "create", create);
   Nan__SetPrototypeAsyncableMethod(lcons, "copy", copy);
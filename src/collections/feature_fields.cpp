@@ -13,15 +13,15 @@ void FeatureFields::Initialize(Local<Object> target) {
   lcons->InstanceTemplate()->SetInternalFieldCount(1);
   lcons->SetClassName(Nan::New("FeatureFields").ToLocalChecked());
 
-  Nan::SetPrototypeMethod(lcons, "toString", toString);
-  Nan::SetPrototypeMethod(lcons, "toObject", toObject);
-  Nan::SetPrototypeMethod(lcons, "toArray", toArray);
-  Nan::SetPrototypeMethod(lcons, "count", count);
-  Nan::SetPrototypeMethod(lcons, "get", get);
-  Nan::SetPrototypeMethod(lcons, "getNames", getNames);
-  Nan::SetPrototypeMethod(lcons, "set", set);
-  Nan::SetPrototypeMethod(lcons, "reset", reset);
-  Nan::SetPrototypeMethod(lcons, "indexOf", indexOf);
+  Nan__SetPrototypeMethod(lcons, "toString", toString);
+  Nan__SetPrototypeMethod(lcons, "toObject", toObject);
+  Nan__SetPrototypeMethod(lcons, "toArray", toArray);
+  Nan__SetPrototypeMethod(lcons, "count", count);
+  Nan__SetPrototypeMethod(lcons, "get", get);
+  Nan__SetPrototypeMethod(lcons, "getNames", getNames);
+  Nan__SetPrototypeMethod(lcons, "set", set);
+  Nan__SetPrototypeMethod(lcons, "reset", reset);
+  Nan__SetPrototypeMethod(lcons, "indexOf", indexOf);
 
   ATTR_DONT_ENUM(lcons, "feature", featureGetter, READ_ONLY_SETTER);
 
@@ -13,10 +13,10 @@ void GDALDrivers::Initialize(Local<Object> target) {
   lcons->InstanceTemplate()->SetInternalFieldCount(1);
   lcons->SetClassName(Nan::New("GDALDrivers").ToLocalChecked());
 
-  Nan::SetPrototypeMethod(lcons, "toString", toString);
-  Nan::SetPrototypeMethod(lcons, "count", count);
-  Nan::SetPrototypeMethod(lcons, "get", get);
-  Nan::SetPrototypeMethod(lcons, "getNames", getNames);
+  Nan__SetPrototypeMethod(lcons, "toString", toString);
+  Nan__SetPrototypeMethod(lcons, "count", count);
+  Nan__SetPrototypeMethod(lcons, "get", get);
+  Nan__SetPrototypeMethod(lcons, "getNames", getNames);
 
   GDALAllRegister();
 
@@ -33,7 +33,7 @@ class GroupCollection : public Nan::ObjectWrap {
     lcons->InstanceTemplate()->SetInternalFieldCount(1);
     lcons->SetClassName(Nan::New(SELF::_className).ToLocalChecked());
 
-    Nan::SetPrototypeMethod(lcons, "toString", toString);
+    Nan__SetPrototypeMethod(lcons, "toString", toString);
     Nan__SetPrototypeAsyncableMethod(lcons, "count", count);
     Nan__SetPrototypeAsyncableMethod(lcons, "get", get);
 
@@ -14,7 +14,7 @@ void LayerFeatures::Initialize(Local<Object> target) {
   lcons->InstanceTemplate()->SetInternalFieldCount(1);
   lcons->SetClassName(Nan::New("LayerFeatures").ToLocalChecked());
 
-  Nan::SetPrototypeMethod(lcons, "toString", toString);
+  Nan__SetPrototypeMethod(lcons, "toString", toString);
   Nan__SetPrototypeAsyncableMethod(lcons, "count", count);
   Nan__SetPrototypeAsyncableMethod(lcons, "add", add);
   Nan__SetPrototypeAsyncableMethod(lcons, "get", get);
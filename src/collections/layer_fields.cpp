@@ -14,15 +14,15 @@ void LayerFields::Initialize(Local<Object> target) {
   lcons->InstanceTemplate()->SetInternalFieldCount(1);
   lcons->SetClassName(Nan::New("LayerFields").ToLocalChecked());
 
-  Nan::SetPrototypeMethod(lcons, "toString", toString);
-  Nan::SetPrototypeMethod(lcons, "count", count);
-  Nan::SetPrototypeMethod(lcons, "get", get);
-  Nan::SetPrototypeMethod(lcons, "remove", remove);
-  Nan::SetPrototypeMethod(lcons, "getNames", getNames);
-  Nan::SetPrototypeMethod(lcons, "indexOf", indexOf);
-  Nan::SetPrototypeMethod(lcons, "reorder", reorder);
-  Nan::SetPrototypeMethod(lcons, "add", add);
-  // Nan::SetPrototypeMethod(lcons, "alter", alter);
+  Nan__SetPrototypeMethod(lcons, "toString", toString);
+  Nan__SetPrototypeMethod(lcons, "count", count);
+  Nan__SetPrototypeMethod(lcons, "get", get);
+  Nan__SetPrototypeMethod(lcons, "remove", remove);
+  Nan__SetPrototypeMethod(lcons, "getNames", getNames);
+  Nan__SetPrototypeMethod(lcons, "indexOf", indexOf);
+  Nan__SetPrototypeMethod(lcons, "reorder", reorder);
+  Nan__SetPrototypeMethod(lcons, "add", add);
+  // Nan__SetPrototypeMethod(lcons, "alter", alter);
 
   ATTR_DONT_ENUM(lcons, "layer", layerGetter, READ_ONLY_SETTER);
 
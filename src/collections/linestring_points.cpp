@@ -15,13 +15,13 @@ void LineStringPoints::Initialize(Local<Object> target) {
   lcons->InstanceTemplate()->SetInternalFieldCount(1);
   lcons->SetClassName(Nan::New("LineStringPoints").ToLocalChecked());
 
-  Nan::SetPrototypeMethod(lcons, "toString", toString);
-  Nan::SetPrototypeMethod(lcons, "count", count);
-  Nan::SetPrototypeMethod(lcons, "get", get);
-  Nan::SetPrototypeMethod(lcons, "set", set);
-  Nan::SetPrototypeMethod(lcons, "add", add);
-  Nan::SetPrototypeMethod(lcons, "reverse", reverse);
-  Nan::SetPrototypeMethod(lcons, "resize", resize);
+  Nan__SetPrototypeMethod(lcons, "toString", toString);
+  Nan__SetPrototypeMethod(lcons, "count", count);
+  Nan__SetPrototypeMethod(lcons, "get", get);
+  Nan__SetPrototypeMethod(lcons, "set", set);
+  Nan__SetPrototypeMethod(lcons, "add", add);
+  Nan__SetPrototypeMethod(lcons, "reverse", reverse);
+  Nan__SetPrototypeMethod(lcons, "resize", resize);
 
   Nan::Set(target, Nan::New("LineStringPoints").ToLocalChecked(), Nan::GetFunction(lcons).ToLocalChecked());
 
@@ -13,7 +13,7 @@ void RasterBandOverviews::Initialize(Local<Object> target) {
   lcons->InstanceTemplate()->SetInternalFieldCount(1);
   lcons->SetClassName(Nan::New("RasterBandOverviews").ToLocalChecked());
 
-  Nan::SetPrototypeMethod(lcons, "toString", toString);
+  Nan__SetPrototypeMethod(lcons, "toString", toString);
   Nan__SetPrototypeAsyncableMethod(lcons, "count", count);
   Nan__SetPrototypeAsyncableMethod(lcons, "get", get);
   Nan__SetPrototypeAsyncableMethod(lcons, "getBySampleCount", getBySampleCount);
@@ -17,7 +17,7 @@ void RasterBandPixels::Initialize(Local<Object> target) {
   lcons->InstanceTemplate()->SetInternalFieldCount(1);
   lcons->SetClassName(Nan::New("RasterBandPixels").ToLocalChecked());
 
-  Nan::SetPrototypeMethod(lcons, "toString", toString);
+  Nan__SetPrototypeMethod(lcons, "toString", toString);
   Nan__SetPrototypeAsyncableMethod(lcons, "get", get);
   Nan__SetPrototypeAsyncableMethod(lcons, "set", set);
   Nan__SetPrototypeAsyncableMethod(lcons, "read", read);
@@ -25,6 +25,7 @@ void RasterBandPixels::Initialize(Local<Object> target) {
   Nan__SetPrototypeAsyncableMethod(lcons, "readBlock", readBlock);
   Nan__SetPrototypeAsyncableMethod(lcons, "writeBlock", writeBlock);
   Nan__SetPrototypeAsyncableMethod(lcons, "clampBlock", clampBlock);
+  Nan__SetPrototypeAsyncableMethod(lcons, "sample", sample);
 
   ATTR_DONT_ENUM(lcons, "band", bandGetter, READ_ONLY_SETTER);
 
@@ -50,6 +51,60 @@ RasterBand *RasterBandPixels::parent(const Nan::FunctionCallbackInfo<v8::Value>
   return band;
 }
 
+// Parses the (xs, ys, options) arguments of the sample methods,
+// the coordinates are copied as they are converted in place
+bool RasterBandPixels::parseSampleArgs(
+  const Nan::FunctionCallbackInfo<v8::Value> &info,
+  std::shared_ptr<std::vector<double>> &xs,
+  std::shared_ptr<std::vector<double>> &ys,
+  bool &geo,
+  SampleInterpolation &interpolation,
+  Local<Object> &options) {
+  if (info.Length() < 2 || !info[0]->IsFloat64Array() || !info[1]->IsFloat64Array()) {
+    Nan::ThrowTypeError("xs and ys must be Float64Arrays");
+    return false;
+  }
+  Nan::TypedArrayContents<double> x_data(info[0]);
+  Nan::TypedArrayContents<double> y_data(info[1]);
+  if (x_data.length() != y_data.length()) {
+    Nan::ThrowRangeError("xs and ys must have the same length");
+    return false;
+  }
+
+  std::string coords = "pixel";
+  std::string interpolation_name = "nearest";
+  if (info.Length() > 2 && !info[2]->IsUndefined() && !info[2]->IsNull()) {
+    if (!info[2]->IsObject()) {
+      Nan::ThrowTypeError("options must be an object");
+      return false;
+    }
+    options = info[2].As<Object>();
+    for (auto key : {std::make_pair("coords", &coords), std::make_pair("interpolation", &interpolation_name)}) {
+      Local<String> sym = Nan::New(key.first).ToLocalChecked();
+      if (!Nan::HasOwnProperty(options, sym).FromMaybe(false)) continue;
+      Local<Value> val = Nan::Get(options, sym).ToLocalChecked();
+      if (!val->IsString()) {
+        Nan::ThrowTypeError((std::string("Property \"") + key.first + "\" must be a string").c_str());
+        return false;
+      }
+      *key.second = *Nan::Utf8String(val);
+    }
+  }
+  if (coords != "pixel" && coords != "geo") {
+    Nan::ThrowError("coords must be pixel or geo");
+    return false;
+  }
+  geo = coords == "geo";
+  if (!ParseSampleInterpolation(interpolation_name, interpolation)) {
+    Nan::ThrowError("interpolation must be nearest, bilinear or cubic");
+    return false;
+  }
+
+  xs = std::make_shared<std::vector<double>>(*x_data, *x_data + x_data.length());
+  ys = std::make_shared<std::vector<double>>(*y_data, *y_data + y_data.length());
+  return true;
+}
+
 /**
  * A representation of a {@link RasterBand}'s pixels.
  *
@@ -271,6 +326,7 @@ static inline int64_t findHighest(int64_t w, int64_t h, int64_t px, int64_t ln,
  * @property {number} [line_space]
  * @property {string} [resampling]
  * @property {ProgressCb} [progress_cb]
+ * @property {AbortSignal} [signal]
  * @property {number} [offset]
  */
 
@@ -405,12 +461,12 @@ GDAL_ASYNCABLE_DEFINE(RasterBandPixels::read) {
   job.progress = cb;
 
   data = (uint8_t *)data + offset * bytes_per_pixel;
-  job.main = [gdal_band, x, y, w, h, data, buffer_w, buffer_h, type, pixel_space, line_space, resampling, cb](
+  job.main = [gdal_band, x, y, w, h, data, buffer_w, buffer_h, type, pixel_space, line_space, resampling](
                const GDALExecutionProgress &progress) {
     std::shared_ptr<GDALRasterIOExtraArg> extra(new GDALRasterIOExtraArg);
     INIT_RASTERIO_EXTRA_ARG(*extra);
     extra->eResampleAlg = resampling;
-    if (cb) {
+    if (progress.active()) {
       extra->pfnProgress = ProgressTrampoline;
       extra->pProgressData = (void *)&progress;
     }
@@ -435,6 +491,7 @@ GDAL_ASYNCABLE_DEFINE(RasterBandPixels::read) {
  * @property {number} [pixel_space]
  * @property {number} [line_space]
  * @property {ProgressCb} [progress_cb]
+ * @property {AbortSignal} [signal]
  * @property {number} [offset]
  */
 
@@ -543,11 +600,11 @@ GDAL_ASYNCABLE_DEFINE(RasterBandPixels::write) {
   }
 
   data = (uint8_t *)data + offset * bytes_per_pixel;
-  job.main = [gdal_band, x, y, w, h, data, buffer_w, buffer_h, type, pixel_space, line_space, cb](
+  job.main = [gdal_band, x, y, w, h, data, buffer_w, buffer_h, type, pixel_space, line_space](
                const GDALExecutionProgress &progress) {
     std::shared_ptr<GDALRasterIOExtraArg> extra(new GDALRasterIOExtraArg);
     INIT_RASTERIO_EXTRA_ARG(*extra);
-    if (cb) {
+    if (progress.active()) {
       extra->pfnProgress = ProgressTrampoline;
       extra->pProgressData = (void *)&progress;
     }
@@ -761,6 +818,96 @@ GDAL_ASYNCABLE_DEFINE(RasterBandPixels::clampBlock) {
   job.run(info, async, 2);
 }
 
+/**
+ * @typedef {object} SampleOptions
+ * @property {string} [coords]
+ * @property {string} [interpolation]
+ */
+
+/**
+ * Returns the values at many points in one call.
+ *
+ * The points are sorted by the block that contains them and each
+ * block is read only once, which is much faster than calling
+ * {@link RasterBandPixels.get} for each point.
+ *
+ * The points outside the raster and the `noData` pixels produce `NaN`.
+ * `bilinear` and `cubic` fall back to the nearest pixel when a pixel
+ * of their kernel is `noData`.
+ *
+ * @example
+ * const elevations = band.pixels.sample(lons, lats, { coords: 'geo', interpolation: 'bilinear' })
+ *
+ * @method sample
+ * @instance
+ * @memberof RasterBandPixels
+ * @throws {Error}
+ * @param {Float64Array} xs
+ * @param {Float64Array} ys
+ * @param {SampleOptions} [options]
+ * @param {string} [options.coords="pixel"] `pixel` for pixel/line coordinates or `geo` for coordinates in the spatial reference system of the dataset
+ * @param {string} [options.interpolation="nearest"] `nearest`, `bilinear` or `cubic`
+ * @return {Float64Array}
+ */
+
+/**
+ * Returns the values at many points in one call.
+ * @async
+ *
+ * The points are sorted by the block that contains them and each
+ * block is read only once, which is much faster than calling
+ * {@link RasterBandPixels.getAsync} for each point.
+ *
+ * The points outside the raster and the `noData` pixels produce `NaN`.
+ * `bilinear` and `cubic` fall back to the nearest pixel when a pixel
+ * of their kernel is `noData`.
+ *
+ * @method sampleAsync
+ * @instance
+ * @memberof RasterBandPixels
+ * @throws {Error}
+ * @param {Float64Array} xs
+ * @param {Float64Array} ys
+ * @param {SampleOptions} [options]
+ * @param {string} [options.coords="pixel"] `pixel` for pixel/line coordinates or `geo` for coordinates in the spatial reference system of the dataset
+ * @param {string} [options.interpolation="nearest"] `nearest`, `bilinear` or `cubic`
+ * @param {callback<Float64Array>} [callback=undefined]
+ * @return {Promise<Float64Array>}
+ */
+GDAL_ASYNCABLE_DEFINE(RasterBandPixels::sample) {
+  RasterBand *band;
+  if ((band = parent(info)) == nullptr) return;
+
+  std::shared_ptr<std::vector<double>> xs, ys;
+  bool geo;
+  SampleInterpolation interpolation;
+  Local<Object> options;
+  if (!parseSampleArgs(info, xs, ys, geo, interpolation, options)) return;
+
+  GDALRasterBand *gdal_band = band->get();
+  size_t n = xs->size();
+
+  Local<Value> array = TypedArray::New(GDT_Float64, n);
+  if (array.IsEmpty() || !array->IsObject()) {
+    return; // TypedArray::New threw an error
+  }
+  double *data = *Nan::TypedArrayContents<double>(array);
+
+  GDALAsyncableJob<int> job(band->parent_uid);
+  job.persist("array", array.As<Object>());
+  job.persist(band->handle());
+  job.main = [gdal_band, xs, ys, n, geo, interpolation, data](const GDALExecutionProgress &) {
+    if (geo) {
+      if (gdal_band->GetDataset() == nullptr) throw "The band does not belong to a dataset";
+      GeoToPixel(gdal_band->GetDataset(), xs->data(), ys->data(), n);
+    }
+    SampleBands({gdal_band}, xs->data(), ys->data(), n, interpolation, data);
+    return 0;
+  };
+  job.rval = [](int, const GetFromPersistentFunc &getter) { return getter("array"); };
+  job.run(info, async, 3);
+}
+
 /**
  * Returns the parent raster band.
  *
@@ -13,6 +13,10 @@
 
 #include "../gdal_rasterband.hpp"
 #include "../async.hpp"
+#include "../utils/raster_sampler.hpp"
+
+#include <memory>
+#include <vector>
 
 using namespace v8;
 using namespace node;
@@ -35,10 +39,18 @@ class RasterBandPixels : public Nan::ObjectWrap {
   GDAL_ASYNCABLE_DECLARE(readBlock);
   GDAL_ASYNCABLE_DECLARE(writeBlock);
   GDAL_ASYNCABLE_DECLARE(clampBlock);
+  GDAL_ASYNCABLE_DECLARE(sample);
 
   static NAN_GETTER(bandGetter);
 
   static RasterBand *parent(const Nan::FunctionCallbackInfo<v8::Value> &info);
+  static bool parseSampleArgs(
+    const Nan::FunctionCallbackInfo<v8::Value> &info,
+    std::shared_ptr<std::vector<double>> &xs,
+    std::shared_ptr<std::vector<double>> &ys,
+    bool &geo,
+    SampleInterpolation &interpolation,
+    Local<Object> &options);
 
   RasterBandPixels();
 
@@ -3,11 +3,26 @@
 #include "gdal_dataset.hpp"
 #include "gdal_layer.hpp"
 #include "gdal_rasterband.hpp"
+#include "geometry/gdal_geometry.hpp"
+#include "utils/expression.hpp"
 #include "utils/number_list.hpp"
+#include "utils/parallel.hpp"
+#include "utils/pixel_functions.hpp"
 #include "utils/typed_array.hpp"
+#include "utils/zonal_stats.hpp"
 
 #include "node_gdal.h"
 
+#include <cpl_quad_tree.h>
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <deque>
+#include <limits>
+#include <map>
+#include <memory>
+#include <mutex>
+
 namespace node_gdal {
 
 void Algorithms::Initialize(Local<Object> target) {
@@ -16,9 +31,15 @@ void Algorithms::Initialize(Local<Object> target) {
   Nan__SetAsyncableMethod(target, "sieveFilter", sieveFilter);
   Nan__SetAsyncableMethod(target, "checksumImage", checksumImage);
   Nan__SetAsyncableMethod(target, "polygonize", polygonize);
-  Nan::SetMethod(target, "addPixelFunc", addPixelFunc);
-  Nan::SetMethod(target, "toPixelFunc", toPixelFunc);
+  Nan__SetAsyncableMethod(target, "spatialJoin", spatialJoin);
+  Nan__SetAsyncableMethod(target, "zonalStats", zonalStats);
+  Nan__SetAsyncableMethod(target, "calcExpr", calcExpr);
+  Nan__SetAsyncableMethod(target, "_processTiles", _processTiles);
+  Nan__SetMethod(target, "addPixelFunc", addPixelFunc);
+  Nan__SetMethod(target, "toPixelFunc", toPixelFunc);
   Nan__SetAsyncableMethod(target, "_acquireLocks", _acquireLocks);
+
+  RegisterPixelFunctions();
 }
 
 /**
@@ -102,6 +123,7 @@ GDAL_ASYNCABLE_DEFINE(Algorithms::fillNodata) {
  * @property {number} [idField]
  * @property {number} [elevField]
  * @property {ProgressCb} [progress_cb]
+ * @property {AbortSignal} [signal]
  */
 
 /**
@@ -210,8 +232,7 @@ GDAL_ASYNCABLE_DEFINE(Algorithms::contourGenerate) {
               nodata,
               gdal_dst,
               id_field,
-              elev_field,
-              progress_cb](const GDALExecutionProgress &progress) {
+              elev_field](const GDALExecutionProgress &progress) {
     CPLErrorReset();
     CPLErr err = GDALContourGenerate(
       gdal_src,
@@ -224,8 +245,8 @@ GDAL_ASYNCABLE_DEFINE(Algorithms::contourGenerate) {
       gdal_dst,
       id_field,
       elev_field,
-      progress_cb ? ProgressTrampoline : nullptr,
-      progress_cb ? (void *)&progress : nullptr);
+      progress.active() ? ProgressTrampoline : nullptr,
+      progress.active() ? (void *)&progress : nullptr);
     if (err) { throw CPLGetLastErrorMsg(); }
     return err;
   };
@@ -241,6 +262,7 @@ GDAL_ASYNCABLE_DEFINE(Algorithms::contourGenerate) {
  * @property {number} threshold
  * @property {number} [connectedness]
  * @property {ProgressCb} [progress_cb]
+ * @property {AbortSignal} [signal]
  */
 
 /**
@@ -307,21 +329,20 @@ GDAL_ASYNCABLE_DEFINE(Algorithms::sieveFilter) {
 
   GDALAsyncableJob<CPLErr> job(ds_uids);
   job.progress = progress_cb;
-  job.main =
-    [gdal_src, gdal_dst, gdal_mask, threshold, connectedness, progress_cb](const GDALExecutionProgress &progress) {
-      CPLErrorReset();
-      CPLErr err = GDALSieveFilter(
-        gdal_src,
-        gdal_mask,
-        gdal_dst,
-        threshold,
-        connectedness,
-        NULL,
-        progress_cb ? ProgressTrampoline : nullptr,
-        progress_cb ? (void *)&progress : nullptr);
-      if (err) { throw CPLGetLastErrorMsg(); }
-      return err;
-    };
+  job.main = [gdal_src, gdal_dst, gdal_mask, threshold, connectedness](const GDALExecutionProgress &progress) {
+    CPLErrorReset();
+    CPLErr err = GDALSieveFilter(
+      gdal_src,
+      gdal_mask,
+      gdal_dst,
+      threshold,
+      connectedness,
+      NULL,
+      progress.active() ? ProgressTrampoline : nullptr,
+      progress.active() ? (void *)&progress : nullptr);
+    if (err) { throw CPLGetLastErrorMsg(); }
+    return err;
+  };
   job.rval = [](CPLErr r, const GetFromPersistentFunc &) { return Nan::Undefined().As<Value>(); };
   job.run(info, async, 1);
 }
@@ -407,6 +428,7 @@ GDAL_ASYNCABLE_DEFINE(Algorithms::checksumImage) {
  * @property {number} [connectedness=4] Either 4 indicating that diagonal pixels are not considered directly adjacent for polygon membership purposes or 8 indicating they are.
  * @property {boolean} [useFloats=false] Use floating point buffers instead of int buffers.
  * @property {ProgressCb} [progress_cb]
+ * @property {AbortSignal} [signal]
  */
 
 /**
@@ -488,42 +510,1086 @@ GDAL_ASYNCABLE_DEFINE(Algorithms::polygonize) {
   if (
     Nan::HasOwnProperty(obj, Nan::New("useFloats").ToLocalChecked()).FromMaybe(false) &&
     Nan::To<bool>(Nan::Get(obj, Nan::New("useFloats").ToLocalChecked()).ToLocalChecked()).ToChecked()) {
-    job.main =
-      [gdal_src, gdal_mask, gdal_dst, pix_val_field, papszOptions, progress_cb](const GDALExecutionProgress &progress) {
-        CPLErrorReset();
-        CPLErr err = GDALFPolygonize(
-          gdal_src,
-          gdal_mask,
-          reinterpret_cast<OGRLayerH>(gdal_dst),
-          pix_val_field,
-          papszOptions,
-          progress_cb ? ProgressTrampoline : nullptr,
-          progress_cb ? (void *)&progress : nullptr);
-        if (papszOptions) CSLDestroy(papszOptions);
-        if (err) throw CPLGetLastErrorMsg();
-        return err;
-      };
+    job.main = [gdal_src, gdal_mask, gdal_dst, pix_val_field, papszOptions](const GDALExecutionProgress &progress) {
+      CPLErrorReset();
+      CPLErr err = GDALFPolygonize(
+        gdal_src,
+        gdal_mask,
+        reinterpret_cast<OGRLayerH>(gdal_dst),
+        pix_val_field,
+        papszOptions,
+        progress.active() ? ProgressTrampoline : nullptr,
+        progress.active() ? (void *)&progress : nullptr);
+      if (papszOptions) CSLDestroy(papszOptions);
+      if (err) throw CPLGetLastErrorMsg();
+      return err;
+    };
   } else {
-    job.main =
-      [gdal_src, gdal_mask, gdal_dst, pix_val_field, papszOptions, progress_cb](const GDALExecutionProgress &progress) {
-        CPLErrorReset();
-        CPLErr err = GDALPolygonize(
-          gdal_src,
-          gdal_mask,
-          reinterpret_cast<OGRLayerH>(gdal_dst),
-          pix_val_field,
-          papszOptions,
-          progress_cb ? ProgressTrampoline : nullptr,
-          progress_cb ? (void *)&progress : nullptr);
-        if (papszOptions) CSLDestroy(papszOptions);
-        if (err) throw CPLGetLastErrorMsg();
-        return err;
-      };
+    job.main = [gdal_src, gdal_mask, gdal_dst, pix_val_field, papszOptions](const GDALExecutionProgress &progress) {
+      CPLErrorReset();
+      CPLErr err = GDALPolygonize(
+        gdal_src,
+        gdal_mask,
+        reinterpret_cast<OGRLayerH>(gdal_dst),
+        pix_val_field,
+        papszOptions,
+        progress.active() ? ProgressTrampoline : nullptr,
+        progress.active() ? (void *)&progress : nullptr);
+      if (papszOptions) CSLDestroy(papszOptions);
+      if (err) throw CPLGetLastErrorMsg();
+      return err;
+    };
   }
   job.rval = [](CPLErr r, const GetFromPersistentFunc &) { return Nan::Undefined().As<Value>(); };
   job.run(info, async, 1);
 }
 
+/**
+ * @typedef {object} SpatialJoinOptions
+ * @property {string} [predicate]
+ * @property {number} [distance]
+ * @property {Layer} [outputLayer]
+ * @property {string[]} [fields]
+ * @property {ProgressCb} [progress_cb]
+ * @property {AbortSignal} [signal]
+ */
+
+/**
+ * @typedef {object} SpatialJoinResult
+ * @property {number} count
+ * @property {number[]} [left]
+ * @property {number[]} [right]
+ */
+
+/**
+ * Joins the features of two layers on a spatial predicate.
+ *
+ * The left layer is read in memory and indexed, the right layer is streamed
+ * in batches which are tested on `GDAL_NUM_THREADS` threads using prepared geometries.
+ * Both layers are read from the start, honoring their spatial and attribute filters.
+ *
+ * The predicate is relative to the left feature: `within` matches the left features
+ * that are within a right feature.
+ *
+ * When `outputLayer` is given, a feature is created in it for each matching pair,
+ * with the geometry of the left feature, the fields of the left feature
+ * and the `fields` of the right feature, all matched by name,
+ * otherwise the feature ids of the matching pairs are returned.
+ *
+ * @example
+ * // attach the name of the district to each point
+ * await gdal.spatialJoinAsync(points, districts, {
+ *   predicate: 'within',
+ *   outputLayer: output,
+ *   fields: [ 'name' ]
+ * })
+ *
+ * @throws {Error}
+ * @method spatialJoin
+ * @static
+ * @param {Layer} left
+ * @param {Layer} right
+ * @param {SpatialJoinOptions} [options]
+ * @param {string} [options.predicate="intersects"] One of `intersects`, `within`, `contains` or `dwithin`
+ * @param {number} [options.distance=0] The distance for `dwithin`
+ * @param {Layer} [options.outputLayer] The layer receiving the joined features
+ * @param {string[]} [options.fields] The fields of the right layer to copy to the output layer
+ * @param {ProgressCb} [options.progress_cb]
+ * @return {SpatialJoinResult}
+ */
+
+/**
+ * Joins the features of two layers on a spatial predicate.
+ * @async
+ *
+ * The left layer is read in memory and indexed, the right layer is streamed
+ * in batches which are tested on `GDAL_NUM_THREADS` threads using prepared geometries.
+ * Both layers are read from the start, honoring their spatial and attribute filters.
+ *
+ * The predicate is relative to the left feature: `within` matches the left features
+ * that are within a right feature.
+ *
+ * When `outputLayer` is given, a feature is created in it for each matching pair,
+ * with the geometry of the left feature, the fields of the left feature
+ * and the `fields` of the right feature, all matched by name,
+ * otherwise the feature ids of the matching pairs are returned.
+ *
+ * @throws {Error}
+ * @method spatialJoinAsync
+ * @static
+ * @param {Layer} left
+ * @param {Layer} right
+ * @param {SpatialJoinOptions} [options]
+ * @param {string} [options.predicate="intersects"] One of `intersects`, `within`, `contains` or `dwithin`
+ * @param {number} [options.distance=0] The distance for `dwithin`
+ * @param {Layer} [options.outputLayer] The layer receiving the joined features
+ * @param {string[]} [options.fields] The fields of the right layer to copy to the output layer
+ * @param {ProgressCb} [options.progress_cb]
+ * @param {callback<SpatialJoinResult>} [callback=undefined]
+ * @return {Promise<SpatialJoinResult>}
+ */
+
+enum SpatialJoinPredicate { JoinIntersects, JoinWithin, JoinContains, JoinDWithin };
+
+struct SpatialJoinResult {
+  GIntBig count;
+  bool fids;
+  std::vector<GIntBig> left;
+  std::vector<GIntBig> right;
+};
+
+struct SpatialJoinEntry {
+  OGREnvelope envelope;
+  size_t idx;
+};
+
+static void spatialJoinBounds(const void *entry, CPLRectObj *bounds) {
+  const OGREnvelope &env = static_cast<const SpatialJoinEntry *>(entry)->envelope;
+  bounds->minx = env.MinX;
+  bounds->miny = env.MinY;
+  bounds->maxx = env.MaxX;
+  bounds->maxy = env.MaxY;
+}
+
+struct SpatialJoinIndex {
+  CPLQuadTree *tree;
+  SpatialJoinIndex() : tree(nullptr) {
+  }
+  ~SpatialJoinIndex() {
+    if (tree != nullptr) CPLQuadTreeDestroy(tree);
+  }
+};
+
+// Copies the field of src at src_idx into the field dst_idx of dst
+static void spatialJoinCopyField(OGRFeature *dst, int dst_idx, OGRFeature *src, int src_idx) {
+  if (!src->IsFieldSetAndNotNull(src_idx)) return;
+  if (dst->GetFieldDefnRef(dst_idx)->GetType() == src->GetFieldDefnRef(src_idx)->GetType()) {
+    dst->SetField(dst_idx, src->GetRawFieldRef(src_idx));
+  } else {
+    dst->SetField(dst_idx, src->GetFieldAsString(src_idx));
+  }
+}
+
+GDAL_ASYNCABLE_DEFINE(Algorithms::spatialJoin) {
+  Layer *left, *right;
+  Layer *output = nullptr;
+  Local<Object> obj;
+  Local<Array> fields_array;
+  std::string predicate_name = "intersects";
+  double distance = 0;
+  Nan::Callback *progress_cb = nullptr;
+
+  NODE_ARG_WRAPPED(0, "left", Layer, left);
+  NODE_ARG_WRAPPED(1, "right", Layer, right);
+  NODE_ARG_OBJECT_OPT(2, "options", obj);
+
+  if (!obj.IsEmpty()) {
+    NODE_STR_FROM_OBJ_OPT(obj, "predicate", predicate_name);
+    NODE_DOUBLE_FROM_OBJ_OPT(obj, "distance", distance);
+    NODE_WRAPPED_FROM_OBJ_OPT(obj, "outputLayer", Layer, output);
+    NODE_ARRAY_FROM_OBJ_OPT(obj, "fields", fields_array);
+    NODE_CB_FROM_OBJ_OPT(obj, "progress_cb", progress_cb);
+  }
+
+  SpatialJoinPredicate predicate;
+  if (predicate_name == "intersects") {
+    predicate = JoinIntersects;
+  } else if (predicate_name == "within") {
+    predicate = JoinWithin;
+  } else if (predicate_name == "contains") {
+    predicate = JoinContains;
+  } else if (predicate_name == "dwithin") {
+    predicate = JoinDWithin;
+  } else {
+    Nan::ThrowError("predicate must be one of intersects, within, contains or dwithin");
+    return;
+  }
+  if (distance < 0) {
+    Nan::ThrowRangeError("distance must be positive");
+    return;
+  }
+
+  std::shared_ptr<std::vector<std::string>> fields = std::make_shared<std::vector<std::string>>();
+  if (!fields_array.IsEmpty()) {
+    for (unsigned i = 0; i < fields_array->Length(); i++) {
+      Local<Value> name = Nan::Get(fields_array, i).ToLocalChecked();
+      if (!name->IsString()) {
+        Nan::ThrowTypeError("fields must be an array of strings");
+        return;
+      }
+      fields->push_back(*Nan::Utf8String(name));
+    }
+  }
+
+  OGRLayer *gdal_left = left->get();
+  OGRLayer *gdal_right = right->get();
+  OGRLayer *gdal_output = output ? output->get() : nullptr;
+  if (gdal_output != nullptr && (gdal_output == gdal_left || gdal_output == gdal_right)) {
+    Nan::ThrowError("outputLayer must be different from the joined layers");
+    return;
+  }
+
+  std::vector<long> ds_uids = {left->parent_uid, right->parent_uid};
+  if (output) ds_uids.push_back(output->parent_uid);
+
+  GDALAsyncableJob<SpatialJoinResult *> job(ds_uids);
+  job.persist(left->handle());
+  job.persist(right->handle());
+  if (output) job.persist(output->handle());
+  job.progress = progress_cb;
+  job.main = [gdal_left, gdal_right, gdal_output, predicate, distance, fields, progress_cb](
+               const GDALExecutionProgress &progress) {
+    std::unique_ptr<SpatialJoinResult> r(new SpatialJoinResult);
+    r->count = 0;
+    r->fids = gdal_output == nullptr;
+
+    // Map the fields of the output layer to the fields of the joined layers
+    std::vector<int> from_left, from_right;
+    if (gdal_output != nullptr) {
+      OGRFeatureDefn *left_defn = gdal_left->GetLayerDefn();
+      OGRFeatureDefn *right_defn = gdal_right->GetLayerDefn();
+      OGRFeatureDefn *output_defn = gdal_output->GetLayerDefn();
+      for (const std::string &name : *fields) {
+        if (right_defn->GetFieldIndex(name.c_str()) < 0) {
+          CPLError(CE_Failure, CPLE_AppDefined, "Field \"%s\" does not exist in the right layer", name.c_str());
+          throw CPLGetLastErrorMsg();
+        }
+      }
+      for (int i = 0; i < output_defn->GetFieldCount(); i++) {
+        const char *name = output_defn->GetFieldDefn(i)->GetNameRef();
+        bool requested = std::find(fields->begin(), fields->end(), std::string(name)) != fields->end();
+        from_right.push_back(requested ? right_defn->GetFieldIndex(name) : -1);
+        from_left.push_back(requested ? -1 : left_defn->GetFieldIndex(name));
+      }
+    }
+
+    // Read and index the left layer
+    CPLErrorReset();
+    std::vector<OGRFeatureUniquePtr> left_features;
+    std::vector<SpatialJoinEntry> entries;
+    OGREnvelope extent;
+    gdal_left->ResetReading();
+    OGRFeature *feature;
+    while ((feature = gdal_left->GetNextFeature()) != nullptr) {
+      left_features.emplace_back(feature);
+      OGRGeometry *geom = feature->GetGeometryRef();
+      if (geom == nullptr || geom->IsEmpty()) continue;
+      SpatialJoinEntry entry;
+      geom->getEnvelope(&entry.envelope);
+      entry.idx = left_features.size() - 1;
+      extent.Merge(entry.envelope);
+      entries.push_back(entry);
+    }
+    if (CPLGetLastErrorType() == CE_Failure) throw CPLGetLastErrorMsg();
+    if (entries.size() == 0) return r.release();
+
+    SpatialJoinIndex index;
+    CPLRectObj bounds = {extent.MinX, extent.MinY, extent.MaxX, extent.MaxY};
+    index.tree = CPLQuadTreeCreate(&bounds, spatialJoinBounds);
+    for (SpatialJoinEntry &entry : entries) CPLQuadTreeInsert(index.tree, &entry);
+
+    // Stream the right layer in batches
+    const int max_threads = GetNumThreads(std::numeric_limits<size_t>::max());
+    const size_t batch_size = 1024 * static_cast<size_t>(max_threads);
+    const bool prepared = OGRHasPreparedGeometrySupport();
+    GIntBig total = progress_cb ? gdal_right->GetFeatureCount(FALSE) : -1;
+    GIntBig done = 0;
+
+    std::vector<OGRFeatureUniquePtr> batch;
+    std::vector<std::vector<size_t>> matches;
+    bool eof = false;
+    gdal_right->ResetReading();
+    while (!eof) {
+      batch.clear();
+      while (batch.size() < batch_size) {
+        feature = gdal_right->GetNextFeature();
+        if (feature == nullptr) {
+          eof = true;
+          break;
+        }
+        batch.emplace_back(feature);
+      }
+      if (CPLGetLastErrorType() == CE_Failure) throw CPLGetLastErrorMsg();
+
+      size_t n = batch.size();
+      matches.assign(n, std::vector<size_t>());
+      int threads = GetNumThreads(n, max_threads);
+      size_t grain = std::max<size_t>(1, n / (static_cast<size_t>(threads) * 8));
+      ParallelFor(n, threads, grain, [&](size_t begin, size_t end, int) {
+        for (size_t i = begin; i < end; i++) {
+          OGRGeometry *geom = batch[i]->GetGeometryRef();
+          if (geom == nullptr || geom->IsEmpty()) continue;
+
+          OGREnvelope env;
+          geom->getEnvelope(&env);
+          CPLRectObj query = {env.MinX - distance, env.MinY - distance, env.MaxX + distance, env.MaxY + distance};
+          int found = 0;
+          void **candidates = CPLQuadTreeSearch(index.tree, &query, &found);
+
+          // Preparing pays off only when there are several candidates
+          OGRPreparedGeometryUniquePtr prep;
+          if (prepared && found > 1 && (predicate == JoinIntersects || predicate == JoinWithin))
+            prep.reset(OGRCreatePreparedGeometry(OGRGeometry::ToHandle(geom)));
+
+          for (int j = 0; j < found; j++) {
+            size_t idx = static_cast<SpatialJoinEntry *>(candidates[j])->idx;
+            OGRGeometry *left_geom = left_features[idx]->GetGeometryRef();
+            bool match;
+            switch (predicate) {
+              case JoinIntersects:
+                match = prep ? OGRPreparedGeometryIntersects(prep.get(), OGRGeometry::ToHandle(left_geom))
+                             : geom->Intersects(left_geom);
+                break;
+              case JoinWithin:
+                match = prep ? OGRPreparedGeometryContains(prep.get(), OGRGeometry::ToHandle(left_geom))
+                             : geom->Contains(left_geom);
+                break;
+              case JoinContains: match = left_geom->Contains(geom); break;
+              default: match = left_geom->Distance(geom) <= distance; break;
+            }
+            if (match) matches[i].push_back(idx);
+          }
+          CPLFree(candidates);
+          std::sort(matches[i].begin(), matches[i].end());
+        }
+      });
+
+      // Write the results in the order of the right layer
+      for (size_t i = 0; i < n; i++) {
+        for (size_t idx : matches[i]) {
+          OGRFeature *left_feature = left_features[idx].get();
+          r->count++;
+          if (gdal_output == nullptr) {
+            r->left.push_back(left_feature->GetFID());
+            r->right.push_back(batch[i]->GetFID());
+            continue;
+          }
+          OGRFeatureUniquePtr out(new OGRFeature(gdal_output->GetLayerDefn()));
+          out->SetGeometry(left_feature->GetGeometryRef());
+          for (int f = 0; f < static_cast<int>(from_left.size()); f++) {
+            if (from_left[f] >= 0) spatialJoinCopyField(out.get(), f, left_feature, from_left[f]);
+            if (from_right[f] >= 0) spatialJoinCopyField(out.get(), f, batch[i].get(), from_right[f]);
+          }
+          OGRErr err = gdal_output->CreateFeature(out.get());
+          if (err) throw getOGRErrMsg(err);
+        }
+      }
+
+      done += n;
+      if (total > 0) ProgressTrampoline(std::min(1.0, static_cast<double>(done) / total), "", (void *)&progress);
+      if (progress.aborted()) throw abortedMessage;
+    }
+
+    return r.release();
+  };
+  job.rval = [](SpatialJoinResult *r, const GetFromPersistentFunc &) {
+    Nan::EscapableHandleScope scope;
+    std::unique_ptr<SpatialJoinResult> result(r);
+
+    Local<Object> obj = Nan::New<Object>();
+    Nan::Set(obj, Nan::New("count").ToLocalChecked(), Nan::New<Number>(static_cast<double>(r->count)));
+    if (r->fids) {
+      Local<Array> left = Nan::New<Array>(r->left.size());
+      Local<Array> right = Nan::New<Array>(r->right.size());
+      for (size_t i = 0; i < r->left.size(); i++) {
+        Nan::Set(left, i, Nan::New<Number>(static_cast<double>(r->left[i])));
+        Nan::Set(right, i, Nan::New<Number>(static_cast<double>(r->right[i])));
+      }
+      Nan::Set(obj, Nan::New("left").ToLocalChecked(), left);
+      Nan::Set(obj, Nan::New("right").ToLocalChecked(), right);
+    }
+    return scope.Escape(obj).As<Value>();
+  };
+  job.run(info, async, 3);
+}
+
+/**
+ * @typedef {object} ZonalStatsOptions
+ * @property {string[]} [stats]
+ * @property {boolean} [allTouched]
+ * @property {RasterBand} [weights]
+ * @property {ZonalStatsHistogram} [histogram]
+ * @property {number} [concurrency]
+ * @property {ProgressCb} [progress_cb]
+ * @property {AbortSignal} [signal]
+ */
+
+/**
+ * @typedef {object} ZonalStatsHistogram
+ * @property {number} min
+ * @property {number} max
+ * @property {number} [bins]
+ */
+
+/**
+ * @typedef {object} ZonalStats
+ * @property {number} [fid]
+ * @property {number} [count]
+ * @property {number|null} [sum]
+ * @property {number|null} [mean]
+ * @property {number|null} [min]
+ * @property {number|null} [max]
+ * @property {number|null} [stddev]
+ * @property {number[]} [histogram]
+ */
+
+/**
+ * Computes statistics of a raster band over each zone of a layer or of an array of geometries.
+ *
+ * Only the window of the envelope of each zone is read, a mask is burned by scanline
+ * in this window and the masked pixels are reduced. The zones are processed in parallel
+ * on `GDAL_NUM_THREADS` threads that share the block cache.
+ *
+ * A pixel belongs to a zone when its center is inside the zone, or, with `allTouched`,
+ * when it is touched by the zone. The pixels that are `noData` or `NaN` are ignored.
+ * Lines and points zones always include all the pixels they touch.
+ *
+ * The zones must be in the spatial reference system of the raster.
+ *
+ * With `weights`, `sum`, `mean` and `stddev` are weighted by the pixels of this band,
+ * which must have the size of the raster band.
+ *
+ * `histogram` counts the values in `bins` buckets of equal width between `min` and `max`,
+ * the values outside this range are not counted.
+ *
+ * The statistics of a zone without any valid pixel are `null`, except `count` and `histogram`.
+ * When the zones come from a layer, each result has the `fid` of its feature.
+ *
+ * @example
+ * // the average elevation of each district
+ * const stats = await gdal.zonalStatsAsync(dem.bands.get(1), districts, {
+ *   stats: [ 'mean', 'max' ]
+ * })
+ *
+ * @throws {Error}
+ * @method zonalStats
+ * @static
+ * @param {RasterBand} band
+ * @param {Layer|Geometry[]} zones
+ * @param {ZonalStatsOptions} [options]
+ * @param {string[]} [options.stats=["count","mean","min","max"]] Any of `count`, `sum`, `mean`, `min`, `max`, `stddev` and `histogram`
+ * @param {boolean} [options.allTouched=false]
+ * @param {RasterBand} [options.weights]
+ * @param {ZonalStatsHistogram} [options.histogram] Required for the `histogram` statistic
+ * @param {number} [options.concurrency=0] Number of threads, `0` for `GDAL_NUM_THREADS`
+ * @param {ProgressCb} [options.progress_cb]
+ * @return {ZonalStats[]}
+ */
+
+/**
+ * Computes statistics of a raster band over each zone of a layer or of an array of geometries.
+ * @async
+ *
+ * Only the window of the envelope of each zone is read, a mask is burned by scanline
+ * in this window and the masked pixels are reduced. The zones are processed in parallel
+ * on `GDAL_NUM_THREADS` threads that share the block cache.
+ *
+ * See {@link zonalStats} for the details.
+ *
+ * @throws {Error}
+ * @method zonalStatsAsync
+ * @static
+ * @param {RasterBand} band
+ * @param {Layer|Geometry[]} zones
+ * @param {ZonalStatsOptions} [options]
+ * @param {string[]} [options.stats=["count","mean","min","max"]] Any of `count`, `sum`, `mean`, `min`, `max`, `stddev` and `histogram`
+ * @param {boolean} [options.allTouched=false]
+ * @param {RasterBand} [options.weights]
+ * @param {ZonalStatsHistogram} [options.histogram] Required for the `histogram` statistic
+ * @param {number} [options.concurrency=0] Number of threads, `0` for `GDAL_NUM_THREADS`
+ * @param {ProgressCb} [options.progress_cb]
+ * @param {callback<ZonalStats[]>} [callback=undefined]
+ * @return {Promise<ZonalStats[]>}
+ */
+
+enum ZonalStat { ZonalCount, ZonalSum, ZonalMean, ZonalMin, ZonalMax, ZonalStdDev, ZonalHistogram };
+
+struct ZonalStatsJobResult {
+  std::vector<ZonalStatsResult> stats;
+  std::vector<GIntBig> fids;
+};
+
+GDAL_ASYNCABLE_DEFINE(Algorithms::zonalStats) {
+  RasterBand *band;
+  RasterBand *weights = nullptr;
+  Layer *layer = nullptr;
+  Local<Object> obj;
+  Local<Array> stats_array;
+  Local<Object> hist_obj;
+  ZonalStatsOptions options = {false, 0, 0, 0, 0};
+  Nan::Callback *progress_cb = nullptr;
+
+  NODE_ARG_WRAPPED(0, "band", RasterBand, band);
+  NODE_ARG_OBJECT_OPT(2, "options", obj);
+
+  if (!obj.IsEmpty()) {
+    NODE_ARRAY_FROM_OBJ_OPT(obj, "stats", stats_array);
+    Local<String> sym = Nan::New("allTouched").ToLocalChecked();
+    if (Nan::HasOwnProperty(obj, sym).FromMaybe(false))
+      options.all_touched = Nan::To<bool>(Nan::Get(obj, sym).ToLocalChecked()).ToChecked();
+    NODE_WRAPPED_FROM_OBJ_OPT(obj, "weights", RasterBand, weights);
+    NODE_INT_FROM_OBJ_OPT(obj, "concurrency", options.concurrency);
+    NODE_CB_FROM_OBJ_OPT(obj, "progress_cb", progress_cb);
+    sym = Nan::New("histogram").ToLocalChecked();
+    if (Nan::HasOwnProperty(obj, sym).FromMaybe(false)) {
+      Local<Value> val = Nan::Get(obj, sym).ToLocalChecked();
+      if (!val->IsObject()) {
+        Nan::ThrowTypeError("histogram must be an object");
+        return;
+      }
+      hist_obj = val.As<Object>();
+    }
+  }
+  if (options.concurrency < 0) {
+    Nan::ThrowRangeError("concurrency must be positive");
+    return;
+  }
+
+  std::vector<ZonalStat> stats;
+  if (stats_array.IsEmpty()) {
+    stats = {ZonalCount, ZonalMean, ZonalMin, ZonalMax};
+  } else {
+    for (unsigned i = 0; i < stats_array->Length(); i++) {
+      Local<Value> val = Nan::Get(stats_array, i).ToLocalChecked();
+      std::string name = val->IsString() ? *Nan::Utf8String(val) : "";
+      if (name == "count") {
+        stats.push_back(ZonalCount);
+      } else if (name == "sum") {
+        stats.push_back(ZonalSum);
+      } else if (name == "mean") {
+        stats.push_back(ZonalMean);
+      } else if (name == "min") {
+        stats.push_back(ZonalMin);
+      } else if (name == "max") {
+        stats.push_back(ZonalMax);
+      } else if (name == "stddev") {
+        stats.push_back(ZonalStdDev);
+      } else if (name == "histogram") {
+        stats.push_back(ZonalHistogram);
+      } else {
+        Nan::ThrowError("stats must contain only count, sum, mean, min, max, stddev or histogram");
+        return;
+      }
+    }
+  }
+
+  if (std::find(stats.begin(), stats.end(), ZonalHistogram) != stats.end()) {
+    if (hist_obj.IsEmpty()) {
+      Nan::ThrowError("The histogram statistic requires the histogram option");
+      return;
+    }
+    options.bins = 10;
+    NODE_DOUBLE_FROM_OBJ(hist_obj, "min", options.hist_min);
+    NODE_DOUBLE_FROM_OBJ(hist_obj, "max", options.hist_max);
+    NODE_INT_FROM_OBJ_OPT(hist_obj, "bins", options.bins);
+    if (options.bins < 1) {
+      Nan::ThrowRangeError("histogram.bins must be at least 1");
+      return;
+    }
+    if (!(options.hist_max > options.hist_min)) {
+      Nan::ThrowRangeError("histogram.max must be greater than histogram.min");
+      return;
+    }
+  }
+
+  // The geometries are cloned, so the zones can be modified or collected during the job
+  std::shared_ptr<std::vector<OGRGeometry *>> zones = std::shared_ptr<std::vector<OGRGeometry *>>(
+    new std::vector<OGRGeometry *>, [](std::vector<OGRGeometry *> *v) {
+      for (OGRGeometry *geom : *v) OGRGeometryFactory::destroyGeometry(geom);
+      delete v;
+    });
+  if (IS_WRAPPED(info[1], Layer)) {
+    layer = Nan::ObjectWrap::Unwrap<Layer>(info[1].As<Object>());
+    if (!layer->isAlive()) {
+      Nan::ThrowError("Layer object already destroyed");
+      return;
+    }
+  } else if (info.Length() > 1 && info[1]->IsArray()) {
+    Local<Array> array = info[1].As<Array>();
+    for (unsigned i = 0; i < array->Length(); i++) {
+      Local<Value> element = Nan::Get(array, i).ToLocalChecked();
+      if (!IS_WRAPPED(element, Geometry)) {
+        Nan::ThrowTypeError("All array elements must be Geometry objects");
+        return;
+      }
+      Geometry *geom = Nan::ObjectWrap::Unwrap<Geometry>(element.As<Object>());
+      if (!geom->isAlive()) {
+        Nan::ThrowError("Geometry object has already been destroyed");
+        return;
+      }
+      zones->push_back(geom->get()->clone());
+    }
+  } else {
+    Nan::ThrowTypeError("zones must be a Layer or an array of Geometry");
+    return;
+  }
+
+  GDALRasterBand *gdal_band = band->get();
+  GDALRasterBand *gdal_weights = weights ? weights->get() : nullptr;
+  OGRLayer *gdal_layer = layer ? layer->get() : nullptr;
+
+  std::vector<long> ds_uids = {band->parent_uid};
+  if (layer) ds_uids.push_back(layer->parent_uid);
+  if (weights) ds_uids.push_back(weights->parent_uid);
+
+  GDALAsyncableJob<ZonalStatsJobResult *> job(ds_uids);
+  job.persist(band->handle());
+  if (layer) job.persist(layer->handle());
+  if (weights) job.persist(weights->handle());
+  job.progress = progress_cb;
+  job.main = [gdal_band, gdal_weights, gdal_layer, zones, options](const GDALExecutionProgress &progress) {
+    std::unique_ptr<ZonalStatsJobResult> r(new ZonalStatsJobResult);
+
+    if (gdal_layer != nullptr) {
+      CPLErrorReset();
+      gdal_layer->ResetReading();
+      OGRFeature *feature;
+      while ((feature = gdal_layer->GetNextFeature()) != nullptr) {
+        r->fids.push_back(feature->GetFID());
+        OGRGeometry *geom = feature->StealGeometry();
+        zones->push_back(geom != nullptr ? geom : new OGRGeometryCollection);
+        OGRFeature::DestroyFeature(feature);
+      }
+      if (CPLGetLastErrorType() == CE_Failure) throw CPLGetLastErrorMsg();
+    }
+
+    std::function<void(double)> report;
+    if (progress.active())
+      report = [&progress](double complete) {
+        if (!ProgressTrampoline(complete, "", (void *)&progress)) throw abortedMessage;
+      };
+    ComputeZonalStats(gdal_band, gdal_weights, *zones, options, r->stats, report);
+    return r.release();
+  };
+  job.rval = [stats](ZonalStatsJobResult *r, const GetFromPersistentFunc &) {
+    Nan::EscapableHandleScope scope;
+    std::unique_ptr<ZonalStatsJobResult> result(r);
+
+    Local<Array> array = Nan::New<Array>(r->stats.size());
+    for (size_t i = 0; i < r->stats.size(); i++) {
+      const ZonalStatsResult &zone = r->stats[i];
+      Local<Object> obj = Nan::New<Object>();
+      if (r->fids.size() > 0)
+        Nan::Set(obj, Nan::New("fid").ToLocalChecked(), Nan::New<Number>(static_cast<double>(r->fids[i])));
+      for (ZonalStat stat : stats) {
+        Local<Value> val = Nan::Null();
+        const char *name;
+        switch (stat) {
+          case ZonalCount:
+            name = "count";
+            val = Nan::New<Number>(static_cast<double>(zone.count));
+            break;
+          case ZonalSum:
+            name = "sum";
+            if (zone.count > 0) val = Nan::New<Number>(zone.Sum());
+            break;
+          case ZonalMean:
+            name = "mean";
+            if (zone.count > 0) val = Nan::New<Number>(zone.Mean());
+            break;
+          case ZonalMin:
+            name = "min";
+            if (zone.count > 0) val = Nan::New<Number>(zone.min);
+            break;
+          case ZonalMax:
+            name = "max";
+            if (zone.count > 0) val = Nan::New<Number>(zone.max);
+            break;
+          case ZonalStdDev:
+            name = "stddev";
+            if (zone.count > 0) val = Nan::New<Number>(zone.StdDev());
+            break;
+          default: {
+            name = "histogram";
+            Local<Array> histogram = Nan::New<Array>(zone.histogram.size());
+            for (size_t k = 0; k < zone.histogram.size(); k++)
+              Nan::Set(histogram, k, Nan::New<Number>(static_cast<double>(zone.histogram[k])));
+            val = histogram;
+            break;
+          }
+        }
+        Nan::Set(obj, Nan::New(name).ToLocalChecked(), val);
+      }
+      Nan::Set(array, i, obj);
+    }
+    return scope.Escape(array).As<Value>();
+  };
+  job.run(info, async, 3);
+}
+
+/**
+ * @typedef {object} CalcExprOptions
+ * @property {boolean} [convertNoData]
+ * @property {ProgressCb} [progress_cb]
+ * @property {AbortSignal} [signal]
+ */
+
+/**
+ * Compute a new output band as a pixel-wise expression of given input bands.
+ *
+ * This is a native alternative to {@link calcAsync}: the expression is compiled
+ * once and evaluated on `GDAL_NUM_THREADS` threads over blocks of pixels, without
+ * ever calling JavaScript. The computations are carried out in double precision.
+ *
+ * The expression refers to the input bands by their keys in `inputs` and supports
+ * the usual arithmetic operators `+ - * / % ^`, the comparisons `< <= > >= == !=`,
+ * the logical operators `&& || !`, the conditional operator `c ? a : b`,
+ * the constants `pi` and `nan` and the functions `abs`, `sqrt`, `exp`, `log`, `log10`,
+ * `sin`, `cos`, `tan`, `asin`, `acos`, `atan`, `atan2`, `pow`, `floor`, `ceil`, `round`,
+ * `min`, `max` and `isnan`. Comparisons and logical operators evaluate to `1` or `0`.
+ *
+ * @example
+ *
+ * // Espy's estimation for cloud base height
+ * await gdal.calcExprAsync({
+ *  t: await T2m.bands.getAsync(1),
+ *  td: await D2m.bands.getAsync(1)
+ * }, await cloudBase.bands.getAsync(1), '125 * (t - td)', { convertNoData: true });
+ *
+ * @throws {Error}
+ * @method calcExpr
+ * @static
+ * @param {Record<string, RasterBand>} inputs An object containing all the input bands
+ * @param {RasterBand} output Output raster band
+ * @param {string} expression
+ * @param {CalcExprOptions} [options]
+ * @param {boolean} [options.convertNoData=false] Input bands will have their NoData pixels converted to NaN and a NaN output value of the expression will be converted to a NoData pixel, provided that the output raster band has its `RasterBand.noDataValue` set
+ * @param {ProgressCb} [options.progress_cb]
+ */
+
+/**
+ * Compute a new output band as a pixel-wise expression of given input bands.
+ * @async
+ *
+ * This is a native alternative to {@link calcAsync}: the expression is compiled
+ * once and evaluated on `GDAL_NUM_THREADS` threads over blocks of pixels, without
+ * ever calling JavaScript. The computations are carried out in double precision.
+ *
+ * See {@link calcExpr} for the expression syntax.
+ *
+ * @throws {Error}
+ * @method calcExprAsync
+ * @static
+ * @param {Record<string, RasterBand>} inputs An object containing all the input bands
+ * @param {RasterBand} output Output raster band
+ * @param {string} expression
+ * @param {CalcExprOptions} [options]
+ * @param {boolean} [options.convertNoData=false] Input bands will have their NoData pixels converted to NaN and a NaN output value of the expression will be converted to a NoData pixel, provided that the output raster band has its `RasterBand.noDataValue` set
+ * @param {ProgressCb} [options.progress_cb]
+ * @param {callback<void>} [callback=undefined]
+ * @return {Promise<void>}
+ */
+GDAL_ASYNCABLE_DEFINE(Algorithms::calcExpr) {
+  Local<Object> inputs_obj;
+  RasterBand *output;
+  std::string text;
+  Local<Object> options;
+  bool convert_nodata = false;
+  Nan::Callback *progress_cb = nullptr;
+
+  NODE_ARG_OBJECT(0, "inputs", inputs_obj);
+  NODE_ARG_WRAPPED(1, "output", RasterBand, output);
+  NODE_ARG_STR(2, "expression", text);
+  NODE_ARG_OBJECT_OPT(3, "options", options);
+
+  if (!options.IsEmpty()) {
+    Local<String> sym = Nan::New("convertNoData").ToLocalChecked();
+    if (Nan::HasOwnProperty(options, sym).FromMaybe(false))
+      convert_nodata = Nan::To<bool>(Nan::Get(options, sym).ToLocalChecked()).ToChecked();
+    NODE_CB_FROM_OBJ_OPT(options, "progress_cb", progress_cb);
+  }
+
+  std::vector<std::string> names;
+  std::shared_ptr<std::vector<GDALRasterBand *>> inputs = std::make_shared<std::vector<GDALRasterBand *>>();
+  std::vector<long> ds_uids = {output->parent_uid};
+  std::vector<Local<Object>> persistent;
+
+  Local<Array> keys = Nan::GetOwnPropertyNames(inputs_obj).ToLocalChecked();
+  for (unsigned i = 0; i < keys->Length(); i++) {
+    Local<Value> key = Nan::Get(keys, i).ToLocalChecked();
+    Local<Value> val = Nan::Get(inputs_obj, key).ToLocalChecked();
+    if (!val->IsObject() || !IS_WRAPPED(val, RasterBand)) {
+      Nan::ThrowTypeError("All inputs must be instances of gdal.RasterBand");
+      return;
+    }
+    RasterBand *band = Nan::ObjectWrap::Unwrap<RasterBand>(val.As<Object>());
+    if (!band->isAlive()) {
+      Nan::ThrowError("RasterBand object has already been destroyed");
+      return;
+    }
+    names.push_back(*Nan::Utf8String(key));
+    inputs->push_back(band->get());
+    ds_uids.push_back(band->parent_uid);
+    persistent.push_back(val.As<Object>());
+  }
+
+  std::shared_ptr<Expression> expr = std::make_shared<Expression>();
+  std::string error;
+  if (!expr->compile(text, names, error)) {
+    Nan::ThrowError(("Invalid expression: " + error).c_str());
+    return;
+  }
+
+  GDALRasterBand *gdal_output = output->get();
+
+  GDALAsyncableJob<int> job(ds_uids);
+  job.persist(output->handle());
+  for (const Local<Object> &obj : persistent) job.persist(obj);
+  job.progress = progress_cb;
+  job.main = [expr, inputs, gdal_output, convert_nodata](const GDALExecutionProgress &progress) {
+    const int w = gdal_output->GetXSize();
+    const int h = gdal_output->GetYSize();
+    const size_t n_inputs = inputs->size();
+
+    std::vector<double> input_nodata(n_inputs);
+    std::vector<int> input_has_nodata(n_inputs, 0);
+    for (size_t i = 0; i < n_inputs; i++) {
+      GDALRasterBand *band = (*inputs)[i];
+      if (band->GetXSize() != w || band->GetYSize() != h) throw "All raster bands dimensions must match";
+      if (convert_nodata) input_nodata[i] = band->GetNoDataValue(&input_has_nodata[i]);
+    }
+    int output_has_nodata = 0;
+    double output_nodata = convert_nodata ? gdal_output->GetNoDataValue(&output_has_nodata) : 0;
+
+    // Process stripes of whole blocks of about 1M pixels
+    int block_x, block_y;
+    gdal_output->GetBlockSize(&block_x, &block_y);
+    int rows = std::max(1, (1 << 20) / std::max(1, w));
+    if (rows > block_y) rows -= rows % block_y;
+    rows = std::min(rows, h);
+    const size_t stripe = static_cast<size_t>(rows) * w;
+
+    std::vector<std::vector<double>> in(n_inputs, std::vector<double>(stripe));
+    std::vector<double> out(stripe);
+    const int threads = GetNumThreads(stripe / 4096 + 1);
+    std::vector<std::vector<double>> scratch(threads);
+
+    for (int y = 0; y < h; y += rows) {
+      const int r = std::min(rows, h - y);
+      const size_t count = static_cast<size_t>(r) * w;
+
+      CPLErrorReset();
+      for (size_t i = 0; i < n_inputs; i++) {
+        CPLErr err = (*inputs)[i]->RasterIO(GF_Read, 0, y, w, r, in[i].data(), w, r, GDT_Float64, 0, 0, nullptr);
+        if (err != CE_None) throw CPLGetLastErrorMsg();
+      }
+
+      size_t grain = std::max<size_t>(4096, count / (static_cast<size_t>(threads) * 8));
+      ParallelFor(count, threads, grain, [&](size_t begin, size_t end, int thread) {
+        std::vector<const double *> vars(n_inputs);
+        for (size_t i = 0; i < n_inputs; i++) {
+          double *data = in[i].data() + begin;
+          if (input_has_nodata[i] && !std::isnan(input_nodata[i])) {
+            const double nodata = input_nodata[i];
+            for (size_t k = 0; k < end - begin; k++)
+              if (data[k] == nodata) data[k] = std::numeric_limits<double>::quiet_NaN();
+          }
+          vars[i] = data;
+        }
+        double *result = out.data() + begin;
+        expr->evaluate(vars.data(), end - begin, result, scratch[thread]);
+        if (output_has_nodata) {
+          for (size_t k = 0; k < end - begin; k++)
+            if (std::isnan(result[k])) result[k] = output_nodata;
+        }
+      });
+
+      CPLErr err = gdal_output->RasterIO(GF_Write, 0, y, w, r, out.data(), w, r, GDT_Float64, 0, 0, nullptr);
+      if (err != CE_None) throw CPLGetLastErrorMsg();
+
+      if (progress.active() && !ProgressTrampoline(static_cast<double>(y + r) / h, "", (void *)&progress))
+        throw abortedMessage;
+    }
+    return 0;
+  };
+  job.rval = [](int, const GetFromPersistentFunc &) { return Nan::Undefined().As<Value>(); };
+  job.run(info, async, 4);
+}
+
+// The native engine of gdal.processTilesAsync() for expressions, see lib/tiles.js
+//
+// The output raster is split in tiles aligned on its blocks that are
+// distributed dynamically to the threads, each thread reads, computes and
+// writes its own tiles - GDAL datasets are not thread-safe, so the I/O
+// is serialized by a lock per dataset while the computation is not,
+// and the reading of a tile overlaps with the computing and the writing of the others
+GDAL_ASYNCABLE_DEFINE(Algorithms::_processTiles) {
+  Local<Object> inputs_obj;
+  RasterBand *output;
+  std::string text;
+  Local<Object> options;
+  int tile_size = 1024;
+  int concurrency = 0;
+  bool convert_nodata = false;
+  Nan::Callback *progress_cb = nullptr;
+
+  NODE_ARG_OBJECT(0, "inputs", inputs_obj);
+  NODE_ARG_WRAPPED(1, "output", RasterBand, output);
+  NODE_ARG_STR(2, "expression", text);
+  NODE_ARG_OBJECT_OPT(3, "options", options);
+
+  if (!options.IsEmpty()) {
+    NODE_INT_FROM_OBJ_OPT(options, "tileSize", tile_size);
+    NODE_INT_FROM_OBJ_OPT(options, "concurrency", concurrency);
+    Local<String> sym = Nan::New("convertNoData").ToLocalChecked();
+    if (Nan::HasOwnProperty(options, sym).FromMaybe(false))
+      convert_nodata = Nan::To<bool>(Nan::Get(options, sym).ToLocalChecked()).ToChecked();
+    NODE_CB_FROM_OBJ_OPT(options, "progress_cb", progress_cb);
+  }
+  if (tile_size < 1) {
+    Nan::ThrowRangeError("tileSize must be a positive number");
+    return;
+  }
+
+  std::vector<std::string> names;
+  std::shared_ptr<std::vector<GDALRasterBand *>> inputs = std::make_shared<std::vector<GDALRasterBand *>>();
+  std::vector<long> ds_uids = {output->parent_uid};
+  std::vector<Local<Object>> persistent;
+
+  Local<Array> keys = Nan::GetOwnPropertyNames(inputs_obj).ToLocalChecked();
+  for (unsigned i = 0; i < keys->Length(); i++) {
+    Local<Value> key = Nan::Get(keys, i).ToLocalChecked();
+    Local<Value> val = Nan::Get(inputs_obj, key).ToLocalChecked();
+    if (!val->IsObject() || !IS_WRAPPED(val, RasterBand)) {
+      Nan::ThrowTypeError("All inputs must be instances of gdal.RasterBand");
+      return;
+    }
+    RasterBand *band = Nan::ObjectWrap::Unwrap<RasterBand>(val.As<Object>());
+    if (!band->isAlive()) {
+      Nan::ThrowError("RasterBand object has already been destroyed");
+      return;
+    }
+    names.push_back(*Nan::Utf8String(key));
+    inputs->push_back(band->get());
+    ds_uids.push_back(band->parent_uid);
+    persistent.push_back(val.As<Object>());
+  }
+
+  std::shared_ptr<Expression> expr = std::make_shared<Expression>();
+  std::string error;
+  if (!expr->compile(text, names, error)) {
+    Nan::ThrowError(("Invalid expression: " + error).c_str());
+    return;
+  }
+
+  GDALRasterBand *gdal_output = output->get();
+
+  GDALAsyncableJob<int> job(ds_uids);
+  job.persist(output->handle());
+  for (const Local<Object> &obj : persistent) job.persist(obj);
+  job.progress = progress_cb;
+  job.main = [expr, inputs, gdal_output, tile_size, concurrency, convert_nodata](
+               const GDALExecutionProgress &progress) {
+    const int w = gdal_output->GetXSize();
+    const int h = gdal_output->GetYSize();
+    const size_t n_inputs = inputs->size();
+
+    std::vector<double> input_nodata(n_inputs);
+    std::vector<int> input_has_nodata(n_inputs, 0);
+    for (size_t i = 0; i < n_inputs; i++) {
+      GDALRasterBand *band = (*inputs)[i];
+      if (band->GetXSize() != w || band->GetYSize() != h) throw "All raster bands dimensions must match";
+      if (convert_nodata) input_nodata[i] = band->GetNoDataValue(&input_has_nodata[i]);
+    }
+    int output_has_nodata = 0;
+    double output_nodata = convert_nodata ? gdal_output->GetNoDataValue(&output_has_nodata) : 0;
+
+    // One lock per dataset, an input can be in the same dataset as the output
+    std::map<void *, size_t> datasets;
+    std::vector<size_t> input_lock(n_inputs);
+    auto lockOf = [&datasets](GDALRasterBand *band) {
+      void *ds = band->GetDataset() != nullptr ? static_cast<void *>(band->GetDataset()) : static_cast<void *>(band);
+      auto it = datasets.find(ds);
+      if (it != datasets.end()) return it->second;
+      size_t idx = datasets.size();
+      datasets[ds] = idx;
+      return idx;
+    };
+    const size_t output_lock = lockOf(gdal_output);
+    for (size_t i = 0; i < n_inputs; i++) input_lock[i] = lockOf((*inputs)[i]);
+    std::unique_ptr<std::mutex[]> locks(new std::mutex[datasets.size()]);
+
+    // Tiles are aligned on the blocks of the output
+    int block_x, block_y;
+    gdal_output->GetBlockSize(&block_x, &block_y);
+    block_x = std::max(1, block_x);
+    block_y = std::max(1, block_y);
+    const int tile_x = std::min(w, std::max(1, (tile_size + block_x - 1) / block_x) * block_x);
+    const int tile_y = std::min(h, std::max(1, (tile_size + block_y - 1) / block_y) * block_y);
+    const size_t tiles_x = (w + tile_x - 1) / tile_x;
+    const size_t tiles_y = (h + tile_y - 1) / tile_y;
+    const size_t tiles = tiles_x * tiles_y;
+    const size_t tile_pixels = static_cast<size_t>(tile_x) * tile_y;
+
+    const int threads = GetNumThreads(tiles, concurrency);
+    std::vector<std::vector<std::vector<double>>> in(threads);
+    std::vector<std::vector<double>> out(threads);
+    std::vector<std::vector<double>> scratch(threads);
+    std::atomic<size_t> done(0);
+
+    ParallelFor(tiles, threads, 1, [&](size_t begin, size_t end, int thread) {
+      std::vector<std::vector<double>> &in_data = in[thread];
+      std::vector<double> &out_data = out[thread];
+      if (in_data.empty()) {
+        in_data.assign(n_inputs, std::vector<double>(tile_pixels));
+        out_data.resize(tile_pixels);
+      }
+      std::vector<const double *> vars(n_inputs);
+
+      for (size_t t = begin; t < end; t++) {
+        const int x = static_cast<int>(t % tiles_x) * tile_x;
+        const int y = static_cast<int>(t / tiles_x) * tile_y;
+        const int tw = std::min(tile_x, w - x);
+        const int th = std::min(tile_y, h - y);
+        const size_t count = static_cast<size_t>(tw) * th;
+
+        for (size_t i = 0; i < n_inputs; i++) {
+          CPLErr err;
+          {
+            std::lock_guard<std::mutex> lock(locks[input_lock[i]]);
+            CPLErrorReset();
+            err = (*inputs)[i]->RasterIO(
+              GF_Read, x, y, tw, th, in_data[i].data(), tw, th, GDT_Float64, 0, 0, nullptr);
+          }
+          if (err != CE_None) throw CPLGetLastErrorMsg();
+          double *data = in_data[i].data();
+          if (input_has_nodata[i] && !std::isnan(input_nodata[i])) {
+            const double nodata = input_nodata[i];
+            for (size_t k = 0; k < count; k++)
+              if (data[k] == nodata) data[k] = std::numeric_limits<double>::quiet_NaN();
+          }
+          vars[i] = data;
+        }
+
+        expr->evaluate(vars.data(), count, out_data.data(), scratch[thread]);
+        if (output_has_nodata) {
+          for (size_t k = 0; k < count; k++)
+            if (std::isnan(out_data[k])) out_data[k] = output_nodata;
+        }
+
+        CPLErr err;
+        {
+          std::lock_guard<std::mutex> lock(locks[output_lock]);
+          CPLErrorReset();
+          err = gdal_output->RasterIO(GF_Write, x, y, tw, th, out_data.data(), tw, th, GDT_Float64, 0, 0, nullptr);
+        }
+        if (err != CE_None) throw CPLGetLastErrorMsg();
+
+        size_t completed = ++done;
+        // The progress callback can be called only from the calling thread
+        if (
+          progress.active() && thread == 0 &&
+          !ProgressTrampoline(static_cast<double>(completed) / tiles, "", (void *)&progress))
+          throw abortedMessage;
+      }
+    });
+    if (progress.active()) ProgressTrampoline(1, "", (void *)&progress);
+    return 0;
+  };
+  job.rval = [](int, const GetFromPersistentFunc &) { return Nan::Undefined().As<Value>(); };
+  job.run(info, async, 4);
+}
+
 // This is used for stress-testing the locking mechanism
 // it doesn't do anything but sollicit locks
 GDAL_ASYNCABLE_DEFINE(Algorithms::_acquireLocks) {
@@ -548,6 +1614,11 @@ GDAL_ASYNCABLE_DEFINE(Algorithms::_acquireLocks) {
  * @typedef {Uint8Array} PixelFunction
  */
 
+/**
+ * @typedef {object} PixelFuncOptions
+ * @property {number} [workers]
+ */
+
 /**
  * Register a new compiled pixel function for derived virtual datasets.
  *
@@ -589,8 +1660,11 @@ NAN_METHOD(Algorithms::addPixelFunc) {
 }
 
 #if GDAL_VERSION_MAJOR > 3 || (GDAL_VERSION_MAJOR == 3 && GDAL_VERSION_MINOR >= 5)
+struct pixelFn;
+
 // This is the arguments of one call of the pixel function
 struct pixelFnCall {
+  pixelFn *fn;
   void **sources;
   size_t num;
   void *destination;
@@ -599,20 +1673,30 @@ struct pixelFnCall {
   GDALDataType outType;
   std::map<std::string, std::string> args;
   Nan::Utf8String *err;
+  // Posted when the JS function has returned (or called done)
+  uv_sem_t *returnJS;
+  // true when called on the main thread
+  bool sync;
 };
 
 // This is the pixel function descriptor
-// The queue can be modified both by the main thread and the worker threads
+// A deferred pixel function receives a done callback in async mode
+// and it can be called concurrently by several worker threads,
+// each with its own pixelFnCall
+// The other pixel functions are called one at a time using
+// the mutex and the semaphore of the descriptor
 struct pixelFn {
   Nan::Callback *fn;
-  pixelFnCall call;
+  bool deferred;
   uv_mutex_t callJS;
   uv_sem_t returnJS;
 };
 
-// Only the main thread can modify this and only by adding new elements
-// No need to lock
-std::vector<pixelFn> pixelFuncs;
+// Only the main thread can modify this and only by adding new elements,
+// the elements never move but the deque itself is not thread-safe:
+// adding and looking up an element must hold pixelFuncsLock
+std::deque<pixelFn> pixelFuncs;
+std::mutex pixelFuncsLock;
 
 #define PFN_ID_FIELD "node_gdal_pfn_id"
 const char metadataTemplate[] =
@@ -621,26 +1705,38 @@ const char metadataTemplate[] =
   "' type='constant' value='%x' />\n"
   "</PixelFunctionArgumentsList>";
 
+// This is the done callback of the deferred pixel functions
+// Its data is an array holding the call, it is cleared once the worker thread
+// has been unlocked as the call lives on its stack, so calling done again
+// (or after the JS function has thrown) does nothing
+static NAN_METHOD(pixelFnDone) {
+  Local<Array> data = info.Data().As<Array>();
+  Local<Value> external = Nan::Get(data, 0).ToLocalChecked();
+  if (!external->IsExternal()) return;
+  Nan::Set(data, 0, Nan::Undefined());
+  pixelFnCall *call = reinterpret_cast<pixelFnCall *>(external.As<External>()->Value());
+  if (info.Length() > 0 && !info[0]->IsNullOrUndefined()) call->err = new Nan::Utf8String(info[0]);
+  // unlock the worker thread
+  uv_sem_post(call->returnJS);
+}
+
 // This is the final step before calling the JS function
-// This function is called by libuv on the main thread
-// The async_send in the function below is what triggers this call
-static void callJSpfn(uv_async_t *async) {
-  // Here V8 is accessible
+// Here V8 is accessible
+static void callJS(pixelFnCall *call) {
   Nan::HandleScope scope;
 
-  pixelFn *fn = reinterpret_cast<pixelFn *>(async->data);
-  Local<Array> sources = Nan::New<Array>(fn->call.num);
-  size_t len = fn->call.width * fn->call.height;
-  for (size_t i = 0; i < fn->call.num; i++) {
-    Nan::Set(sources, i, TypedArray::New(fn->call.inType, fn->call.sources[i], len));
+  Local<Array> sources = Nan::New<Array>(call->num);
+  size_t len = call->width * call->height;
+  for (size_t i = 0; i < call->num; i++) {
+    Nan::Set(sources, i, TypedArray::New(call->inType, call->sources[i], len));
   }
-  Local<Value> destination = TypedArray::New(fn->call.outType, fn->call.destination, len);
-  Local<Number> width = Nan::New<Number>(fn->call.width);
-  Local<Number> height = Nan::New<Number>(fn->call.height);
+  Local<Value> destination = TypedArray::New(call->outType, call->destination, len);
+  Local<Number> width = Nan::New<Number>(call->width);
+  Local<Number> height = Nan::New<Number>(call->height);
 
   Local<Object> pfArgs = Nan::New<Object>();
-  if (fn->call.args.size() > 0) {
-    for (auto const &el : fn->call.args) {
+  if (call->args.size() > 0) {
+    for (auto const &el : call->args) {
       char *end;
       double dval = std::strtod(el.second.c_str(), &end);
       if (*end == 0)
@@ -650,16 +1746,41 @@ static void callJSpfn(uv_async_t *async) {
     }
   }
 
-  Local<Value> args[] = {sources, destination, pfArgs, width, height};
+  // In sync mode the deferred pixel functions do not receive a done callback
+  // and must complete before returning, waiting would deadlock the main thread
+  bool deferred = call->fn->deferred && !call->sync;
+  Local<Value> done = Nan::Undefined();
+  Local<Array> doneData = Nan::New<Array>(1);
+  if (deferred) {
+    Nan::Set(doneData, 0, Nan::New<External>(call));
+    done = Nan::GetFunction(Nan::New<FunctionTemplate>(pixelFnDone, doneData)).ToLocalChecked();
+  }
+
+  Local<Value> args[] = {sources, destination, pfArgs, width, height, done};
 
-  fn->call.err = nullptr;
+  call->err = nullptr;
   Nan::TryCatch try_catch;
   // async_hooks do not make any sense for pixel functions
-  Nan::Call(*fn->fn, 5, args);
-  if (try_catch.HasCaught()) fn->call.err = new Nan::Utf8String(try_catch.Message()->Get());
+  Nan::Call(*call->fn->fn, deferred ? 6 : 5, args);
+  if (try_catch.HasCaught()) {
+    // When done has already been called, the worker thread is gone with the call
+    if (deferred && !Nan::Get(doneData, 0).ToLocalChecked()->IsExternal()) return;
+    // Otherwise done must not unlock the worker thread a second time
+    Nan::Set(doneData, 0, Nan::Undefined());
+    call->err = new Nan::Utf8String(try_catch.Message()->Get());
+  } else if (deferred) {
+    // done will unlock the worker thread
+    return;
+  }
 
   // unlock the worker thread (the function below)
-  uv_sem_post(&fn->returnJS);
+  uv_sem_post(call->returnJS);
+}
+
+// This function is called by libuv on the main thread
+// The async_send in the function below is what triggers this call
+static void callJSpfn(uv_async_t *async) {
+  callJS(reinterpret_cast<pixelFnCall *>(async->data));
 }
 
 // This is the GDAL pixel function trampoline that calls the JS callback
@@ -688,7 +1809,12 @@ static CPLErr pixelFunc(
   }
   char *end;
   size_t id = std::strtoul(uid->second.c_str(), &end, 16);
-  if (end == uid->second.c_str() || id >= pixelFuncs.size()) {
+  pixelFn *fn = nullptr;
+  {
+    std::lock_guard<std::mutex> lock(pixelFuncsLock);
+    if (end != uid->second.c_str() && id < pixelFuncs.size()) fn = &pixelFuncs[id];
+  }
+  if (fn == nullptr) {
     CPLError(CE_Failure, CPLE_AppDefined, "gdal-async Internal error, pixelFuncs inconsistency");
     return CE_Failure;
   }
@@ -702,11 +1828,10 @@ static CPLErr pixelFunc(
     return CE_Failure;
   }
 
-  uv_async_t *async = new uv_async_t;
-  async->data = &pixelFuncs[id];
-
-  uv_mutex_lock(&pixelFuncs[id].callJS);
-  pixelFuncs[id].call = {
+  bool sync = std::this_thread::get_id() == mainV8ThreadId;
+  uv_sem_t returnJS;
+  pixelFnCall call = {
+    fn,
     papoSources,
     static_cast<size_t>(nSources),
     pData,
@@ -715,30 +1840,44 @@ static CPLErr pixelFunc(
     eSrcType,
     eBufType,
     std::move(pfArgsMap),
-    nullptr};
-  if (std::this_thread::get_id() == mainV8ThreadId) {
+    nullptr,
+    &fn->returnJS,
+    sync};
+
+  if (fn->deferred) {
+    uv_sem_init(&returnJS, 0);
+    call.returnJS = &returnJS;
+  } else {
+    uv_mutex_lock(&fn->callJS);
+  }
+  if (sync) {
     // Main thread = sync mode
-    // Here we are abusing an uninitialized uv_async_t as a data holder
-    callJSpfn(async);
-    delete async;
+    callJS(&call);
+    // Consume the post
+    uv_sem_wait(call.returnJS);
   } else {
     // Worker thread = async mode
+    uv_async_t *async = new uv_async_t;
+    async->data = &call;
     uv_async_init(uv_default_loop(), async, callJSpfn);
 
     uv_async_send(async);
-    uv_sem_wait(&pixelFuncs[id].returnJS);
+    uv_sem_wait(call.returnJS);
 
     uv_close(reinterpret_cast<uv_handle_t *>(async), [](uv_handle_t *handle) {
       uv_async_t *async = reinterpret_cast<uv_async_t *>(handle);
       delete async;
     });
   }
-  uv_mutex_unlock(&pixelFuncs[id].callJS);
+  if (fn->deferred) {
+    uv_sem_destroy(&returnJS);
+  } else {
+    uv_mutex_unlock(&fn->callJS);
+  }
 
-  if (pixelFuncs[id].call.err != nullptr) {
-    CPLError(CE_Failure, CPLE_AppDefined, "Pixel function error: %s", **pixelFuncs[id].call.err);
-    delete pixelFuncs[id].call.err;
-    pixelFuncs[id].call.err = nullptr;
+  if (call.err != nullptr) {
+    CPLError(CE_Failure, CPLE_AppDefined, "Pixel function error: %s", **call.err);
+    delete call.err;
     return CE_Failure;
   }
 
@@ -756,6 +1895,12 @@ static CPLErr pixelFunc(
  * You can check the `gdal-exprtk` plugin for an alternative
  * which uses ExprTk expressions and does not suffer from this problem.
  *
+ * Alternatively, with `options.workers`, the function is evaluated in a pool of
+ * `worker_threads` and the main thread only copies the data to and from shared memory.
+ * In this case the function is transferred to the workers as source code
+ * and it cannot use any variable from its enclosing scope. When reading in sync mode,
+ * the function is still called on the main thread.
+ *
  * As GDAL does not allow unregistering a previously registered pixel functions,
  * each call of this method will produce a permanently registered pixel function.
  *
@@ -773,21 +1918,32 @@ static CPLErr pixelFunc(
  * };
  * gdal.addPixelFunc('sum2', gdal.toPixelFunc(sum2));
  *
+ * // The same function evaluated by 4 worker threads
+ * gdal.addPixelFunc('sum2w', gdal.toPixelFunc(sum2, { workers: 4 }));
+ *
  * @throws {Error}
  * @method toPixelFunc
  * @static
  * @param {(sources: TypedArray[], buffer: TypedArray, args: Record<string, string|number>, width: number, height: number) => void} pixelFn JavaScript pixel function
+ * @param {PixelFuncOptions} [options]
+ * @param {number} [options.workers] Number of worker threads evaluating the function
  * @returns {PixelFunction}
  */
 NAN_METHOD(Algorithms::toPixelFunc) {
 #if GDAL_VERSION_MAJOR > 3 || (GDAL_VERSION_MAJOR == 3 && GDAL_VERSION_MINOR >= 5)
   Nan::Callback *pfn;
   NODE_ARG_CB(0, "pixelFn", pfn);
-
-  size_t uid = pixelFuncs.size();
-  pixelFuncs.push_back({pfn, {}, {}, {}});
-  uv_mutex_init(&pixelFuncs[uid].callJS);
-  uv_sem_init(&pixelFuncs[uid].returnJS, 0);
+  // Used by lib/pixelfunc.js for the worker_threads pool
+  bool deferred = info.Length() > 1 && info[1]->IsTrue();
+
+  size_t uid;
+  {
+    std::lock_guard<std::mutex> lock(pixelFuncsLock);
+    uid = pixelFuncs.size();
+    pixelFuncs.push_back({pfn, deferred, {}, {}});
+    uv_mutex_init(&pixelFuncs[uid].callJS);
+    uv_sem_init(&pixelFuncs[uid].returnJS, 0);
+  }
 
   std::string metadata;
   metadata.reserve(strlen(metadataTemplate) + 32);
@@ -33,6 +33,10 @@ GDAL_ASYNCABLE_GLOBAL(contourGenerate);
 GDAL_ASYNCABLE_GLOBAL(sieveFilter);
 GDAL_ASYNCABLE_GLOBAL(checksumImage);
 GDAL_ASYNCABLE_GLOBAL(polygonize);
+GDAL_ASYNCABLE_GLOBAL(spatialJoin);
+GDAL_ASYNCABLE_GLOBAL(zonalStats);
+GDAL_ASYNCABLE_GLOBAL(calcExpr);
+GDAL_ASYNCABLE_GLOBAL(_processTiles);
 NAN_METHOD(addPixelFunc);
 NAN_METHOD(toPixelFunc);
 GDAL_ASYNCABLE_GLOBAL(_acquireLocks);
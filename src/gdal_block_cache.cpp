@@ -0,0 +1,408 @@
+#include "gdal_block_cache.hpp"
+#include "gdal_dataset.hpp"
+
+#include <map>
+#include <mutex>
+
+namespace node_gdal {
+
+/**
+ * The GDAL raster block cache.
+ *
+ * GDAL keeps the recently used raster blocks of all datasets in a single
+ * LRU cache limited by `GDAL_CACHEMAX`. These functions give visibility
+ * on its usage and allow to keep the blocks of a hot dataset in memory.
+ *
+ * @namespace blockCache
+ */
+
+void BlockCache::Initialize(Local<Object> target) {
+  Local<Object> blockCache = Nan::New<Object>();
+  Nan::Set(target, Nan::New("blockCache").ToLocalChecked(), blockCache);
+  Nan__SetAsyncableMethod(blockCache, "stats", stats);
+  Nan__SetMethod(blockCache, "setMaxBytes", setMaxBytes);
+  Nan__SetAsyncableMethod(blockCache, "flushDataset", flushDataset);
+  Nan__SetAsyncableMethod(blockCache, "pin", pin);
+  Nan__SetMethod(blockCache, "unpin", unpin);
+}
+
+// The pinned blocks are kept locked, GDAL never evicts a locked block
+struct Pin {
+  std::vector<GDALRasterBlock *> blocks;
+  GIntBig bytes;
+};
+
+static std::map<long, Pin> pins;
+static GIntBig pinnedBytes = 0;
+static std::mutex pinsLock;
+
+void BlockCache::Unpin(long uid) {
+  std::lock_guard<std::mutex> lock(pinsLock);
+  auto it = pins.find(uid);
+  if (it == pins.end()) return;
+  for (GDALRasterBlock *block : it->second.blocks) block->DropLock();
+  pinnedBytes -= it->second.bytes;
+  pins.erase(it);
+}
+
+static GIntBig pinnedFor(long uid) {
+  std::lock_guard<std::mutex> lock(pinsLock);
+  auto it = pins.find(uid);
+  return it == pins.end() ? 0 : it->second.bytes;
+}
+
+struct DatasetCacheStats {
+  double blocks;
+  double bytes;
+  double dirtyBytes;
+  double pinnedBytes;
+};
+
+struct CacheStats {
+  double maxBytes;
+  double usedBytes;
+  double pinnedBytes;
+  std::vector<DatasetCacheStats> datasets;
+};
+
+// Looks up each block of the band without loading it
+static void scanBand(GDALRasterBand *band, DatasetCacheStats &stats) {
+  int bw, bh;
+  band->GetBlockSize(&bw, &bh);
+  const int nx = (band->GetXSize() + bw - 1) / bw;
+  const int ny = (band->GetYSize() + bh - 1) / bh;
+  for (int y = 0; y < ny; y++)
+    for (int x = 0; x < nx; x++) {
+      GDALRasterBlock *block = band->TryGetLockedBlockRef(x, y);
+      if (block == nullptr) continue;
+      stats.blocks++;
+      stats.bytes += static_cast<double>(block->GetBlockSize());
+      if (block->GetDirty()) stats.dirtyBytes += static_cast<double>(block->GetBlockSize());
+      block->DropLock();
+    }
+}
+
+/**
+ * @typedef {object} BlockCacheDatasetStats
+ * @memberof blockCache
+ * @property {number} blocks
+ * @property {number} bytes
+ * @property {number} dirtyBytes
+ * @property {number} pinnedBytes
+ */
+
+/**
+ * @typedef {object} BlockCacheStats
+ * @memberof blockCache
+ * @property {number} maxBytes
+ * @property {number} usedBytes
+ * @property {number} pinnedBytes
+ * @property {BlockCacheDatasetStats[]} datasets
+ */
+
+/**
+ * Returns the size and the usage of the block cache and, for each of the
+ * given datasets, the number of its blocks in the cache (including its overviews),
+ * their size, the size of the modified blocks that have not been written yet
+ * and the size of the pinned blocks.
+ *
+ * GDAL does not count the cache hits, misses and evictions.
+ *
+ * Looking up the blocks of a dataset requires its lock and is proportional
+ * to its total number of blocks.
+ *
+ * @example
+ * const { usedBytes, maxBytes, datasets } = gdal.blockCache.stats([ dem ])
+ * console.log(`${usedBytes}/${maxBytes} bytes used, ${datasets[0].bytes} by the DEM`)
+ *
+ * @static
+ * @method stats
+ * @memberof blockCache
+ * @param {Dataset[]} [datasets]
+ * @throws {Error}
+ * @return {BlockCacheStats}
+ */
+
+/**
+ * Returns the size and the usage of the block cache and of the given datasets.
+ * @async
+ *
+ * @static
+ * @method statsAsync
+ * @memberof blockCache
+ * @param {Dataset[]} [datasets]
+ * @param {callback<BlockCacheStats>} [callback=undefined]
+ * @throws {Error}
+ * @return {Promise<BlockCacheStats>}
+ */
+GDAL_ASYNCABLE_DEFINE(BlockCache::stats) {
+  Local<Array> datasets;
+  NODE_ARG_ARRAY_OPT(0, "datasets", datasets);
+
+  std::vector<GDALDataset *> raws;
+  std::vector<long> uids;
+  if (!datasets.IsEmpty()) {
+    for (unsigned i = 0; i < datasets->Length(); i++) {
+      Local<Value> el = Nan::Get(datasets, i).ToLocalChecked();
+      if (!el->IsObject() || !Nan::New(Dataset::constructor)->HasInstance(el)) {
+        Nan::ThrowTypeError("datasets must contain only Dataset objects");
+        return;
+      }
+      Dataset *ds = Nan::ObjectWrap::Unwrap<Dataset>(el.As<Object>());
+      if (!ds->isAlive()) {
+        Nan::ThrowError("Dataset object has already been destroyed");
+        return;
+      }
+      raws.push_back(ds->get());
+      uids.push_back(ds->uid);
+    }
+  }
+
+  // Without datasets there is nothing to lock
+  GDALAsyncableJob<CacheStats> job(uids.empty() ? std::vector<long>{0} : uids);
+  job.main = [raws, uids](const GDALExecutionProgress &) {
+    CacheStats stats;
+    stats.maxBytes = static_cast<double>(GDALGetCacheMax64());
+    stats.usedBytes = static_cast<double>(GDALGetCacheUsed64());
+    {
+      std::lock_guard<std::mutex> lock(pinsLock);
+      stats.pinnedBytes = static_cast<double>(pinnedBytes);
+    }
+    for (size_t i = 0; i < raws.size(); i++) {
+      DatasetCacheStats ds_stats = {0, 0, 0, static_cast<double>(pinnedFor(uids[i]))};
+      for (int b = 1; b <= raws[i]->GetRasterCount(); b++) {
+        GDALRasterBand *band = raws[i]->GetRasterBand(b);
+        scanBand(band, ds_stats);
+        for (int o = 0; o < band->GetOverviewCount(); o++) {
+          GDALRasterBand *overview = band->GetOverview(o);
+          if (overview != nullptr) scanBand(overview, ds_stats);
+        }
+      }
+      stats.datasets.push_back(ds_stats);
+    }
+    return stats;
+  };
+  job.rval = [](CacheStats stats, const GetFromPersistentFunc &) {
+    Nan::EscapableHandleScope scope;
+    Local<Object> result = Nan::New<Object>();
+    Nan::Set(result, Nan::New("maxBytes").ToLocalChecked(), Nan::New<Number>(stats.maxBytes));
+    Nan::Set(result, Nan::New("usedBytes").ToLocalChecked(), Nan::New<Number>(stats.usedBytes));
+    Nan::Set(result, Nan::New("pinnedBytes").ToLocalChecked(), Nan::New<Number>(stats.pinnedBytes));
+    Local<Array> datasets = Nan::New<Array>(stats.datasets.size());
+    for (size_t i = 0; i < stats.datasets.size(); i++) {
+      Local<Object> ds = Nan::New<Object>();
+      Nan::Set(ds, Nan::New("blocks").ToLocalChecked(), Nan::New<Number>(stats.datasets[i].blocks));
+      Nan::Set(ds, Nan::New("bytes").ToLocalChecked(), Nan::New<Number>(stats.datasets[i].bytes));
+      Nan::Set(ds, Nan::New("dirtyBytes").ToLocalChecked(), Nan::New<Number>(stats.datasets[i].dirtyBytes));
+      Nan::Set(ds, Nan::New("pinnedBytes").ToLocalChecked(), Nan::New<Number>(stats.datasets[i].pinnedBytes));
+      Nan::Set(datasets, i, ds);
+    }
+    Nan::Set(result, Nan::New("datasets").ToLocalChecked(), datasets);
+    return scope.Escape(result);
+  };
+  job.run(info, async, 1);
+}
+
+/**
+ * Sets the maximum size of the block cache in bytes, the equivalent of
+ * `GDAL_CACHEMAX`. Reducing it evicts the least recently used blocks
+ * immediately.
+ *
+ * @static
+ * @method setMaxBytes
+ * @memberof blockCache
+ * @param {number} bytes
+ * @throws {Error}
+ * @return {void}
+ */
+NAN_METHOD(BlockCache::setMaxBytes) {
+  double bytes;
+  NODE_ARG_DOUBLE(0, "bytes", bytes);
+  if (!(bytes >= 0)) {
+    Nan::ThrowRangeError("bytes must not be negative");
+    return;
+  }
+  GDALSetCacheMax64(static_cast<GIntBig>(bytes));
+}
+
+/**
+ * Writes the modified blocks of a dataset and removes all of its blocks,
+ * including the pinned ones, from the block cache.
+ *
+ * @static
+ * @method flushDataset
+ * @memberof blockCache
+ * @param {Dataset} dataset
+ * @throws {Error}
+ * @return {void}
+ */
+
+/**
+ * Writes the modified blocks of a dataset and removes all of its blocks,
+ * including the pinned ones, from the block cache.
+ * @async
+ *
+ * @static
+ * @method flushDatasetAsync
+ * @memberof blockCache
+ * @param {Dataset} dataset
+ * @param {callback<void>} [callback=undefined]
+ * @throws {Error}
+ * @return {Promise<void>}
+ */
+GDAL_ASYNCABLE_DEFINE(BlockCache::flushDataset) {
+  Dataset *ds;
+  NODE_ARG_WRAPPED(0, "dataset", Dataset, ds);
+  GDAL_RAW_CHECK(GDALDataset *, ds, raw);
+
+  long uid = ds->uid;
+  GDALAsyncableJob<int> job(uid);
+  job.main = [raw, uid](const GDALExecutionProgress &) {
+    Unpin(uid);
+    raw->FlushCache();
+    return 0;
+  };
+  job.rval = [](int, const GetFromPersistentFunc &) { return Nan::Undefined().As<Value>(); };
+  job.run(info, async, 1);
+}
+
+/**
+ * Loads the blocks of the overviews of a dataset in the block cache and
+ * keeps them there until `unpin()` is called or the dataset is flushed
+ * or closed. Pinning again a dataset replaces its previously pinned blocks.
+ *
+ * This allows to hold the overviews of a frequently accessed COG in memory
+ * across requests while the full resolution blocks go through the LRU cache.
+ * Only datasets opened in read-only mode can be pinned and the pinned blocks
+ * of all datasets cannot exceed half of the block cache.
+ *
+ * @example
+ * const cog = gdal.open('/vsicurl/https://example.com/cog.tif')
+ * gdal.blockCache.pin(cog)
+ *
+ * @static
+ * @method pin
+ * @memberof blockCache
+ * @param {Dataset} dataset
+ * @param {number[]} [overviews] The overview levels to pin, all of them by default
+ * @throws {Error}
+ * @return {number} The pinned size in bytes
+ */
+
+/**
+ * Loads the blocks of the overviews of a dataset in the block cache and
+ * keeps them there until `unpin()` is called or the dataset is flushed
+ * or closed.
+ * @async
+ *
+ * @static
+ * @method pinAsync
+ * @memberof blockCache
+ * @param {Dataset} dataset
+ * @param {number[]} [overviews] The overview levels to pin, all of them by default
+ * @param {callback<number>} [callback=undefined]
+ * @throws {Error}
+ * @return {Promise<number>}
+ */
+GDAL_ASYNCABLE_DEFINE(BlockCache::pin) {
+  Dataset *ds;
+  NODE_ARG_WRAPPED(0, "dataset", Dataset, ds);
+  GDAL_RAW_CHECK(GDALDataset *, ds, raw);
+  Local<Array> overviews_arg;
+  NODE_ARG_ARRAY_OPT(1, "overviews", overviews_arg);
+
+  bool all = overviews_arg.IsEmpty();
+  std::vector<int> overviews;
+  if (!all) {
+    for (unsigned i = 0; i < overviews_arg->Length(); i++) {
+      Local<Value> el = Nan::Get(overviews_arg, i).ToLocalChecked();
+      if (!el->IsNumber()) {
+        Nan::ThrowTypeError("overviews must contain only numbers");
+        return;
+      }
+      overviews.push_back(Nan::To<int32_t>(el).ToChecked());
+    }
+  }
+
+  long uid = ds->uid;
+  GDALAsyncableJob<GIntBig> job(uid);
+  job.main = [raw, uid, all, overviews](const GDALExecutionProgress &) {
+    if (raw->GetAccess() != GA_ReadOnly) throw "Only the datasets opened in read-only mode can be pinned";
+    Unpin(uid);
+
+    std::vector<GDALRasterBand *> bands;
+    GIntBig estimate = 0;
+    for (int b = 1; b <= raw->GetRasterCount(); b++) {
+      GDALRasterBand *band = raw->GetRasterBand(b);
+      std::vector<int> levels = overviews;
+      if (all)
+        for (int o = 0; o < band->GetOverviewCount(); o++) levels.push_back(o);
+      for (int o : levels) {
+        if (o < 0 || o >= band->GetOverviewCount()) throw "Invalid overview level";
+        GDALRasterBand *overview = band->GetOverview(o);
+        if (overview == nullptr) continue;
+        int bw, bh;
+        overview->GetBlockSize(&bw, &bh);
+        estimate += static_cast<GIntBig>((overview->GetXSize() + bw - 1) / bw) *
+          ((overview->GetYSize() + bh - 1) / bh) * bw * bh *
+          GDALGetDataTypeSizeBytes(overview->GetRasterDataType());
+        bands.push_back(overview);
+      }
+    }
+    // The estimate is reserved before loading so that concurrent pins cannot exceed the limit together
+    {
+      std::lock_guard<std::mutex> lock(pinsLock);
+      if (pinnedBytes + estimate > GDALGetCacheMax64() / 2)
+        throw "The pinned blocks cannot exceed half of the block cache";
+      pinnedBytes += estimate;
+    }
+
+    Pin pin = {{}, 0};
+    for (GDALRasterBand *band : bands) {
+      int bw, bh;
+      band->GetBlockSize(&bw, &bh);
+      const int nx = (band->GetXSize() + bw - 1) / bw;
+      const int ny = (band->GetYSize() + bh - 1) / bh;
+      for (int y = 0; y < ny; y++)
+        for (int x = 0; x < nx; x++) {
+          CPLErrorReset();
+          GDALRasterBlock *block = band->GetLockedBlockRef(x, y);
+          if (block == nullptr) {
+            for (GDALRasterBlock *pinned : pin.blocks) pinned->DropLock();
+            std::lock_guard<std::mutex> lock(pinsLock);
+            pinnedBytes -= estimate;
+            throw CPLGetLastErrorMsg();
+          }
+          pin.blocks.push_back(block);
+          pin.bytes += block->GetBlockSize();
+        }
+    }
+
+    std::lock_guard<std::mutex> lock(pinsLock);
+    pinnedBytes += pin.bytes - estimate;
+    pins[uid] = std::move(pin);
+    return pins[uid].bytes;
+  };
+  job.rval = [](GIntBig bytes, const GetFromPersistentFunc &) {
+    return Nan::New<Number>(static_cast<double>(bytes)).As<Value>();
+  };
+  job.run(info, async, 2);
+}
+
+/**
+ * Releases the blocks pinned with `pin()`, they go back to the LRU cache.
+ *
+ * @static
+ * @method unpin
+ * @memberof blockCache
+ * @param {Dataset} dataset
+ * @throws {Error}
+ * @return {void}
+ */
+NAN_METHOD(BlockCache::unpin) {
+  Dataset *ds;
+  NODE_ARG_WRAPPED(0, "dataset", Dataset, ds);
+  Unpin(ds->uid);
+}
+
+} // namespace node_gdal
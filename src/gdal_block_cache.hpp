@@ -0,0 +1,40 @@
+#ifndef __NODE_GDAL_BLOCK_CACHE_H__
+#define __NODE_GDAL_BLOCK_CACHE_H__
+
+// node
+#include <node.h>
+#include <node_object_wrap.h>
+
+// nan
+#include "nan-wrapper.h"
+
+// gdal
+#include <gdal_priv.h>
+
+#include "gdal_common.hpp"
+
+#include "async.hpp"
+
+using namespace v8;
+using namespace node;
+
+// The GDAL raster block cache
+
+namespace node_gdal {
+
+namespace BlockCache {
+
+void Initialize(Local<Object> target);
+GDAL_ASYNCABLE_GLOBAL(stats);
+NAN_METHOD(setMaxBytes);
+GDAL_ASYNCABLE_GLOBAL(flushDataset);
+GDAL_ASYNCABLE_GLOBAL(pin);
+NAN_METHOD(unpin);
+
+// Releases the blocks pinned for a dataset, must be called before
+// anything that can flush its cache (closing, flushing), any thread
+void Unpin(long uid);
+
+} // namespace BlockCache
+} // namespace node_gdal
+#endif
@@ -10,6 +10,7 @@
 #include "nan-wrapper.h"
 
 #include "utils/ptr_manager.hpp"
+#include "utils/sync_profile.hpp"
 
 #if GDAL_VERSION_MAJOR < 2 || (GDAL_VERSION_MAJOR == 2 && GDAL_VERSION_MINOR < 2)
 #error gdal-async now requires GDAL >= 2.2, downgrade to gdal-async@3.6.x for earlier versions
@@ -88,34 +89,55 @@ std::shared_ptr<RETURN> NumberArrayToSharedPtr(Local<Array> array, size_t count
 
 #define NODE_THROW_OGRERR(err) Nan::ThrowError(getOGRErrMsg(err))
 
-#define ATTR(t, name, get, set) Nan::SetAccessor(t->InstanceTemplate(), Nan::New(name).ToLocalChecked(), get, set);
+// The methods and getters go through the trampolines of the sync profiler, see utils/sync_profile.hpp
+#define ATTR(t, name, get, set)                                                                                        \
+  Nan::SetAccessor(                                                                                                    \
+    t->InstanceTemplate(),                                                                                             \
+    Nan::New(name).ToLocalChecked(),                                                                                   \
+    node_gdal::SyncProfile::GetterTrampoline,                                                                          \
+    set,                                                                                                               \
+    node_gdal::SyncProfile::Getter(get, name));
 
 #define ATTR_ASYNCABLE(t, name, get, set)                                                                              \
-  Nan::SetAccessor(t->InstanceTemplate(), Nan::New(name).ToLocalChecked(), get, set);                                  \
+  ATTR(t, name, get, set);                                                                                             \
   Nan::SetAccessor(                                                                                                    \
     t->InstanceTemplate(),                                                                                             \
     Nan::New(name "Async").ToLocalChecked(),                                                                           \
-    get##Async,                                                                                                        \
+    node_gdal::SyncProfile::GetterTrampoline,                                                                          \
     READ_ONLY_SETTER,                                                                                                  \
-    Local<Value>(),                                                                                                    \
+    node_gdal::SyncProfile::Getter(get##Async, name "Async"),                                                          \
     DEFAULT,                                                                                                           \
     DontEnum);
 
 #define ATTR_DONT_ENUM(t, name, get, set)                                                                              \
-  Nan::SetAccessor(t->InstanceTemplate(), Nan::New(name).ToLocalChecked(), get, set, Local<Value>(), DEFAULT, DontEnum);
+  Nan::SetAccessor(                                                                                                    \
+    t->InstanceTemplate(),                                                                                             \
+    Nan::New(name).ToLocalChecked(),                                                                                   \
+    node_gdal::SyncProfile::GetterTrampoline,                                                                          \
+    set,                                                                                                               \
+    node_gdal::SyncProfile::Getter(get, name),                                                                         \
+    DEFAULT,                                                                                                           \
+    DontEnum);
 
 NAN_SETTER(READ_ONLY_SETTER);
 
 #define IS_WRAPPED(obj, type) Nan::New(type::constructor)->HasInstance(obj)
 
 // ----- async method definition shortcuts ------
+#define Nan__SetMethod(lcons, name, method)                                                                            \
+  Nan::SetMethod(lcons, name, node_gdal::SyncProfile::MethodTrampoline, node_gdal::SyncProfile::Method(method, name))
+
+#define Nan__SetPrototypeMethod(lcons, name, method)                                                                   \
+  Nan::SetPrototypeMethod(                                                                                             \
+    lcons, name, node_gdal::SyncProfile::MethodTrampoline, node_gdal::SyncProfile::Method(method, name))
+
 #define Nan__SetAsyncableMethod(lcons, name, method)                                                                   \
-  Nan::SetMethod(lcons, name, method);                                                                                 \
-  Nan::SetMethod(lcons, name "Async", method##Async)
+  Nan__SetMethod(lcons, name, method);                                                                                 \
+  Nan__SetMethod(lcons, name "Async", method##Async)
 
 #define Nan__SetPrototypeAsyncableMethod(lcons, name, method)                                                          \
-  Nan::SetPrototypeMethod(lcons, name, method);                                                                        \
-  Nan::SetPrototypeMethod(lcons, name "Async", method##Async)
+  Nan__SetPrototypeMethod(lcons, name, method);                                                                        \
+  Nan__SetPrototypeMethod(lcons, name "Async", method##Async)
 
 #define NODE_UNWRAP_CHECK(type, obj, var)                                                                              \
   if (!obj->IsObject() || obj->IsNull() || !Nan::New(type::constructor)->HasInstance(obj)) {                           \
@@ -2,6 +2,8 @@
 #include "gdal_group.hpp"
 #include "collections/dataset_bands.hpp"
 #include "collections/dataset_layers.hpp"
+#include "collections/rasterband_pixels.hpp"
+#include "gdal_block_cache.hpp"
 #include "gdal_common.hpp"
 #include "gdal_driver.hpp"
 #include "geometry/gdal_geometry.hpp"
@@ -9,7 +11,10 @@
 #include "gdal_majorobject.hpp"
 #include "gdal_rasterband.hpp"
 #include "gdal_spatial_reference.hpp"
+#include "utils/overview_builder.hpp"
+#include "utils/raster_sampler.hpp"
 #include "utils/string_list.hpp"
+#include "utils/typed_array.hpp"
 
 namespace node_gdal {
 
@@ -22,18 +27,19 @@ void Dataset::Initialize(Local<Object> target) {
   lcons->InstanceTemplate()->SetInternalFieldCount(1);
   lcons->SetClassName(Nan::New("Dataset").ToLocalChecked());
 
-  Nan::SetPrototypeMethod(lcons, "toString", toString);
-  Nan::SetPrototypeMethod(lcons, "setGCPs", setGCPs);
-  Nan::SetPrototypeMethod(lcons, "getGCPs", getGCPs);
-  Nan::SetPrototypeMethod(lcons, "getGCPProjection", getGCPProjection);
-  Nan::SetPrototypeMethod(lcons, "getFileList", getFileList);
+  Nan__SetPrototypeMethod(lcons, "toString", toString);
+  Nan__SetPrototypeMethod(lcons, "setGCPs", setGCPs);
+  Nan__SetPrototypeMethod(lcons, "getGCPs", getGCPs);
+  Nan__SetPrototypeMethod(lcons, "getGCPProjection", getGCPProjection);
+  Nan__SetPrototypeMethod(lcons, "getFileList", getFileList);
   Nan__SetPrototypeAsyncableMethod(lcons, "flush", flush);
-  Nan::SetPrototypeMethod(lcons, "close", close);
+  Nan__SetPrototypeMethod(lcons, "close", close);
   Nan__SetPrototypeAsyncableMethod(lcons, "getMetadata", getMetadata);
   Nan__SetPrototypeAsyncableMethod(lcons, "setMetadata", setMetadata);
-  Nan::SetPrototypeMethod(lcons, "testCapability", testCapability);
+  Nan__SetPrototypeMethod(lcons, "testCapability", testCapability);
   Nan__SetPrototypeAsyncableMethod(lcons, "executeSQL", executeSQL);
   Nan__SetPrototypeAsyncableMethod(lcons, "buildOverviews", buildOverviews);
+  Nan__SetPrototypeAsyncableMethod(lcons, "sample", sample);
 
   ATTR_DONT_ENUM(lcons, "_uid", uidGetter, READ_ONLY_SETTER);
   ATTR(lcons, "description", descriptionGetter, READ_ONLY_SETTER);
@@ -340,8 +346,10 @@ NAN_METHOD(Dataset::close) {
 GDAL_ASYNCABLE_DEFINE(Dataset::flush) {
   NODE_UNWRAP_CHECK(Dataset, info.This(), ds);
   GDAL_RAW_CHECK(GDALDataset *, ds, raw);
-  GDALAsyncableJob<int> job(ds->uid);
-  job.main = [raw](const GDALExecutionProgress &) {
+  long uid = ds->uid;
+  GDALAsyncableJob<int> job(uid);
+  job.main = [raw, uid](const GDALExecutionProgress &) {
+    BlockCache::Unpin(uid);
     raw->FlushCache();
     return 0;
   };
@@ -582,35 +590,54 @@ NAN_METHOD(Dataset::setGCPs) {
   return;
 }
 
+/**
+ * @typedef {object} BuildOverviewsOptions
+ * @property {ProgressCb} [progress_cb]
+ * @property {AbortSignal} [signal]
+ * @property {number} [concurrency]
+ */
+
 /**
  * Builds dataset overviews.
  *
+ * When `concurrency` is set, the overviews are computed by a multi-threaded
+ * builder instead of GDAL: each level is computed from the previous level
+ * and the tiles of a level are resampled in parallel on `concurrency` threads
+ * (`0` for `GDAL_NUM_THREADS`). It supports the `"NEAREST"`, `"AVERAGE"`, `"MODE"`,
+ * `"GAUSS"` and `"RMS"` resampling methods and it ignores the masks
+ * and the alpha bands.
+ *
  * @throws {Error}
  * @method buildOverviews
  * @instance
  * @memberof Dataset
  * @param {string} resampling `"NEAREST"`, `"GAUSS"`, `"CUBIC"`, `"AVERAGE"`,
- * `"MODE"`, `"AVERAGE_MAGPHASE"` or `"NONE"`
+ * `"MODE"`, `"RMS"`, `"AVERAGE_MAGPHASE"` or `"NONE"`
  * @param {number[]} overviews
  * @param {number[]} [bands] Note: Generation of overviews in external TIFF currently only supported when operating on all bands.
- * @param {ProgressOptions} [options] options
+ * @param {BuildOverviewsOptions} [options] options
  * @param {ProgressCb} [options.progress_cb]
+ * @param {number} [options.concurrency] Use the multi-threaded builder with this many threads
  */
 
 /**
  * Builds dataset overviews.
  * @async
  *
+ * When `concurrency` is set, the overviews are computed by a multi-threaded
+ * builder instead of GDAL, see {@link Dataset.buildOverviews}.
+ *
  * @throws {Error}
  * @method buildOverviewsAsync
  * @instance
  * @memberof Dataset
  * @param {string} resampling `"NEAREST"`, `"GAUSS"`, `"CUBIC"`, `"AVERAGE"`,
- * `"MODE"`, `"AVERAGE_MAGPHASE"` or `"NONE"`
+ * `"MODE"`, `"RMS"`, `"AVERAGE_MAGPHASE"` or `"NONE"`
  * @param {number[]} overviews
  * @param {number[]} [bands] Note: Generation of overviews in external TIFF currently only supported when operating on all bands.
- * @param {ProgressOptions} [options] options
+ * @param {BuildOverviewsOptions} [options] options
  * @param {ProgressCb} [options.progress_cb]
+ * @param {number} [options.concurrency] Use the multi-threaded builder with this many threads
  * @param {callback<void>} [callback=undefined]
  * @return {Promise<void>}
  */
@@ -655,21 +682,58 @@ GDAL_ASYNCABLE_DEFINE(Dataset::buildOverviews) {
     }
   }
 
-  GDALAsyncableJob<CPLErr> job(ds->uid);
+  long uid = ds->uid;
+  GDALAsyncableJob<CPLErr> job(uid);
 
   Nan::Callback *progress_cb;
   NODE_PROGRESS_CB_OPT(3, progress_cb, job);
   job.progress = progress_cb;
+
+  // -1 is GDAL's own single-threaded implementation
+  int concurrency = -1;
+  if (info.Length() > 3 && info[3]->IsObject()) {
+    Local<Object> options = info[3].As<Object>();
+    NODE_INT_FROM_OBJ_OPT(options, "concurrency", concurrency);
+    if (Nan::HasOwnProperty(options, Nan::New("concurrency").ToLocalChecked()).FromMaybe(false) && concurrency < 0) {
+      Nan::ThrowRangeError("concurrency must not be negative");
+      return;
+    }
+  }
+
+  if (concurrency >= 0) {
+    OverviewResampling alg;
+    if (!ParseOverviewResampling(resampling, alg)) {
+      Nan::ThrowError("The multi-threaded overview builder supports only NEAREST, AVERAGE, MODE, GAUSS and RMS");
+      return;
+    }
+    std::vector<int> levels(o.get(), o.get() + n_overviews);
+    std::vector<int> band_list;
+    if (b != nullptr) band_list.assign(b.get(), b.get() + n_bands);
+    job.main = [raw, uid, alg, levels, band_list, concurrency](const GDALExecutionProgress &progress) {
+      // The overviews are rewritten
+      BlockCache::Unpin(uid);
+      BuildOverviewsParallel(raw, alg, levels, band_list, concurrency, [&progress](double complete) {
+        if (progress.active() && !ProgressTrampoline(complete, "", (void *)&progress)) throw abortedMessage;
+      });
+      return CE_None;
+    };
+    job.rval = [](CPLErr, const GetFromPersistentFunc &) { return Nan::Undefined().As<Value>(); };
+    job.run(info, async, 4);
+    return;
+  }
+
   // Alas one cannot capture-move a unique_ptr and assign the lambda to a variable
   // because the lambda becomes non-copyable
   // But we can use a shared_ptr because the lifetime of the lambda is limited by the lifetime
   // of the async worker
-  job.main = [raw, resampling, n_overviews, o, n_bands, b, progress_cb](const GDALExecutionProgress &progress) {
+  job.main = [raw, uid, resampling, n_overviews, o, n_bands, b](const GDALExecutionProgress &progress) {
     if (b != nullptr) {
       for (int i = 0; i < n_bands; i++) {
         if (b.get()[i] > raw->GetRasterCount() || b.get()[i] < 1) { throw "invalid band id"; }
       }
     }
+    // GDAL flushes the dataset
+    BlockCache::Unpin(uid);
     CPLErrorReset();
     CPLErr err = raw->BuildOverviews(
       resampling.c_str(),
@@ -677,8 +741,8 @@ GDAL_ASYNCABLE_DEFINE(Dataset::buildOverviews) {
       o.get(),
       n_bands,
       b.get(),
-      progress_cb ? ProgressTrampoline : nullptr,
-      progress_cb ? (void *)&progress : nullptr);
+      progress.active() ? ProgressTrampoline : nullptr,
+      progress.active() ? (void *)&progress : nullptr);
     if (err != CE_None) { throw CPLGetLastErrorMsg(); }
     return err;
   };
@@ -687,6 +751,115 @@ GDAL_ASYNCABLE_DEFINE(Dataset::buildOverviews) {
   job.run(info, async, 4);
 }
 
+/**
+ * @typedef {object} DatasetSampleOptions
+ * @property {string} [coords]
+ * @property {string} [interpolation]
+ * @property {number[]} [bands]
+ */
+
+/**
+ * Returns the values of several bands at many points in one call.
+ *
+ * The points are sorted by the block that contains them and each
+ * block is read only once, see {@link RasterBandPixels.sample}.
+ *
+ * The result is band-sequential: the value of the `b`-th requested band
+ * at the point `i` is at index `b * xs.length + i`.
+ *
+ * @example
+ * const rgb = ds.sample(lons, lats, { coords: 'geo', bands: [ 1, 2, 3 ] })
+ * const red = rgb.subarray(0, lons.length)
+ *
+ * @method sample
+ * @instance
+ * @memberof Dataset
+ * @throws {Error}
+ * @param {Float64Array} xs
+ * @param {Float64Array} ys
+ * @param {DatasetSampleOptions} [options]
+ * @param {string} [options.coords="pixel"] `pixel` for pixel/line coordinates or `geo` for coordinates in the spatial reference system of the dataset
+ * @param {string} [options.interpolation="nearest"] `nearest`, `bilinear` or `cubic`
+ * @param {number[]} [options.bands] The band numbers, all the bands if not given
+ * @return {Float64Array}
+ */
+
+/**
+ * Returns the values of several bands at many points in one call.
+ * @async
+ *
+ * The points are sorted by the block that contains them and each
+ * block is read only once, see {@link RasterBandPixels.sampleAsync}.
+ *
+ * The result is band-sequential: the value of the `b`-th requested band
+ * at the point `i` is at index `b * xs.length + i`.
+ *
+ * @method sampleAsync
+ * @instance
+ * @memberof Dataset
+ * @throws {Error}
+ * @param {Float64Array} xs
+ * @param {Float64Array} ys
+ * @param {DatasetSampleOptions} [options]
+ * @param {string} [options.coords="pixel"] `pixel` for pixel/line coordinates or `geo` for coordinates in the spatial reference system of the dataset
+ * @param {string} [options.interpolation="nearest"] `nearest`, `bilinear` or `cubic`
+ * @param {number[]} [options.bands] The band numbers, all the bands if not given
+ * @param {callback<Float64Array>} [callback=undefined]
+ * @return {Promise<Float64Array>}
+ */
+GDAL_ASYNCABLE_DEFINE(Dataset::sample) {
+
+  NODE_UNWRAP_CHECK(Dataset, info.This(), ds);
+  GDAL_RAW_CHECK(GDALDataset *, ds, raw);
+
+  std::shared_ptr<std::vector<double>> xs, ys;
+  bool geo;
+  SampleInterpolation interpolation;
+  Local<Object> options;
+  if (!RasterBandPixels::parseSampleArgs(info, xs, ys, geo, interpolation, options)) return;
+
+  std::vector<int> band_list;
+  Local<Array> bands;
+  if (!options.IsEmpty()) { NODE_ARRAY_FROM_OBJ_OPT(options, "bands", bands); }
+  if (!bands.IsEmpty()) {
+    for (unsigned i = 0; i < bands->Length(); i++) {
+      Local<Value> val = Nan::Get(bands, i).ToLocalChecked();
+      if (!val->IsNumber()) {
+        Nan::ThrowError("band array must only contain numbers");
+        return;
+      }
+      band_list.push_back(Nan::To<int32_t>(val).ToChecked());
+    }
+  } else {
+    for (int i = 1; i <= raw->GetRasterCount(); i++) band_list.push_back(i);
+  }
+  for (int b : band_list) {
+    if (b < 1 || b > raw->GetRasterCount()) {
+      Nan::ThrowRangeError("invalid band id");
+      return;
+    }
+  }
+
+  size_t n = xs->size();
+  Local<Value> array = TypedArray::New(GDT_Float64, n * band_list.size());
+  if (array.IsEmpty() || !array->IsObject()) {
+    return; // TypedArray::New threw an error
+  }
+  double *data = *Nan::TypedArrayContents<double>(array);
+
+  GDALAsyncableJob<int> job(ds->uid);
+  job.persist("array", array.As<Object>());
+  job.main = [raw, xs, ys, n, geo, interpolation, band_list, data](const GDALExecutionProgress &) {
+    std::vector<GDALRasterBand *> gdal_bands;
+    for (int b : band_list) gdal_bands.push_back(raw->GetRasterBand(b));
+    if (geo) GeoToPixel(raw, xs->data(), ys->data(), n);
+    SampleBands(gdal_bands, xs->data(), ys->data(), n, interpolation, data);
+    return 0;
+  };
+  job.rval = [](int, const GetFromPersistentFunc &getter) { return getter("array"); };
+  job.run(info, async, 3);
+}
+
 /**
  * @readonly
  * @kind member
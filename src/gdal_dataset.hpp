@@ -42,6 +42,7 @@ class Dataset : public Nan::ObjectWrap {
   GDAL_ASYNCABLE_DECLARE(executeSQL);
   static NAN_METHOD(testCapability);
   GDAL_ASYNCABLE_DECLARE(buildOverviews);
+  GDAL_ASYNCABLE_DECLARE(sample);
   static NAN_METHOD(close);
 
   static NAN_GETTER(bandsGetter);
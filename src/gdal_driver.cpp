@@ -17,14 +17,14 @@ void Driver::Initialize(Local<Object> target) {
   lcons->InstanceTemplate()->SetInternalFieldCount(1);
   lcons->SetClassName(Nan::New("Driver").ToLocalChecked());
 
-  Nan::SetPrototypeMethod(lcons, "toString", toString);
+  Nan__SetPrototypeMethod(lcons, "toString", toString);
   Nan__SetPrototypeAsyncableMethod(lcons, "open", open);
   Nan__SetPrototypeAsyncableMethod(lcons, "create", create);
   Nan__SetPrototypeAsyncableMethod(lcons, "createCopy", createCopy);
-  Nan::SetPrototypeMethod(lcons, "deleteDataset", deleteDataset);
-  Nan::SetPrototypeMethod(lcons, "rename", rename);
-  Nan::SetPrototypeMethod(lcons, "copyFiles", copyFiles);
-  Nan::SetPrototypeMethod(lcons, "getMetadata", getMetadata);
+  Nan__SetPrototypeMethod(lcons, "deleteDataset", deleteDataset);
+  Nan__SetPrototypeMethod(lcons, "rename", rename);
+  Nan__SetPrototypeMethod(lcons, "copyFiles", copyFiles);
+  Nan__SetPrototypeMethod(lcons, "getMetadata", getMetadata);
 
   ATTR(lcons, "description", descriptionGetter, READ_ONLY_SETTER);
 
@@ -238,6 +238,7 @@ GDAL_ASYNCABLE_DEFINE(Driver::create) {
 /**
  * @typedef {object} CreateOptions
  * @property {ProgressCb} [progress_cb]
+ * @property {AbortSignal} [signal]
  */
 
 /**
@@ -319,11 +320,16 @@ GDAL_ASYNCABLE_DEFINE(Driver::createCopy) {
   job.persist(driver->handle());
   job.progress = progress_cb;
 
-  job.main = [raw, filename, raw_ds, strict, options, progress_cb](const GDALExecutionProgress &progress) {
+  job.main = [raw, filename, raw_ds, strict, options](const GDALExecutionProgress &progress) {
     std::unique_ptr<StringList> options_ptr(options);
     CPLErrorReset();
     GDALDataset *ds = raw->CreateCopy(
-      filename.c_str(), raw_ds, strict, options->get(), progress_cb ? ProgressTrampoline : nullptr, (void *)&progress);
+      filename.c_str(),
+      raw_ds,
+      strict,
+      options->get(),
+      progress.active() ? ProgressTrampoline : nullptr,
+      (void *)&progress);
     if (!ds) throw CPLGetLastErrorMsg();
     return ds;
   };
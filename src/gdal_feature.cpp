@@ -18,21 +18,21 @@ void Feature::Initialize(Local<Object> target) {
   lcons->InstanceTemplate()->SetInternalFieldCount(1);
   lcons->SetClassName(Nan::New("Feature").ToLocalChecked());
 
-  Nan::SetPrototypeMethod(lcons, "toString", toString);
-  Nan::SetPrototypeMethod(lcons, "getGeometry", getGeometry);
-  // Nan::SetPrototypeMethod(lcons, "setGeometryDirectly", setGeometryDirectly);
-  Nan::SetPrototypeMethod(lcons, "setGeometry", setGeometry);
-  // Nan::SetPrototypeMethod(lcons, "stealGeometry", stealGeometry);
-  Nan::SetPrototypeMethod(lcons, "clone", clone);
-  // Nan::SetPrototypeMethod(lcons, "equals", equals);
-  // Nan::SetPrototypeMethod(lcons, "getFieldDefn", getFieldDefn); (use
+  Nan__SetPrototypeMethod(lcons, "toString", toString);
+  Nan__SetPrototypeMethod(lcons, "getGeometry", getGeometry);
+  // Nan__SetPrototypeMethod(lcons, "setGeometryDirectly", setGeometryDirectly);
+  Nan__SetPrototypeMethod(lcons, "setGeometry", setGeometry);
+  // Nan__SetPrototypeMethod(lcons, "stealGeometry", stealGeometry);
+  Nan__SetPrototypeMethod(lcons, "clone", clone);
+  // Nan__SetPrototypeMethod(lcons, "equals", equals);
+  // Nan__SetPrototypeMethod(lcons, "getFieldDefn", getFieldDefn); (use
   // defn.fields.get() instead)
-  Nan::SetPrototypeMethod(lcons, "setFrom", setFrom);
+  Nan__SetPrototypeMethod(lcons, "setFrom", setFrom);
 
   // Note: This is used mainly for testing
   // TODO: Give node more info on the amount of memory a feature is using
   //      Nan::AdjustExternalMemory()
-  Nan::SetPrototypeMethod(lcons, "destroy", destroy);
+  Nan__SetPrototypeMethod(lcons, "destroy", destroy);
 
   ATTR(lcons, "fields", fieldsGetter, READ_ONLY_SETTER);
   ATTR(lcons, "defn", defnGetter, READ_ONLY_SETTER);
@@ -15,8 +15,8 @@ void FeatureDefn::Initialize(Local<Object> target) {
   lcons->InstanceTemplate()->SetInternalFieldCount(1);
   lcons->SetClassName(Nan::New("FeatureDefn").ToLocalChecked());
 
-  Nan::SetPrototypeMethod(lcons, "toString", toString);
-  Nan::SetPrototypeMethod(lcons, "clone", clone);
+  Nan__SetPrototypeMethod(lcons, "toString", toString);
+  Nan__SetPrototypeMethod(lcons, "clone", clone);
 
   ATTR(lcons, "name", nameGetter, READ_ONLY_SETTER);
   ATTR(lcons, "fields", fieldsGetter, READ_ONLY_SETTER);
@@ -1,4 +1,6 @@
 #include "gdal_fs.hpp"
+#include "gdal_dataset.hpp"
+#include "utils/vsi_stats.hpp"
 
 namespace node_gdal {
 
@@ -13,6 +15,10 @@ void VSI::Initialize(Local<Object> target) {
   Nan::Set(target, Nan::New("fs").ToLocalChecked(), fs);
   Nan__SetAsyncableMethod(fs, "stat", stat);
   Nan__SetAsyncableMethod(fs, "readDir", readDir);
+  Nan__SetAsyncableMethod(fs, "ioStats", ioStats);
+  Nan__SetMethod(fs, "_resetIOStats", resetIOStats);
+
+  VSIStats::Install();
 }
 
 /**
@@ -248,4 +254,195 @@ GDAL_ASYNCABLE_DEFINE(VSI::readDir) {
   };
   job.run(info, async, 1);
 }
+
+struct IOStatsResult {
+  std::map<std::string, VSIStats::IOSnapshot> prefixes;
+  std::map<std::string, VSIStats::IOSnapshot> files;
+  std::string network;
+  bool dataset;
+  VSIStats::IOSnapshot total;
+};
+
+static Local<Object> IOSnapshotToObject(const VSIStats::IOSnapshot &io) {
+  Nan::EscapableHandleScope scope;
+  Local<Object> obj = Nan::New<Object>();
+  Nan::Set(obj, Nan::New("opens").ToLocalChecked(), Nan::New<Number>(io.opens));
+  Nan::Set(obj, Nan::New("reads").ToLocalChecked(), Nan::New<Number>(io.reads));
+  Nan::Set(obj, Nan::New("bytesRead").ToLocalChecked(), Nan::New<Number>(io.bytesRead));
+  Nan::Set(obj, Nan::New("ranges").ToLocalChecked(), Nan::New<Number>(io.ranges));
+  Nan::Set(obj, Nan::New("seeks").ToLocalChecked(), Nan::New<Number>(io.seeks));
+  Nan::Set(obj, Nan::New("writes").ToLocalChecked(), Nan::New<Number>(io.writes));
+  Nan::Set(obj, Nan::New("bytesWritten").ToLocalChecked(), Nan::New<Number>(io.bytesWritten));
+  return scope.Escape(obj);
+}
+
+/**
+ * @typedef {object} VSIIOStats
+ * @memberof fs
+ * @property {number} opens
+ * @property {number} reads
+ * @property {number} bytesRead
+ * @property {number} ranges
+ * @property {number} seeks
+ * @property {number} writes
+ * @property {number} bytesWritten
+ */
+
+/**
+ * @typedef {object} VSIIOReport
+ * @memberof fs
+ * @property {Record<string, VSIIOStats>} prefixes
+ * @property {Record<string, VSIIOStats>} files
+ * @property {any} network
+ */
+
+/**
+ * Get the I/O statistics of the files accessed through `/vsistats/`.
+ *
+ * `/vsistats/` is a pass-through file system that counts the operations on
+ * the files opened through it: `/vsistats//vsis3/bucket/file.tif` reads
+ * `/vsis3/bucket/file.tif`. The operations are counted per file system
+ * prefix (`/vsis3/`, `/vsicurl/`, `/vsimem/`, ... or `file` for the local files)
+ * and per file (without the `/vsistats/` prefix, at most 1024 files).
+ *
+ * `ranges` is the number of reads that do not continue the previous one,
+ * a multi-range read counting its ranges - the number of range requests
+ * before GDAL's own caching. The HTTP requests actually made by the network
+ * file systems are reported in `network` when the `CPL_VSIL_NETWORK_STATS_ENABLED`
+ * configuration option is set to `YES` (GDAL >= 3.7).
+ *
+ * The reads are also attributed to the GDAL jobs in {@link stats}.
+ *
+ * Requires GDAL >= 3.7.
+ *
+ * @example
+ * const ds = gdal.open('/vsistats//vsicurl/https://example.com/cog.tif')
+ * await ds.bands.get(1).pixels.readAsync(0, 0, 256, 256)
+ * console.log(gdal.fs.ioStats(ds).ranges)
+ * console.log(gdal.fs.ioStats().prefixes['/vsicurl/'])
+ *
+ * @static
+ * @method ioStats
+ * @memberof fs
+ * @throws {Error}
+ * @returns {VSIIOReport}
+ */
+
+/**
+ * Get the I/O statistics of a dataset opened through `/vsistats/`,
+ * the sum of the statistics of all its files.
+ *
+ * @static
+ * @method ioStats
+ * @memberof fs
+ * @param {Dataset} dataset
+ * @throws {Error}
+ * @returns {VSIIOStats}
+ */
+
+/**
+ * Get the I/O statistics of the files accessed through `/vsistats/`.
+ * @async
+ *
+ * @static
+ * @method ioStatsAsync
+ * @memberof fs
+ * @param {undefined} [dataset]
+ * @param {callback<VSIIOReport>} [callback=undefined]
+ * @throws {Error}
+ * @returns {Promise<VSIIOReport>}
+ */
+
+/**
+ * Get the I/O statistics of a dataset opened through `/vsistats/`.
+ * @async
+ *
+ * @static
+ * @method ioStatsAsync
+ * @memberof fs
+ * @param {Dataset} dataset
+ * @param {callback<VSIIOStats>} [callback=undefined]
+ * @throws {Error}
+ * @returns {Promise<VSIIOStats>}
+ */
+GDAL_ASYNCABLE_DEFINE(VSI::ioStats) {
+#ifndef VSI_STATS_SUPPORTED
+  Nan::ThrowError("ioStats requires GDAL 3.7");
+  return;
+#else
+  Dataset *ds = nullptr;
+  NODE_ARG_WRAPPED_OPT(0, "dataset", Dataset, ds);
+  GDALDataset *raw = ds ? ds->get() : nullptr;
+
+  GDALAsyncableJob<IOStatsResult> job(ds ? ds->uid : 0);
+  job.main = [raw](const GDALExecutionProgress &) {
+    IOStatsResult r;
+    r.dataset = raw != nullptr;
+    r.total = {0, 0, 0, 0, 0, 0, 0};
+    VSIStats::Snapshot(r.prefixes, r.files);
+    if (raw == nullptr) {
+      char *network = VSINetworkStatsGetAsSerializedJSON(nullptr);
+      if (network != nullptr) r.network = network;
+      CPLFree(network);
+      return r;
+    }
+
+    char **list = raw->GetFileList();
+    for (int i = 0; list != nullptr && list[i] != nullptr; i++) {
+      const char *file = list[i];
+      if (strncmp(file, "/vsistats/", 10) == 0) file += 10;
+      auto it = r.files.find(file);
+      if (it == r.files.end()) continue;
+      r.total.opens += it->second.opens;
+      r.total.reads += it->second.reads;
+      r.total.bytesRead += it->second.bytesRead;
+      r.total.ranges += it->second.ranges;
+      r.total.seeks += it->second.seeks;
+      r.total.writes += it->second.writes;
+      r.total.bytesWritten += it->second.bytesWritten;
+    }
+    CSLDestroy(list);
+    return r;
+  };
+  job.rval = [](IOStatsResult r, const GetFromPersistentFunc &) {
+    Nan::EscapableHandleScope scope;
+    if (r.dataset) return scope.Escape(IOSnapshotToObject(r.total).As<Value>());
+
+    Local<Object> result = Nan::New<Object>();
+    Local<Object> prefixes = Nan::New<Object>();
+    for (const auto &p : r.prefixes)
+      Nan::Set(prefixes, Nan::New(p.first).ToLocalChecked(), IOSnapshotToObject(p.second));
+    Nan::Set(result, Nan::New("prefixes").ToLocalChecked(), prefixes);
+    Local<Object> files = Nan::New<Object>();
+    for (const auto &f : r.files) Nan::Set(files, Nan::New(f.first).ToLocalChecked(), IOSnapshotToObject(f.second));
+    Nan::Set(result, Nan::New("files").ToLocalChecked(), files);
+    Local<Value> network = Nan::Null();
+    if (!r.network.empty()) {
+      Nan::JSON json;
+      Nan::MaybeLocal<Value> parsed = json.Parse(Nan::New(r.network).ToLocalChecked());
+      if (!parsed.IsEmpty()) network = parsed.ToLocalChecked();
+    }
+    Nan::Set(result, Nan::New("network").ToLocalChecked(), network);
+    return scope.Escape(result.As<Value>());
+  };
+  job.run(info, async, 1);
+#endif
+}
+
+/**
+ * Resets the statistics returned by {@link fs.ioStats}, including
+ * the network statistics of GDAL.
+ *
+ * @static
+ * @method reset
+ * @memberof fs.ioStats
+ * @return {void}
+ */
+NAN_METHOD(VSI::resetIOStats) {
+  VSIStats::Reset();
+#ifdef VSI_STATS_SUPPORTED
+  VSINetworkStatsReset();
+#endif
+}
+
 } // namespace node_gdal
@@ -28,6 +28,8 @@ namespace VSI {
 void Initialize(Local<Object> target);
 GDAL_ASYNCABLE_GLOBAL(stat);
 GDAL_ASYNCABLE_GLOBAL(readDir);
+GDAL_ASYNCABLE_GLOBAL(ioStats);
+NAN_METHOD(resetIOStats);
 
 } // namespace VSI
 } // namespace node_gdal
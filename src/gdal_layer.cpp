@@ -24,12 +24,12 @@ void Layer::Initialize(Local<Object> target) {
   lcons->InstanceTemplate()->SetInternalFieldCount(1);
   lcons->SetClassName(Nan::New("Layer").ToLocalChecked());
 
-  Nan::SetPrototypeMethod(lcons, "toString", toString);
-  Nan::SetPrototypeMethod(lcons, "getExtent", getExtent);
-  Nan::SetPrototypeMethod(lcons, "setAttributeFilter", setAttributeFilter);
-  Nan::SetPrototypeMethod(lcons, "setSpatialFilter", setSpatialFilter);
-  Nan::SetPrototypeMethod(lcons, "getSpatialFilter", getSpatialFilter);
-  Nan::SetPrototypeMethod(lcons, "testCapability", testCapability);
+  Nan__SetPrototypeMethod(lcons, "toString", toString);
+  Nan__SetPrototypeMethod(lcons, "getExtent", getExtent);
+  Nan__SetPrototypeMethod(lcons, "setAttributeFilter", setAttributeFilter);
+  Nan__SetPrototypeMethod(lcons, "setSpatialFilter", setSpatialFilter);
+  Nan__SetPrototypeMethod(lcons, "getSpatialFilter", getSpatialFilter);
+  Nan__SetPrototypeMethod(lcons, "testCapability", testCapability);
   Nan__SetPrototypeAsyncableMethod(lcons, "flush", syncToDisk);
 
   ATTR_DONT_ENUM(lcons, "ds", dsGetter, READ_ONLY_SETTER);
@@ -23,11 +23,11 @@ void MDArray::Initialize(Local<Object> target) {
   lcons->InstanceTemplate()->SetInternalFieldCount(1);
   lcons->SetClassName(Nan::New("MDArray").ToLocalChecked());
 
-  Nan::SetPrototypeMethod(lcons, "toString", toString);
+  Nan__SetPrototypeMethod(lcons, "toString", toString);
   Nan__SetPrototypeAsyncableMethod(lcons, "read", read);
-  Nan::SetPrototypeMethod(lcons, "getView", getView);
-  Nan::SetPrototypeMethod(lcons, "getMask", getMask);
-  Nan::SetPrototypeMethod(lcons, "asDataset", asDataset);
+  Nan__SetPrototypeMethod(lcons, "getView", getView);
+  Nan__SetPrototypeMethod(lcons, "getMask", getMask);
+  Nan__SetPrototypeMethod(lcons, "asDataset", asDataset);
 
   ATTR_DONT_ENUM(lcons, "_uid", uidGetter, READ_ONLY_SETTER);
   ATTR(lcons, "srs", srsGetter, READ_ONLY_SETTER);
@@ -34,10 +34,10 @@ void Memfile::weakCallback(const Nan::WeakCallbackInfo<Memfile> &file) {
 void Memfile::Initialize(Local<Object> target) {
   Local<Object> vsimem = Nan::New<Object>();
   Nan::Set(target, Nan::New("vsimem").ToLocalChecked(), vsimem);
-  Nan::SetMethod(vsimem, "_anonymous", Memfile::vsimemAnonymous); // not a public API
-  Nan::SetMethod(vsimem, "set", Memfile::vsimemSet);
-  Nan::SetMethod(vsimem, "release", Memfile::vsimemRelease);
-  Nan::SetMethod(vsimem, "copy", Memfile::vsimemCopy);
+  Nan__SetMethod(vsimem, "_anonymous", Memfile::vsimemAnonymous); // not a public API
+  Nan__SetMethod(vsimem, "set", Memfile::vsimemSet);
+  Nan__SetMethod(vsimem, "release", Memfile::vsimemRelease);
+  Nan__SetMethod(vsimem, "copy", Memfile::vsimemCopy);
 }
 
 // Anonymous buffers are handled by the GC
@@ -1,4 +1,5 @@
 
+#include "gdal_block_cache.hpp"
 #include "gdal_common.hpp"
 
 #include "collections/rasterband_overviews.hpp"
@@ -25,18 +26,18 @@ void RasterBand::Initialize(Local<Object> target) {
   lcons->InstanceTemplate()->SetInternalFieldCount(1);
   lcons->SetClassName(Nan::New("RasterBand").ToLocalChecked());
 
-  Nan::SetPrototypeMethod(lcons, "toString", toString);
+  Nan__SetPrototypeMethod(lcons, "toString", toString);
   Nan__SetPrototypeAsyncableMethod(lcons, "flush", flush);
   Nan__SetPrototypeAsyncableMethod(lcons, "fill", fill);
 #if GDAL_VERSION_MAJOR > 3 || (GDAL_VERSION_MAJOR == 3 && GDAL_VERSION_MINOR >= 1)
-  Nan::SetPrototypeMethod(lcons, "asMDArray", asMDArray);
+  Nan__SetPrototypeMethod(lcons, "asMDArray", asMDArray);
 #endif
-  Nan::SetPrototypeMethod(lcons, "getStatistics", getStatistics);
-  Nan::SetPrototypeMethod(lcons, "setStatistics", setStatistics);
+  Nan__SetPrototypeMethod(lcons, "getStatistics", getStatistics);
+  Nan__SetPrototypeMethod(lcons, "setStatistics", setStatistics);
   Nan__SetPrototypeAsyncableMethod(lcons, "computeStatistics", computeStatistics);
-  Nan::SetPrototypeMethod(lcons, "getMaskBand", getMaskBand);
-  Nan::SetPrototypeMethod(lcons, "getMaskFlags", getMaskFlags);
-  Nan::SetPrototypeMethod(lcons, "createMaskBand", createMaskBand);
+  Nan__SetPrototypeMethod(lcons, "getMaskBand", getMaskBand);
+  Nan__SetPrototypeMethod(lcons, "getMaskFlags", getMaskFlags);
+  Nan__SetPrototypeMethod(lcons, "createMaskBand", createMaskBand);
   Nan__SetPrototypeAsyncableMethod(lcons, "getMetadata", getMetadata);
   Nan__SetPrototypeAsyncableMethod(lcons, "setMetadata", setMetadata);
   ATTR_DONT_ENUM(lcons, "ds", dsGetter, READ_ONLY_SETTER);
@@ -178,7 +179,21 @@ NAN_METHOD(RasterBand::toString) {
  * @return {Promise<void>}
  *
  */
-NODE_WRAPPED_ASYNC_METHOD_WITH_OGRERR_RESULT_LOCKED(RasterBand, flush, FlushCache);
+GDAL_ASYNCABLE_DEFINE(RasterBand::flush) {
+  NODE_UNWRAP_CHECK(RasterBand, info.This(), band);
+  GDALRasterBand *raw = band->get();
+  long uid = band->parent_uid;
+  GDALAsyncableJob<OGRErr> job(uid);
+  job.main = [raw, uid](const GDALExecutionProgress &) {
+    // GDAL waits for the locked blocks when flushing
+    BlockCache::Unpin(uid);
+    int err = raw->FlushCache();
+    if (err) throw getOGRErrMsg(err);
+    return err;
+  };
+  job.rval = [](OGRErr, const GetFromPersistentFunc &) { return Nan::Undefined().As<Value>(); };
+  job.run(info, async, 0);
+}
 
 /**
  * Return the status flags of the mask band associated with the band.
@@ -16,48 +16,48 @@ void SpatialReference::Initialize(Local<Object> target) {
   lcons->SetClassName(Nan::New("SpatialReference").ToLocalChecked());
 
   Nan__SetAsyncableMethod(lcons, "fromUserInput", fromUserInput);
-  Nan::SetMethod(lcons, "fromWKT", fromWKT);
-  Nan::SetMethod(lcons, "fromProj4", fromProj4);
-  Nan::SetMethod(lcons, "fromEPSG", fromEPSG);
-  Nan::SetMethod(lcons, "fromEPSGA", fromEPSGA);
-  Nan::SetMethod(lcons, "fromESRI", fromESRI);
-  Nan::SetMethod(lcons, "fromWMSAUTO", fromWMSAUTO);
-  Nan::SetMethod(lcons, "fromXML", fromXML);
-  Nan::SetMethod(lcons, "fromURN", fromURN);
+  Nan__SetMethod(lcons, "fromWKT", fromWKT);
+  Nan__SetMethod(lcons, "fromProj4", fromProj4);
+  Nan__SetMethod(lcons, "fromEPSG", fromEPSG);
+  Nan__SetMethod(lcons, "fromEPSGA", fromEPSGA);
+  Nan__SetMethod(lcons, "fromESRI", fromESRI);
+  Nan__SetMethod(lcons, "fromWMSAUTO", fromWMSAUTO);
+  Nan__SetMethod(lcons, "fromXML", fromXML);
+  Nan__SetMethod(lcons, "fromURN", fromURN);
   Nan__SetAsyncableMethod(lcons, "fromCRSURL", fromCRSURL);
   Nan__SetAsyncableMethod(lcons, "fromURL", fromURL);
-  Nan::SetMethod(lcons, "fromMICoordSys", fromMICoordSys);
-
-  Nan::SetPrototypeMethod(lcons, "toString", toString);
-  Nan::SetPrototypeMethod(lcons, "toWKT", exportToWKT);
-  Nan::SetPrototypeMethod(lcons, "toPrettyWKT", exportToPrettyWKT);
-  Nan::SetPrototypeMethod(lcons, "toProj4", exportToProj4);
-  Nan::SetPrototypeMethod(lcons, "toXML", exportToXML);
-
-  Nan::SetPrototypeMethod(lcons, "clone", clone);
-  Nan::SetPrototypeMethod(lcons, "cloneGeogCS", cloneGeogCS);
-  Nan::SetPrototypeMethod(lcons, "setWellKnownGeogCS", setWellKnownGeogCS);
-  Nan::SetPrototypeMethod(lcons, "morphToESRI", morphToESRI);
-  Nan::SetPrototypeMethod(lcons, "morphFromESRI", morphFromESRI);
-  Nan::SetPrototypeMethod(lcons, "EPSGTreatsAsLatLong", EPSGTreatsAsLatLong);
-  Nan::SetPrototypeMethod(lcons, "EPSGTreatsAsNorthingEasting", EPSGTreatsAsNorthingEasting);
-  Nan::SetPrototypeMethod(lcons, "getLinearUnits", getLinearUnits);
-  Nan::SetPrototypeMethod(lcons, "getAngularUnits", getAngularUnits);
-  Nan::SetPrototypeMethod(lcons, "isGeographic", isGeographic);
-  Nan::SetPrototypeMethod(lcons, "isGeocentric", isGeocentric);
-  Nan::SetPrototypeMethod(lcons, "isProjected", isProjected);
-  Nan::SetPrototypeMethod(lcons, "isLocal", isLocal);
-  Nan::SetPrototypeMethod(lcons, "isVectical", isVertical);
-  Nan::SetPrototypeMethod(lcons, "isVertical", isVertical);
-  Nan::SetPrototypeMethod(lcons, "isCompound", isCompound);
-  Nan::SetPrototypeMethod(lcons, "isSameGeogCS", isSameGeogCS);
-  Nan::SetPrototypeMethod(lcons, "isSameVertCS", isSameVertCS);
-  Nan::SetPrototypeMethod(lcons, "isSame", isSame);
-  Nan::SetPrototypeMethod(lcons, "getAuthorityName", getAuthorityName);
-  Nan::SetPrototypeMethod(lcons, "getAuthorityCode", getAuthorityCode);
-  Nan::SetPrototypeMethod(lcons, "getAttrValue", getAttrValue);
-  Nan::SetPrototypeMethod(lcons, "autoIdentifyEPSG", autoIdentifyEPSG);
-  Nan::SetPrototypeMethod(lcons, "validate", validate);
+  Nan__SetMethod(lcons, "fromMICoordSys", fromMICoordSys);
+
+  Nan__SetPrototypeMethod(lcons, "toString", toString);
+  Nan__SetPrototypeMethod(lcons, "toWKT", exportToWKT);
+  Nan__SetPrototypeMethod(lcons, "toPrettyWKT", exportToPrettyWKT);
+  Nan__SetPrototypeMethod(lcons, "toProj4", exportToProj4);
+  Nan__SetPrototypeMethod(lcons, "toXML", exportToXML);
+
+  Nan__SetPrototypeMethod(lcons, "clone", clone);
+  Nan__SetPrototypeMethod(lcons, "cloneGeogCS", cloneGeogCS);
+  Nan__SetPrototypeMethod(lcons, "setWellKnownGeogCS", setWellKnownGeogCS);
+  Nan__SetPrototypeMethod(lcons, "morphToESRI", morphToESRI);
+  Nan__SetPrototypeMethod(lcons, "morphFromESRI", morphFromESRI);
+  Nan__SetPrototypeMethod(lcons, "EPSGTreatsAsLatLong", EPSGTreatsAsLatLong);
+  Nan__SetPrototypeMethod(lcons, "EPSGTreatsAsNorthingEasting", EPSGTreatsAsNorthingEasting);
+  Nan__SetPrototypeMethod(lcons, "getLinearUnits", getLinearUnits);
+  Nan__SetPrototypeMethod(lcons, "getAngularUnits", getAngularUnits);
+  Nan__SetPrototypeMethod(lcons, "isGeographic", isGeographic);
+  Nan__SetPrototypeMethod(lcons, "isGeocentric", isGeocentric);
+  Nan__SetPrototypeMethod(lcons, "isProjected", isProjected);
+  Nan__SetPrototypeMethod(lcons, "isLocal", isLocal);
+  Nan__SetPrototypeMethod(lcons, "isVectical", isVertical);
+  Nan__SetPrototypeMethod(lcons, "isVertical", isVertical);
+  Nan__SetPrototypeMethod(lcons, "isCompound", isCompound);
+  Nan__SetPrototypeMethod(lcons, "isSameGeogCS", isSameGeogCS);
+  Nan__SetPrototypeMethod(lcons, "isSameVertCS", isSameVertCS);
+  Nan__SetPrototypeMethod(lcons, "isSame", isSame);
+  Nan__SetPrototypeMethod(lcons, "getAuthorityName", getAuthorityName);
+  Nan__SetPrototypeMethod(lcons, "getAuthorityCode", getAuthorityCode);
+  Nan__SetPrototypeMethod(lcons, "getAttrValue", getAttrValue);
+  Nan__SetPrototypeMethod(lcons, "autoIdentifyEPSG", autoIdentifyEPSG);
+  Nan__SetPrototypeMethod(lcons, "validate", validate);
 
   Nan::Set(target, Nan::New("SpatialReference").ToLocalChecked(), Nan::GetFunction(lcons).ToLocalChecked());
 
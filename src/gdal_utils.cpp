@@ -3,6 +3,10 @@
 #include "gdal_dataset.hpp"
 #include "gdal_spatial_reference.hpp"
 
+#include <algorithm>
+#include <atomic>
+#include <climits>
+
 #if GDAL_VERSION_MAJOR > 2 || (GDAL_VERSION_MAJOR == 2 && GDAL_VERSION_MINOR >= 3)
 #define GDALDatasetToHandle(x) GDALDataset::ToHandle(x)
 #define GDALDatasetFromHandle(x) GDALDataset::FromHandle(x)
@@ -13,11 +17,96 @@
 
 namespace node_gdal {
 
+// The in-memory output of translateToBuffer() and warpToBuffer()
+//
+// Each job writes to its own /vsimem/ directory, which also receives
+// the sidecar files, the memory of the main file is then taken over
+// from GDAL and handed to a Node.js Buffer without copying
+struct VSIMemOutput {
+  std::string dir;
+  std::string file;
+  GByte *data;
+  size_t len;
+
+  VSIMemOutput() : data(nullptr), len(0) {
+  }
+  VSIMemOutput(const VSIMemOutput &) = delete;
+  VSIMemOutput &operator=(const VSIMemOutput &) = delete;
+  // The buffer is not handed over to a Node.js Buffer when the job fails
+  ~VSIMemOutput() {
+    if (data != nullptr) CPLFree(data);
+  }
+};
+
+static std::atomic<unsigned> vsimem_output_counter(0);
+
+static std::shared_ptr<VSIMemOutput> NewVSIMemOutput(GDALDriver *driver) {
+  auto r = std::make_shared<VSIMemOutput>();
+  r->dir = "/vsimem/_node_gdal_output_" + std::to_string(vsimem_output_counter++);
+  r->file = r->dir + "/output";
+  const char *ext = driver->GetMetadataItem(GDAL_DMD_EXTENSION);
+  if (ext != nullptr && *ext) r->file += std::string(".") + ext;
+  return r;
+}
+
+static void DeleteVSIMemOutput(const std::shared_ptr<VSIMemOutput> &out) {
+#if GDAL_VERSION_MAJOR > 2 || (GDAL_VERSION_MAJOR == 2 && GDAL_VERSION_MINOR >= 3)
+  VSIRmdirRecursive(out->dir.c_str());
+#else
+  VSIUnlink(out->file.c_str());
+  VSIRmdir(out->dir.c_str());
+#endif
+}
+
+// Closes the produced dataset and takes ownership of the file
+static void TakeVSIMemOutput(GDALDatasetH ds, const std::shared_ptr<VSIMemOutput> &out) {
+  if (ds == nullptr) {
+    DeleteVSIMemOutput(out);
+    throw CPLGetLastErrorMsg();
+  }
+  GDALClose(ds);
+  vsi_l_offset len;
+  out->data = VSIGetMemFileBuffer(out->file.c_str(), &len, TRUE);
+  DeleteVSIMemOutput(out);
+  if (out->data == nullptr) throw "Failed retrieving the output file";
+  out->len = static_cast<size_t>(len);
+}
+
+// Nan::AdjustExternalMemory() takes an int, larger sizes are reported in chunks
+static void AdjustExternalMemory(int64_t change) {
+  while (change != 0) {
+    int chunk = static_cast<int>(std::max<int64_t>(std::min<int64_t>(change, INT_MAX), -INT_MAX));
+    Nan::AdjustExternalMemory(chunk);
+    change -= chunk;
+  }
+}
+
+static Local<Value> VSIMemOutputToBuffer(const std::shared_ptr<VSIMemOutput> &out) {
+  // If you malloc, you adjust external memory too (https://github.com/nodejs/node/issues/40936)
+  AdjustExternalMemory(static_cast<int64_t>(out->len));
+  size_t *hint = new size_t{out->len};
+  Local<Value> r = Nan::NewBuffer(
+                     reinterpret_cast<char *>(out->data),
+                     out->len,
+                     [](char *data, void *hint) {
+                       size_t *len = reinterpret_cast<size_t *>(hint);
+                       AdjustExternalMemory(-static_cast<int64_t>(*len));
+                       delete len;
+                       CPLFree(data);
+                     },
+                     hint)
+                     .ToLocalChecked();
+  out->data = nullptr;
+  return r;
+}
+
 void Utils::Initialize(Local<Object> target) {
   Nan__SetAsyncableMethod(target, "info", info);
   Nan__SetAsyncableMethod(target, "translate", translate);
+  Nan__SetAsyncableMethod(target, "translateToBuffer", translateToBuffer);
   Nan__SetAsyncableMethod(target, "vectorTranslate", vectorTranslate);
   Nan__SetAsyncableMethod(target, "warp", warp);
+  Nan__SetAsyncableMethod(target, "warpToBuffer", warpToBuffer);
   Nan__SetAsyncableMethod(target, "buildVRT", buildvrt);
   Nan__SetAsyncableMethod(target, "rasterize", rasterize);
   Nan__SetAsyncableMethod(target, "dem", dem);
@@ -26,6 +115,7 @@ void Utils::Initialize(Local<Object> target) {
 /**
  * @typedef {object} UtilOptions
  * @property {ProgressCb} [progress_cb]
+ * @property {AbortSignal} [signal]
  */
 
 /**
@@ -90,12 +180,12 @@ GDAL_ASYNCABLE_DEFINE(Utils::translate) {
 
   GDALAsyncableJob<GDALDataset *> job(ds->uid);
   job.progress = progress_cb;
-  job.main = [raw, dst, aosOptions, progress_cb](const GDALExecutionProgress &progress) {
+  job.main = [raw, dst, aosOptions](const GDALExecutionProgress &progress) {
     CPLErrorReset();
     auto b = aosOptions;
     auto psOptions = GDALTranslateOptionsNew(aosOptions->List(), nullptr);
     if (psOptions == nullptr) throw CPLGetLastErrorMsg();
-    if (progress_cb) GDALTranslateOptionsSetProgress(psOptions, ProgressTrampoline, (void *)&progress);
+    if (progress.active()) GDALTranslateOptionsSetProgress(psOptions, ProgressTrampoline, (void *)&progress);
     GDALDataset *r = GDALDatasetFromHandle(GDALTranslate(dst.c_str(), GDALDatasetToHandle(raw), psOptions, nullptr));
     GDALTranslateOptionsFree(psOptions);
     if (r == nullptr) throw CPLGetLastErrorMsg();
@@ -106,6 +196,98 @@ GDAL_ASYNCABLE_DEFINE(Utils::translate) {
   job.run(info, async, 4);
 }
 
+/**
+ * Library version of gdal_translate producing an in-memory file.
+ *
+ * The output is written to a private `/vsimem/` file which is
+ * then returned as a `Buffer` without copying, the file is
+ * deleted along with any sidecar files.
+ *
+ * @example
+ * const ds = gdal.open('input.tif')
+ * const png = gdal.translateToBuffer(ds, 'PNG', [ '-b', '1' ])
+ *
+ * @throws {Error}
+ * @method translateToBuffer
+ * @static
+ * @param {Dataset} source source dataset
+ * @param {string} format output format (GDAL driver short name)
+ * @param {string[]} [args] array of CLI options for gdal_translate
+ * @param {UtilOptions} [options] additional options
+ * @param {ProgressCb} [options.progress_cb]
+ * @return {Buffer}
+ */
+
+/**
+ * Library version of gdal_translate producing an in-memory file.
+ * @async
+ *
+ * @example
+ * const ds = await gdal.openAsync('input.tif')
+ * const png = await gdal.translateToBufferAsync(ds, 'PNG', [ '-b', '1' ])
+ * @throws {Error}
+ *
+ * @method translateToBufferAsync
+ * @static
+ * @param {Dataset} source source dataset
+ * @param {string} format output format (GDAL driver short name)
+ * @param {string[]} [args] array of CLI options for gdal_translate
+ * @param {UtilOptions} [options] additional options
+ * @param {ProgressCb} [options.progress_cb]
+ * @param {callback<Buffer>} [callback=undefined]
+ * @return {Promise<Buffer>}
+ */
+GDAL_ASYNCABLE_DEFINE(Utils::translateToBuffer) {
+  auto aosOptions = std::make_shared<CPLStringList>();
+
+  Local<Object> src;
+  NODE_ARG_OBJECT(0, "src", src);
+  NODE_UNWRAP_CHECK(Dataset, src, ds);
+  GDAL_RAW_CHECK(GDALDataset *, ds, raw);
+
+  std::string format;
+  NODE_ARG_STR(1, "format", format);
+  GDALDriver *driver = GetGDALDriverManager()->GetDriverByName(format.c_str());
+  if (driver == nullptr) {
+    Nan::ThrowError("Invalid format");
+    return;
+  }
+
+  aosOptions->AddString("-of");
+  aosOptions->AddString(format.c_str());
+  Local<Array> args;
+  NODE_ARG_ARRAY_OPT(2, "args", args);
+  if (!args.IsEmpty())
+    for (unsigned i = 0; i < args->Length(); ++i) {
+      aosOptions->AddString(*Nan::Utf8String(Nan::Get(args, i).ToLocalChecked()));
+    }
+
+  Local<Object> options;
+  Nan::Callback *progress_cb = nullptr;
+  NODE_ARG_OBJECT_OPT(3, "options", options);
+  if (!options.IsEmpty()) NODE_CB_FROM_OBJ_OPT(options, "progress_cb", progress_cb);
+
+  std::shared_ptr<VSIMemOutput> out = NewVSIMemOutput(driver);
+
+  GDALAsyncableJob<std::shared_ptr<VSIMemOutput>> job(ds->uid);
+  job.progress = progress_cb;
+  job.main = [raw, out, aosOptions](const GDALExecutionProgress &progress) {
+    CPLErrorReset();
+    auto psOptions = GDALTranslateOptionsNew(aosOptions->List(), nullptr);
+    if (psOptions == nullptr) throw CPLGetLastErrorMsg();
+    if (progress.active()) GDALTranslateOptionsSetProgress(psOptions, ProgressTrampoline, (void *)&progress);
+    GDALDatasetH r = GDALTranslate(out->file.c_str(), GDALDatasetToHandle(raw), psOptions, nullptr);
+    GDALTranslateOptionsFree(psOptions);
+    TakeVSIMemOutput(r, out);
+    return out;
+  };
+  job.rval = [](std::shared_ptr<VSIMemOutput> out, const GetFromPersistentFunc &) {
+    return VSIMemOutputToBuffer(out);
+  };
+
+  job.run(info, async, 4);
+}
+
 /**
  * Library version of ogr2ogr.
  *
@@ -187,13 +369,13 @@ GDAL_ASYNCABLE_DEFINE(Utils::vectorTranslate) {
   GDALAsyncableJob<GDALDataset *> job(uids);
   job.progress = progress_cb;
 
-  job.main = [src_raw, dst_filename, dst_raw, aosOptions, progress_cb](const GDALExecutionProgress &progress) {
+  job.main = [src_raw, dst_filename, dst_raw, aosOptions](const GDALExecutionProgress &progress) {
     CPLErrorReset();
-    if (progress_cb) aosOptions->AddString("-progress");
+    if (progress.active()) aosOptions->AddString("-progress");
     auto psOptions = GDALVectorTranslateOptionsNew(aosOptions->List(), nullptr);
     if (psOptions == nullptr) throw CPLGetLastErrorMsg();
 
-    if (progress_cb) GDALVectorTranslateOptionsSetProgress(psOptions, ProgressTrampoline, (void *)&progress);
+    if (progress.active()) GDALVectorTranslateOptionsSetProgress(psOptions, ProgressTrampoline, (void *)&progress);
 
     auto srcH = GDALDatasetToHandle(src_raw);
     GDALDataset *r = GDALDatasetFromHandle(
@@ -362,28 +544,130 @@ GDAL_ASYNCABLE_DEFINE(Utils::warp) {
   GDALAsyncableJob<GDALDataset *> job(uids);
   int src_count = src_ds->Length();
   job.progress = progress_cb;
-  job.main =
-    [dst_path, gdal_dst_ds, src_count, gdal_src_ds, aosOptions, progress_cb](const GDALExecutionProgress &progress) {
-      CPLErrorReset();
-      auto psOptions = GDALWarpAppOptionsNew(aosOptions->List(), nullptr);
-      if (psOptions == nullptr) throw CPLGetLastErrorMsg();
-      if (progress_cb) GDALWarpAppOptionsSetProgress(psOptions, ProgressTrampoline, (void *)&progress);
-      GDALDatasetH r = GDALWarp(
-        dst_path.length() > 0 ? dst_path.c_str() : nullptr,
-        gdal_dst_ds,
-        src_count,
-        gdal_src_ds.get(),
-        psOptions,
-        nullptr);
-      GDALWarpAppOptionsFree(psOptions);
-      if (r == nullptr) throw CPLGetLastErrorMsg();
-      return GDALDatasetFromHandle(r);
-    };
+  job.main = [dst_path, gdal_dst_ds, src_count, gdal_src_ds, aosOptions](const GDALExecutionProgress &progress) {
+    CPLErrorReset();
+    auto psOptions = GDALWarpAppOptionsNew(aosOptions->List(), nullptr);
+    if (psOptions == nullptr) throw CPLGetLastErrorMsg();
+    if (progress.active()) GDALWarpAppOptionsSetProgress(psOptions, ProgressTrampoline, (void *)&progress);
+    GDALDatasetH r = GDALWarp(
+      dst_path.length() > 0 ? dst_path.c_str() : nullptr,
+      gdal_dst_ds,
+      src_count,
+      gdal_src_ds.get(),
+      psOptions,
+      nullptr);
+    GDALWarpAppOptionsFree(psOptions);
+    if (r == nullptr) throw CPLGetLastErrorMsg();
+    return GDALDatasetFromHandle(r);
+  };
   job.rval = [](GDALDataset *ds, const GetFromPersistentFunc &) { return Dataset::New(ds); };
 
   job.run(info, async, 5);
 }
 
+/**
+ * Library version of gdalwarp producing an in-memory file.
+ *
+ * The output is written to a private `/vsimem/` file which is
+ * then returned as a `Buffer` without copying, the file is
+ * deleted along with any sidecar files.
+ *
+ * @example
+ * const ds = gdal.open('input.tif')
+ * const tiff = gdal.warpToBuffer([ ds ], 'GTiff', [ '-t_srs', 'epsg:3857' ])
+ *
+ * @throws {Error}
+ * @method warpToBuffer
+ * @static
+ * @param {Dataset[]} src_ds array of source datasets
+ * @param {string} format output format (GDAL driver short name)
+ * @param {string[]} [args] array of CLI options for gdalwarp
+ * @param {UtilOptions} [options] additional options
+ * @param {ProgressCb} [options.progress_cb]
+ * @return {Buffer}
+ */
+
+/**
+ * Library version of gdalwarp producing an in-memory file.
+ * @async
+ *
+ * @example
+ * const ds = await gdal.openAsync('input.tif')
+ * const tiff = await gdal.warpToBufferAsync([ ds ], 'GTiff', [ '-t_srs', 'epsg:3857' ])
+ * @throws {Error}
+ *
+ * @method warpToBufferAsync
+ * @static
+ * @param {Dataset[]} src_ds array of source datasets
+ * @param {string} format output format (GDAL driver short name)
+ * @param {string[]} [args] array of CLI options for gdalwarp
+ * @param {UtilOptions} [options] additional options
+ * @param {ProgressCb} [options.progress_cb]
+ * @param {callback<Buffer>} [callback=undefined]
+ * @return {Promise<Buffer>}
+ */
+GDAL_ASYNCABLE_DEFINE(Utils::warpToBuffer) {
+  auto aosOptions = std::make_shared<CPLStringList>();
+  std::vector<long> uids;
+
+  Local<Array> src_ds;
+  NODE_ARG_ARRAY(0, "src_ds", src_ds);
+  if (src_ds->Length() < 1) {
+    Nan::ThrowError("\"src_ds\" must contain at least one element");
+    return;
+  }
+  auto gdal_src_ds = std::shared_ptr<GDALDatasetH>(new GDALDatasetH[src_ds->Length()], array_deleter<GDALDatasetH>());
+  for (unsigned i = 0; i < src_ds->Length(); ++i) {
+    NODE_UNWRAP_CHECK(Dataset, Nan::Get(src_ds, i).ToLocalChecked().As<Object>(), ds);
+    GDAL_RAW_CHECK(GDALDataset *, ds, raw);
+    gdal_src_ds.get()[i] = GDALDatasetToHandle(raw);
+    uids.push_back(ds->uid);
+  }
+
+  std::string format;
+  NODE_ARG_STR(1, "format", format);
+  GDALDriver *driver = GetGDALDriverManager()->GetDriverByName(format.c_str());
+  if (driver == nullptr) {
+    Nan::ThrowError("Invalid format");
+    return;
+  }
+
+  aosOptions->AddString("-of");
+  aosOptions->AddString(format.c_str());
+  Local<Array> args;
+  NODE_ARG_ARRAY_OPT(2, "args", args);
+  if (!args.IsEmpty())
+    for (unsigned i = 0; i < args->Length(); ++i) {
+      aosOptions->AddString(*Nan::Utf8String(Nan::Get(args, i).ToLocalChecked()));
+    }
+
+  Local<Object> options;
+  Nan::Callback *progress_cb = nullptr;
+  NODE_ARG_OBJECT_OPT(3, "options", options);
+  if (!options.IsEmpty()) NODE_CB_FROM_OBJ_OPT(options, "progress_cb", progress_cb);
+
+  std::shared_ptr<VSIMemOutput> out = NewVSIMemOutput(driver);
+
+  GDALAsyncableJob<std::shared_ptr<VSIMemOutput>> job(uids);
+  int src_count = src_ds->Length();
+  job.progress = progress_cb;
+  job.main = [out, src_count, gdal_src_ds, aosOptions](const GDALExecutionProgress &progress) {
+    CPLErrorReset();
+    auto psOptions = GDALWarpAppOptionsNew(aosOptions->List(), nullptr);
+    if (psOptions == nullptr) throw CPLGetLastErrorMsg();
+    if (progress.active()) GDALWarpAppOptionsSetProgress(psOptions, ProgressTrampoline, (void *)&progress);
+    GDALDatasetH r = GDALWarp(out->file.c_str(), nullptr, src_count, gdal_src_ds.get(), psOptions, nullptr);
+    GDALWarpAppOptionsFree(psOptions);
+    TakeVSIMemOutput(r, out);
+    return out;
+  };
+  job.rval = [](std::shared_ptr<VSIMemOutput> out, const GetFromPersistentFunc &) {
+    return VSIMemOutputToBuffer(out);
+  };
+
+  job.run(info, async, 4);
+}
+
 /**
  * Library version of gdalbuildvrt.
  *
@@ -486,25 +770,24 @@ GDAL_ASYNCABLE_DEFINE(Utils::buildvrt) {
   GDALAsyncableJob<GDALDataset *> job(uids);
   int src_count = src_ds->Length();
   job.progress = progress_cb;
-  job.main =
-    [dst_path, src_count, gdalSrcDs, aosSrcDs, aosOptions, progress_cb](const GDALExecutionProgress &progress) {
-      CPLErrorReset();
-      auto psOptions = GDALBuildVRTOptionsNew(aosOptions->List(), nullptr);
-      if (psOptions == nullptr) throw CPLGetLastErrorMsg();
-      if (progress_cb) GDALBuildVRTOptionsSetProgress(psOptions, ProgressTrampoline, (void *)&progress);
-
-      GDALDatasetH r = GDALBuildVRT(
-        dst_path.c_str(),
-        src_count,
-        gdalSrcDs.get(),
-        aosSrcDs.get() != nullptr ? aosSrcDs->List() : nullptr,
-        psOptions,
-        nullptr);
-
-      GDALBuildVRTOptionsFree(psOptions);
-      if (r == nullptr) throw CPLGetLastErrorMsg();
-      return GDALDatasetFromHandle(r);
-    };
+  job.main = [dst_path, src_count, gdalSrcDs, aosSrcDs, aosOptions](const GDALExecutionProgress &progress) {
+    CPLErrorReset();
+    auto psOptions = GDALBuildVRTOptionsNew(aosOptions->List(), nullptr);
+    if (psOptions == nullptr) throw CPLGetLastErrorMsg();
+    if (progress.active()) GDALBuildVRTOptionsSetProgress(psOptions, ProgressTrampoline, (void *)&progress);
+
+    GDALDatasetH r = GDALBuildVRT(
+      dst_path.c_str(),
+      src_count,
+      gdalSrcDs.get(),
+      aosSrcDs.get() != nullptr ? aosSrcDs->List() : nullptr,
+      psOptions,
+      nullptr);
+
+    GDALBuildVRTOptionsFree(psOptions);
+    if (r == nullptr) throw CPLGetLastErrorMsg();
+    return GDALDatasetFromHandle(r);
+  };
   job.rval = [](GDALDataset *ds, const GetFromPersistentFunc &) { return Dataset::New(ds); };
 
   job.run(info, async, 4);
@@ -595,11 +878,11 @@ GDAL_ASYNCABLE_DEFINE(Utils::rasterize) {
 
   GDALAsyncableJob<GDALDataset *> job(ds->uid);
   job.progress = progress_cb;
-  job.main = [dst_path, dst_raw, src_raw, aosOptions, progress_cb](const GDALExecutionProgress &progress) {
+  job.main = [dst_path, dst_raw, src_raw, aosOptions](const GDALExecutionProgress &progress) {
     CPLErrorReset();
     auto psOptions = GDALRasterizeOptionsNew(aosOptions->List(), nullptr);
     if (psOptions == nullptr) throw CPLGetLastErrorMsg();
-    if (progress_cb) GDALRasterizeOptionsSetProgress(psOptions, ProgressTrampoline, (void *)&progress);
+    if (progress.active()) GDALRasterizeOptionsSetProgress(psOptions, ProgressTrampoline, (void *)&progress);
 
     GDALDatasetH r = GDALRasterize(
       dst_path.length() > 0 ? dst_path.c_str() : nullptr,
@@ -690,11 +973,11 @@ GDAL_ASYNCABLE_DEFINE(Utils::dem) {
 
   GDALAsyncableJob<GDALDataset *> job(ds->uid);
   job.progress = progress_cb;
-  job.main = [dst_path, mode, raw, colorFilename, aosOptions, progress_cb](const GDALExecutionProgress &progress) {
+  job.main = [dst_path, mode, raw, colorFilename, aosOptions](const GDALExecutionProgress &progress) {
     CPLErrorReset();
     auto psOptions = GDALDEMProcessingOptionsNew(aosOptions->List(), nullptr);
     if (psOptions == nullptr) throw CPLGetLastErrorMsg();
-    if (progress_cb) GDALDEMProcessingOptionsSetProgress(psOptions, ProgressTrampoline, (void *)&progress);
+    if (progress.active()) GDALDEMProcessingOptionsSetProgress(psOptions, ProgressTrampoline, (void *)&progress);
     GDALDataset *r = GDALDatasetFromHandle(GDALDEMProcessing(
       dst_path.c_str(),
       GDALDatasetToHandle(raw),
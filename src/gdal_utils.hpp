@@ -31,8 +31,10 @@ void Initialize(Local<Object> target);
 
 GDAL_ASYNCABLE_GLOBAL(info);
 GDAL_ASYNCABLE_GLOBAL(translate);
+GDAL_ASYNCABLE_GLOBAL(translateToBuffer);
 GDAL_ASYNCABLE_GLOBAL(vectorTranslate);
 GDAL_ASYNCABLE_GLOBAL(warp);
+GDAL_ASYNCABLE_GLOBAL(warpToBuffer);
 GDAL_ASYNCABLE_GLOBAL(buildvrt);
 GDAL_ASYNCABLE_GLOBAL(rasterize);
 GDAL_ASYNCABLE_GLOBAL(dem);
@@ -0,0 +1,462 @@
+#include <climits>
+#include <cmath>
+#include <cstring>
+#include <string>
+
+#include "gdal_warp_context.hpp"
+#include "gdal_common.hpp"
+#include "gdal_dataset.hpp"
+#include "gdal_spatial_reference.hpp"
+#include "utils/number_list.hpp"
+#include "utils/string_list.hpp"
+#include "utils/typed_array.hpp"
+#include "utils/warp_options.hpp"
+
+namespace node_gdal {
+
+Nan::Persistent<FunctionTemplate> WarpContext::constructor;
+
+void WarpContext::Initialize(Local<Object> target) {
+  Nan::HandleScope scope;
+
+  Local<FunctionTemplate> lcons = Nan::New<FunctionTemplate>(WarpContext::New);
+  lcons->InstanceTemplate()->SetInternalFieldCount(1);
+  lcons->SetClassName(Nan::New("WarpContext").ToLocalChecked());
+
+  Nan__SetPrototypeMethod(lcons, "toString", toString);
+  Nan__SetPrototypeAsyncableMethod(lcons, "renderWindow", renderWindow);
+
+  ATTR(lcons, "bands", bandsGetter, READ_ONLY_SETTER);
+  ATTR(lcons, "dataType", dataTypeGetter, READ_ONLY_SETTER);
+
+  Nan::Set(target, Nan::New("WarpContext").ToLocalChecked(), Nan::GetFunction(lcons).ToLocalChecked());
+
+  constructor.Reset(lcons);
+}
+
+WarpContextState::WarpContextState()
+  : src(nullptr),
+    gen_transformer(nullptr),
+    approx_transformer(nullptr),
+    operation(),
+    type(GDT_Unknown),
+    bands(0),
+    has_dst_nodata(false),
+    dst_nodata(0) {
+}
+
+// The warp operation refers to the transformers, it must go first
+WarpContextState::~WarpContextState() {
+  operation.reset();
+  if (approx_transformer) GDALDestroyApproxTransformer(approx_transformer);
+  if (gen_transformer) GDALDestroyGenImgProjTransformer(gen_transformer);
+}
+
+WarpContext::WarpContext(std::shared_ptr<WarpContextState> state, long src_uid)
+  : Nan::ObjectWrap(), state(state), src_uid(src_uid) {
+  LOG("Created WarpContext [%p]", state.get());
+}
+
+WarpContext::~WarpContext() {
+  LOG("Disposing WarpContext [%p]", state.get());
+}
+
+/**
+ * @typedef {object} WarpContextOptions
+ * @property {Dataset} src
+ * @property {SpatialReference} t_srs
+ * @property {SpatialReference} [s_srs]
+ * @property {string} [resampling]
+ * @property {number[]} [srcBands]
+ * @property {number} [srcAlphaBand]
+ * @property {number} [srcNodata]
+ * @property {number} [dstNodata]
+ * @property {string} [dataType]
+ * @property {number} [maxError]
+ * @property {StringOptions} [options]
+ */
+
+/**
+ * A reusable warping operation from a source dataset to a target
+ * spatial reference system, rendering arbitrary windows directly into
+ * TypedArrays without creating a destination dataset.
+ *
+ * The transformers (including the approximated transformer) and the
+ * `GDALWarpOperation` are created once by the constructor and reused
+ * for every window, which makes it suitable for rendering many tiles.
+ *
+ * The rendering of the windows of one context is serialized by the lock
+ * of the source dataset.
+ *
+ * @example
+ *
+ * const ctx = new gdal.WarpContext({
+ *   src: ds,
+ *   t_srs: gdal.SpatialReference.fromEPSG(3857),
+ *   resampling: gdal.GRA_Bilinear
+ * });
+ * const tile = await ctx.renderWindowAsync([ -20037508.34, 156543.03, 0, 20037508.34, 0, -156543.03 ], 256, 256);
+ *
+ * @constructor
+ * @class WarpContext
+ * @param {WarpContextOptions} options
+ * @param {Dataset} options.src Source dataset
+ * @param {SpatialReference} options.t_srs Target spatial reference system
+ * @param {SpatialReference} [options.s_srs] Source spatial reference system, the one of `src` by default
+ * @param {string} [options.resampling=NearestNeighbor] Resampling algorithm ({@link GRA|available options})
+ * @param {number[]} [options.srcBands] Source bands, all the non-alpha bands by default
+ * @param {number} [options.srcAlphaBand] Source alpha band, detected automatically by default
+ * @param {number} [options.srcNodata] Source NoData value, the one of each band by default
+ * @param {number} [options.dstNodata] Value of the pixels without data, 0 by default
+ * @param {string} [options.dataType] Data type of the rendered windows ({@link GDT|see GDT constants}), the one of the first source band by default
+ * @param {number} [options.maxError=0.125] Error threshold of the approximated transformer in pixels, 0 for exact transformations
+ * @param {StringOptions} [options.options] Warp options (see {@link https://gdal.org/doxygen/structGDALWarpOptions.html|GDALWarpOptions})
+ */
+NAN_METHOD(WarpContext::New) {
+  if (!info.IsConstructCall()) {
+    Nan::ThrowError("Cannot call constructor as function, you need to use 'new' keyword");
+    return;
+  }
+
+  Local<Object> obj;
+  Dataset *src;
+  SpatialReference *t_srs;
+  SpatialReference *s_srs = nullptr;
+  int src_alpha = 0;
+  double max_error = 0.125;
+  std::string type_name;
+  IntegerList src_bands("src band ids");
+  StringList warp_options;
+
+  NODE_ARG_OBJECT(0, "options", obj);
+  NODE_WRAPPED_FROM_OBJ(obj, "src", Dataset, src);
+  NODE_WRAPPED_FROM_OBJ(obj, "t_srs", SpatialReference, t_srs);
+  NODE_WRAPPED_FROM_OBJ_OPT(obj, "s_srs", SpatialReference, s_srs);
+  NODE_INT_FROM_OBJ_OPT(obj, "srcAlphaBand", src_alpha);
+  NODE_DOUBLE_FROM_OBJ_OPT(obj, "maxError", max_error);
+  NODE_STR_FROM_OBJ_OPT(obj, "dataType", type_name);
+
+  Local<Object> src_obj = Nan::Get(obj, Nan::New("src").ToLocalChecked()).ToLocalChecked().As<Object>();
+  GDALDataset *raw = src->get();
+  if (raw == nullptr) {
+    Nan::ThrowError("src: Dataset object has already been destroyed");
+    return;
+  }
+
+  WarpOptions resampling;
+  Local<String> sym = Nan::New("resampling").ToLocalChecked();
+  if (resampling.parseResamplingAlg(
+        Nan::HasOwnProperty(obj, sym).FromMaybe(false) ? Nan::Get(obj, sym).ToLocalChecked()
+                                                       : Nan::Undefined().As<Value>()))
+    return;
+
+  sym = Nan::New("srcBands").ToLocalChecked();
+  if (Nan::HasOwnProperty(obj, sym).FromMaybe(false) && src_bands.parse(Nan::Get(obj, sym).ToLocalChecked())) return;
+  sym = Nan::New("options").ToLocalChecked();
+  if (Nan::HasOwnProperty(obj, sym).FromMaybe(false) && warp_options.parse(Nan::Get(obj, sym).ToLocalChecked()))
+    return;
+
+  bool has_src_nodata = false;
+  double src_nodata = 0;
+  NODE_DOUBLE_FROM_OBJ_OPT(obj, "srcNodata", src_nodata);
+  has_src_nodata = Nan::HasOwnProperty(obj, Nan::New("srcNodata").ToLocalChecked()).FromMaybe(false);
+
+  std::shared_ptr<WarpContextState> state = std::make_shared<WarpContextState>();
+  state->src = raw;
+  state->has_dst_nodata = Nan::HasOwnProperty(obj, Nan::New("dstNodata").ToLocalChecked()).FromMaybe(false);
+  NODE_DOUBLE_FROM_OBJ_OPT(obj, "dstNodata", state->dst_nodata);
+
+  if (max_error < 0) {
+    Nan::ThrowRangeError("maxError must not be negative");
+    return;
+  }
+
+  char *t_wkt = nullptr, *s_wkt = nullptr;
+  if (t_srs->get()->exportToWkt(&t_wkt) != OGRERR_NONE || (s_srs && s_srs->get()->exportToWkt(&s_wkt) != OGRERR_NONE)) {
+    CPLFree(t_wkt);
+    CPLFree(s_wkt);
+    Nan::ThrowError("Failed exporting the spatial reference systems");
+    return;
+  }
+  char **transformer_options = CSLSetNameValue(nullptr, "DST_SRS", t_wkt);
+  if (s_wkt) transformer_options = CSLSetNameValue(transformer_options, "SRC_SRS", s_wkt);
+  CPLFree(t_wkt);
+  CPLFree(s_wkt);
+
+  AsyncGuard lock({src->uid}, eventLoopWarn);
+
+  int band_count = raw->GetRasterCount();
+  std::vector<int> bands;
+  if (src_bands.length() > 0) {
+    for (int i = 0; i < src_bands.length(); i++) {
+      if (src_bands.get()[i] < 1 || src_bands.get()[i] > band_count) {
+        CSLDestroy(transformer_options);
+        Nan::ThrowRangeError("Invalid source band");
+        return;
+      }
+      bands.push_back(src_bands.get()[i]);
+    }
+  }
+  for (int i = 1; i <= band_count; i++) {
+    if (src_alpha == 0 && raw->GetRasterBand(i)->GetColorInterpretation() == GCI_AlphaBand) src_alpha = i;
+  }
+  if (src_alpha < 0 || src_alpha > band_count) {
+    CSLDestroy(transformer_options);
+    Nan::ThrowRangeError("Invalid source alpha band");
+    return;
+  }
+  if (bands.empty()) {
+    for (int i = 1; i <= band_count; i++)
+      if (i != src_alpha) bands.push_back(i);
+  }
+  if (bands.empty()) {
+    CSLDestroy(transformer_options);
+    Nan::ThrowError("The source dataset does not have any raster bands to warp");
+    return;
+  }
+  state->bands = static_cast<int>(bands.size());
+
+  if (!type_name.empty()) {
+    state->type = GDALGetDataTypeByName(type_name.c_str());
+    if (state->type == GDT_Unknown || GDALDataTypeIsComplex(state->type)) {
+      CSLDestroy(transformer_options);
+      Nan::ThrowError("Invalid dataType");
+      return;
+    }
+  } else {
+    state->type = raw->GetRasterBand(bands[0])->GetRasterDataType();
+  }
+
+  // The destination geotransform is set before rendering each window
+#if GDAL_VERSION_MAJOR == 2 && GDAL_VERSION_MINOR < 3
+  GDALDatasetH src_handle = static_cast<GDALDatasetH>(raw);
+#else
+  GDALDatasetH src_handle = GDALDataset::ToHandle(raw);
+#endif
+  CPLErrorReset();
+  state->gen_transformer = GDALCreateGenImgProjTransformer2(src_handle, nullptr, transformer_options);
+  CSLDestroy(transformer_options);
+  if (state->gen_transformer == nullptr) {
+    NODE_THROW_LAST_CPLERR;
+    return;
+  }
+
+  GDALWarpOptions *options = GDALCreateWarpOptions();
+  options->hSrcDS = src_handle;
+  options->hDstDS = nullptr;
+  options->eResampleAlg = resampling.get()->eResampleAlg;
+  options->eWorkingDataType = state->type;
+  options->nBandCount = state->bands;
+  options->panSrcBands = static_cast<int *>(CPLMalloc(sizeof(int) * state->bands));
+  options->panDstBands = static_cast<int *>(CPLMalloc(sizeof(int) * state->bands));
+  for (int i = 0; i < state->bands; i++) {
+    options->panSrcBands[i] = bands[i];
+    options->panDstBands[i] = i + 1;
+  }
+  options->nSrcAlphaBand = src_alpha;
+
+  // Bands without a NoData value get NaN, which never matches an integer pixel
+  bool any_nodata = has_src_nodata;
+  std::vector<double> nodata(state->bands, has_src_nodata ? src_nodata : NAN);
+  if (!has_src_nodata) {
+    for (int i = 0; i < state->bands; i++) {
+      int has;
+      double value = raw->GetRasterBand(bands[i])->GetNoDataValue(&has);
+      if (has) {
+        nodata[i] = value;
+        any_nodata = true;
+      }
+    }
+  }
+  if (any_nodata) {
+    options->padfSrcNoDataReal = static_cast<double *>(CPLMalloc(sizeof(double) * state->bands));
+    options->padfSrcNoDataImag = static_cast<double *>(CPLCalloc(sizeof(double), state->bands));
+    for (int i = 0; i < state->bands; i++) options->padfSrcNoDataReal[i] = nodata[i];
+  }
+  if (state->has_dst_nodata) {
+    options->padfDstNoDataReal = static_cast<double *>(CPLMalloc(sizeof(double) * state->bands));
+    options->padfDstNoDataImag = static_cast<double *>(CPLCalloc(sizeof(double), state->bands));
+    for (int i = 0; i < state->bands; i++) options->padfDstNoDataReal[i] = state->dst_nodata;
+  }
+
+  options->papszWarpOptions = CSLDuplicate(warp_options.get());
+  // Windows outside of the source simply remain empty
+  options->papszWarpOptions = CSLSetNameValue(options->papszWarpOptions, "ERROR_OUT_IF_EMPTY_SOURCE_WINDOW", "NO");
+
+  if (max_error > 0) {
+    state->approx_transformer = GDALCreateApproxTransformer(GDALGenImgProjTransform, state->gen_transformer, max_error);
+    options->pfnTransformer = GDALApproxTransform;
+    options->pTransformerArg = state->approx_transformer;
+  } else {
+    options->pfnTransformer = GDALGenImgProjTransform;
+    options->pTransformerArg = state->gen_transformer;
+  }
+
+  // Initialize() makes its own copy of the options
+  state->operation = std::unique_ptr<GDALWarpOperation>(new GDALWarpOperation());
+  CPLErr err = state->operation->Initialize(options);
+  GDALDestroyWarpOptions(options);
+  if (err != CE_None) {
+    NODE_THROW_LAST_CPLERR;
+    return;
+  }
+
+  WarpContext *ctx = new WarpContext(state, src->uid);
+  ctx->Wrap(info.This());
+  // The context must keep the source dataset alive
+  Nan::SetPrivate(info.This(), Nan::New("src_").ToLocalChecked(), src_obj);
+
+  info.GetReturnValue().Set(info.This());
+}
+
+NAN_METHOD(WarpContext::toString) {
+  info.GetReturnValue().Set(Nan::New("WarpContext").ToLocalChecked());
+}
+
+/**
+ * Renders a window of the target spatial reference system.
+ *
+ * The result is band-sequential: the pixels of the first band
+ * followed by the pixels of the second band and so on. The pixels
+ * without data are set to `dstNodata`.
+ *
+ * @method renderWindow
+ * @instance
+ * @memberof WarpContext
+ * @throws {Error}
+ * @param {number[]} geoTransform The geotransform of the window
+ * @param {number} width Width of the window in pixels
+ * @param {number} height Height of the window in pixels
+ * @param {TypedArray} [data] The destination array of `width * height * bands` elements of {@link WarpContext.dataType}, a new one is created if not given
+ * @return {TypedArray}
+ */
+
+/**
+ * Renders a window of the target spatial reference system.
+ * @async
+ *
+ * @method renderWindowAsync
+ * @instance
+ * @memberof WarpContext
+ * @throws {Error}
+ * @param {number[]} geoTransform The geotransform of the window
+ * @param {number} width Width of the window in pixels
+ * @param {number} height Height of the window in pixels
+ * @param {TypedArray} [data] The destination array of `width * height * bands` elements of {@link WarpContext.dataType}, a new one is created if not given
+ * @param {callback<TypedArray>} [callback=undefined]
+ * @return {Promise<TypedArray>}
+ */
+GDAL_ASYNCABLE_DEFINE(WarpContext::renderWindow) {
+  WarpContext *ctx = Nan::ObjectWrap::Unwrap<WarpContext>(info.This());
+  std::shared_ptr<WarpContextState> state = ctx->state;
+  Local<Array> gt_array;
+  int w, h;
+  Local<Object> obj;
+
+  NODE_ARG_ARRAY(0, "geoTransform", gt_array);
+  NODE_ARG_INT(1, "width", w);
+  NODE_ARG_INT(2, "height", h);
+
+  Local<Value> src_obj = Nan::GetPrivate(info.This(), Nan::New("src_").ToLocalChecked()).ToLocalChecked();
+  Dataset *src = Nan::ObjectWrap::Unwrap<Dataset>(src_obj.As<Object>());
+  if (!src->isAlive()) {
+    Nan::ThrowError("src: Dataset object has already been destroyed");
+    return;
+  }
+
+  if (gt_array->Length() != 6) {
+    Nan::ThrowError("geoTransform array must have 6 elements");
+    return;
+  }
+  std::vector<double> gt(6);
+  for (int i = 0; i < 6; i++) {
+    Local<Value> val = Nan::Get(gt_array, i).ToLocalChecked();
+    if (!val->IsNumber()) {
+      Nan::ThrowError("geoTransform array must only contain numbers");
+      return;
+    }
+    gt[i] = Nan::To<double>(val).ToChecked();
+  }
+  if (w <= 0 || h <= 0 || static_cast<int64_t>(w) * h > INT_MAX) {
+    Nan::ThrowRangeError("Invalid window size");
+    return;
+  }
+
+  int64_t length = static_cast<int64_t>(w) * h * state->bands;
+  if (info.Length() > 3 && !info[3]->IsUndefined() && !info[3]->IsNull()) {
+    NODE_ARG_OBJECT(3, "data", obj);
+  } else {
+    Local<Value> array = TypedArray::New(state->type, length);
+    if (array.IsEmpty() || !array->IsObject()) {
+      return; // TypedArray::New threw an error
+    }
+    obj = array.As<Object>();
+  }
+
+  void *data = TypedArray::Validate(obj, state->type, length);
+  if (!data) {
+    return; // TypedArray::Validate threw an error
+  }
+
+  GDALAsyncableJob<CPLErr> job(ctx->src_uid);
+  job.persist("array", obj);
+  job.persist(info.This());
+  job.main = [state, gt, w, h, data](const GDALExecutionProgress &) {
+    // The warp kernel composites over the existing content of the buffer
+    int pixels = w * h;
+    int size = GDALGetDataTypeSize(state->type) / 8;
+    if (state->has_dst_nodata) {
+      for (int i = 0; i < state->bands; i++)
+        GDALCopyWords(
+          &state->dst_nodata,
+          GDT_Float64,
+          0,
+          static_cast<GByte *>(data) + static_cast<size_t>(i) * pixels * size,
+          state->type,
+          size,
+          pixels);
+    } else {
+      memset(data, 0, static_cast<size_t>(pixels) * state->bands * size);
+    }
+
+    GDALSetGenImgProjTransformerDstGeoTransform(state->gen_transformer, gt.data());
+    CPLErrorReset();
+    CPLErr err = state->operation->WarpRegionToBuffer(0, 0, w, h, data, state->type);
+    if (err != CE_None) throw CPLGetLastErrorMsg();
+    return err;
+  };
+  job.rval = [](CPLErr, const GetFromPersistentFunc &getter) { return getter("array"); };
+  job.run(info, async, 4);
+}
+
+/**
+ * Number of bands of the rendered windows.
+ *
+ * @readonly
+ * @kind member
+ * @name bands
+ * @instance
+ * @memberof WarpContext
+ * @type {number}
+ */
+NAN_GETTER(WarpContext::bandsGetter) {
+  WarpContext *ctx = Nan::ObjectWrap::Unwrap<WarpContext>(info.This());
+  info.GetReturnValue().Set(Nan::New<Integer>(ctx->state->bands));
+}
+
+/**
+ * Data type of the rendered windows.
+ *
+ * @readonly
+ * @kind member
+ * @name dataType
+ * @instance
+ * @memberof WarpContext
+ * @type {string}
+ */
+NAN_GETTER(WarpContext::dataTypeGetter) {
+  WarpContext *ctx = Nan::ObjectWrap::Unwrap<WarpContext>(info.This());
+  info.GetReturnValue().Set(SafeString::New(GDALGetDataTypeName(ctx->state->type)));
+}
+
+} // namespace node_gdal
@@ -0,0 +1,66 @@
+#ifndef __NODE_GDAL_WARP_CONTEXT_H__
+#define __NODE_GDAL_WARP_CONTEXT_H__
+
+// node
+#include <node.h>
+#include <node_object_wrap.h>
+
+// nan
+#include "nan-wrapper.h"
+
+// gdal
+#include <gdal_priv.h>
+#include <gdalwarper.h>
+
+#include <memory>
+#include <vector>
+
+#include "async.hpp"
+
+using namespace v8;
+using namespace node;
+
+namespace node_gdal {
+
+// The GDAL objects of a WarpContext, shared with the running jobs
+// The transformers and the warp operation are created once and reused
+// for every rendered window, only the destination geotransform changes
+struct WarpContextState {
+  GDALDataset *src;
+  void *gen_transformer;
+  void *approx_transformer;
+  std::unique_ptr<GDALWarpOperation> operation;
+  GDALDataType type;
+  int bands;
+  bool has_dst_nodata;
+  double dst_nodata;
+
+  WarpContextState();
+  ~WarpContextState();
+};
+
+class WarpContext : public Nan::ObjectWrap {
+    public:
+  static Nan::Persistent<FunctionTemplate> constructor;
+
+  static void Initialize(Local<Object> target);
+  static NAN_METHOD(New);
+  static NAN_METHOD(toString);
+  GDAL_ASYNCABLE_DECLARE(renderWindow);
+
+  static NAN_GETTER(bandsGetter);
+  static NAN_GETTER(dataTypeGetter);
+
+  WarpContext(std::shared_ptr<WarpContextState> state, long src_uid);
+  inline std::shared_ptr<WarpContextState> get() {
+    return state;
+  }
+
+    private:
+  ~WarpContext();
+  std::shared_ptr<WarpContextState> state;
+  long src_uid;
+};
+
+} // namespace node_gdal
+#endif
@@ -2,13 +2,17 @@
 #include "gdal_common.hpp"
 #include "gdal_dataset.hpp"
 #include "gdal_spatial_reference.hpp"
+#include "utils/tile_pyramid.hpp"
 #include "utils/warp_options.hpp"
 
+#include <memory>
+
 namespace node_gdal {
 
 void Warper::Initialize(Local<Object> target) {
   Nan__SetAsyncableMethod(target, "reprojectImage", reprojectImage);
   Nan__SetAsyncableMethod(target, "suggestedWarpOutput", suggestedWarpOutput);
+  Nan__SetAsyncableMethod(target, "buildTilePyramid", buildTilePyramid);
 }
 
 /**
@@ -31,6 +35,7 @@ void Warper::Initialize(Local<Object> target) {
  * @property {boolean} [multi]
  * @property {object} [options]
  * @property {ProgressCb} [progress_cb]
+ * @property {AbortSignal} [signal]
  */
 
 /*
@@ -291,7 +296,7 @@ GDAL_ASYNCABLE_DEFINE(Warper::reprojectImage) {
   // opts is a pointer inside options memory space
   // the lifetime of the options shared_ptr is limited by the lifetime of the lambda
   if (options->useMultithreading()) {
-    job.main = [options, opts, s_srs_str, t_srs_str, maxError, progress_cb](const GDALExecutionProgress &progress) {
+    job.main = [options, opts, s_srs_str, t_srs_str, maxError](const GDALExecutionProgress &progress) {
       CPLErrorReset();
       CPLErr err = GDALReprojectImageMulti(
         opts->hSrcDS,
@@ -301,14 +306,14 @@ GDAL_ASYNCABLE_DEFINE(Warper::reprojectImage) {
         opts->eResampleAlg,
         opts->dfWarpMemoryLimit,
         maxError,
-        progress_cb ? ProgressTrampoline : nullptr,
-        progress_cb ? (void *)&progress : nullptr,
+        progress.active() ? ProgressTrampoline : nullptr,
+        progress.active() ? (void *)&progress : nullptr,
         opts);
       if (err) { throw CPLGetLastErrorMsg(); }
       return err;
     };
   } else {
-    job.main = [options, opts, s_srs_str, t_srs_str, maxError, progress_cb](const GDALExecutionProgress &progress) {
+    job.main = [options, opts, s_srs_str, t_srs_str, maxError](const GDALExecutionProgress &progress) {
       CPLErrorReset();
       CPLErr err = GDALReprojectImage(
         opts->hSrcDS,
@@ -318,8 +323,8 @@ GDAL_ASYNCABLE_DEFINE(Warper::reprojectImage) {
         opts->eResampleAlg,
         opts->dfWarpMemoryLimit,
         maxError,
-        progress_cb ? ProgressTrampoline : nullptr,
-        progress_cb ? (void *)&progress : nullptr,
+        progress.active() ? ProgressTrampoline : nullptr,
+        progress.active() ? (void *)&progress : nullptr,
         opts);
       if (err) { throw CPLGetLastErrorMsg(); }
       return err;
@@ -493,4 +498,187 @@ GDAL_ASYNCABLE_DEFINE(Warper::suggestedWarpOutput) {
   job.run(info, async, 1);
 }
 
+/**
+ * @typedef {object} TilePyramidOptions
+ * @property {number} [minZoom]
+ * @property {number} maxZoom
+ * @property {number} [tileSize]
+ * @property {string} [format]
+ * @property {string} [resampling]
+ * @property {string} [outDir]
+ * @property {number} [concurrency]
+ * @property {ProgressCb} [progress_cb]
+ * @property {AbortSignal} [signal]
+ */
+
+/**
+ * @typedef {object} PyramidTile
+ * @property {number} z
+ * @property {number} x
+ * @property {number} y
+ * @property {Buffer} data
+ */
+
+/**
+ * @typedef {object} TilePyramidResult
+ * @property {number} count
+ * @property {PyramidTile[]} [tiles]
+ */
+
+/**
+ * Generates a XYZ (Google / OpenStreetMap) tile pyramid in Web Mercator (`EPSG:3857`).
+ *
+ * The tiles of `maxZoom` are warped from the source on multiple threads, each thread
+ * reusing the same warper for all its tiles, the tiles of the lower zoom levels are
+ * produced by downsampling their four children instead of warping the source again.
+ * Every thread builds whole subtrees of the pyramid depth-first, keeping in memory
+ * only the children of the tiles it is working on.
+ *
+ * Fully transparent tiles are skipped. When `outDir` is given, the tiles are written
+ * to `outDir/z/x/y.png` (`.webp`, `.raw`), otherwise they are returned. `raw` tiles contain
+ * the pixels in the source data type, band after band, followed by an alpha band.
+ * `png` and `webp` tiles are always 8-bit and require a source with 1 or 3 bands,
+ * not counting its alpha band.
+ *
+ * Only the thread that runs the job uses `src`, the other threads open their own
+ * copy of the source from its filename. Sources that cannot be reopened as the same
+ * files with the same driver (ie `MEM` datasets) and sources opened in update mode
+ * are processed on a single thread.
+ *
+ * @example
+ * await gdal.buildTilePyramidAsync(ds, { minZoom: 0, maxZoom: 8, outDir: 'tiles' })
+ *
+ * @throws {Error}
+ * @method buildTilePyramid
+ * @static
+ * @param {Dataset} src
+ * @param {TilePyramidOptions} options
+ * @param {number} [options.minZoom=0]
+ * @param {number} options.maxZoom
+ * @param {number} [options.tileSize=256]
+ * @param {string} [options.format="png"] One of `png`, `webp` or `raw`
+ * @param {string} [options.resampling] Resampling algorithm ({@link GRA|available options}), lower zoom levels are averaged unless it is `NearestNeighbor` or `Mode`
+ * @param {string} [options.outDir] Output directory, can be on any GDAL filesystem
+ * @param {number} [options.concurrency] Number of threads, `GDAL_NUM_THREADS` by default
+ * @param {ProgressCb} [options.progress_cb]
+ * @return {TilePyramidResult}
+ */
+
+/**
+ * Generates a XYZ (Google / OpenStreetMap) tile pyramid in Web Mercator (`EPSG:3857`).
+ * @async
+ *
+ * See {@link buildTilePyramid}.
+ *
+ * @throws {Error}
+ * @method buildTilePyramidAsync
+ * @static
+ * @param {Dataset} src
+ * @param {TilePyramidOptions} options
+ * @param {number} [options.minZoom=0]
+ * @param {number} options.maxZoom
+ * @param {number} [options.tileSize=256]
+ * @param {string} [options.format="png"] One of `png`, `webp` or `raw`
+ * @param {string} [options.resampling] Resampling algorithm ({@link GRA|available options}), lower zoom levels are averaged unless it is `NearestNeighbor` or `Mode`
+ * @param {string} [options.outDir] Output directory, can be on any GDAL filesystem
+ * @param {number} [options.concurrency] Number of threads, `GDAL_NUM_THREADS` by default
+ * @param {ProgressCb} [options.progress_cb]
+ * @param {callback<TilePyramidResult>} [callback=undefined]
+ * @return {Promise<TilePyramidResult>}
+ */
+struct TilePyramidResult {
+  size_t count;
+  bool returned;
+  std::vector<TilePyramidTile> tiles;
+};
+
+GDAL_ASYNCABLE_DEFINE(Warper::buildTilePyramid) {
+  Dataset *ds;
+  Local<Object> obj;
+  std::string format = "png";
+  TilePyramidOptions options;
+  options.min_zoom = 0;
+  options.tile_size = 256;
+  options.concurrency = 0;
+  Nan::Callback *progress_cb = nullptr;
+
+  NODE_ARG_WRAPPED(0, "src", Dataset, ds);
+  NODE_ARG_OBJECT(1, "options", obj);
+  GDAL_RAW_CHECK(GDALDataset *, ds, raw);
+
+  NODE_INT_FROM_OBJ_OPT(obj, "minZoom", options.min_zoom);
+  NODE_INT_FROM_OBJ(obj, "maxZoom", options.max_zoom);
+  NODE_INT_FROM_OBJ_OPT(obj, "tileSize", options.tile_size);
+  NODE_STR_FROM_OBJ_OPT(obj, "format", format);
+  NODE_STR_FROM_OBJ_OPT(obj, "outDir", options.out_dir);
+  NODE_INT_FROM_OBJ_OPT(obj, "concurrency", options.concurrency);
+  NODE_CB_FROM_OBJ_OPT(obj, "progress_cb", progress_cb);
+
+  WarpOptions resampling;
+  Local<String> sym = Nan::New("resampling").ToLocalChecked();
+  if (resampling.parseResamplingAlg(
+        Nan::HasOwnProperty(obj, sym).FromMaybe(false) ? Nan::Get(obj, sym).ToLocalChecked()
+                                                       : Nan::Undefined().As<Value>()))
+    return;
+  options.resampling = resampling.get()->eResampleAlg;
+
+  if (options.min_zoom < 0 || options.max_zoom < options.min_zoom || options.max_zoom > 30) {
+    Nan::ThrowRangeError("Invalid zoom levels");
+    return;
+  }
+  if (options.tile_size < 2 || options.tile_size > 4096 || options.tile_size % 2) {
+    Nan::ThrowRangeError("tileSize must be an even number between 2 and 4096");
+    return;
+  }
+  if (format == "png") {
+    options.format = TilePNG;
+  } else if (format == "webp") {
+    options.format = TileWEBP;
+  } else if (format == "raw") {
+    options.format = TileRaw;
+  } else {
+    Nan::ThrowError("format must be one of png, webp or raw");
+    return;
+  }
+  if (options.format != TileRaw && !GetGDALDriverManager()->GetDriverByName(options.format == TilePNG ? "PNG" : "WEBP")) {
+    Nan::ThrowError("The driver for this tile format is not available");
+    return;
+  }
+
+  GDALAsyncableJob<std::shared_ptr<TilePyramidResult>> job(ds->uid);
+  job.progress = progress_cb;
+  job.main = [raw, options](const GDALExecutionProgress &progress) {
+    std::shared_ptr<TilePyramidResult> r = std::make_shared<TilePyramidResult>();
+    r->count = BuildTilePyramid(raw, options, r->tiles, [&progress](double complete) {
+      if (progress.active() && !ProgressTrampoline(complete, "", (void *)&progress)) throw abortedMessage;
+    });
+    r->returned = options.out_dir.empty();
+    return r;
+  };
+  job.rval = [](std::shared_ptr<TilePyramidResult> r, const GetFromPersistentFunc &) {
+    Nan::EscapableHandleScope scope;
+    Local<Object> result = Nan::New<Object>();
+    Nan::Set(result, Nan::New("count").ToLocalChecked(), Nan::New<Number>(static_cast<double>(r->count)));
+    if (r->returned) {
+      Local<Array> tiles = Nan::New<Array>(r->tiles.size());
+      for (size_t i = 0; i < r->tiles.size(); i++) {
+        const TilePyramidTile &tile = r->tiles[i];
+        Local<Object> t = Nan::New<Object>();
+        Nan::Set(t, Nan::New("z").ToLocalChecked(), Nan::New<Integer>(tile.z));
+        Nan::Set(t, Nan::New("x").ToLocalChecked(), Nan::New<Integer>(tile.x));
+        Nan::Set(t, Nan::New("y").ToLocalChecked(), Nan::New<Integer>(tile.y));
+        Nan::Set(
+          t,
+          Nan::New("data").ToLocalChecked(),
+          Nan::CopyBuffer(reinterpret_cast<const char *>(tile.data.data()), tile.data.size()).ToLocalChecked());
+        Nan::Set(tiles, i, t);
+      }
+      Nan::Set(result, Nan::New("tiles").ToLocalChecked(), tiles);
+    }
+    return scope.Escape(result);
+  };
+
+  job.run(info, async, 2);
+}
+
 } // namespace node_gdal
@@ -19,7 +19,7 @@ void CompoundCurve::Initialize(Local<Object> target) {
   lcons->InstanceTemplate()->SetInternalFieldCount(1);
   lcons->SetClassName(Nan::New("CompoundCurve").ToLocalChecked());
 
-  Nan::SetPrototypeMethod(lcons, "toString", toString);
+  Nan__SetPrototypeMethod(lcons, "toString", toString);
 
   ATTR(lcons, "curves", curvesGetter, READ_ONLY_SETTER);
 
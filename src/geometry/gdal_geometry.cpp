@@ -14,9 +14,13 @@
 #include "gdal_point.hpp"
 #include "gdal_polygon.hpp"
 #include "../gdal_spatial_reference.hpp"
+#include "../utils/parallel.hpp"
+#include "gdal_geometrybatch.hpp"
+#include "gdal_geometrycursor.hpp"
 
 #include <node_buffer.h>
 #include <ogr_core.h>
+#include <cmath>
 #include <memory>
 #include <sstream>
 #include <stdlib.h>
@@ -32,15 +36,17 @@ void Geometry::Initialize(Local<Object> target) {
   lcons->InstanceTemplate()->SetInternalFieldCount(1);
   lcons->SetClassName(Nan::New("Geometry").ToLocalChecked());
 
-  // Nan::SetMethod(constructor, "fromWKBType", Geometry::create);
+  // Nan__SetMethod(constructor, "fromWKBType", Geometry::create);
   Nan__SetAsyncableMethod(lcons, "fromWKT", Geometry::createFromWkt);
   Nan__SetAsyncableMethod(lcons, "fromWKB", Geometry::createFromWkb);
   Nan__SetAsyncableMethod(lcons, "fromGeoJson", Geometry::createFromGeoJson);
   Nan__SetAsyncableMethod(lcons, "fromGeoJsonBuffer", Geometry::createFromGeoJsonBuffer);
-  Nan::SetMethod(lcons, "getName", Geometry::getName);
-  Nan::SetMethod(lcons, "getConstructor", Geometry::getConstructor);
+  Nan__SetAsyncableMethod(lcons, "fromWKBArray", Geometry::createFromWkbArray);
+  Nan__SetAsyncableMethod(lcons, "fromWKTArray", Geometry::createFromWktArray);
+  Nan__SetMethod(lcons, "getName", Geometry::getName);
+  Nan__SetMethod(lcons, "getConstructor", Geometry::getConstructor);
 
-  Nan::SetPrototypeMethod(lcons, "toString", toString);
+  Nan__SetPrototypeMethod(lcons, "toString", toString);
   Nan__SetPrototypeAsyncableMethod(lcons, "toKML", exportToKML);
   Nan__SetPrototypeAsyncableMethod(lcons, "toGML", exportToGML);
   Nan__SetPrototypeAsyncableMethod(lcons, "toJSON", exportToJSON);
@@ -50,7 +56,7 @@ void Geometry::Initialize(Local<Object> target) {
   Nan__SetPrototypeAsyncableMethod(lcons, "isValid", isValid);
   Nan__SetPrototypeAsyncableMethod(lcons, "isSimple", isSimple);
   Nan__SetPrototypeAsyncableMethod(lcons, "isRing", isRing);
-  Nan::SetPrototypeMethod(lcons, "clone", clone);
+  Nan__SetPrototypeMethod(lcons, "clone", clone);
   Nan__SetPrototypeAsyncableMethod(lcons, "empty", empty);
   Nan__SetPrototypeAsyncableMethod(lcons, "closeRings", closeRings);
   Nan__SetPrototypeAsyncableMethod(lcons, "intersects", intersects);
@@ -72,7 +78,8 @@ void Geometry::Initialize(Local<Object> target) {
   Nan__SetPrototypeAsyncableMethod(lcons, "centroid", centroid);
   Nan__SetPrototypeAsyncableMethod(lcons, "simplify", simplify);
   Nan__SetPrototypeAsyncableMethod(lcons, "simplifyPreserveTopology", simplifyPreserveTopology);
-  Nan::SetPrototypeMethod(lcons, "segmentize", segmentize);
+  Nan__SetPrototypeMethod(lcons, "segmentize", segmentize);
+  Nan__SetPrototypeMethod(lcons, "visit", visit);
   Nan__SetPrototypeAsyncableMethod(lcons, "swapXY", swapXY);
   Nan__SetPrototypeAsyncableMethod(lcons, "getEnvelope", getEnvelope);
   Nan__SetPrototypeAsyncableMethod(lcons, "getEnvelope3D", getEnvelope3D);
@@ -1527,6 +1534,43 @@ GDAL_ASYNCABLE_DEFINE(Geometry::getEnvelope3D) {
 
 NODE_WRAPPED_ASYNC_METHOD(Geometry, flattenTo2D, flattenTo2D);
 
+/**
+ * Walks the geometry and all its descendants - collection members,
+ * polygon rings and compound curve parts - depth-first, calling the callback
+ * for each one with a {@link GeometryCursor} pointing to it.
+ *
+ * The same cursor object is reused for all the geometries, no Geometry
+ * objects are created unless `cursor.geometry()` is called.
+ * Returning `false` from the callback stops the traversal.
+ * The callback can modify the geometry, the traversal continues from
+ * the position of the cursor in the modified geometry: the removed geometries
+ * are skipped and the children added after this position are visited.
+ *
+ * @example
+ *
+ * let points = 0;
+ * multipolygon.visit((cursor) => {
+ *   points += cursor.pointCount;
+ * });
+ *
+ * @method visit
+ * @instance
+ * @memberof Geometry
+ * @param {(cursor: GeometryCursor) => boolean|void} callback
+ */
+NAN_METHOD(Geometry::visit) {
+  Geometry *geom = Nan::ObjectWrap::Unwrap<Geometry>(info.This());
+  Local<Function> callback;
+
+  NODE_ARG_CB(0, "callback", callback);
+
+  Local<Object> cursor = GeometryCursor::New();
+  std::vector<int> path;
+  GeometryCursor::Visit(cursor, callback, geom, path);
+  // The cursor can escape from the callback
+  Nan::ObjectWrap::Unwrap<GeometryCursor>(cursor)->reset();
+}
+
 // --- JS static methods (OGRGeometryFactory) ---
 
 /**
@@ -1773,6 +1817,224 @@ GDAL_ASYNCABLE_DEFINE(Geometry::createFromGeoJsonBuffer) {
 #endif
 }
 
+// Converts an offset given as a double, the conversion of a value that cannot
+// be represented is undefined, throws a JS exception and returns false on error
+static bool toOffset(double v, size_t length, size_t &offset) {
+  if (!std::isfinite(v) || v < 0 || v != std::floor(v) || v > static_cast<double>(length)) {
+    Nan::ThrowRangeError("offsets must be non-negative integers within the buffer");
+    return false;
+  }
+  offset = static_cast<size_t>(v);
+  return true;
+}
+
+// Reads the N+1 offsets delimiting N geometries in a buffer of the given length
+// (the Arrow / GeoParquet layout), throws a JS exception and returns false on error
+static bool readOffsets(Local<Value> arg, size_t length, std::vector<size_t> &offsets) {
+  if (arg->IsUint32Array() || arg->IsInt32Array()) {
+    Nan::TypedArrayContents<int32_t> data(arg);
+    offsets.resize(data.length());
+    for (size_t i = 0; i < offsets.size(); i++) offsets[i] = static_cast<uint32_t>((*data)[i]);
+  } else if (arg->IsFloat64Array()) {
+    Nan::TypedArrayContents<double> data(arg);
+    offsets.resize(data.length());
+    for (size_t i = 0; i < offsets.size(); i++)
+      if (!toOffset((*data)[i], length, offsets[i])) return false;
+  } else if (arg->IsArray()) {
+    Local<Array> array = arg.As<Array>();
+    offsets.resize(array->Length());
+    for (size_t i = 0; i < offsets.size(); i++) {
+      Local<Value> v = Nan::Get(array, i).ToLocalChecked();
+      if (!v->IsNumber()) {
+        Nan::ThrowTypeError("offsets must contain only numbers");
+        return false;
+      }
+      if (!toOffset(Nan::To<double>(v).ToChecked(), length, offsets[i])) return false;
+    }
+  } else {
+    Nan::ThrowTypeError("offsets must be an array, an Uint32Array, an Int32Array or a Float64Array");
+    return false;
+  }
+
+  if (offsets.size() < 1) {
+    Nan::ThrowRangeError("offsets must contain at least one element");
+    return false;
+  }
+  for (size_t i = 0; i < offsets.size(); i++) {
+    if (offsets[i] > length || (i > 0 && offsets[i] < offsets[i - 1])) {
+      Nan::ThrowRangeError("offsets must be increasing and within the buffer");
+      return false;
+    }
+  }
+  return true;
+}
+
+// Common implementation of fromWKBArray / fromWKTArray
+static void createFromArray(const Nan::FunctionCallbackInfo<v8::Value> &info, bool async, bool wkt) {
+  Local<Object> buffer_obj;
+  SpatialReference *srs = NULL;
+
+  NODE_ARG_OBJECT(0, "buffer", buffer_obj);
+  if (info.Length() < 2) {
+    Nan::ThrowError("offsets must be given");
+    return;
+  }
+  NODE_ARG_WRAPPED_OPT(2, "srs", SpatialReference, srs);
+
+  std::string obj_type = *Nan::Utf8String(buffer_obj->GetConstructorName());
+  if (obj_type != "Buffer" && obj_type != "Uint8Array") {
+    Nan::ThrowError("Argument must be a buffer object");
+    return;
+  }
+
+  char *data = Buffer::Data(buffer_obj);
+  size_t length = Buffer::Length(buffer_obj);
+
+  auto offsets = std::make_shared<std::vector<size_t>>();
+  if (!readOffsets(info[1], length, *offsets)) return;
+
+  OGRSpatialReference *ogr_srs = NULL;
+  if (srs) { ogr_srs = srs->get(); }
+
+  size_t count = offsets->size() - 1;
+  int threads = GetNumThreads(count);
+  size_t grain = std::max<size_t>(1, count / (static_cast<size_t>(threads) * 8));
+
+  GDALAsyncableJob<GeometryBatchResult *> job(0);
+  // The job reads directly from the buffer
+  job.persist(buffer_obj);
+  if (srs) job.persist(info[2].As<Object>());
+  job.main = [data, offsets, ogr_srs, wkt, count, threads, grain](const GDALExecutionProgress &) {
+    std::unique_ptr<GeometryBatchResult> r(new GeometryBatchResult(count));
+    ParallelFor(count, threads, grain, [&](size_t begin, size_t end, int) {
+      std::string text;
+      for (size_t i = begin; i < end; i++) {
+        size_t start = (*offsets)[i];
+        size_t len = (*offsets)[i + 1] - start;
+        // Empty elements are null geometries
+        if (len == 0) continue;
+        OGRErr err;
+        if (wkt) {
+          // createFromWkt expects a zero-terminated string
+          text.assign(data + start, len);
+          const char *p = text.c_str();
+          err = OGRGeometryFactory::createFromWkt(&p, ogr_srs, &r->geoms[i]);
+        } else {
+          err = OGRGeometryFactory::createFromWkb(data + start, ogr_srs, &r->geoms[i], len);
+        }
+        if (err) {
+          CPLError(CE_Failure, CPLE_AppDefined, "Failed decoding geometry %lu: %s", (unsigned long)i, getOGRErrMsg(err));
+          throw CPLGetLastErrorMsg();
+        }
+      }
+    });
+    return r.release();
+  };
+  job.rval = [](GeometryBatchResult *r, const GetFromPersistentFunc &) {
+    Nan::EscapableHandleScope scope;
+    std::unique_ptr<GeometryBatchResult> result(r);
+    Local<Array> geometries = Nan::New<Array>(r->geoms.size());
+    for (size_t i = 0; i < r->geoms.size(); i++) {
+      Nan::Set(geometries, i, Geometry::New(r->geoms[i], true));
+      r->geoms[i] = nullptr;
+    }
+    return scope.Escape(geometries);
+  };
+  job.run(info, async, 3);
+}
+
+/**
+ * Creates an array of Geometry from a buffer containing many WKB geometries,
+ * such as a WKB column retrieved from PostGIS, Arrow or GeoParquet.
+ *
+ * Geometry `i` spans the bytes from `offsets[i]` to `offsets[i + 1]`,
+ * `offsets` having one more element than the number of geometries.
+ * Empty spans produce `null` elements.
+ *
+ * The decoding is split across `GDAL_NUM_THREADS` threads.
+ *
+ * @static
+ * @method fromWKBArray
+ * @instance
+ * @memberof Geometry
+ * @throws {Error}
+ * @param {Buffer} wkb
+ * @param {number[]|Uint32Array|Int32Array|Float64Array} offsets
+ * @param {SpatialReference} [srs]
+ * @return {(Geometry|null)[]}
+ */
+
+/**
+ * Creates an array of Geometry from a buffer containing many WKB geometries,
+ * such as a WKB column retrieved from PostGIS, Arrow or GeoParquet.
+ *
+ * Geometry `i` spans the bytes from `offsets[i]` to `offsets[i + 1]`,
+ * `offsets` having one more element than the number of geometries.
+ * Empty spans produce `null` elements.
+ *
+ * The decoding is split across `GDAL_NUM_THREADS` threads.
+ * @async
+ *
+ * @static
+ * @method fromWKBArrayAsync
+ * @instance
+ * @memberof Geometry
+ * @throws {Error}
+ * @param {Buffer} wkb
+ * @param {number[]|Uint32Array|Int32Array|Float64Array} offsets
+ * @param {SpatialReference} [srs]
+ * @param {callback<(Geometry|null)[]>} [callback=undefined]
+ * @return {Promise<(Geometry|null)[]>}
+ */
+GDAL_ASYNCABLE_DEFINE(Geometry::createFromWkbArray) {
+  createFromArray(info, async, false);
+}
+
+/**
+ * Creates an array of Geometry from a buffer containing many UTF-8 WKT geometries.
+ *
+ * Geometry `i` spans the bytes from `offsets[i]` to `offsets[i + 1]`,
+ * `offsets` having one more element than the number of geometries.
+ * Empty spans produce `null` elements.
+ *
+ * The decoding is split across `GDAL_NUM_THREADS` threads.
+ *
+ * @static
+ * @method fromWKTArray
+ * @instance
+ * @memberof Geometry
+ * @throws {Error}
+ * @param {Buffer} wkt
+ * @param {number[]|Uint32Array|Int32Array|Float64Array} offsets
+ * @param {SpatialReference} [srs]
+ * @return {(Geometry|null)[]}
+ */
+
+/**
+ * Creates an array of Geometry from a buffer containing many UTF-8 WKT geometries.
+ *
+ * Geometry `i` spans the bytes from `offsets[i]` to `offsets[i + 1]`,
+ * `offsets` having one more element than the number of geometries.
+ * Empty spans produce `null` elements.
+ *
+ * The decoding is split across `GDAL_NUM_THREADS` threads.
+ * @async
+ *
+ * @static
+ * @method fromWKTArrayAsync
+ * @instance
+ * @memberof Geometry
+ * @throws {Error}
+ * @param {Buffer} wkt
+ * @param {number[]|Uint32Array|Int32Array|Float64Array} offsets
+ * @param {SpatialReference} [srs]
+ * @param {callback<(Geometry|null)[]>} [callback=undefined]
+ * @return {Promise<(Geometry|null)[]>}
+ */
+GDAL_ASYNCABLE_DEFINE(Geometry::createFromWktArray) {
+  createFromArray(info, async, true);
+}
+
 /**
  * Creates an empty Geometry from a WKB type.
  *
@@ -64,6 +64,7 @@ class Geometry : public GeometryBase<Geometry, OGRGeometry> {
   GDAL_ASYNCABLE_DECLARE(polygonize);
   GDAL_ASYNCABLE_DECLARE(swapXY);
   static NAN_METHOD(getNumGeometries);
+  static NAN_METHOD(visit);
   GDAL_ASYNCABLE_DECLARE(getEnvelope);
   GDAL_ASYNCABLE_DECLARE(getEnvelope3D);
   GDAL_ASYNCABLE_DECLARE(flattenTo2D);
@@ -79,6 +80,8 @@ class Geometry : public GeometryBase<Geometry, OGRGeometry> {
   GDAL_ASYNCABLE_DECLARE(createFromWkb);
   GDAL_ASYNCABLE_DECLARE(createFromGeoJson);
   GDAL_ASYNCABLE_DECLARE(createFromGeoJsonBuffer);
+  GDAL_ASYNCABLE_DECLARE(createFromWkbArray);
+  GDAL_ASYNCABLE_DECLARE(createFromWktArray);
   static NAN_METHOD(getName);
   static NAN_METHOD(getConstructor);
 
@@ -78,6 +78,9 @@ template <class T, class OGRT> class GeometryBase : public Nan::ObjectWrap {
   inline bool isAlive() {
     return this_;
   }
+  inline uv_sem_t *getAsyncLock() {
+    return async_lock;
+  }
 
     protected:
   ~GeometryBase();
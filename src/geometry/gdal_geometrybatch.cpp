@@ -0,0 +1,467 @@
+#include "gdal_geometrybatch.hpp"
+#include "../gdal_common.hpp"
+#include "../gdal_coordinate_transformation.hpp"
+#include "../utils/parallel.hpp"
+#include "gdal_geometry.hpp"
+#include "gdal_point.hpp"
+
+namespace node_gdal {
+
+Nan::Persistent<FunctionTemplate> GeometryBatch::constructor;
+
+void GeometryBatch::Initialize(Local<Object> target) {
+  Nan::HandleScope scope;
+
+  Local<FunctionTemplate> lcons = Nan::New<FunctionTemplate>(GeometryBatch::New);
+  lcons->InstanceTemplate()->SetInternalFieldCount(1);
+  lcons->SetClassName(Nan::New("GeometryBatch").ToLocalChecked());
+
+  Nan__SetPrototypeMethod(lcons, "toString", toString);
+  Nan__SetPrototypeMethod(lcons, "count", count);
+  Nan__SetPrototypeAsyncableMethod(lcons, "buffer", buffer);
+  Nan__SetPrototypeAsyncableMethod(lcons, "simplify", simplify);
+  Nan__SetPrototypeAsyncableMethod(lcons, "simplifyPreserveTopology", simplifyPreserveTopology);
+  Nan__SetPrototypeAsyncableMethod(lcons, "centroid", centroid);
+  Nan__SetPrototypeAsyncableMethod(lcons, "transform", transform);
+#if GDAL_VERSION_MAJOR >= 3
+  Nan__SetPrototypeAsyncableMethod(lcons, "makeValid", makeValid);
+#endif
+
+  Nan::Set(target, Nan::New("GeometryBatch").ToLocalChecked(), Nan::GetFunction(lcons).ToLocalChecked());
+
+  constructor.Reset(lcons);
+}
+
+GeometryBatchResult::GeometryBatchResult(size_t n) : geoms(n, nullptr), errors(n) {
+}
+
+// Geometries that were not handed over to JS are freed here
+GeometryBatchResult::~GeometryBatchResult() {
+  for (OGRGeometry *geom : geoms)
+    if (geom != nullptr) OGRGeometryFactory::destroyGeometry(geom);
+}
+
+GeometryBatch::GeometryBatch(
+  std::shared_ptr<std::vector<OGRGeometry *>> geoms, std::shared_ptr<std::vector<uv_sem_t *>> locks)
+  : Nan::ObjectWrap(), geoms(geoms), locks(locks) {
+}
+
+GeometryBatch::~GeometryBatch() {
+}
+
+/**
+ * A batch of geometries on which the same operation can be applied
+ * in a single job spread over multiple threads.
+ *
+ * Each batch operation returns new geometries, the original geometries
+ * are never modified. Errors are reported per geometry and a failure of
+ * one geometry does not fail the whole batch.
+ *
+ * The number of threads follows the `GDAL_NUM_THREADS` configuration option.
+ *
+ * @example
+ * const batch = new gdal.GeometryBatch(points)
+ * const { geometries, errors } = await batch.bufferAsync(10)
+ *
+ * @constructor
+ * @class GeometryBatch
+ * @param {Geometry[]} geometries
+ */
+NAN_METHOD(GeometryBatch::New) {
+  GeometryBatch *f;
+
+  if (!info.IsConstructCall()) {
+    Nan::ThrowError("Cannot call constructor as function, you need to use 'new' keyword");
+    return;
+  }
+
+  if (info[0]->IsExternal()) {
+    Local<External> ext = info[0].As<External>();
+    void *ptr = ext->Value();
+    f = static_cast<GeometryBatch *>(ptr);
+  } else {
+    Local<Array> array;
+    NODE_ARG_ARRAY(0, "geometries", array);
+
+    // Our own copy of the array keeps the geometries alive
+    // for as long as the batch exists
+    unsigned length = array->Length();
+    Local<Array> geometries = Nan::New<Array>(length);
+    auto geoms = std::make_shared<std::vector<OGRGeometry *>>();
+    auto locks = std::make_shared<std::vector<uv_sem_t *>>();
+    geoms->reserve(length);
+    locks->reserve(length);
+    for (unsigned i = 0; i < length; i++) {
+      Local<Value> element = Nan::Get(array, i).ToLocalChecked();
+      if (!IS_WRAPPED(element, Geometry)) {
+        Nan::ThrowTypeError("All array elements must be Geometry objects");
+        return;
+      }
+      Geometry *geom = Nan::ObjectWrap::Unwrap<Geometry>(element.As<Object>());
+      if (!geom->isAlive()) {
+        Nan::ThrowError("Geometry object has already been destroyed");
+        return;
+      }
+      geoms->push_back(geom->get());
+      locks->push_back(geom->getAsyncLock());
+      Nan::Set(geometries, i, element);
+    }
+    Nan::SetPrivate(info.This(), Nan::New("geometries_").ToLocalChecked(), geometries);
+
+    f = new GeometryBatch(geoms, locks);
+  }
+
+  f->Wrap(info.This());
+  info.GetReturnValue().Set(info.This());
+}
+
+NAN_METHOD(GeometryBatch::toString) {
+  info.GetReturnValue().Set(Nan::New("GeometryBatch").ToLocalChecked());
+}
+
+/**
+ * Returns the number of geometries in the batch.
+ *
+ * @method count
+ * @instance
+ * @memberof GeometryBatch
+ * @return {number}
+ */
+NAN_METHOD(GeometryBatch::count) {
+  GeometryBatch *batch = Nan::ObjectWrap::Unwrap<GeometryBatch>(info.This());
+  info.GetReturnValue().Set(Nan::New<Integer>(static_cast<uint32_t>(batch->geoms->size())));
+}
+
+/**
+ * @typedef {object} GeometryBatchResult
+ * @property {(Geometry|null)[]} geometries The resulting geometries, `null` for the failed elements
+ * @property {(string|null)[]} errors The error messages, `null` for the successful elements
+ */
+
+Local<Value> GeometryBatch::ToJS(GeometryBatchResult *r) {
+  Nan::EscapableHandleScope scope;
+
+  size_t n = r->geoms.size();
+  Local<Array> geometries = Nan::New<Array>(n);
+  Local<Array> errors = Nan::New<Array>(n);
+  for (size_t i = 0; i < n; i++) {
+    if (r->geoms[i] != nullptr) {
+      Nan::Set(geometries, i, Geometry::New(r->geoms[i], true));
+      // The geometry is now owned by its JS object
+      r->geoms[i] = nullptr;
+      Nan::Set(errors, i, Nan::Null());
+    } else {
+      Nan::Set(geometries, i, Nan::Null());
+      Nan::Set(errors, i, SafeString::New(r->errors[i].c_str()));
+    }
+  }
+
+  Local<Object> result = Nan::New<Object>();
+  Nan::Set(result, Nan::New("geometries").ToLocalChecked(), geometries);
+  Nan::Set(result, Nan::New("errors").ToLocalChecked(), errors);
+  return scope.Escape(result);
+}
+
+// Holds the lock of a geometry for the duration of an operation
+class GeometryLockGuard {
+    public:
+  inline GeometryLockGuard(uv_sem_t *sem) : sem(sem) {
+    uv_sem_wait(sem);
+  }
+  inline ~GeometryLockGuard() {
+    uv_sem_post(sem);
+  }
+  GeometryLockGuard(const GeometryLockGuard &) = delete;
+  GeometryLockGuard &operator=(const GeometryLockGuard &) = delete;
+
+    private:
+  uv_sem_t *sem;
+};
+
+void GeometryBatch::run(
+  const Nan::FunctionCallbackInfo<v8::Value> &info,
+  bool async,
+  int cb_arg,
+  const GeometryBatchOp &op,
+  int threads,
+  const std::vector<v8::Local<v8::Object>> &persistent) {
+  GeometryBatch *batch = Nan::ObjectWrap::Unwrap<GeometryBatch>(info.This());
+  std::shared_ptr<std::vector<OGRGeometry *>> geoms = batch->geoms;
+  std::shared_ptr<std::vector<uv_sem_t *>> locks = batch->locks;
+
+  // Small chunks balance the very uneven cost of the geometry operations
+  size_t grain = std::max<size_t>(1, geoms->size() / (static_cast<size_t>(threads) * 8));
+
+  GDALAsyncableJob<GeometryBatchResult *> job(0);
+  // The batch holds the references to the source geometries
+  job.persist(info.This());
+  for (const Local<Object> &obj : persistent) job.persist(obj);
+  job.main = [geoms, locks, op, threads, grain](const GDALExecutionProgress &) {
+    std::unique_ptr<GeometryBatchResult> r(new GeometryBatchResult(geoms->size()));
+    ParallelFor(geoms->size(), threads, grain, [&r, &geoms, &locks, &op](size_t begin, size_t end, int thread) {
+      for (size_t i = begin; i < end; i++) {
+        CPLErrorReset();
+        GeometryLockGuard lock((*locks)[i]);
+        try {
+          r->geoms[i] = op((*geoms)[i], thread);
+          if (r->geoms[i] == nullptr) {
+            const char *msg = CPLGetLastErrorMsg();
+            r->errors[i] = (msg != nullptr && *msg) ? msg : "Geometry operation failed";
+          }
+        } catch (const char *err) { r->errors[i] = err != nullptr ? err : "Geometry operation failed"; }
+      }
+    });
+    return r.release();
+  };
+  job.rval = [](GeometryBatchResult *r, const GetFromPersistentFunc &) {
+    std::unique_ptr<GeometryBatchResult> result(r);
+    return GeometryBatch::ToJS(r);
+  };
+  job.run(info, async, cb_arg);
+}
+
+/**
+ * Buffers all the geometries by the given distance.
+ *
+ * @method buffer
+ * @instance
+ * @memberof GeometryBatch
+ * @param {number} distance
+ * @param {number} [segments=30]
+ * @return {GeometryBatchResult}
+ */
+
+/**
+ * Buffers all the geometries by the given distance.
+ * @async
+ *
+ * @method bufferAsync
+ * @instance
+ * @memberof GeometryBatch
+ * @param {number} distance
+ * @param {number} [segments=30]
+ * @param {callback<GeometryBatchResult>} [callback=undefined]
+ * @return {Promise<GeometryBatchResult>}
+ */
+GDAL_ASYNCABLE_DEFINE(GeometryBatch::buffer) {
+  double distance;
+  int number_of_segments = 30;
+
+  NODE_ARG_DOUBLE(0, "distance", distance);
+  NODE_ARG_INT_OPT(1, "number of segments", number_of_segments);
+
+  GeometryBatch *batch = Nan::ObjectWrap::Unwrap<GeometryBatch>(info.This());
+  run(
+    info,
+    async,
+    2,
+    [distance, number_of_segments](OGRGeometry *geom, int) { return geom->Buffer(distance, number_of_segments); },
+    GetNumThreads(batch->geoms->size()));
+}
+
+/**
+ * Reduces the complexity of all the geometries.
+ *
+ * @method simplify
+ * @instance
+ * @memberof GeometryBatch
+ * @param {number} tolerance
+ * @return {GeometryBatchResult}
+ */
+
+/**
+ * Reduces the complexity of all the geometries.
+ * @async
+ *
+ * @method simplifyAsync
+ * @instance
+ * @memberof GeometryBatch
+ * @param {number} tolerance
+ * @param {callback<GeometryBatchResult>} [callback=undefined]
+ * @return {Promise<GeometryBatchResult>}
+ */
+GDAL_ASYNCABLE_DEFINE(GeometryBatch::simplify) {
+  double tolerance;
+
+  NODE_ARG_DOUBLE(0, "tolerance", tolerance);
+
+  GeometryBatch *batch = Nan::ObjectWrap::Unwrap<GeometryBatch>(info.This());
+  run(
+    info,
+    async,
+    1,
+    [tolerance](OGRGeometry *geom, int) { return geom->Simplify(tolerance); },
+    GetNumThreads(batch->geoms->size()));
+}
+
+/**
+ * Reduces the complexity of all the geometries while preserving their topology.
+ *
+ * @method simplifyPreserveTopology
+ * @instance
+ * @memberof GeometryBatch
+ * @param {number} tolerance
+ * @return {GeometryBatchResult}
+ */
+
+/**
+ * Reduces the complexity of all the geometries while preserving their topology.
+ * @async
+ *
+ * @method simplifyPreserveTopologyAsync
+ * @instance
+ * @memberof GeometryBatch
+ * @param {number} tolerance
+ * @param {callback<GeometryBatchResult>} [callback=undefined]
+ * @return {Promise<GeometryBatchResult>}
+ */
+GDAL_ASYNCABLE_DEFINE(GeometryBatch::simplifyPreserveTopology) {
+  double tolerance;
+
+  NODE_ARG_DOUBLE(0, "tolerance", tolerance);
+
+  GeometryBatch *batch = Nan::ObjectWrap::Unwrap<GeometryBatch>(info.This());
+  run(
+    info,
+    async,
+    1,
+    [tolerance](OGRGeometry *geom, int) { return geom->SimplifyPreserveTopology(tolerance); },
+    GetNumThreads(batch->geoms->size()));
+}
+
+/**
+ * Computes the centroids of all the geometries.
+ *
+ * @method centroid
+ * @instance
+ * @memberof GeometryBatch
+ * @return {GeometryBatchResult}
+ */
+
+/**
+ * Computes the centroids of all the geometries.
+ * @async
+ *
+ * @method centroidAsync
+ * @instance
+ * @memberof GeometryBatch
+ * @param {callback<GeometryBatchResult>} [callback=undefined]
+ * @return {Promise<GeometryBatchResult>}
+ */
+GDAL_ASYNCABLE_DEFINE(GeometryBatch::centroid) {
+  GeometryBatch *batch = Nan::ObjectWrap::Unwrap<GeometryBatch>(info.This());
+  run(
+    info,
+    async,
+    0,
+    [](OGRGeometry *geom, int) -> OGRGeometry * {
+      OGRPoint *point = new OGRPoint();
+      OGRErr err = geom->Centroid(point);
+      if (err) {
+        delete point;
+        throw getOGRErrMsg(err);
+      }
+      return point;
+    },
+    GetNumThreads(batch->geoms->size()));
+}
+
+/**
+ * Applies a coordinate transformation to copies of all the geometries.
+ *
+ * @throws {Error}
+ * @method transform
+ * @instance
+ * @memberof GeometryBatch
+ * @param {CoordinateTransformation} transformation
+ * @return {GeometryBatchResult}
+ */
+
+/**
+ * Applies a coordinate transformation to copies of all the geometries.
+ * @async
+ *
+ * @throws {Error}
+ * @method transformAsync
+ * @instance
+ * @memberof GeometryBatch
+ * @param {CoordinateTransformation} transformation
+ * @param {callback<GeometryBatchResult>} [callback=undefined]
+ * @return {Promise<GeometryBatchResult>}
+ */
+GDAL_ASYNCABLE_DEFINE(GeometryBatch::transform) {
+  CoordinateTransformation *ct;
+
+  NODE_ARG_WRAPPED(0, "transform", CoordinateTransformation, ct);
+
+  GeometryBatch *batch = Nan::ObjectWrap::Unwrap<GeometryBatch>(info.This());
+  OGRCoordinateTransformation *gdal_ct = ct->get();
+
+  // A coordinate transformation cannot be shared between threads,
+  // every thread gets its own clone, created on first use
+#if GDAL_VERSION_MAJOR > 3 || (GDAL_VERSION_MAJOR == 3 && GDAL_VERSION_MINOR >= 1)
+  int threads = GetNumThreads(batch->geoms->size());
+#else
+  int threads = 1;
+#endif
+  auto clones = std::make_shared<std::vector<std::shared_ptr<OGRCoordinateTransformation>>>(threads);
+
+  run(
+    info,
+    async,
+    1,
+    [gdal_ct, clones](OGRGeometry *geom, int thread) {
+      OGRCoordinateTransformation *thread_ct = gdal_ct;
+#if GDAL_VERSION_MAJOR > 3 || (GDAL_VERSION_MAJOR == 3 && GDAL_VERSION_MINOR >= 1)
+      if (thread > 0) {
+        if ((*clones)[thread] == nullptr) {
+          OGRCoordinateTransformation *clone = gdal_ct->Clone();
+          if (clone == nullptr) throw "Failed cloning the coordinate transformation";
+          (*clones)[thread] = std::shared_ptr<OGRCoordinateTransformation>(
+            clone, [](OGRCoordinateTransformation *ct) { OGRCoordinateTransformation::DestroyCT(ct); });
+        }
+        thread_ct = (*clones)[thread].get();
+      }
+#endif
+      OGRGeometry *r = geom->clone();
+      OGRErr err = r->transform(thread_ct);
+      if (err) {
+        OGRGeometryFactory::destroyGeometry(r);
+        throw getOGRErrMsg(err);
+      }
+      return r;
+    },
+    threads,
+    {info[0].As<Object>()});
+}
+
+#if GDAL_VERSION_MAJOR >= 3
+/**
+ * Attempts to make all the invalid geometries valid without losing vertices.
+ * Requires GDAL 3.0
+ *
+ * @method makeValid
+ * @instance
+ * @memberof GeometryBatch
+ * @return {GeometryBatchResult}
+ */
+
+/**
+ * Attempts to make all the invalid geometries valid without losing vertices.
+ * Requires GDAL 3.0
+ * @async
+ *
+ * @method makeValidAsync
+ * @instance
+ * @memberof GeometryBatch
+ * @param {callback<GeometryBatchResult>} [callback=undefined]
+ * @return {Promise<GeometryBatchResult>}
+ */
+GDAL_ASYNCABLE_DEFINE(GeometryBatch::makeValid) {
+  GeometryBatch *batch = Nan::ObjectWrap::Unwrap<GeometryBatch>(info.This());
+  run(
+    info, async, 0, [](OGRGeometry *geom, int) { return geom->MakeValid(); }, GetNumThreads(batch->geoms->size()));
+}
+#endif
+
+} // namespace node_gdal
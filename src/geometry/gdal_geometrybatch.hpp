@@ -0,0 +1,82 @@
+#ifndef __NODE_OGR_GEOMETRYBATCH_H__
+#define __NODE_OGR_GEOMETRYBATCH_H__
+
+// node
+#include <node.h>
+#include <node_object_wrap.h>
+
+// nan
+#include "../nan-wrapper.h"
+
+// ogr
+#include <ogrsf_frmts.h>
+
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "../async.hpp"
+
+using namespace v8;
+using namespace node;
+
+namespace node_gdal {
+
+// The outcome of a batch operation, one element per input geometry
+// Exactly one of geoms[i] / errors[i] is set
+struct GeometryBatchResult {
+  std::vector<OGRGeometry *> geoms;
+  std::vector<std::string> errors;
+  GeometryBatchResult(size_t n);
+  ~GeometryBatchResult();
+};
+
+// Produces a new geometry from an input geometry, it can throw or return nullptr on error
+// The second argument is the index of the worker thread
+typedef std::function<OGRGeometry *(OGRGeometry *, int)> GeometryBatchOp;
+
+class GeometryBatch : public Nan::ObjectWrap {
+    public:
+  static Nan::Persistent<FunctionTemplate> constructor;
+
+  static void Initialize(Local<Object> target);
+  static NAN_METHOD(New);
+  static NAN_METHOD(toString);
+  static NAN_METHOD(count);
+  GDAL_ASYNCABLE_DECLARE(buffer);
+  GDAL_ASYNCABLE_DECLARE(simplify);
+  GDAL_ASYNCABLE_DECLARE(simplifyPreserveTopology);
+  GDAL_ASYNCABLE_DECLARE(centroid);
+  GDAL_ASYNCABLE_DECLARE(transform);
+#if GDAL_VERSION_MAJOR >= 3
+  GDAL_ASYNCABLE_DECLARE(makeValid);
+#endif
+
+  // Runs op over all the geometries of the batch in one job split across several threads
+  static void run(
+    const Nan::FunctionCallbackInfo<v8::Value> &info,
+    bool async,
+    int cb_arg,
+    const GeometryBatchOp &op,
+    int threads,
+    const std::vector<v8::Local<v8::Object>> &persistent = {});
+  static Local<Value> ToJS(GeometryBatchResult *r);
+
+  GeometryBatch(std::shared_ptr<std::vector<OGRGeometry *>> geoms, std::shared_ptr<std::vector<uv_sem_t *>> locks);
+  inline std::shared_ptr<std::vector<OGRGeometry *>> get() {
+    return geoms;
+  }
+  inline bool isAlive() {
+    return geoms != nullptr;
+  }
+
+    private:
+  ~GeometryBatch();
+  std::shared_ptr<std::vector<OGRGeometry *>> geoms;
+  // The async locks of the geometries, held while reading each geometry
+  std::shared_ptr<std::vector<uv_sem_t *>> locks;
+};
+
+} // namespace node_gdal
+#endif
@@ -25,9 +25,9 @@ void GeometryCollection::Initialize(Local<Object> target) {
   lcons->InstanceTemplate()->SetInternalFieldCount(1);
   lcons->SetClassName(Nan::New("GeometryCollection").ToLocalChecked());
 
-  Nan::SetPrototypeMethod(lcons, "toString", toString);
-  Nan::SetPrototypeMethod(lcons, "getArea", getArea);
-  Nan::SetPrototypeMethod(lcons, "getLength", getLength);
+  Nan__SetPrototypeMethod(lcons, "toString", toString);
+  Nan__SetPrototypeMethod(lcons, "getArea", getArea);
+  Nan__SetPrototypeMethod(lcons, "getLength", getLength);
 
   ATTR(lcons, "children", childrenGetter, READ_ONLY_SETTER);
 
@@ -0,0 +1,284 @@
+#include "gdal_geometrycursor.hpp"
+#include "../gdal_common.hpp"
+#include "../utils/typed_array.hpp"
+#include "gdal_geometry.hpp"
+
+namespace node_gdal {
+
+Nan::Persistent<FunctionTemplate> GeometryCursor::constructor;
+
+void GeometryCursor::Initialize(Local<Object> target) {
+  Nan::HandleScope scope;
+
+  Local<FunctionTemplate> lcons = Nan::New<FunctionTemplate>(GeometryCursor::New);
+  lcons->InstanceTemplate()->SetInternalFieldCount(1);
+  lcons->SetClassName(Nan::New("GeometryCursor").ToLocalChecked());
+
+  Nan__SetPrototypeMethod(lcons, "toString", toString);
+  Nan__SetPrototypeMethod(lcons, "toArray", toArray);
+  Nan__SetPrototypeMethod(lcons, "geometry", geometry);
+
+  ATTR(lcons, "wkbType", typeGetter, READ_ONLY_SETTER);
+  ATTR(lcons, "name", nameGetter, READ_ONLY_SETTER);
+  ATTR(lcons, "depth", depthGetter, READ_ONLY_SETTER);
+  ATTR(lcons, "index", indexGetter, READ_ONLY_SETTER);
+  ATTR(lcons, "pointCount", pointCountGetter, READ_ONLY_SETTER);
+
+  Nan::Set(target, Nan::New("GeometryCursor").ToLocalChecked(), Nan::GetFunction(lcons).ToLocalChecked());
+
+  constructor.Reset(lcons);
+}
+
+GeometryCursor::GeometryCursor() : Nan::ObjectWrap(), current(nullptr), depth(0), index(0) {
+}
+
+GeometryCursor::~GeometryCursor() {
+}
+
+/**
+ * The cursor passed to the callback of {@link Geometry.visit}.
+ *
+ * The same cursor object is reused for all the visited geometries
+ * and it can be used only inside the callback.
+ *
+ * @class GeometryCursor
+ */
+NAN_METHOD(GeometryCursor::New) {
+  if (!info.IsConstructCall()) {
+    Nan::ThrowError("Cannot call constructor as function, you need to use 'new' keyword");
+    return;
+  }
+  if (info[0]->IsExternal()) {
+    Local<External> ext = info[0].As<External>();
+    void *ptr = ext->Value();
+    GeometryCursor *cursor = static_cast<GeometryCursor *>(ptr);
+    cursor->Wrap(info.This());
+    info.GetReturnValue().Set(info.This());
+    return;
+  } else {
+    Nan::ThrowError("Cannot create GeometryCursor directly");
+    return;
+  }
+}
+
+Local<Object> GeometryCursor::New() {
+  Nan::EscapableHandleScope scope;
+
+  GeometryCursor *wrapped = new GeometryCursor();
+
+  v8::Local<v8::Value> ext = Nan::New<External>(wrapped);
+  v8::Local<v8::Object> obj =
+    Nan::NewInstance(Nan::GetFunction(Nan::New(GeometryCursor::constructor)).ToLocalChecked(), 1, &ext)
+      .ToLocalChecked();
+
+  return scope.Escape(obj);
+}
+
+NAN_METHOD(GeometryCursor::toString) {
+  info.GetReturnValue().Set(Nan::New("GeometryCursor").ToLocalChecked());
+}
+
+// The children of a geometry are the members of a collection,
+// the rings of a polygon and the parts of a compound curve
+static int countChildren(OGRGeometry *geom) {
+  OGRwkbGeometryType type = wkbFlatten(geom->getGeometryType());
+  if (OGR_GT_IsSubClassOf(type, wkbGeometryCollection)) return geom->toGeometryCollection()->getNumGeometries();
+  if (OGR_GT_IsSubClassOf(type, wkbCurvePolygon)) {
+    OGRCurvePolygon *polygon = geom->toCurvePolygon();
+    return polygon->getExteriorRingCurve() != nullptr ? polygon->getNumInteriorRings() + 1 : 0;
+  }
+  if (type == wkbCompoundCurve) return geom->toCompoundCurve()->getNumCurves();
+  return 0;
+}
+
+static OGRGeometry *getChild(OGRGeometry *geom, int i) {
+  if (i < 0 || i >= countChildren(geom)) return nullptr;
+  OGRwkbGeometryType type = wkbFlatten(geom->getGeometryType());
+  if (OGR_GT_IsSubClassOf(type, wkbGeometryCollection)) return geom->toGeometryCollection()->getGeometryRef(i);
+  if (OGR_GT_IsSubClassOf(type, wkbCurvePolygon)) {
+    OGRCurvePolygon *polygon = geom->toCurvePolygon();
+    return i == 0 ? polygon->getExteriorRingCurve() : polygon->getInteriorRingCurve(i - 1);
+  }
+  return geom->toCompoundCurve()->getCurve(i);
+}
+
+// The callback can modify or destroy any part of the geometry, so no pointer
+// is kept across a call, the current geometry is found again from the root
+// returns nullptr when it does not exist anymore
+static OGRGeometry *resolve(Geometry *root, const std::vector<int> &path) {
+  OGRGeometry *geom = root->get();
+  for (size_t i = 0; i < path.size() && geom != nullptr; i++) geom = getChild(geom, path[i]);
+  return geom;
+}
+
+bool GeometryCursor::Visit(Local<Object> obj, Local<Function> callback, Geometry *root, std::vector<int> &path) {
+  OGRGeometry *geom = resolve(root, path);
+  if (geom == nullptr) return true;
+
+  GeometryCursor *cursor = Nan::ObjectWrap::Unwrap<GeometryCursor>(obj);
+  cursor->current = geom;
+  cursor->depth = static_cast<int>(path.size());
+  cursor->index = path.empty() ? 0 : path.back();
+
+  Local<Value> argv[] = {obj};
+  Nan::MaybeLocal<Value> r = Nan::Call(callback, Nan::GetCurrentContext()->Global(), 1, argv);
+  cursor->current = nullptr;
+  if (r.IsEmpty()) return false;
+  Local<Value> rval = r.ToLocalChecked();
+  if (rval->IsBoolean() && !Nan::To<bool>(rval).ToChecked()) return false;
+
+  for (int i = 0;; i++) {
+    geom = resolve(root, path);
+    if (geom == nullptr || i >= countChildren(geom)) break;
+    path.push_back(i);
+    bool more = Visit(obj, callback, root, path);
+    path.pop_back();
+    if (!more) return false;
+  }
+  return true;
+}
+
+// Only points and simple curves have coordinates of their own
+static int countPoints(OGRGeometry *geom) {
+  OGRwkbGeometryType type = wkbFlatten(geom->getGeometryType());
+  if (type == wkbPoint) return geom->IsEmpty() ? 0 : 1;
+  if (OGR_GT_IsSubClassOf(type, wkbCurve) && type != wkbCompoundCurve) return geom->toSimpleCurve()->getNumPoints();
+  return 0;
+}
+
+#define NODE_UNWRAP_CURSOR(var)                                                                                        \
+  GeometryCursor *var = Nan::ObjectWrap::Unwrap<GeometryCursor>(info.This());                                          \
+  if (!var->isAlive()) {                                                                                               \
+    Nan::ThrowError("GeometryCursor can be used only inside the visit() callback");                                   \
+    return;                                                                                                            \
+  }
+
+/**
+ * Returns the coordinates of the current geometry as a flat array,
+ * `[x0, y0, x1, y1, ...]` or `[x0, y0, z0, x1, y1, z1, ...]` for 3D geometries.
+ *
+ * Only points and simple curves have coordinates, all other geometries
+ * return an empty array, their coordinates being accessible from their children.
+ *
+ * @method toArray
+ * @instance
+ * @memberof GeometryCursor
+ * @throws {Error}
+ * @return {Float64Array}
+ */
+NAN_METHOD(GeometryCursor::toArray) {
+  NODE_UNWRAP_CURSOR(cursor);
+  OGRGeometry *geom = cursor->current;
+
+  int dims = geom->Is3D() ? 3 : 2;
+  int points = countPoints(geom);
+
+  Local<Value> array = TypedArray::New(GDT_Float64, static_cast<int64_t>(points) * dims);
+  if (array.IsEmpty() || !array->IsObject()) return;
+  Nan::TypedArrayContents<double> data(array);
+  double *p = *data;
+  if (points > 0 && wkbFlatten(geom->getGeometryType()) == wkbPoint) {
+    OGRPoint *point = geom->toPoint();
+    p[0] = point->getX();
+    p[1] = point->getY();
+    if (dims == 3) p[2] = point->getZ();
+  } else if (points > 0) {
+    OGRSimpleCurve *curve = geom->toSimpleCurve();
+    for (int i = 0; i < points; i++) {
+      p[i * dims] = curve->getX(i);
+      p[i * dims + 1] = curve->getY(i);
+      if (dims == 3) p[i * dims + 2] = curve->getZ(i);
+    }
+  }
+
+  info.GetReturnValue().Set(array);
+}
+
+/**
+ * Returns a copy of the current geometry as a Geometry object.
+ *
+ * @method geometry
+ * @instance
+ * @memberof GeometryCursor
+ * @throws {Error}
+ * @return {Geometry}
+ */
+NAN_METHOD(GeometryCursor::geometry) {
+  NODE_UNWRAP_CURSOR(cursor);
+  info.GetReturnValue().Set(Geometry::New(cursor->current, false));
+}
+
+/**
+ * See {@link wkbGeometryType}.
+ * @readonly
+ * @kind member
+ * @name wkbType
+ * @instance
+ * @memberof GeometryCursor
+ * @type {number}
+ */
+NAN_GETTER(GeometryCursor::typeGetter) {
+  NODE_UNWRAP_CURSOR(cursor);
+  info.GetReturnValue().Set(Nan::New<Integer>(Geometry::getGeometryType_fixed(cursor->current)));
+}
+
+/**
+ * @readonly
+ * @kind member
+ * @name name
+ * @instance
+ * @memberof GeometryCursor
+ * @type {string}
+ */
+NAN_GETTER(GeometryCursor::nameGetter) {
+  NODE_UNWRAP_CURSOR(cursor);
+  info.GetReturnValue().Set(SafeString::New(cursor->current->getGeometryName()));
+}
+
+/**
+ * The nesting level of the current geometry, `0` for the visited geometry.
+ *
+ * @readonly
+ * @kind member
+ * @name depth
+ * @instance
+ * @memberof GeometryCursor
+ * @type {number}
+ */
+NAN_GETTER(GeometryCursor::depthGetter) {
+  NODE_UNWRAP_CURSOR(cursor);
+  info.GetReturnValue().Set(Nan::New<Integer>(cursor->depth));
+}
+
+/**
+ * The index of the current geometry in its parent, for polygons
+ * the exterior ring has index `0`.
+ *
+ * @readonly
+ * @kind member
+ * @name index
+ * @instance
+ * @memberof GeometryCursor
+ * @type {number}
+ */
+NAN_GETTER(GeometryCursor::indexGetter) {
+  NODE_UNWRAP_CURSOR(cursor);
+  info.GetReturnValue().Set(Nan::New<Integer>(cursor->index));
+}
+
+/**
+ * The number of points of the current geometry if it is a point or a simple curve, `0` otherwise.
+ *
+ * @readonly
+ * @kind member
+ * @name pointCount
+ * @instance
+ * @memberof GeometryCursor
+ * @type {number}
+ */
+NAN_GETTER(GeometryCursor::pointCountGetter) {
+  NODE_UNWRAP_CURSOR(cursor);
+  info.GetReturnValue().Set(Nan::New<Integer>(countPoints(cursor->current)));
+}
+
+} // namespace node_gdal
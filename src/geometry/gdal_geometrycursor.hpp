@@ -0,0 +1,66 @@
+#ifndef __NODE_OGR_GEOMETRYCURSOR_H__
+#define __NODE_OGR_GEOMETRYCURSOR_H__
+
+// node
+#include <node.h>
+#include <node_object_wrap.h>
+
+// nan
+#include "../nan-wrapper.h"
+
+// ogr
+#include <ogrsf_frmts.h>
+
+#include <vector>
+
+using namespace v8;
+using namespace node;
+
+namespace node_gdal {
+
+class Geometry;
+
+// The cursor passed to the callback of Geometry.visit()
+// It points to the geometry being visited and it is reused for all the geometries
+class GeometryCursor : public Nan::ObjectWrap {
+    public:
+  static Nan::Persistent<FunctionTemplate> constructor;
+
+  static void Initialize(Local<Object> target);
+  static NAN_METHOD(New);
+  static Local<Object> New();
+  static NAN_METHOD(toString);
+  static NAN_METHOD(toArray);
+  static NAN_METHOD(geometry);
+
+  static NAN_GETTER(typeGetter);
+  static NAN_GETTER(nameGetter);
+  static NAN_GETTER(depthGetter);
+  static NAN_GETTER(indexGetter);
+  static NAN_GETTER(pointCountGetter);
+
+  // Visits the descendant of root at path (the indices of the children from the root)
+  // and all its descendants, returns false if the traversal was stopped by the callback
+  // or if the callback threw
+  static bool Visit(Local<Object> obj, Local<Function> callback, Geometry *root, std::vector<int> &path);
+
+  GeometryCursor();
+  inline OGRGeometry *get() {
+    return current;
+  }
+  inline bool isAlive() {
+    return current != nullptr;
+  }
+  inline void reset() {
+    current = nullptr;
+  }
+
+    private:
+  ~GeometryCursor();
+  OGRGeometry *current;
+  int depth;
+  int index;
+};
+
+} // namespace node_gdal
+#endif
@@ -0,0 +1,527 @@
+#include "gdal_geometrypipeline.hpp"
+#include "../gdal_common.hpp"
+#include "../gdal_coordinate_transformation.hpp"
+#include "../gdal_layer.hpp"
+#include "../gdal_spatial_reference.hpp"
+#include "../utils/parallel.hpp"
+#include "gdal_geometry.hpp"
+#include "gdal_point.hpp"
+
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace node_gdal {
+namespace GeometryPipeline {
+
+void Initialize(Local<Object> target) {
+  Nan__SetAsyncableMethod(target, "_geometryPipeline", run);
+}
+
+enum class StepType {
+  Transform,
+  TransformTo,
+  MakeValid,
+  Simplify,
+  SimplifyPreserveTopology,
+  Buffer,
+  Centroid,
+  ConvexHull,
+  Boundary,
+  Intersection,
+  Union,
+  Difference,
+  SymDifference,
+  FlattenTo2D,
+  SwapXY,
+  Segmentize
+};
+
+struct Step {
+  StepType type;
+  double value;
+  int segments;
+  OGRCoordinateTransformation *ct;
+  OGRSpatialReference *srs;
+  OGRGeometry *geom;
+  uv_sem_t *geom_lock;
+  Step()
+    : type(StepType::MakeValid), value(0), segments(30), ct(nullptr), srs(nullptr), geom(nullptr), geom_lock(nullptr) {
+  }
+};
+
+enum class OutputFormat { Geometry, WKB, WKT, GeoJSON };
+
+struct Output {
+  OutputFormat format;
+  OGRwkbByteOrder byte_order;
+  OGRwkbVariant variant;
+  Output() : format(OutputFormat::Geometry), byte_order(wkbXDR), variant(wkbVariantOldOgc) {
+  }
+};
+
+struct CTDeleter {
+  void operator()(OGRCoordinateTransformation *ct) {
+    OGRCoordinateTransformation::DestroyCT(ct);
+  }
+};
+
+struct SRSDeleter {
+  void operator()(OGRSpatialReference *srs) {
+    srs->Release();
+  }
+};
+
+// Coordinate transformations cannot be shared between threads
+// Each thread has its own for every transform / transformTo step
+struct ThreadState {
+  std::vector<std::unique_ptr<OGRCoordinateTransformation, CTDeleter>> cts;
+  // The source SRS of the transformTo transformations
+  std::vector<std::unique_ptr<OGRSpatialReference, SRSDeleter>> sources;
+  ThreadState(size_t steps) : cts(steps), sources(steps) {
+  }
+};
+
+struct Result {
+  bool single;
+  Output output;
+  std::vector<OGRGeometry *> geoms;
+  std::vector<std::string> data;
+  std::vector<std::string> errors;
+  std::vector<bool> failed;
+  // features without geometry
+  std::vector<bool> missing;
+  std::vector<GIntBig> fids;
+
+  Result(bool single, const Output &output) : single(single), output(output) {
+  }
+  void resize(size_t n) {
+    geoms.resize(n, nullptr);
+    data.resize(n);
+    errors.resize(n);
+    failed.resize(n, false);
+    missing.resize(n, false);
+  }
+  ~Result() {
+    for (OGRGeometry *geom : geoms)
+      if (geom != nullptr) OGRGeometryFactory::destroyGeometry(geom);
+  }
+};
+
+// Applies one step, returns the new geometry which can be the same object
+// when the step modifies the geometry in place, throws on error
+static OGRGeometry *applyStep(const Step &step, size_t idx, OGRGeometry *geom, ThreadState &state, int thread) {
+  OGRGeometry *r = nullptr;
+  OGRErr err = OGRERR_NONE;
+
+  switch (step.type) {
+    case StepType::Transform: {
+      OGRCoordinateTransformation *ct = step.ct;
+#if GDAL_VERSION_MAJOR > 3 || (GDAL_VERSION_MAJOR == 3 && GDAL_VERSION_MINOR >= 1)
+      if (thread > 0) {
+        if (state.cts[idx] == nullptr) {
+          state.cts[idx].reset(step.ct->Clone());
+          if (state.cts[idx] == nullptr) throw "Failed cloning the coordinate transformation";
+        }
+        ct = state.cts[idx].get();
+      }
+#endif
+      err = geom->transform(ct);
+      r = geom;
+    } break;
+    case StepType::TransformTo: {
+      OGRSpatialReference *source = geom->getSpatialReference();
+      if (source == nullptr) throw "Geometry has no spatial reference";
+      if (state.cts[idx] == nullptr || !state.sources[idx]->IsSame(source)) {
+        state.cts[idx].reset(OGRCreateCoordinateTransformation(source, step.srs));
+        if (state.cts[idx] == nullptr) throw CPLGetLastErrorMsg();
+        state.sources[idx].reset(source->Clone());
+      }
+      err = geom->transform(state.cts[idx].get());
+      r = geom;
+    } break;
+    case StepType::MakeValid:
+#if GDAL_VERSION_MAJOR >= 3
+      r = geom->MakeValid();
+#else
+      throw "makeValid requires GDAL 3.0";
+#endif
+      break;
+    case StepType::Simplify: r = geom->Simplify(step.value); break;
+    case StepType::SimplifyPreserveTopology: r = geom->SimplifyPreserveTopology(step.value); break;
+    case StepType::Buffer: r = geom->Buffer(step.value, step.segments); break;
+    case StepType::Centroid: {
+      OGRPoint *point = new OGRPoint();
+      err = geom->Centroid(point);
+      r = point;
+      if (err) delete point;
+    } break;
+    case StepType::ConvexHull: r = geom->ConvexHull(); break;
+    case StepType::Boundary: r = geom->Boundary(); break;
+    case StepType::Intersection: r = geom->Intersection(step.geom); break;
+    case StepType::Union: r = geom->Union(step.geom); break;
+    case StepType::Difference: r = geom->Difference(step.geom); break;
+    case StepType::SymDifference: r = geom->SymDifference(step.geom); break;
+    case StepType::FlattenTo2D:
+      geom->flattenTo2D();
+      r = geom;
+      break;
+    case StepType::SwapXY:
+      geom->swapXY();
+      r = geom;
+      break;
+    case StepType::Segmentize:
+      geom->segmentize(step.value);
+      r = geom;
+      break;
+  }
+
+  if (err) throw getOGRErrMsg(err);
+  if (r == nullptr) throw CPLGetLastErrorMsg();
+  return r;
+}
+
+// Runs all the steps on a geometry owned by the caller and stores the output
+static void process(
+  const std::vector<Step> &steps, OGRGeometry *geom, size_t i, Result *r, ThreadState &state, int thread) {
+  std::unique_ptr<OGRGeometry> current(geom);
+  for (size_t s = 0; s < steps.size(); s++) {
+    OGRGeometry *next = applyStep(steps[s], s, current.get(), state, thread);
+    if (next != current.get()) current.reset(next);
+  }
+
+  switch (r->output.format) {
+    case OutputFormat::Geometry: r->geoms[i] = current.release(); break;
+    case OutputFormat::WKB: {
+      r->data[i].resize(current->WkbSize());
+      unsigned char *data = reinterpret_cast<unsigned char *>(&r->data[i][0]);
+      OGRErr err = current->exportToWkb(r->output.byte_order, data, r->output.variant);
+      if (err) throw getOGRErrMsg(err);
+    } break;
+    case OutputFormat::WKT: {
+      char *text = nullptr;
+      OGRErr err = current->exportToWkt(&text);
+      if (err) throw getOGRErrMsg(err);
+      r->data[i] = text;
+      CPLFree(text);
+    } break;
+    case OutputFormat::GeoJSON: {
+      char *text = current->exportToJson();
+      if (text == nullptr) throw CPLGetLastErrorMsg();
+      r->data[i] = text;
+      CPLFree(text);
+    } break;
+  }
+}
+
+static Local<Value> outputToJS(Result *r, size_t i) {
+  Nan::EscapableHandleScope scope;
+  if (r->missing[i]) return scope.Escape(Nan::Null());
+  switch (r->output.format) {
+    case OutputFormat::Geometry: {
+      if (r->geoms[i] == nullptr) return scope.Escape(Nan::Null());
+      Local<Value> geom = Geometry::New(r->geoms[i], true);
+      r->geoms[i] = nullptr;
+      return scope.Escape(geom);
+    }
+    case OutputFormat::WKB:
+      return scope.Escape(Nan::CopyBuffer(r->data[i].data(), r->data[i].size()).ToLocalChecked());
+    default: return scope.Escape(SafeString::New(r->data[i].c_str()));
+  }
+}
+
+// ok remains false if a JS exception has been thrown
+static void parseSteps(Local<Array> array, std::vector<Step> &steps, std::vector<Local<Object>> &persistent, bool &ok) {
+  ok = false;
+  for (unsigned i = 0; i < array->Length(); i++) {
+    Local<Value> val = Nan::Get(array, i).ToLocalChecked();
+    if (!val->IsObject()) {
+      Nan::ThrowTypeError("pipeline steps must be objects");
+      return;
+    }
+    Local<Object> obj = val.As<Object>();
+    std::string op;
+    Step step;
+    NODE_STR_FROM_OBJ(obj, "op", op);
+
+    if (op == "transform") {
+      CoordinateTransformation *ct;
+      NODE_WRAPPED_FROM_OBJ(obj, "transformation", CoordinateTransformation, ct);
+      step.type = StepType::Transform;
+      step.ct = ct->get();
+      persistent.push_back(Nan::Get(obj, Nan::New("transformation").ToLocalChecked()).ToLocalChecked().As<Object>());
+    } else if (op == "transformTo") {
+      SpatialReference *srs;
+      NODE_WRAPPED_FROM_OBJ(obj, "srs", SpatialReference, srs);
+      step.type = StepType::TransformTo;
+      step.srs = srs->get();
+      persistent.push_back(Nan::Get(obj, Nan::New("srs").ToLocalChecked()).ToLocalChecked().As<Object>());
+    } else if (op == "makeValid") {
+      step.type = StepType::MakeValid;
+    } else if (op == "simplify" || op == "simplifyPreserveTopology") {
+      NODE_DOUBLE_FROM_OBJ(obj, "tolerance", step.value);
+      step.type = op == "simplify" ? StepType::Simplify : StepType::SimplifyPreserveTopology;
+    } else if (op == "buffer") {
+      NODE_DOUBLE_FROM_OBJ(obj, "distance", step.value);
+      NODE_INT_FROM_OBJ_OPT(obj, "segments", step.segments);
+      step.type = StepType::Buffer;
+    } else if (op == "centroid") {
+      step.type = StepType::Centroid;
+    } else if (op == "convexHull") {
+      step.type = StepType::ConvexHull;
+    } else if (op == "boundary") {
+      step.type = StepType::Boundary;
+    } else if (op == "intersection" || op == "union" || op == "difference" || op == "symDifference") {
+      Geometry *geom;
+      NODE_WRAPPED_FROM_OBJ(obj, "geometry", Geometry, geom);
+      if (!geom->isAlive()) {
+        Nan::ThrowError("Geometry object has already been destroyed");
+        return;
+      }
+      step.type = op == "intersection" ? StepType::Intersection
+        : op == "union"                ? StepType::Union
+        : op == "difference"           ? StepType::Difference
+                                       : StepType::SymDifference;
+      step.geom = geom->get();
+      step.geom_lock = geom->getAsyncLock();
+      persistent.push_back(Nan::Get(obj, Nan::New("geometry").ToLocalChecked()).ToLocalChecked().As<Object>());
+    } else if (op == "flattenTo2D") {
+      step.type = StepType::FlattenTo2D;
+    } else if (op == "swapXY") {
+      step.type = StepType::SwapXY;
+    } else if (op == "segmentize") {
+      NODE_DOUBLE_FROM_OBJ(obj, "length", step.value);
+      step.type = StepType::Segmentize;
+    } else {
+      Nan::ThrowError(("Invalid pipeline step " + op).c_str());
+      return;
+    }
+    steps.push_back(step);
+  }
+  ok = true;
+}
+
+// ok remains false if a JS exception has been thrown
+static void parseOutput(Local<Value> val, Output &output, bool &ok) {
+  ok = false;
+  if (!val->IsUndefined() && !val->IsNull() && !val->IsObject()) {
+    Nan::ThrowTypeError("pipeline output must be an object");
+    return;
+  }
+  if (!val->IsObject()) {
+    ok = true;
+    return;
+  }
+  Local<Object> obj = val.As<Object>();
+  std::string format = "geometry", order = "MSB", variant = "OGC";
+  NODE_STR_FROM_OBJ_OPT(obj, "format", format);
+  NODE_STR_FROM_OBJ_OPT(obj, "byteOrder", order);
+  NODE_STR_FROM_OBJ_OPT(obj, "variant", variant);
+
+  if (format == "geometry") {
+    output.format = OutputFormat::Geometry;
+  } else if (format == "wkb") {
+    output.format = OutputFormat::WKB;
+  } else if (format == "wkt") {
+    output.format = OutputFormat::WKT;
+  } else if (format == "json") {
+    output.format = OutputFormat::GeoJSON;
+  } else {
+    Nan::ThrowError("pipeline output format must be 'geometry', 'wkb', 'wkt' or 'json'");
+    return;
+  }
+
+  if (order == "MSB") {
+    output.byte_order = wkbXDR;
+  } else if (order == "LSB") {
+    output.byte_order = wkbNDR;
+  } else {
+    Nan::ThrowError("byte order must be 'MSB' or 'LSB'");
+    return;
+  }
+
+  if (variant == "OGC") {
+    output.variant = wkbVariantOldOgc;
+  } else if (variant == "ISO") {
+    output.variant = wkbVariantIso;
+  } else {
+    Nan::ThrowError("variant must be 'OGC' or 'ISO'");
+    return;
+  }
+  ok = true;
+}
+
+/*
+ * Runs a pipeline of geometry operations, used by GeometryPipeline.run()
+ *
+ * _geometryPipeline(source: Geometry | Geometry[] | Layer, steps: object[], output?: object)
+ */
+GDAL_ASYNCABLE_DEFINE(run) {
+  Local<Array> steps_array;
+  std::vector<Local<Object>> persistent;
+  auto steps = std::make_shared<std::vector<Step>>();
+  Output output;
+
+  if (info.Length() < 1 || !info[0]->IsObject()) {
+    Nan::ThrowTypeError("source must be a Geometry, an array of Geometry or a Layer");
+    return;
+  }
+  NODE_ARG_ARRAY(1, "steps", steps_array);
+  bool ok;
+  parseSteps(steps_array, *steps, persistent, ok);
+  if (!ok) return;
+  parseOutput(info[2], output, ok);
+  if (!ok) return;
+
+  // Geometries coming from JS are cloned under their async lock,
+  // those coming from a layer are read inside the job
+  auto inputs = std::make_shared<std::vector<OGRGeometry *>>();
+  auto locks = std::make_shared<std::vector<uv_sem_t *>>();
+  OGRLayer *gdal_layer = nullptr;
+  long ds_uid = 0;
+  bool single = false;
+
+  if (IS_WRAPPED(info[0], Layer)) {
+    Layer *layer = Nan::ObjectWrap::Unwrap<Layer>(info[0].As<Object>());
+    if (!layer->isAlive()) {
+      Nan::ThrowError("Layer object already destroyed");
+      return;
+    }
+    gdal_layer = layer->get();
+    ds_uid = layer->parent_uid;
+  } else if (IS_WRAPPED(info[0], Geometry)) {
+    Geometry *geom = Nan::ObjectWrap::Unwrap<Geometry>(info[0].As<Object>());
+    if (!geom->isAlive()) {
+      Nan::ThrowError("Geometry object has already been destroyed");
+      return;
+    }
+    inputs->push_back(geom->get());
+    locks->push_back(geom->getAsyncLock());
+    single = true;
+  } else if (info[0]->IsArray()) {
+    Local<Array> array = info[0].As<Array>();
+    // Our own copy of the array protects the geometries from the GC
+    Local<Array> copy = Nan::New<Array>(array->Length());
+    for (unsigned i = 0; i < array->Length(); i++) {
+      Local<Value> element = Nan::Get(array, i).ToLocalChecked();
+      if (!IS_WRAPPED(element, Geometry)) {
+        Nan::ThrowTypeError("All array elements must be Geometry objects");
+        return;
+      }
+      Geometry *geom = Nan::ObjectWrap::Unwrap<Geometry>(element.As<Object>());
+      if (!geom->isAlive()) {
+        Nan::ThrowError("Geometry object has already been destroyed");
+        return;
+      }
+      inputs->push_back(geom->get());
+      locks->push_back(geom->getAsyncLock());
+      Nan::Set(copy, i, element);
+    }
+    persistent.push_back(copy);
+  } else {
+    Nan::ThrowTypeError("source must be a Geometry, an array of Geometry or a Layer");
+    return;
+  }
+
+  GDALAsyncableJob<Result *> job(ds_uid);
+  job.persist(info[0].As<Object>());
+  for (const Local<Object> &obj : persistent) job.persist(obj);
+  job.main = [steps, output, inputs, locks, gdal_layer, single](const GDALExecutionProgress &) {
+    std::unique_ptr<Result> r(new Result(single, output));
+
+    // The operands of the steps are cloned under their async lock like the inputs
+    std::vector<Step> pipeline(*steps);
+    std::vector<std::unique_ptr<OGRGeometry>> operands;
+    for (Step &step : pipeline) {
+      if (step.geom == nullptr) continue;
+      uv_sem_wait(step.geom_lock);
+      step.geom = step.geom->clone();
+      uv_sem_post(step.geom_lock);
+      operands.emplace_back(step.geom);
+    }
+
+    if (gdal_layer != nullptr) {
+      CPLErrorReset();
+      gdal_layer->ResetReading();
+      OGRFeature *feature;
+      while ((feature = gdal_layer->GetNextFeature()) != nullptr) {
+        r->fids.push_back(feature->GetFID());
+        inputs->push_back(feature->StealGeometry());
+        OGRFeature::DestroyFeature(feature);
+      }
+      if (CPLGetLastErrorType() == CE_Failure) {
+        for (OGRGeometry *geom : *inputs) OGRGeometryFactory::destroyGeometry(geom);
+        throw CPLGetLastErrorMsg();
+      }
+    }
+
+    size_t n = inputs->size();
+    r->resize(n);
+    int threads = GetNumThreads(n);
+    size_t grain = std::max<size_t>(1, n / (static_cast<size_t>(threads) * 8));
+    std::vector<ThreadState> states;
+    for (int i = 0; i < threads; i++) states.emplace_back(steps->size());
+
+    ParallelFor(n, threads, grain, [&](size_t begin, size_t end, int thread) {
+      for (size_t i = begin; i < end; i++) {
+        OGRGeometry *geom = (*inputs)[i];
+        // Features without geometry produce null without error
+        if (geom == nullptr) {
+          r->missing[i] = true;
+          continue;
+        }
+        if (gdal_layer == nullptr) {
+          uv_sem_wait((*locks)[i]);
+          geom = geom->clone();
+          uv_sem_post((*locks)[i]);
+        }
+        CPLErrorReset();
+        try {
+          process(pipeline, geom, i, r.get(), states[thread], thread);
+        } catch (const char *err) {
+          r->failed[i] = true;
+          r->errors[i] = (err != nullptr && *err) ? err : "Geometry operation failed";
+        }
+      }
+    });
+
+    if (single && r->failed[0]) {
+      CPLError(CE_Failure, CPLE_AppDefined, "%s", r->errors[0].c_str());
+      throw CPLGetLastErrorMsg();
+    }
+    return r.release();
+  };
+  job.rval = [](Result *r, const GetFromPersistentFunc &) {
+    Nan::EscapableHandleScope scope;
+    std::unique_ptr<Result> result(r);
+
+    if (r->single) return scope.Escape(outputToJS(r, 0));
+
+    size_t n = r->geoms.size();
+    Local<Array> results = Nan::New<Array>(n);
+    Local<Array> errors = Nan::New<Array>(n);
+    for (size_t i = 0; i < n; i++) {
+      if (r->failed[i]) {
+        Nan::Set(results, i, Nan::Null());
+        Nan::Set(errors, i, SafeString::New(r->errors[i].c_str()));
+      } else {
+        Nan::Set(results, i, outputToJS(r, i));
+        Nan::Set(errors, i, Nan::Null());
+      }
+    }
+
+    Local<Object> obj = Nan::New<Object>();
+    Nan::Set(obj, Nan::New("results").ToLocalChecked(), results);
+    Nan::Set(obj, Nan::New("errors").ToLocalChecked(), errors);
+    if (r->fids.size() > 0) {
+      Local<Array> fids = Nan::New<Array>(r->fids.size());
+      for (size_t i = 0; i < r->fids.size(); i++) Nan::Set(fids, i, Nan::New<Number>(static_cast<double>(r->fids[i])));
+      Nan::Set(obj, Nan::New("fids").ToLocalChecked(), fids);
+    }
+    return scope.Escape(obj).As<Value>();
+  };
+  job.run(info, async, 3);
+}
+
+} // namespace GeometryPipeline
+} // namespace node_gdal
@@ -0,0 +1,33 @@
+#ifndef __NODE_OGR_GEOMETRYPIPELINE_H__
+#define __NODE_OGR_GEOMETRYPIPELINE_H__
+
+// node
+#include <node.h>
+#include <node_object_wrap.h>
+
+// nan
+#include "../nan-wrapper.h"
+
+// ogr
+#include <ogrsf_frmts.h>
+
+#include "../async.hpp"
+
+using namespace v8;
+using namespace node;
+
+// The native side of GeometryPipeline (lib/pipeline.js)
+// A pipeline is a list of steps applied to each geometry of a source
+// (a geometry, an array of geometries or a layer) inside a single job
+
+namespace node_gdal {
+namespace GeometryPipeline {
+
+void Initialize(Local<Object> target);
+
+GDAL_ASYNCABLE_GLOBAL(run);
+
+} // namespace GeometryPipeline
+} // namespace node_gdal
+
+#endif
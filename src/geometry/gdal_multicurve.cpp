@@ -19,8 +19,8 @@ void MultiCurve::Initialize(Local<Object> target) {
   lcons->InstanceTemplate()->SetInternalFieldCount(1);
   lcons->SetClassName(Nan::New("MultiCurve").ToLocalChecked());
 
-  Nan::SetPrototypeMethod(lcons, "toString", toString);
-  Nan::SetPrototypeMethod(lcons, "polygonize", polygonize);
+  Nan__SetPrototypeMethod(lcons, "toString", toString);
+  Nan__SetPrototypeMethod(lcons, "polygonize", polygonize);
 
   Nan::Set(target, Nan::New("MultiCurve").ToLocalChecked(), Nan::GetFunction(lcons).ToLocalChecked());
 
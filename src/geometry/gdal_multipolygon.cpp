@@ -19,9 +19,9 @@ void MultiPolygon::Initialize(Local<Object> target) {
   lcons->InstanceTemplate()->SetInternalFieldCount(1);
   lcons->SetClassName(Nan::New("MultiPolygon").ToLocalChecked());
 
-  Nan::SetPrototypeMethod(lcons, "toString", toString);
-  Nan::SetPrototypeMethod(lcons, "unionCascaded", unionCascaded);
-  Nan::SetPrototypeMethod(lcons, "getArea", getArea);
+  Nan__SetPrototypeMethod(lcons, "toString", toString);
+  Nan__SetPrototypeMethod(lcons, "unionCascaded", unionCascaded);
+  Nan__SetPrototypeMethod(lcons, "getArea", getArea);
 
   Nan::Set(target, Nan::New("MultiPolygon").ToLocalChecked(), Nan::GetFunction(lcons).ToLocalChecked());
 
@@ -20,10 +20,10 @@ void SimpleCurve::Initialize(Local<Object> target) {
   lcons->InstanceTemplate()->SetInternalFieldCount(1);
   lcons->SetClassName(Nan::New("SimpleCurve").ToLocalChecked());
 
-  Nan::SetPrototypeMethod(lcons, "toString", toString);
-  Nan::SetPrototypeMethod(lcons, "getLength", getLength);
-  Nan::SetPrototypeMethod(lcons, "value", value);
-  Nan::SetPrototypeMethod(lcons, "addSubLineString", addSubLineString);
+  Nan__SetPrototypeMethod(lcons, "toString", toString);
+  Nan__SetPrototypeMethod(lcons, "getLength", getLength);
+  Nan__SetPrototypeMethod(lcons, "value", value);
+  Nan__SetPrototypeMethod(lcons, "addSubLineString", addSubLineString);
 
   ATTR(lcons, "points", pointsGetter, READ_ONLY_SETTER);
 
@@ -20,6 +20,7 @@
 #include "gdal_dimension.hpp"
 #include "gdal_attribute.hpp"
 #include "gdal_warper.hpp"
+#include "gdal_warp_context.hpp"
 #include "gdal_utils.hpp"
 
 #include "gdal_coordinate_transformation.hpp"
@@ -28,6 +29,9 @@
 #include "gdal_field_defn.hpp"
 #include "geometry/gdal_geometry.hpp"
 #include "geometry/gdal_geometrycollection.hpp"
+#include "geometry/gdal_geometrybatch.hpp"
+#include "geometry/gdal_geometrycursor.hpp"
+#include "geometry/gdal_geometrypipeline.hpp"
 #include "gdal_layer.hpp"
 #include "geometry/gdal_simplecurve.hpp"
 #include "geometry/gdal_linearring.hpp"
@@ -43,6 +47,8 @@
 #include "gdal_spatial_reference.hpp"
 #include "gdal_memfile.hpp"
 #include "gdal_fs.hpp"
+#include "gdal_block_cache.hpp"
+#include "utils/microbench.hpp"
 
 #include "utils/field_types.hpp"
 
@@ -344,12 +350,21 @@ static void Init(Local<Object> target, Local<v8::Value>, void *) {
   mainV8ThreadId = std::this_thread::get_id();
 
   Nan__SetAsyncableMethod(target, "open", gdal_open);
-  Nan::SetMethod(target, "setConfigOption", setConfigOption);
-  Nan::SetMethod(target, "getConfigOption", getConfigOption);
-  Nan::SetMethod(target, "decToDMS", decToDMS);
-  Nan::SetMethod(target, "setPROJSearchPath", setPROJSearchPath);
-  Nan::SetMethod(target, "_triggerCPLError", ThrowDummyCPLError); // for tests
-  Nan::SetMethod(target, "_isAlive", isAlive);                    // for tests
+  Nan__SetMethod(target, "setConfigOption", setConfigOption);
+  Nan__SetMethod(target, "getConfigOption", getConfigOption);
+  Nan__SetMethod(target, "decToDMS", decToDMS);
+  Nan__SetMethod(target, "setPROJSearchPath", setPROJSearchPath);
+  Nan__SetMethod(target, "_triggerCPLError", ThrowDummyCPLError); // for tests
+  Nan__SetMethod(target, "_isAlive", isAlive);                    // for tests
+  Nan__SetMethod(target, "stats", JobStats::stats);
+  Nan__SetMethod(target, "_resetStats", JobStats::resetStats);
+  Nan__SetMethod(target, "_lockStats", JobStats::lockStats);
+  Nan__SetMethod(target, "_setJobHook", JobStats::setJobHook);
+  Nan__SetMethod(target, "_setAbortFlag", setAbortFlag);
+  Nan__SetMethod(target, "profileSync", SyncProfile::profileSync);
+  Nan__SetMethod(target, "syncProfile", SyncProfile::syncProfile);
+  Nan__SetMethod(target, "_setSyncProfileLib", SyncProfile::setLibPath);
+  Nan__SetMethod(target, "_microbench", Microbench::run); // for bench/native.js
 
   Warper::Initialize(target);
   Algorithms::Initialize(target);
@@ -381,9 +396,13 @@ static void Init(Local<Object> target, Local<v8::Value>, void *) {
   CircularString::Initialize(target);
   CompoundCurve::Initialize(target);
   MultiCurve::Initialize(target);
+  GeometryBatch::Initialize(target);
+  GeometryCursor::Initialize(target);
+  GeometryPipeline::Initialize(target);
 
   SpatialReference::Initialize(target);
   CoordinateTransformation::Initialize(target);
+  WarpContext::Initialize(target);
   ColorTable::Initialize(target);
 
   DatasetBands::Initialize(target);
@@ -409,6 +428,7 @@ static void Init(Local<Object> target, Local<v8::Value>, void *) {
   Memfile::Initialize(target);
   Utils::Initialize(target);
   VSI::Initialize(target);
+  BlockCache::Initialize(target);
 
   /**
    * The collection of all drivers registered with GDAL
@@ -1765,7 +1785,7 @@ static void Init(Local<Object> target, Local<v8::Value>, void *) {
    * @static
    * @method quiet
    */
-  Nan::SetMethod(target, "quiet", QuietOutput);
+  Nan__SetMethod(target, "quiet", QuietOutput);
 
   /**
    * Displays extra debugging information from GDAL.
@@ -1773,11 +1793,11 @@ static void Init(Local<Object> target, Local<v8::Value>, void *) {
    * @static
    * @method verbose
    */
-  Nan::SetMethod(target, "verbose", VerboseOutput);
+  Nan__SetMethod(target, "verbose", VerboseOutput);
 
-  Nan::SetMethod(target, "startLogging", StartLogging);
-  Nan::SetMethod(target, "stopLogging", StopLogging);
-  Nan::SetMethod(target, "log", Log);
+  Nan__SetMethod(target, "startLogging", StartLogging);
+  Nan__SetMethod(target, "stopLogging", StopLogging);
+  Nan__SetMethod(target, "log", Log);
 
   Local<Object> supports = Nan::New<Object>();
   Nan::Set(target, Nan::New("supports").ToLocalChecked(), supports);
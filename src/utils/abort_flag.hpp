@@ -0,0 +1,28 @@
+#ifndef __NODE_GDAL_ABORT_FLAG_H__
+#define __NODE_GDAL_ABORT_FLAG_H__
+
+#include <stdint.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+namespace node_gdal {
+
+static const char abortedMessage[] = "Operation has been aborted";
+
+// The abort flag of an async job is the first element of an Int32Array
+// written by Atomics.store() on the main thread while the job is running
+// on a worker thread, it must be read with an atomic load
+inline bool IsAborted(const int32_t *flag) {
+  if (flag == nullptr) return false;
+#ifdef _MSC_VER
+  // long is 32 bits on Windows, a compare-exchange that never writes is an atomic load
+  return _InterlockedCompareExchange(reinterpret_cast<volatile long *>(const_cast<int32_t *>(flag)), 0, 0) != 0;
+#else
+  return __atomic_load_n(flag, __ATOMIC_SEQ_CST) != 0;
+#endif
+}
+
+} // namespace node_gdal
+
+#endif
@@ -0,0 +1,459 @@
+#include "expression.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <ctype.h>
+#include <limits>
+#include <stdlib.h>
+#include <string.h>
+
+namespace node_gdal {
+
+static double fnAbs(double x) {
+  return std::fabs(x);
+}
+static double fnSqrt(double x) {
+  return std::sqrt(x);
+}
+static double fnExp(double x) {
+  return std::exp(x);
+}
+static double fnLog(double x) {
+  return std::log(x);
+}
+static double fnLog10(double x) {
+  return std::log10(x);
+}
+static double fnSin(double x) {
+  return std::sin(x);
+}
+static double fnCos(double x) {
+  return std::cos(x);
+}
+static double fnTan(double x) {
+  return std::tan(x);
+}
+static double fnAsin(double x) {
+  return std::asin(x);
+}
+static double fnAcos(double x) {
+  return std::acos(x);
+}
+static double fnAtan(double x) {
+  return std::atan(x);
+}
+static double fnFloor(double x) {
+  return std::floor(x);
+}
+static double fnCeil(double x) {
+  return std::ceil(x);
+}
+static double fnRound(double x) {
+  return std::round(x);
+}
+static double fnIsNaN(double x) {
+  return std::isnan(x) ? 1 : 0;
+}
+static double fnAtan2(double y, double x) {
+  return std::atan2(y, x);
+}
+static double fnPow(double x, double y) {
+  return std::pow(x, y);
+}
+static double fnMin(double x, double y) {
+  return (std::isnan(x) || std::isnan(y)) ? std::numeric_limits<double>::quiet_NaN() : std::min(x, y);
+}
+static double fnMax(double x, double y) {
+  return (std::isnan(x) || std::isnan(y)) ? std::numeric_limits<double>::quiet_NaN() : std::max(x, y);
+}
+
+static const struct {
+  const char *name;
+  double (*fn)(double);
+} functions1[] = {
+  {"abs", fnAbs},
+  {"sqrt", fnSqrt},
+  {"exp", fnExp},
+  {"log", fnLog},
+  {"log10", fnLog10},
+  {"sin", fnSin},
+  {"cos", fnCos},
+  {"tan", fnTan},
+  {"asin", fnAsin},
+  {"acos", fnAcos},
+  {"atan", fnAtan},
+  {"floor", fnFloor},
+  {"ceil", fnCeil},
+  {"round", fnRound},
+  {"isnan", fnIsNaN}};
+
+static const struct {
+  const char *name;
+  double (*fn)(double, double);
+} functions2[] = {{"atan2", fnAtan2}, {"pow", fnPow}, {"min", fnMin}, {"max", fnMax}};
+
+// A recursive descent parser emitting the postfix program
+// Errors are thrown as std::string and caught in compile()
+class Expression::Parser {
+    public:
+  Parser(const std::string &text, const std::vector<std::string> &variables, std::vector<Instruction> &code)
+    : text(text), variables(variables), code(code), pos(0), depth(0), max_depth(0) {
+  }
+
+  size_t parse() {
+    cond();
+    skip();
+    if (pos < text.size()) fail("Unexpected character '" + std::string(1, text[pos]) + "'");
+    return max_depth;
+  }
+
+    private:
+  const std::string &text;
+  const std::vector<std::string> &variables;
+  std::vector<Instruction> &code;
+  size_t pos;
+  size_t depth, max_depth;
+
+  static void fail(const std::string &msg) {
+    throw msg;
+  }
+
+  void emit(OpCode op, int var = -1, double value = 0, double (*fn1)(double) = nullptr,
+            double (*fn2)(double, double) = nullptr) {
+    Instruction i = {op, var, value, fn1, fn2};
+    code.push_back(i);
+    switch (op) {
+      case OpVar:
+      case OpConst: depth++; break;
+      case OpNeg:
+      case OpNot:
+      case OpFunc1: break;
+      case OpCond: depth -= 2; break;
+      default: depth--; break;
+    }
+    max_depth = std::max(max_depth, depth);
+  }
+
+  void skip() {
+    while (pos < text.size() && isspace(static_cast<unsigned char>(text[pos]))) pos++;
+  }
+
+  // Consumes the token if it is next
+  bool accept(const char *token) {
+    skip();
+    size_t len = strlen(token);
+    if (text.compare(pos, len, token) != 0) return false;
+    // do not mistake <= for <
+    if (len == 1 && pos + 1 < text.size() && text[pos + 1] == '=' && strchr("<>!=", token[0])) return false;
+    pos += len;
+    return true;
+  }
+
+  void expect(const char *token) {
+    if (!accept(token)) fail(std::string("Expected '") + token + "'");
+  }
+
+  void cond() {
+    logicalOr();
+    if (accept("?")) {
+      cond();
+      expect(":");
+      cond();
+      emit(OpCond);
+    }
+  }
+
+  void logicalOr() {
+    logicalAnd();
+    while (accept("||")) {
+      logicalAnd();
+      emit(OpOr);
+    }
+  }
+
+  void logicalAnd() {
+    comparison();
+    while (accept("&&")) {
+      comparison();
+      emit(OpAnd);
+    }
+  }
+
+  void comparison() {
+    additive();
+    for (;;) {
+      OpCode op;
+      if (accept("<="))
+        op = OpLe;
+      else if (accept(">="))
+        op = OpGe;
+      else if (accept("=="))
+        op = OpEq;
+      else if (accept("!="))
+        op = OpNe;
+      else if (accept("<"))
+        op = OpLt;
+      else if (accept(">"))
+        op = OpGt;
+      else
+        return;
+      additive();
+      emit(op);
+    }
+  }
+
+  void additive() {
+    multiplicative();
+    for (;;) {
+      OpCode op;
+      if (accept("+"))
+        op = OpAdd;
+      else if (accept("-"))
+        op = OpSub;
+      else
+        return;
+      multiplicative();
+      emit(op);
+    }
+  }
+
+  void multiplicative() {
+    unary();
+    for (;;) {
+      OpCode op;
+      if (accept("*"))
+        op = OpMul;
+      else if (accept("/"))
+        op = OpDiv;
+      else if (accept("%"))
+        op = OpMod;
+      else
+        return;
+      unary();
+      emit(op);
+    }
+  }
+
+  void unary() {
+    if (accept("-")) {
+      unary();
+      emit(OpNeg);
+    } else if (accept("+")) {
+      unary();
+    } else if (accept("!")) {
+      unary();
+      emit(OpNot);
+    } else {
+      power();
+    }
+  }
+
+  void power() {
+    primary();
+    if (accept("^")) {
+      unary();
+      emit(OpPow);
+    }
+  }
+
+  void primary() {
+    skip();
+    if (pos >= text.size()) fail("Unexpected end of expression");
+
+    char c = text[pos];
+    if (isdigit(static_cast<unsigned char>(c)) || c == '.') {
+      const char *start = text.c_str() + pos;
+      char *end;
+      double value = strtod(start, &end);
+      if (end == start) fail("Invalid number");
+      pos += end - start;
+      emit(OpConst, -1, value);
+      return;
+    }
+
+    if (isalpha(static_cast<unsigned char>(c)) || c == '_') {
+      size_t start = pos;
+      while (pos < text.size() && (isalnum(static_cast<unsigned char>(text[pos])) || text[pos] == '_')) pos++;
+      std::string name = text.substr(start, pos - start);
+
+      if (accept("(")) {
+        call(name);
+        return;
+      }
+
+      // Variables shadow the constants
+      auto var = std::find(variables.begin(), variables.end(), name);
+      if (var != variables.end()) {
+        emit(OpVar, static_cast<int>(var - variables.begin()));
+      } else if (name == "pi") {
+        emit(OpConst, -1, 3.14159265358979323846);
+      } else if (name == "nan") {
+        emit(OpConst, -1, std::numeric_limits<double>::quiet_NaN());
+      } else {
+        fail("Unknown variable \"" + name + "\"");
+      }
+      return;
+    }
+
+    if (accept("(")) {
+      cond();
+      expect(")");
+      return;
+    }
+
+    fail("Unexpected character '" + std::string(1, c) + "'");
+  }
+
+  void call(const std::string &name) {
+    for (const auto &f : functions1) {
+      if (name == f.name) {
+        cond();
+        expect(")");
+        emit(OpFunc1, -1, 0, f.fn);
+        return;
+      }
+    }
+    for (const auto &f : functions2) {
+      if (name == f.name) {
+        cond();
+        expect(",");
+        cond();
+        expect(")");
+        emit(OpFunc2, -1, 0, nullptr, f.fn);
+        return;
+      }
+    }
+    fail("Unknown function \"" + name + "\"");
+  }
+};
+
+Expression::Expression() : code(), depth(0) {
+}
+
+bool Expression::compile(const std::string &text, const std::vector<std::string> &variables, std::string &error) {
+  code.clear();
+  try {
+    Parser parser(text, variables, code);
+    depth = parser.parse();
+  } catch (const std::string &msg) {
+    code.clear();
+    error = msg;
+    return false;
+  }
+  return true;
+}
+
+// An element of the evaluation stack, either an array or a scalar (ptr == nullptr)
+struct Operand {
+  const double *ptr;
+  double value;
+};
+
+template <typename F> static inline void apply1(Operand &a, double *out, size_t n, F f) {
+  if (a.ptr == nullptr) {
+    a.value = f(a.value);
+    return;
+  }
+  const double *x = a.ptr;
+  for (size_t i = 0; i < n; i++) out[i] = f(x[i]);
+  a.ptr = out;
+}
+
+template <typename F> static inline void apply2(Operand &a, const Operand &b, double *out, size_t n, F f) {
+  if (a.ptr == nullptr && b.ptr == nullptr) {
+    a.value = f(a.value, b.value);
+    return;
+  }
+  const double *x = a.ptr;
+  const double *y = b.ptr;
+  if (x != nullptr && y != nullptr) {
+    for (size_t i = 0; i < n; i++) out[i] = f(x[i], y[i]);
+  } else if (x != nullptr) {
+    const double v = b.value;
+    for (size_t i = 0; i < n; i++) out[i] = f(x[i], v);
+  } else {
+    const double v = a.value;
+    for (size_t i = 0; i < n; i++) out[i] = f(v, y[i]);
+  }
+  a.ptr = out;
+}
+
+void Expression::evaluate(const double *const *vars, size_t n, double *out, std::vector<double> &scratch) const {
+  // The stack element at position p always uses the p-th scratch array,
+  // every instruction writes over its first operand
+  if (scratch.size() < depth * n) scratch.resize(depth * n);
+  std::vector<Operand> stack;
+  stack.reserve(depth);
+
+  for (const Instruction &i : code) {
+    if (i.op == OpVar) {
+      stack.push_back({vars[i.var], 0});
+      continue;
+    }
+    if (i.op == OpConst) {
+      stack.push_back({nullptr, i.value});
+      continue;
+    }
+
+    size_t arity = (i.op == OpNeg || i.op == OpNot || i.op == OpFunc1) ? 1 : i.op == OpCond ? 3 : 2;
+    size_t p = stack.size() - arity;
+    double *slot = scratch.data() + p * n;
+    Operand &a = stack[p];
+
+    switch (i.op) {
+      case OpNeg: apply1(a, slot, n, [](double x) { return -x; }); break;
+      case OpNot: apply1(a, slot, n, [](double x) { return x == 0 ? 1.0 : 0.0; }); break;
+      case OpFunc1: apply1(a, slot, n, i.fn1); break;
+      case OpAdd: apply2(a, stack[p + 1], slot, n, [](double x, double y) { return x + y; }); break;
+      case OpSub: apply2(a, stack[p + 1], slot, n, [](double x, double y) { return x - y; }); break;
+      case OpMul: apply2(a, stack[p + 1], slot, n, [](double x, double y) { return x * y; }); break;
+      case OpDiv: apply2(a, stack[p + 1], slot, n, [](double x, double y) { return x / y; }); break;
+      case OpMod: apply2(a, stack[p + 1], slot, n, [](double x, double y) { return std::fmod(x, y); }); break;
+      case OpPow: apply2(a, stack[p + 1], slot, n, [](double x, double y) { return std::pow(x, y); }); break;
+      case OpLt: apply2(a, stack[p + 1], slot, n, [](double x, double y) { return x < y ? 1.0 : 0.0; }); break;
+      case OpLe: apply2(a, stack[p + 1], slot, n, [](double x, double y) { return x <= y ? 1.0 : 0.0; }); break;
+      case OpGt: apply2(a, stack[p + 1], slot, n, [](double x, double y) { return x > y ? 1.0 : 0.0; }); break;
+      case OpGe: apply2(a, stack[p + 1], slot, n, [](double x, double y) { return x >= y ? 1.0 : 0.0; }); break;
+      case OpEq: apply2(a, stack[p + 1], slot, n, [](double x, double y) { return x == y ? 1.0 : 0.0; }); break;
+      case OpNe: apply2(a, stack[p + 1], slot, n, [](double x, double y) { return x != y ? 1.0 : 0.0; }); break;
+      case OpAnd:
+        apply2(a, stack[p + 1], slot, n, [](double x, double y) { return (x != 0 && y != 0) ? 1.0 : 0.0; });
+        break;
+      case OpOr:
+        apply2(a, stack[p + 1], slot, n, [](double x, double y) { return (x != 0 || y != 0) ? 1.0 : 0.0; });
+        break;
+      case OpFunc2: apply2(a, stack[p + 1], slot, n, i.fn2); break;
+      case OpCond: {
+        const Operand &t = stack[p + 1];
+        const Operand &f = stack[p + 2];
+        if (a.ptr == nullptr) {
+          a = a.value != 0 ? t : f;
+          // the chosen branch may live in a scratch array that will be reused
+          if (a.ptr != nullptr && a.ptr >= scratch.data() && a.ptr < scratch.data() + depth * n) {
+            std::copy(a.ptr, a.ptr + n, slot);
+            a.ptr = slot;
+          }
+        } else {
+          const double *c = a.ptr;
+          for (size_t k = 0; k < n; k++) {
+            double tv = t.ptr ? t.ptr[k] : t.value;
+            double fv = f.ptr ? f.ptr[k] : f.value;
+            slot[k] = c[k] != 0 ? tv : fv;
+          }
+          a.ptr = slot;
+        }
+        break;
+      }
+      default: break;
+    }
+    stack.resize(p + 1);
+  }
+
+  const Operand &r = stack[0];
+  if (r.ptr == nullptr)
+    std::fill(out, out + n, r.value);
+  else
+    std::copy(r.ptr, r.ptr + n, out);
+}
+
+} // namespace node_gdal
@@ -0,0 +1,85 @@
+#ifndef __NODE_GDAL_EXPRESSION_H__
+#define __NODE_GDAL_EXPRESSION_H__
+
+#include <stddef.h>
+#include <string>
+#include <vector>
+
+namespace node_gdal {
+
+// An arithmetic expression compiled once and evaluated over arrays of doubles
+//
+// The expression is compiled to a postfix program in which every instruction
+// is applied to a whole array before moving to the next one - this keeps
+// the inner loops short, branchless and vectorizable by the compiler
+//
+// Supported syntax (by order of precedence):
+//  c ? a : b
+//  ||
+//  &&
+//  < <= > >= == !=
+//  + -
+//  * / %
+//  unary - + !
+//  ^ (power, right-associative)
+//  numbers, variables, pi, nan, (...), functions:
+//  abs sqrt exp log log10 sin cos tan asin acos atan floor ceil round isnan
+//  atan2 pow min max (min and max propagate NaN)
+//
+// Comparisons and logical operators return 1 or 0
+
+class Expression {
+    public:
+  Expression();
+
+  // Returns false and sets error if the expression is invalid
+  // variables are the names of the arrays passed to evaluate()
+  bool compile(const std::string &text, const std::vector<std::string> &variables, std::string &error);
+
+  // Computes out[i] for i in [0, n)
+  // vars must point to arrays of n values, one per variable
+  // scratch is reused between calls to avoid allocations, it must not be shared between threads
+  void evaluate(const double *const *vars, size_t n, double *out, std::vector<double> &scratch) const;
+
+    private:
+  enum OpCode {
+    OpVar,
+    OpConst,
+    OpNeg,
+    OpNot,
+    OpAdd,
+    OpSub,
+    OpMul,
+    OpDiv,
+    OpMod,
+    OpPow,
+    OpLt,
+    OpLe,
+    OpGt,
+    OpGe,
+    OpEq,
+    OpNe,
+    OpAnd,
+    OpOr,
+    OpCond,
+    OpFunc1,
+    OpFunc2
+  };
+
+  struct Instruction {
+    OpCode op;
+    int var;
+    double value;
+    double (*fn1)(double);
+    double (*fn2)(double, double);
+  };
+
+  class Parser;
+
+  std::vector<Instruction> code;
+  size_t depth;
+};
+
+} // namespace node_gdal
+
+#endif
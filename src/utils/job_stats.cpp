@@ -0,0 +1,249 @@
+#include "job_stats.hpp"
+#include "../gdal_common.hpp"
+#include "../gdal_dataset.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <map>
+
+namespace node_gdal {
+
+namespace JobStats {
+
+const char *current = "unknown";
+
+// 4 buckets per power of 2 of microseconds, up to more than one hour
+static const int histogramBuckets = 128;
+
+struct Histogram {
+  double count;
+  double sum;
+  double max;
+  double buckets[histogramBuckets];
+
+  Histogram() : count(0), sum(0), max(0), buckets() {
+  }
+
+  static int Bucket(double us) {
+    return std::min(histogramBuckets - 1, static_cast<int>(4 * std::log2(us + 1)));
+  }
+
+  void Add(double us) {
+    count++;
+    sum += us;
+    max = std::max(max, us);
+    buckets[Bucket(us)]++;
+  }
+
+  // The upper bound of the bucket that contains the percentile, never more than the max
+  double Percentile(double p) const {
+    double target = p * count;
+    double seen = 0;
+    for (int i = 0; i < histogramBuckets; i++) {
+      seen += buckets[i];
+      if (seen >= target && seen > 0) return std::min(max, std::exp2((i + 1) / 4.0) - 1);
+    }
+    return max;
+  }
+
+  // Milliseconds
+  Local<Object> ToObject() const {
+    Nan::EscapableHandleScope scope;
+    Local<Object> obj = Nan::New<Object>();
+    Nan::Set(obj, Nan::New("count").ToLocalChecked(), Nan::New<Number>(count));
+    Nan::Set(obj, Nan::New("mean").ToLocalChecked(), Nan::New<Number>(count > 0 ? sum / count / 1000 : 0));
+    Nan::Set(obj, Nan::New("max").ToLocalChecked(), Nan::New<Number>(max / 1000));
+    Nan::Set(obj, Nan::New("p50").ToLocalChecked(), Nan::New<Number>(Percentile(0.5) / 1000));
+    Nan::Set(obj, Nan::New("p90").ToLocalChecked(), Nan::New<Number>(Percentile(0.9) / 1000));
+    Nan::Set(obj, Nan::New("p99").ToLocalChecked(), Nan::New<Number>(Percentile(0.99) / 1000));
+    return scope.Escape(obj);
+  }
+};
+
+struct MethodStats {
+  double calls;
+  double errors;
+  double reads;
+  double bytesRead;
+  Histogram queue;
+  Histogram lock;
+  Histogram exec;
+  Histogram rval;
+
+  MethodStats() : calls(0), errors(0), reads(0), bytesRead(0) {
+  }
+};
+
+static std::map<std::string, MethodStats> methods;
+static Nan::Persistent<Function> hook;
+
+void Record(const JobTimings &t) {
+  std::string name = t.method;
+  if (t.async) name += "Async";
+  MethodStats &m = methods[name];
+  m.calls++;
+  if (t.error) m.errors++;
+  m.reads += t.reads;
+  m.bytesRead += t.bytesRead;
+  if (t.async) m.queue.Add(t.queue);
+  m.lock.Add(t.lock);
+  m.exec.Add(t.exec);
+  if (!t.error) m.rval.Add(t.rval);
+
+  if (hook.IsEmpty()) return;
+  Nan::HandleScope scope;
+  Local<Object> event = Nan::New<Object>();
+  Nan::Set(event, Nan::New("method").ToLocalChecked(), Nan::New(name).ToLocalChecked());
+  Nan::Set(event, Nan::New("async").ToLocalChecked(), Nan::New<Boolean>(t.async));
+  Nan::Set(event, Nan::New("error").ToLocalChecked(), Nan::New<Boolean>(t.error));
+  Local<Array> datasets = Nan::New<Array>();
+  for (long uid : t.ds_uids)
+    if (uid != 0) Nan::Set(datasets, datasets->Length(), Nan::New<Number>(static_cast<double>(uid)));
+  Nan::Set(event, Nan::New("datasets").ToLocalChecked(), datasets);
+  Nan::Set(event, Nan::New("queue").ToLocalChecked(), Nan::New<Number>(t.queue / 1000));
+  Nan::Set(event, Nan::New("lock").ToLocalChecked(), Nan::New<Number>(t.lock / 1000));
+  Nan::Set(event, Nan::New("exec").ToLocalChecked(), Nan::New<Number>(t.exec / 1000));
+  Nan::Set(event, Nan::New("rval").ToLocalChecked(), Nan::New<Number>(t.rval / 1000));
+  Nan::Set(event, Nan::New("reads").ToLocalChecked(), Nan::New<Number>(t.reads));
+  Nan::Set(event, Nan::New("bytesRead").ToLocalChecked(), Nan::New<Number>(t.bytesRead));
+  Local<Value> argv[] = {event};
+  // An exception in the hook must not affect the job
+  Nan::TryCatch try_catch;
+  Nan::Call(Nan::New(hook), Nan::GetCurrentContext()->Global(), 1, argv);
+}
+
+/**
+ * @typedef {object} JobTimingStats
+ * @property {number} count
+ * @property {number} mean
+ * @property {number} max
+ * @property {number} p50
+ * @property {number} p90
+ * @property {number} p99
+ */
+
+/**
+ * @typedef {object} JobStats
+ * @property {number} calls
+ * @property {number} errors
+ * @property {number} reads
+ * @property {number} bytesRead
+ * @property {JobTimingStats} queue
+ * @property {JobTimingStats} lock
+ * @property {JobTimingStats} exec
+ * @property {JobTimingStats} rval
+ */
+
+/**
+ * Returns the timing statistics of the calls of the methods implemented
+ * as GDAL jobs since the start of the process or since `gdal.stats.reset()`,
+ * keyed by method name (`Class::method` for the sync version and
+ * `Class::methodAsync` for the async version).
+ *
+ * For each method, the times in milliseconds are:
+ * * `queue` - the time spent waiting for a libuv thread (async only)
+ * * `lock` - the time spent waiting for the locks of the datasets
+ * * `exec` - the time spent in GDAL
+ * * `rval` - the time spent on the main thread producing the returned value
+ *
+ * `reads` and `bytesRead` count the reads of the files opened through
+ * `/vsistats/` made by the jobs, see {@link fs.ioStats}.
+ *
+ * The percentiles are estimated from log-scale histograms
+ * with a precision of about 20%.
+ *
+ * @example
+ * const slowest = Object.entries(gdal.stats())
+ *   .sort(([, a], [, b]) => b.exec.p99 - a.exec.p99)
+ *
+ * @static
+ * @method stats
+ * @return {Record<string, JobStats>}
+ */
+NAN_METHOD(stats) {
+  Local<Object> result = Nan::New<Object>();
+  for (const auto &entry : methods) {
+    const MethodStats &m = entry.second;
+    Local<Object> obj = Nan::New<Object>();
+    Nan::Set(obj, Nan::New("calls").ToLocalChecked(), Nan::New<Number>(m.calls));
+    Nan::Set(obj, Nan::New("errors").ToLocalChecked(), Nan::New<Number>(m.errors));
+    Nan::Set(obj, Nan::New("reads").ToLocalChecked(), Nan::New<Number>(m.reads));
+    Nan::Set(obj, Nan::New("bytesRead").ToLocalChecked(), Nan::New<Number>(m.bytesRead));
+    Nan::Set(obj, Nan::New("queue").ToLocalChecked(), m.queue.ToObject());
+    Nan::Set(obj, Nan::New("lock").ToLocalChecked(), m.lock.ToObject());
+    Nan::Set(obj, Nan::New("exec").ToLocalChecked(), m.exec.ToObject());
+    Nan::Set(obj, Nan::New("rval").ToLocalChecked(), m.rval.ToObject());
+    Nan::Set(result, Nan::New(entry.first).ToLocalChecked(), obj);
+  }
+  info.GetReturnValue().Set(result);
+}
+
+/**
+ * @typedef {object} LockStats
+ * @property {number} acquisitions
+ * @property {number} contended
+ * @property {number} wakeups
+ * @property {number} wait
+ * @property {number} maxWait
+ */
+
+/**
+ * Returns the contention counters of the dataset locks since the start of the
+ * process or since `gdal.stats.reset()`, for all datasets or for one dataset
+ * (the dependant datasets share the lock of their parent).
+ *
+ * * `acquisitions` - the number of times a lock was acquired
+ * * `contended` - the number of acquisitions that had to wait
+ * * `wakeups` - the number of times a waiting thread was woken up, more than
+ * `contended` when the waiters were woken up while the lock had already been taken again
+ * * `wait` / `maxWait` - the total and the longest time spent waiting in milliseconds
+ *
+ * @static
+ * @method locks
+ * @memberof stats
+ * @throws {Error}
+ * @param {Dataset} [dataset]
+ * @return {LockStats}
+ */
+NAN_METHOD(lockStats) {
+  Dataset *ds = nullptr;
+  NODE_ARG_WRAPPED_OPT(0, "dataset", Dataset, ds);
+
+  LockCounters counters;
+  if (ds == nullptr) {
+    counters = object_store.lockCounters();
+  } else if (!object_store.lockCounters(ds->uid, counters)) {
+    Nan::ThrowError("Dataset object has already been destroyed");
+    return;
+  }
+
+  Local<Object> result = Nan::New<Object>();
+  Nan::Set(result, Nan::New("acquisitions").ToLocalChecked(), Nan::New<Number>(counters.acquisitions));
+  Nan::Set(result, Nan::New("contended").ToLocalChecked(), Nan::New<Number>(counters.contended));
+  Nan::Set(result, Nan::New("wakeups").ToLocalChecked(), Nan::New<Number>(counters.wakeups));
+  Nan::Set(result, Nan::New("wait").ToLocalChecked(), Nan::New<Number>(counters.wait / 1000));
+  Nan::Set(result, Nan::New("maxWait").ToLocalChecked(), Nan::New<Number>(counters.maxWait / 1000));
+  info.GetReturnValue().Set(result);
+}
+
+NAN_METHOD(resetStats) {
+  methods.clear();
+  object_store.resetLockCounters();
+}
+
+// The hook receives an event object for each job, see lib/stats.js
+NAN_METHOD(setJobHook) {
+  if (info.Length() < 1 || info[0]->IsNull() || info[0]->IsUndefined()) {
+    hook.Reset();
+    return;
+  }
+  if (!info[0]->IsFunction()) {
+    Nan::ThrowTypeError("hook must be a function");
+    return;
+  }
+  hook.Reset(info[0].As<Function>());
+}
+
+} // namespace JobStats
+
+} // namespace node_gdal
@@ -0,0 +1,64 @@
+#ifndef __NODE_GDAL_JOB_STATS_H__
+#define __NODE_GDAL_JOB_STATS_H__
+
+// node
+#include <node.h>
+
+// nan
+#include "../nan-wrapper.h"
+
+#include <chrono>
+#include <string>
+#include <vector>
+
+using namespace v8;
+
+namespace node_gdal {
+
+// Instrumentation of the GDALAsyncableJob calls
+//
+// Each job records the time it waited in the libuv queue, the time it
+// waited for the locks of its datasets, the execution time of its main
+// lambda and the time spent on the main thread converting the result
+// These are aggregated per method in log-scale histograms that are
+// accessed only from the main thread, and optionally passed to a JS hook
+
+typedef std::chrono::steady_clock JobClock;
+
+struct JobTimings {
+  const char *method;
+  bool async;
+  bool error;
+  std::vector<long> ds_uids;
+  // microseconds
+  double queue;
+  double lock;
+  double exec;
+  double rval;
+  // The reads made through /vsistats/ by the job, see utils/vsi_stats.hpp
+  double reads;
+  double bytesRead;
+};
+
+namespace JobStats {
+
+// The name of the method being called, set on the main thread by the GDAL_ASYNCABLE_* macros
+extern const char *current;
+
+inline double Elapsed(const JobClock::time_point &from, const JobClock::time_point &to) {
+  return std::chrono::duration<double, std::micro>(to - from).count();
+}
+
+// Main thread only
+void Record(const JobTimings &timings);
+
+NAN_METHOD(stats);
+NAN_METHOD(resetStats);
+NAN_METHOD(lockStats);
+NAN_METHOD(setJobHook);
+
+} // namespace JobStats
+
+} // namespace node_gdal
+
+#endif
@@ -0,0 +1,284 @@
+#include "microbench.hpp"
+
+#ifdef ENABLE_MICROBENCH
+#include "../gdal_common.hpp"
+#include "../async.hpp"
+#include "typed_array.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <string>
+#include <thread>
+#include <vector>
+#endif
+
+namespace node_gdal {
+
+namespace Microbench {
+
+#ifdef ENABLE_MICROBENCH
+
+typedef std::chrono::steady_clock Clock;
+
+// Each benchmark is repeated until it has run for this long, then measured this many times
+static const double minBatchNs = 50e6;
+static const int repetitions = 5;
+
+// Prevents the compiler from optimizing away the measured code
+static volatile size_t sink;
+
+struct Result {
+  std::string name;
+  size_t iterations;
+  double median;
+  double min;
+};
+
+class Runner {
+    public:
+  Runner(const std::string &filter) : filter(filter) {
+  }
+
+  bool selected(const char *name) const {
+    return filter.empty() || std::string(name).find(filter) != std::string::npos;
+  }
+
+  // op is called once per iteration, the results are in nanoseconds per iteration
+  template <typename F> void measure(const char *name, F op) {
+    if (!selected(name)) return;
+    size_t iterations = 1;
+    while (batch(op, iterations) < minBatchNs) iterations *= 2;
+    std::vector<double> samples;
+    for (int i = 0; i < repetitions; i++) samples.push_back(batch(op, iterations) / iterations);
+    record(name, iterations, samples);
+  }
+
+  // The main thread (0) and threads - 1 other threads call op(thread) concurrently
+  template <typename F> void measureThreads(const char *name, int threads, size_t iterations, F op) {
+    if (!selected(name)) return;
+    std::vector<double> samples;
+    for (int r = 0; r < repetitions; r++) {
+      Clock::time_point start = Clock::now();
+      std::vector<std::thread> workers;
+      for (int t = 1; t < threads; t++)
+        workers.emplace_back([&op, iterations, t]() {
+          for (size_t i = 0; i < iterations; i++) op(t);
+        });
+      for (size_t i = 0; i < iterations; i++) op(0);
+      for (std::thread &w : workers) w.join();
+      samples.push_back(elapsed(start) / (iterations * threads));
+    }
+    record(name, iterations * threads, samples);
+  }
+
+  std::vector<Result> results;
+
+    private:
+  std::string filter;
+
+  static double elapsed(const Clock::time_point &start) {
+    return std::chrono::duration<double, std::nano>(Clock::now() - start).count();
+  }
+
+  template <typename F> static double batch(F &op, size_t iterations) {
+    Clock::time_point start = Clock::now();
+    for (size_t i = 0; i < iterations; i++) op();
+    return elapsed(start);
+  }
+
+  void record(const char *name, size_t iterations, std::vector<double> &samples) {
+    std::sort(samples.begin(), samples.end());
+    results.push_back({name, iterations, samples[samples.size() / 2], samples[0]});
+  }
+};
+
+// Stands for the info of a NAN_METHOD in the NODE_ARG_* macros
+struct Arguments {
+  Local<Value> values[3];
+  int Length() const {
+    return 3;
+  }
+  Local<Value> operator[](int i) const {
+    return values[i];
+  }
+};
+
+static void parseInt(const Arguments &info) {
+  int v;
+  NODE_ARG_INT(0, "int", v);
+  sink += v;
+}
+
+static void parseDouble(const Arguments &info) {
+  double v;
+  NODE_ARG_DOUBLE(1, "double", v);
+  sink += static_cast<size_t>(v);
+}
+
+static void parseStr(const Arguments &info) {
+  std::string v;
+  NODE_ARG_STR(2, "string", v);
+  sink += v.size();
+}
+
+static GDALDataset *createDataset() {
+  GDALDriver *driver = GetGDALDriverManager()->GetDriverByName("MEM");
+  if (driver == nullptr) throw "MEM driver not available";
+  GDALDataset *ds = driver->Create("microbench", 1, 1, 1, GDT_Byte, nullptr);
+  if (ds == nullptr) throw CPLGetLastErrorMsg();
+  return ds;
+}
+
+static void runAll(Runner &runner, const Nan::FunctionCallbackInfo<Value> &info) {
+  Nan::Persistent<Object> obj(Nan::New<Object>());
+  long ds1 = object_store.add(createDataset(), obj, 0);
+  long ds2 = object_store.add(createDataset(), obj, 0);
+
+  // A store with the size of a busy application
+  const size_t alive = 10000;
+  std::vector<GDALRasterBand *> bands;
+  std::vector<long> band_uids;
+  for (size_t i = 0; i < alive; i++) {
+    // The fake pointers are only used as keys, a band is never dereferenced by the ObjectStore
+    bands.push_back(reinterpret_cast<GDALRasterBand *>((i + 1) * 64));
+    band_uids.push_back(object_store.add(bands.back(), obj, ds1));
+  }
+  size_t next = 0;
+  uintptr_t fake = (alive + 1) * 64;
+
+  runner.measure("ObjectStore::add+dispose", [&]() {
+    long uid = object_store.add(reinterpret_cast<GDALRasterBand *>(fake += 64), obj, ds1);
+    object_store.dispose(uid);
+  });
+  runner.measure("ObjectStore::has", [&]() { sink += object_store.has(bands[next++ % alive]); });
+  runner.measure("ObjectStore::get", [&]() {
+    Nan::HandleScope scope;
+    sink += !object_store.get(bands[next++ % alive]).IsEmpty();
+  });
+  runner.measure("ObjectStore::isAlive", [&]() { sink += object_store.isAlive(band_uids[next++ % alive]); });
+
+  runner.measure("ObjectStore::lockDataset+unlockDataset", [&]() {
+    AsyncLock lock = object_store.lockDataset(ds1);
+    object_store.unlockDataset(lock);
+  });
+  runner.measure("ObjectStore::tryLockDataset+unlockDataset", [&]() {
+    AsyncLock lock = object_store.tryLockDataset(ds1);
+    object_store.unlockDataset(lock);
+  });
+  runner.measure("ObjectStore::lockDatasets+unlockDatasets (2)", [&]() {
+    vector<AsyncLock> locks = object_store.lockDatasets({ds1, ds2});
+    object_store.unlockDatasets(locks);
+  });
+  runner.measure("AsyncGuard", [&]() { AsyncGuard guard({ds1}, eventLoopWarn); });
+  const int threads = static_cast<int>(std::max(2u, std::min(8u, std::thread::hardware_concurrency())));
+  runner.measureThreads("ObjectStore::lockDataset+unlockDataset contended", threads, 20000, [&](int) {
+    AsyncLock lock = object_store.lockDataset(ds1);
+    object_store.unlockDataset(lock);
+  });
+  runner.measureThreads("ObjectStore::lockDataset+unlockDataset distinct datasets", 2, 100000, [&](int thread) {
+    // Each thread locks its own dataset, only the master lock is shared
+    AsyncLock lock = object_store.lockDataset(thread == 0 ? ds1 : ds2);
+    object_store.unlockDataset(lock);
+  });
+
+  if (runner.selected("under async load")) {
+    // The worker threads lock and unlock a dataset as the async jobs do
+    // while the main thread creates and looks up wrappers
+    std::atomic<bool> stop(false);
+    std::vector<std::thread> load;
+    for (int t = 1; t < threads; t++)
+      load.emplace_back([&stop, ds2]() {
+        while (!stop) {
+          AsyncLock lock = object_store.lockDataset(ds2);
+          object_store.unlockDataset(lock);
+        }
+      });
+    runner.measure("ObjectStore::add+dispose under async load", [&]() {
+      long uid = object_store.add(reinterpret_cast<GDALRasterBand *>(fake += 64), obj, ds1);
+      object_store.dispose(uid);
+    });
+    runner.measure("ObjectStore::has+get under async load", [&]() {
+      Nan::HandleScope scope;
+      GDALRasterBand *band = bands[next++ % alive];
+      if (object_store.has(band)) sink += !object_store.get(band).IsEmpty();
+    });
+    stop = true;
+    for (std::thread &t : load) t.join();
+  }
+
+  const char *previous = JobStats::current;
+  JobStats::current = "Microbench::job";
+  runner.measure("GDALAsyncableJob construction", [&]() {
+    GDALAsyncableJob<int> job(ds1);
+    job.main = [](const GDALExecutionProgress &) { return 1; };
+    job.rval = [](int r, const GetFromPersistentFunc &) { return Nan::New<Number>(r); };
+  });
+  runner.measure("GDALAsyncableJob::run sync", [&]() {
+    Nan::HandleScope scope;
+    GDALAsyncableJob<int> job(ds1);
+    job.main = [](const GDALExecutionProgress &) { return 1; };
+    job.rval = [](int r, const GetFromPersistentFunc &) { return Nan::New<Number>(r); };
+    job.run(info, false, 0);
+  });
+  JobStats::current = previous;
+
+  runner.measure("TypedArray::New Float64 x256", [&]() {
+    Nan::HandleScope scope;
+    sink += !TypedArray::New(GDT_Float64, 256).IsEmpty();
+  });
+  runner.measure("TypedArray::New Byte x65536", [&]() {
+    Nan::HandleScope scope;
+    sink += !TypedArray::New(GDT_Byte, 65536).IsEmpty();
+  });
+
+  {
+    Nan::HandleScope scope;
+    Arguments args = {
+      {Nan::New<Number>(42), Nan::New<Number>(4.2), Nan::New("/vsimem/microbench.tif").ToLocalChecked()}};
+    runner.measure("NODE_ARG_INT", [&]() { parseInt(args); });
+    runner.measure("NODE_ARG_DOUBLE", [&]() { parseDouble(args); });
+    runner.measure("NODE_ARG_STR", [&]() { parseStr(args); });
+  }
+
+  for (long uid : band_uids) object_store.dispose(uid);
+  object_store.dispose(ds2, true);
+  object_store.dispose(ds1, true);
+  obj.Reset();
+}
+
+#endif
+
+// gdal._microbench(filter?) returns [{name, iterations, median, min}] in nanoseconds per iteration
+// (not a public API)
+NAN_METHOD(run) {
+#ifdef ENABLE_MICROBENCH
+  std::string filter;
+  NODE_ARG_OPT_STR(0, "filter", filter);
+
+  Runner runner(filter);
+  try {
+    runAll(runner, info);
+  } catch (const char *err) {
+    Nan::ThrowError(err);
+    return;
+  }
+
+  Local<Array> results = Nan::New<Array>();
+  for (const Result &r : runner.results) {
+    Local<Object> obj = Nan::New<Object>();
+    Nan::Set(obj, Nan::New("name").ToLocalChecked(), Nan::New(r.name).ToLocalChecked());
+    Nan::Set(obj, Nan::New("iterations").ToLocalChecked(), Nan::New<Number>(static_cast<double>(r.iterations)));
+    Nan::Set(obj, Nan::New("median").ToLocalChecked(), Nan::New<Number>(r.median));
+    Nan::Set(obj, Nan::New("min").ToLocalChecked(), Nan::New<Number>(r.min));
+    Nan::Set(results, results->Length(), obj);
+  }
+  info.GetReturnValue().Set(results);
+#else
+  Nan::ThrowError("Microbenchmarks require gdal-async be compiled with --enable_microbench=true");
+#endif
+}
+
+} // namespace Microbench
+
+} // namespace node_gdal
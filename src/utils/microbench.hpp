@@ -0,0 +1,28 @@
+#ifndef __NODE_GDAL_MICROBENCH_H__
+#define __NODE_GDAL_MICROBENCH_H__
+
+// node
+#include <node.h>
+
+// nan
+#include "../nan-wrapper.h"
+
+using namespace v8;
+
+namespace node_gdal {
+
+// Microbenchmarks of the binding internals - the ObjectStore, the dataset
+// locks, the GDALAsyncableJob and the argument parsing macros - measured
+// entirely in C++ in a single call, see bench/native.js
+//
+// They are compiled only with --enable_microbench=true
+
+namespace Microbench {
+
+NAN_METHOD(run);
+
+} // namespace Microbench
+
+} // namespace node_gdal
+
+#endif
@@ -0,0 +1,376 @@
+#include "overview_builder.hpp"
+#include "parallel.hpp"
+
+// gdal
+#include <cpl_conv.h>
+#include <cpl_string.h>
+
+#include <algorithm>
+#include <atomic>
+#include <climits>
+#include <cmath>
+#include <cstdlib>
+#include <limits>
+#include <mutex>
+
+namespace node_gdal {
+
+// Size of the square tiles processed by one thread, rounded up to the block size
+static const int overviewTileSize = 512;
+
+bool ParseOverviewResampling(const std::string &name, OverviewResampling &resampling) {
+  if (EQUAL(name.c_str(), "NEAREST"))
+    resampling = OverviewNearest;
+  else if (EQUAL(name.c_str(), "AVERAGE"))
+    resampling = OverviewAverage;
+  else if (EQUAL(name.c_str(), "MODE"))
+    resampling = OverviewMode;
+  else if (EQUAL(name.c_str(), "GAUSS"))
+    resampling = OverviewGauss;
+  else if (EQUAL(name.c_str(), "RMS"))
+    resampling = OverviewRMS;
+  else
+    return false;
+  return true;
+}
+
+// One overview level of one band and the larger level it is computed from
+struct OverviewStep {
+  GDALRasterBand *src;
+  GDALRasterBand *dst;
+  int has_nodata;
+  double nodata;
+};
+
+struct OverviewTile {
+  size_t step;
+  int x, y, w, h;
+};
+
+// The buffers of one thread, reused for all its tiles
+struct OverviewScratch {
+  std::vector<double> src;
+  std::vector<double> dst;
+  std::vector<double> values;
+  std::vector<double> weights_x;
+  std::vector<int> x0, x1, y0, y1;
+};
+
+// The overview of band closest to the size GDAL gives to a decimation factor
+static GDALRasterBand *FindOverview(GDALRasterBand *band, int level) {
+  const int w = (band->GetXSize() + level - 1) / level;
+  const int h = (band->GetYSize() + level - 1) / level;
+  GDALRasterBand *best = nullptr;
+  long best_diff = LONG_MAX;
+  for (int i = 0; i < band->GetOverviewCount(); i++) {
+    GDALRasterBand *ovr = band->GetOverview(i);
+    if (ovr == nullptr) continue;
+    long diff = std::labs(static_cast<long>(ovr->GetXSize()) - w) + std::labs(static_cast<long>(ovr->GetYSize()) - h);
+    if (diff < best_diff) {
+      best = ovr;
+      best_diff = diff;
+    }
+  }
+  return best;
+}
+
+// The source pixels [first, last) of each destination pixel, the way GDAL computes them
+static void SourceRanges(int dst_off, int dst_size, double ratio, int src_size, std::vector<int> &first, std::vector<int> &last) {
+  first.resize(dst_size);
+  last.resize(dst_size);
+  for (int i = 0; i < dst_size; i++) {
+    int a = static_cast<int>(0.5 + (dst_off + i) * ratio);
+    int b = static_cast<int>(0.5 + (dst_off + i + 1) * ratio);
+    if (b <= a) b = a + 1;
+    first[i] = std::min(a, src_size - 1);
+    last[i] = std::min(b, src_size);
+  }
+}
+
+static inline double Gauss(double d, double sigma) {
+  return std::exp(-(d * d) / (2 * sigma * sigma));
+}
+
+// Resamples the source window at (sx, sy) of sw pixels per line
+// into the destination tile, no data is NaN in both
+static void ResampleTile(
+  OverviewResampling resampling,
+  const OverviewTile &tile,
+  int sx,
+  int sy,
+  int sw,
+  int sh,
+  int src_w,
+  int src_h,
+  double rx,
+  double ry,
+  bool has_nan,
+  OverviewScratch &s) {
+  const double *src = s.src.data();
+  double *dst = s.dst.data();
+  const double nan = std::numeric_limits<double>::quiet_NaN();
+  const int tw = tile.w;
+  const int th = tile.h;
+
+  // Fast path for the most common case, the compiler vectorizes the inner loop
+  if (resampling == OverviewAverage && !has_nan && rx == 2 && ry == 2 && s.x0[0] == sx && s.y0[0] == sy &&
+      s.x1[tw - 1] == s.x0[0] + 2 * tw && s.y1[th - 1] == s.y0[0] + 2 * th) {
+    for (int j = 0; j < th; j++) {
+      const double *r0 = src + static_cast<size_t>(2 * j) * sw;
+      const double *r1 = r0 + sw;
+      double *out = dst + static_cast<size_t>(j) * tw;
+      for (int i = 0; i < tw; i++) out[i] = 0.25 * (r0[2 * i] + r0[2 * i + 1] + r1[2 * i] + r1[2 * i + 1]);
+    }
+    return;
+  }
+
+  switch (resampling) {
+    case OverviewNearest:
+      for (int j = 0; j < th; j++) {
+        int yy = std::min(static_cast<int>((tile.y + j + 0.5) * ry), src_h - 1) - sy;
+        const double *row = src + static_cast<size_t>(yy) * sw;
+        double *out = dst + static_cast<size_t>(j) * tw;
+        for (int i = 0; i < tw; i++) out[i] = row[std::min(static_cast<int>((tile.x + i + 0.5) * rx), src_w - 1) - sx];
+      }
+      break;
+
+    case OverviewAverage:
+    case OverviewRMS: {
+      const bool rms = resampling == OverviewRMS;
+      for (int j = 0; j < th; j++) {
+        double *out = dst + static_cast<size_t>(j) * tw;
+        for (int i = 0; i < tw; i++) {
+          double sum = 0;
+          int count = 0;
+          for (int yy = s.y0[j]; yy < s.y1[j]; yy++) {
+            const double *row = src + static_cast<size_t>(yy - sy) * sw - sx;
+            for (int xx = s.x0[i]; xx < s.x1[i]; xx++) {
+              const double v = row[xx];
+              if (std::isnan(v)) continue;
+              sum += rms ? v * v : v;
+              count++;
+            }
+          }
+          out[i] = count == 0 ? nan : rms ? std::sqrt(sum / count) : sum / count;
+        }
+      }
+    } break;
+
+    case OverviewMode:
+      for (int j = 0; j < th; j++) {
+        double *out = dst + static_cast<size_t>(j) * tw;
+        for (int i = 0; i < tw; i++) {
+          s.values.clear();
+          for (int yy = s.y0[j]; yy < s.y1[j]; yy++) {
+            const double *row = src + static_cast<size_t>(yy - sy) * sw - sx;
+            for (int xx = s.x0[i]; xx < s.x1[i]; xx++)
+              if (!std::isnan(row[xx])) s.values.push_back(row[xx]);
+          }
+          if (s.values.empty()) {
+            out[i] = nan;
+            continue;
+          }
+          std::sort(s.values.begin(), s.values.end());
+          // On a tie, the smallest value wins
+          double best = s.values[0];
+          size_t best_run = 0;
+          for (size_t k = 0; k < s.values.size();) {
+            size_t l = k;
+            while (l < s.values.size() && s.values[l] == s.values[k]) l++;
+            if (l - k > best_run) {
+              best_run = l - k;
+              best = s.values[k];
+            }
+            k = l;
+          }
+          out[i] = best;
+        }
+      }
+      break;
+
+    case OverviewGauss: {
+      // A gaussian of sigma = half the ratio over the pixel footprint extended by one radius
+      const double sigma_x = std::max(0.5, rx / 2);
+      const double sigma_y = std::max(0.5, ry / 2);
+      const int rad_x = static_cast<int>(std::ceil(rx / 2));
+      const int rad_y = static_cast<int>(std::ceil(ry / 2));
+      for (int j = 0; j < th; j++) {
+        const double cy = (tile.y + j + 0.5) * ry;
+        const int ya = std::max(s.y0[j] - rad_y, sy), yb = std::min(s.y1[j] + rad_y, sy + sh);
+        double *out = dst + static_cast<size_t>(j) * tw;
+        for (int i = 0; i < tw; i++) {
+          const double cx = (tile.x + i + 0.5) * rx;
+          const int xa = std::max(s.x0[i] - rad_x, sx), xb = std::min(s.x1[i] + rad_x, sx + sw);
+          s.weights_x.resize(xb - xa);
+          for (int xx = xa; xx < xb; xx++) s.weights_x[xx - xa] = Gauss(xx + 0.5 - cx, sigma_x);
+          double sum = 0, weight = 0;
+          for (int yy = ya; yy < yb; yy++) {
+            const double wy = Gauss(yy + 0.5 - cy, sigma_y);
+            const double *row = src + static_cast<size_t>(yy - sy) * sw - sx;
+            for (int xx = xa; xx < xb; xx++) {
+              const double v = row[xx];
+              if (std::isnan(v)) continue;
+              const double w = wy * s.weights_x[xx - xa];
+              sum += w * v;
+              weight += w;
+            }
+          }
+          out[i] = weight > 0 ? sum / weight : nan;
+        }
+      }
+    } break;
+  }
+}
+
+void BuildOverviewsParallel(
+  GDALDataset *ds,
+  OverviewResampling resampling,
+  const std::vector<int> &levels,
+  const std::vector<int> &bands,
+  int concurrency,
+  const std::function<void(double)> &progress) {
+  std::vector<int> band_list = bands;
+  if (band_list.empty())
+    for (int i = 1; i <= ds->GetRasterCount(); i++) band_list.push_back(i);
+  for (int b : band_list)
+    if (b < 1 || b > ds->GetRasterCount()) throw "invalid band id";
+  for (int b : band_list)
+    if (GDALDataTypeIsComplex(ds->GetRasterBand(b)->GetRasterDataType()))
+      throw "Complex data types are not supported by the multi-threaded overview builder";
+
+  std::vector<int> sorted = levels;
+  std::sort(sorted.begin(), sorted.end());
+  sorted.erase(std::unique(sorted.begin(), sorted.end()), sorted.end());
+  for (int level : sorted)
+    if (level < 2) throw "Invalid overview level";
+  if (sorted.empty()) return;
+
+  // Create the overview bands without computing them
+  CPLErrorReset();
+  CPLErr err = ds->BuildOverviews(
+    "NONE",
+    static_cast<int>(sorted.size()),
+    sorted.data(),
+    static_cast<int>(band_list.size()),
+    band_list.data(),
+    nullptr,
+    nullptr);
+  if (err != CE_None) throw CPLGetLastErrorMsg();
+
+  // levels[l] of each band is computed from levels[l - 1]
+  std::vector<std::vector<OverviewStep>> steps(sorted.size());
+  double total = 0;
+  for (int b : band_list) {
+    GDALRasterBand *band = ds->GetRasterBand(b);
+    int has_nodata;
+    double nodata = band->GetNoDataValue(&has_nodata);
+    GDALRasterBand *prev = band;
+    for (size_t l = 0; l < sorted.size(); l++) {
+      GDALRasterBand *ovr = FindOverview(band, sorted[l]);
+      if (ovr == nullptr) throw "Failed creating the overviews";
+      // Two levels can resolve to the same overview on very small rasters
+      if (ovr == prev || ovr->GetXSize() > prev->GetXSize() || ovr->GetYSize() > prev->GetYSize()) continue;
+      steps[l].push_back({prev, ovr, has_nodata, nodata});
+      total += static_cast<double>(ovr->GetXSize()) * ovr->GetYSize();
+      prev = ovr;
+    }
+  }
+
+  std::mutex io_lock;
+  std::atomic<size_t> done(0);
+  if (progress) progress(0);
+
+  for (size_t l = 0; l < steps.size(); l++) {
+    // The tiles of all the bands of a level are independent
+    std::vector<OverviewTile> tiles;
+    for (size_t k = 0; k < steps[l].size(); k++) {
+      GDALRasterBand *dst = steps[l][k].dst;
+      const int w = dst->GetXSize();
+      const int h = dst->GetYSize();
+      int block_x, block_y;
+      dst->GetBlockSize(&block_x, &block_y);
+      block_x = std::max(1, block_x);
+      block_y = std::max(1, block_y);
+      const int tile_x = std::min(w, std::max(1, (overviewTileSize + block_x - 1) / block_x) * block_x);
+      const int tile_y = std::min(h, std::max(1, (overviewTileSize + block_y - 1) / block_y) * block_y);
+      for (int y = 0; y < h; y += tile_y)
+        for (int x = 0; x < w; x += tile_x) tiles.push_back({k, x, y, std::min(tile_x, w - x), std::min(tile_y, h - y)});
+    }
+
+    const int threads = GetNumThreads(tiles.size(), concurrency);
+    std::vector<OverviewScratch> scratch(threads);
+    const std::vector<OverviewStep> &level = steps[l];
+
+    ParallelFor(tiles.size(), threads, 1, [&](size_t begin, size_t end, int thread) {
+      OverviewScratch &s = scratch[thread];
+      for (size_t t = begin; t < end; t++) {
+        const OverviewTile &tile = tiles[t];
+        const OverviewStep &step = level[tile.step];
+        const int src_w = step.src->GetXSize();
+        const int src_h = step.src->GetYSize();
+        const double rx = static_cast<double>(src_w) / step.dst->GetXSize();
+        const double ry = static_cast<double>(src_h) / step.dst->GetYSize();
+
+        SourceRanges(tile.x, tile.w, rx, src_w, s.x0, s.x1);
+        SourceRanges(tile.y, tile.h, ry, src_h, s.y0, s.y1);
+        int margin_x = 0, margin_y = 0;
+        if (resampling == OverviewGauss) {
+          margin_x = static_cast<int>(std::ceil(rx / 2));
+          margin_y = static_cast<int>(std::ceil(ry / 2));
+        }
+        const int sx = std::max(0, s.x0.front() - margin_x);
+        const int sy = std::max(0, s.y0.front() - margin_y);
+        const int sw = std::min(src_w, s.x1.back() + margin_x) - sx;
+        const int sh = std::min(src_h, s.y1.back() + margin_y) - sy;
+        const size_t src_count = static_cast<size_t>(sw) * sh;
+        s.src.resize(src_count);
+        s.dst.resize(static_cast<size_t>(tile.w) * tile.h);
+
+        CPLErr err;
+        {
+          std::lock_guard<std::mutex> lock(io_lock);
+          CPLErrorReset();
+          err = step.src->RasterIO(GF_Read, sx, sy, sw, sh, s.src.data(), sw, sh, GDT_Float64, 0, 0, nullptr);
+        }
+        if (err != CE_None) throw CPLGetLastErrorMsg();
+
+        bool has_nan = false;
+        double *data = s.src.data();
+        if (step.has_nodata && !std::isnan(step.nodata)) {
+          const double nodata = step.nodata;
+          for (size_t k = 0; k < src_count; k++)
+            if (data[k] == nodata) data[k] = std::numeric_limits<double>::quiet_NaN();
+        }
+        for (size_t k = 0; k < src_count && !has_nan; k++) has_nan = std::isnan(data[k]);
+
+        ResampleTile(resampling, tile, sx, sy, sw, sh, src_w, src_h, rx, ry, has_nan, s);
+
+        // A floating point overview without nodata keeps its NaNs like its source,
+        // NaN cannot be written to an integer overview
+        // (complex types are rejected above, GDALDataTypeIsInteger() requires GDAL 2.3)
+        const GDALDataType dst_type = step.dst->GetRasterDataType();
+        if (has_nan && (step.has_nodata || (dst_type != GDT_Float32 && dst_type != GDT_Float64))) {
+          const double nodata = step.has_nodata ? step.nodata : 0;
+          for (double &v : s.dst)
+            if (std::isnan(v)) v = nodata;
+        }
+
+        {
+          std::lock_guard<std::mutex> lock(io_lock);
+          CPLErrorReset();
+          err = step.dst->RasterIO(
+            GF_Write, tile.x, tile.y, tile.w, tile.h, s.dst.data(), tile.w, tile.h, GDT_Float64, 0, 0, nullptr);
+        }
+        if (err != CE_None) throw CPLGetLastErrorMsg();
+
+        size_t completed = done += static_cast<size_t>(tile.w) * tile.h;
+        // The progress callback can be called only from the calling thread
+        if (progress && thread == 0) progress(completed / total);
+      }
+    });
+  }
+
+  if (progress) progress(1);
+}
+
+} // namespace node_gdal
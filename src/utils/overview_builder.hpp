@@ -0,0 +1,39 @@
+#ifndef __NODE_GDAL_OVERVIEW_BUILDER_H__
+#define __NODE_GDAL_OVERVIEW_BUILDER_H__
+
+// gdal
+#include <gdal_priv.h>
+
+#include <functional>
+#include <string>
+#include <vector>
+
+namespace node_gdal {
+
+// Multi-threaded overview builder
+//
+// The overview bands are created empty by GDAL, then each level is computed
+// from the previous (larger) level instead of the full resolution band,
+// the tiles of a level being processed in parallel
+// The reading and the writing of the pixels are serialized as a GDALDataset
+// cannot be accessed concurrently, only the resampling runs in parallel
+
+enum OverviewResampling { OverviewNearest, OverviewAverage, OverviewMode, OverviewGauss, OverviewRMS };
+
+// Returns false if the resampling is not supported by this builder
+bool ParseOverviewResampling(const std::string &name, OverviewResampling &resampling);
+
+// bands is empty for all the bands, concurrency is 0 for GDAL_NUM_THREADS
+// progress is called only from the calling thread
+// Throws const char * on error
+void BuildOverviewsParallel(
+  GDALDataset *ds,
+  OverviewResampling resampling,
+  const std::vector<int> &levels,
+  const std::vector<int> &bands,
+  int concurrency,
+  const std::function<void(double)> &progress);
+
+} // namespace node_gdal
+
+#endif
@@ -0,0 +1,89 @@
+#include "parallel.hpp"
+
+// gdal
+#include <cpl_conv.h>
+#include <cpl_error.h>
+#include <cpl_multiproc.h>
+#include <cpl_string.h>
+
+#include <algorithm>
+#include <atomic>
+#include <mutex>
+#include <new>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+#include <thread>
+#include <vector>
+#include <stdlib.h>
+
+namespace node_gdal {
+
+int GetNumThreads(size_t items, int requested) {
+  int threads = requested;
+  if (threads <= 0) {
+    const char *opt = CPLGetConfigOption("GDAL_NUM_THREADS", "ALL_CPUS");
+    threads = EQUAL(opt, "ALL_CPUS") ? CPLGetNumCPUs() : atoi(opt);
+  }
+  if (threads < 1) threads = 1;
+  if (items > 0 && static_cast<size_t>(threads) > items) threads = static_cast<int>(items);
+  return threads;
+}
+
+void ParallelFor(
+  size_t items, int threads, size_t grain, const std::function<void(size_t begin, size_t end, int thread)> &fn) {
+  if (items == 0) return;
+  if (grain == 0) grain = 1;
+
+  std::atomic<size_t> next(0);
+  std::atomic<bool> failed(false);
+  std::mutex error_lock;
+  std::string error;
+
+  // Only the first error is reported, the others are usually consequences
+  auto fail = [&](const char *err) {
+    std::lock_guard<std::mutex> lock(error_lock);
+    if (!failed) error = err != nullptr ? err : "Unknown error";
+    failed = true;
+  };
+
+  // An exception escaping from a std::thread terminates the process
+  auto worker = [&](int thread) {
+    try {
+      while (!failed) {
+        size_t begin = next.fetch_add(grain);
+        if (begin >= items) break;
+        fn(begin, std::min(begin + grain, items), thread);
+      }
+    } catch (const char *err) {
+      fail(err);
+    } catch (const std::bad_alloc &) {
+      fail("Out of memory");
+    } catch (const std::exception &e) {
+      fail(e.what());
+    } catch (...) {
+      fail("Unknown error");
+    }
+  };
+
+  std::vector<std::thread> pool;
+  for (int i = 1; i < threads; i++) {
+    try {
+      pool.emplace_back(worker, i);
+    } catch (const std::system_error &) {
+      // Out of threads, continue with what we have
+      break;
+    }
+  }
+  // The calling thread is always thread 0
+  worker(0);
+  for (auto &t : pool) t.join();
+
+  if (failed) {
+    // The message must live in the error context of the calling thread
+    CPLError(CE_Failure, CPLE_AppDefined, "%s", error.c_str());
+    throw CPLGetLastErrorMsg();
+  }
+}
+
+} // namespace node_gdal
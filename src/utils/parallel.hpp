@@ -0,0 +1,31 @@
+#ifndef __NODE_GDAL_PARALLEL_H__
+#define __NODE_GDAL_PARALLEL_H__
+
+#include <functional>
+#include <stddef.h>
+
+namespace node_gdal {
+
+// Helpers for data-parallel jobs that process many independent items
+// (geometries, tiles, polygons...) inside a single GDALAsyncableJob
+//
+// The calling thread (a libuv worker in async mode, the main thread in sync mode)
+// participates in the work and the additional threads live only for the
+// duration of the call
+
+// Number of threads to use for a job with this many items
+// requested > 0 overrides the GDAL_NUM_THREADS configuration option
+// (which can be a number or ALL_CPUS, ALL_CPUS being the default)
+int GetNumThreads(size_t items, int requested = 0);
+
+// Calls fn(begin, end, thread) for consecutive chunks of at most grain items
+// covering [0, items) from up to threads threads
+// The chunks are distributed dynamically, so uneven work loads are balanced
+// fn can throw const char * or any C++ exception - the first error is rethrown
+// as a const char * on the calling thread once all the threads have finished
+void ParallelFor(
+  size_t items, int threads, size_t grain, const std::function<void(size_t begin, size_t end, int thread)> &fn);
+
+} // namespace node_gdal
+
+#endif
@@ -0,0 +1,406 @@
+#include "pixel_functions.hpp"
+
+// gdal
+#include <cpl_conv.h>
+#include <cpl_error.h>
+#include <cpl_string.h>
+#include <gdal.h>
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <utility>
+#include <vector>
+#include <stdlib.h>
+
+namespace node_gdal {
+
+#if GDAL_VERSION_MAJOR > 3 || (GDAL_VERSION_MAJOR == 3 && GDAL_VERSION_MINOR >= 5)
+
+// NaN and the NoData value of the VRT band (when it has one) are both invalid
+struct PixelNoData {
+  bool has;
+  double value;
+
+  explicit PixelNoData(CSLConstList args) {
+    const char *nodata = CSLFetchNameValue(args, "NoData");
+    has = nodata != nullptr;
+    value = has ? CPLAtof(nodata) : std::numeric_limits<double>::quiet_NaN();
+  }
+  inline bool is(double x) const {
+    return std::isnan(x) || (has && x == value);
+  }
+};
+
+// Converts each line of the sources to double, calls fn(lines, out, width)
+// and converts the result to the output type
+// fn works on whole lines so that its loops can be vectorized
+template <typename F>
+static CPLErr applyLines(
+  const char *name,
+  void **sources,
+  int nSources,
+  int nMinSources,
+  int nMaxSources,
+  void *data,
+  int width,
+  int height,
+  GDALDataType srcType,
+  GDALDataType bufType,
+  int pixelSpace,
+  int lineSpace,
+  F fn) {
+  if (nSources < nMinSources || (nMaxSources > 0 && nSources > nMaxSources)) {
+    CPLError(CE_Failure, CPLE_AppDefined, "%s: invalid number of sources (%d)", name, nSources);
+    return CE_Failure;
+  }
+  if (GDALDataTypeIsComplex(srcType)) {
+    CPLError(CE_Failure, CPLE_AppDefined, "%s: complex data types are not supported", name);
+    return CE_Failure;
+  }
+
+  const int srcSize = GDALGetDataTypeSizeBytes(srcType);
+  std::vector<double> in(static_cast<size_t>(width) * nSources);
+  std::vector<double> out(width);
+  std::vector<const double *> lines(nSources);
+  for (int i = 0; i < nSources; i++) lines[i] = in.data() + static_cast<size_t>(i) * width;
+
+  for (int y = 0; y < height; y++) {
+    for (int i = 0; i < nSources; i++) {
+      GDALCopyWords(
+        static_cast<GByte *>(sources[i]) + static_cast<size_t>(y) * width * srcSize,
+        srcType,
+        srcSize,
+        in.data() + static_cast<size_t>(i) * width,
+        GDT_Float64,
+        sizeof(double),
+        width);
+    }
+    fn(lines.data(), out.data(), width);
+    GDALCopyWords(
+      out.data(),
+      GDT_Float64,
+      sizeof(double),
+      static_cast<GByte *>(data) + static_cast<GPtrDiff_t>(y) * lineSpace,
+      bufType,
+      pixelSpace,
+      width);
+  }
+  return CE_None;
+}
+
+static const char weightedSumMetadata[] =
+  "<PixelFunctionArgumentsList>"
+  "   <Argument type='builtin' value='NoData' optional='true' />"
+  "   <Argument name='weights' description='Comma-separated weights, one per source' type='string' />"
+  "   <Argument name='k' description='Optional constant term' type='double' default='0.0' />"
+  "</PixelFunctionArgumentsList>";
+
+static CPLErr WeightedSumPixelFunc(
+  void **sources,
+  int nSources,
+  void *data,
+  int width,
+  int height,
+  GDALDataType srcType,
+  GDALDataType bufType,
+  int pixelSpace,
+  int lineSpace,
+  CSLConstList args) {
+  const PixelNoData nodata(args);
+  const double k = CPLAtof(CSLFetchNameValueDef(args, "k", "0"));
+
+  std::vector<double> weights(nSources, 1.0);
+  const char *weightsArg = CSLFetchNameValue(args, "weights");
+  if (weightsArg != nullptr) {
+    CPLStringList list(CSLTokenizeString2(weightsArg, ", ", 0));
+    if (list.Count() != nSources) {
+      CPLError(CE_Failure, CPLE_AppDefined, "weighted_sum: %d weights for %d sources", list.Count(), nSources);
+      return CE_Failure;
+    }
+    for (int i = 0; i < nSources; i++) weights[i] = CPLAtof(list[i]);
+  }
+
+  return applyLines(
+    "weighted_sum",
+    sources,
+    nSources,
+    1,
+    0,
+    data,
+    width,
+    height,
+    srcType,
+    bufType,
+    pixelSpace,
+    lineSpace,
+    [&](const double *const *in, double *out, int n) {
+      std::fill(out, out + n, k);
+      for (int i = 0; i < nSources; i++) {
+        const double w = weights[i];
+        const double *src = in[i];
+        for (int x = 0; x < n; x++) out[x] += w * src[x];
+      }
+      for (int i = 0; i < nSources; i++) {
+        const double *src = in[i];
+        for (int x = 0; x < n; x++)
+          if (nodata.is(src[x])) out[x] = nodata.value;
+      }
+    });
+}
+
+static const char clampMetadata[] =
+  "<PixelFunctionArgumentsList>"
+  "   <Argument type='builtin' value='NoData' optional='true' />"
+  "   <Argument name='min' description='Lower bound' type='double' default='-inf' />"
+  "   <Argument name='max' description='Upper bound' type='double' default='inf' />"
+  "</PixelFunctionArgumentsList>";
+
+static CPLErr ClampPixelFunc(
+  void **sources,
+  int nSources,
+  void *data,
+  int width,
+  int height,
+  GDALDataType srcType,
+  GDALDataType bufType,
+  int pixelSpace,
+  int lineSpace,
+  CSLConstList args) {
+  const PixelNoData nodata(args);
+  const char *minArg = CSLFetchNameValue(args, "min");
+  const char *maxArg = CSLFetchNameValue(args, "max");
+  const double lo = minArg ? CPLAtof(minArg) : -std::numeric_limits<double>::infinity();
+  const double hi = maxArg ? CPLAtof(maxArg) : std::numeric_limits<double>::infinity();
+
+  return applyLines(
+    "clamp",
+    sources,
+    nSources,
+    1,
+    1,
+    data,
+    width,
+    height,
+    srcType,
+    bufType,
+    pixelSpace,
+    lineSpace,
+    [&](const double *const *in, double *out, int n) {
+      const double *src = in[0];
+      for (int x = 0; x < n; x++) out[x] = std::min(std::max(src[x], lo), hi);
+      for (int x = 0; x < n; x++)
+        if (nodata.is(src[x])) out[x] = nodata.value;
+    });
+}
+
+static const char lutMetadata[] =
+  "<PixelFunctionArgumentsList>"
+  "   <Argument type='builtin' value='NoData' optional='true' />"
+  "   <Argument name='lut' description='Comma-separated input:output pairs in increasing input order' type='string' />"
+  "</PixelFunctionArgumentsList>";
+
+static CPLErr LUTPixelFunc(
+  void **sources,
+  int nSources,
+  void *data,
+  int width,
+  int height,
+  GDALDataType srcType,
+  GDALDataType bufType,
+  int pixelSpace,
+  int lineSpace,
+  CSLConstList args) {
+  const PixelNoData nodata(args);
+
+  // Same syntax and semantics as the LUT of the VRT ComplexSource
+  const char *lutArg = CSLFetchNameValue(args, "lut");
+  if (lutArg == nullptr) {
+    CPLError(CE_Failure, CPLE_AppDefined, "lut: the lut argument is mandatory");
+    return CE_Failure;
+  }
+  CPLStringList list(CSLTokenizeString2(lutArg, ",", CSLT_STRIPLEADSPACES | CSLT_STRIPENDSPACES));
+  std::vector<double> lutIn, lutOut;
+  for (int i = 0; i < list.Count(); i++) {
+    CPLStringList pair(CSLTokenizeString2(list[i], ":", CSLT_STRIPLEADSPACES | CSLT_STRIPENDSPACES));
+    if (pair.Count() != 2 || (!lutIn.empty() && CPLAtof(pair[0]) < lutIn.back())) {
+      CPLError(CE_Failure, CPLE_AppDefined, "lut: invalid lut \"%s\"", lutArg);
+      return CE_Failure;
+    }
+    lutIn.push_back(CPLAtof(pair[0]));
+    lutOut.push_back(CPLAtof(pair[1]));
+  }
+  if (lutIn.empty()) {
+    CPLError(CE_Failure, CPLE_AppDefined, "lut: empty lut");
+    return CE_Failure;
+  }
+
+  return applyLines(
+    "lut",
+    sources,
+    nSources,
+    1,
+    1,
+    data,
+    width,
+    height,
+    srcType,
+    bufType,
+    pixelSpace,
+    lineSpace,
+    [&](const double *const *in, double *out, int n) {
+      const double *src = in[0];
+      const size_t last = lutIn.size() - 1;
+      for (int x = 0; x < n; x++) {
+        const double v = src[x];
+        if (nodata.is(v)) {
+          out[x] = nodata.value;
+          continue;
+        }
+        size_t i = std::lower_bound(lutIn.begin(), lutIn.end(), v) - lutIn.begin();
+        if (i == 0) {
+          out[x] = lutOut[0];
+        } else if (i > last) {
+          out[x] = lutOut[last];
+        } else if (lutIn[i] == lutIn[i - 1]) {
+          out[x] = lutOut[i];
+        } else {
+          const double t = (v - lutIn[i - 1]) / (lutIn[i] - lutIn[i - 1]);
+          out[x] = lutOut[i - 1] + t * (lutOut[i] - lutOut[i - 1]);
+        }
+      }
+    });
+}
+
+static const char bitmaskMetadata[] =
+  "<PixelFunctionArgumentsList>"
+  "   <Argument type='builtin' value='NoData' optional='true' />"
+  "   <Argument name='mask' description='Mask applied after the shift' type='int' default='-1' />"
+  "   <Argument name='shift' description='Right shift applied first' type='int' default='0' />"
+  "</PixelFunctionArgumentsList>";
+
+static CPLErr BitmaskPixelFunc(
+  void **sources,
+  int nSources,
+  void *data,
+  int width,
+  int height,
+  GDALDataType srcType,
+  GDALDataType bufType,
+  int pixelSpace,
+  int lineSpace,
+  CSLConstList args) {
+  const PixelNoData nodata(args);
+  const GIntBig mask = CPLAtoGIntBig(CSLFetchNameValueDef(args, "mask", "-1"));
+  const int shift = atoi(CSLFetchNameValueDef(args, "shift", "0"));
+  if (shift < 0 || shift > 63) {
+    CPLError(CE_Failure, CPLE_AppDefined, "bitmask: shift must be between 0 and 63");
+    return CE_Failure;
+  }
+
+  return applyLines(
+    "bitmask",
+    sources,
+    nSources,
+    1,
+    1,
+    data,
+    width,
+    height,
+    srcType,
+    bufType,
+    pixelSpace,
+    lineSpace,
+    [&](const double *const *in, double *out, int n) {
+      // The conversion of a value outside of the range of GIntBig is undefined
+      const double min = -9223372036854775808.0, max = 9223372036854775808.0;
+      const double *src = in[0];
+      for (int x = 0; x < n; x++) {
+        if (nodata.is(src[x]))
+          out[x] = nodata.value;
+        else if (!(src[x] >= min && src[x] < max))
+          out[x] = nodata.has ? nodata.value : 0;
+        else
+          out[x] = static_cast<double>((static_cast<GIntBig>(src[x]) >> shift) & mask);
+      }
+    });
+}
+
+static const char nanReduceMetadata[] =
+  "<PixelFunctionArgumentsList>"
+  "   <Argument type='builtin' value='NoData' optional='true' />"
+  "</PixelFunctionArgumentsList>";
+
+// min/max/mean of the valid sources, NoData if there are none
+enum NaNReduceOp { NaNMin, NaNMax, NaNMean };
+
+template <NaNReduceOp op>
+static CPLErr NaNReducePixelFunc(
+  void **sources,
+  int nSources,
+  void *data,
+  int width,
+  int height,
+  GDALDataType srcType,
+  GDALDataType bufType,
+  int pixelSpace,
+  int lineSpace,
+  CSLConstList args) {
+  const PixelNoData nodata(args);
+  std::vector<int> count(width);
+
+  return applyLines(
+    op == NaNMin ? "nanmin" : op == NaNMax ? "nanmax" : "nanmean",
+    sources,
+    nSources,
+    1,
+    0,
+    data,
+    width,
+    height,
+    srcType,
+    bufType,
+    pixelSpace,
+    lineSpace,
+    [&](const double *const *in, double *out, int n) {
+      std::fill(count.begin(), count.begin() + n, 0);
+      std::fill(out, out + n, 0);
+      for (int i = 0; i < nSources; i++) {
+        const double *src = in[i];
+        for (int x = 0; x < n; x++) {
+          const double v = src[x];
+          if (nodata.is(v)) continue;
+          if (op == NaNMean)
+            out[x] += v;
+          else if (count[x] == 0 || (op == NaNMin ? v < out[x] : v > out[x]))
+            out[x] = v;
+          count[x]++;
+        }
+      }
+      for (int x = 0; x < n; x++) {
+        if (count[x] == 0)
+          out[x] = nodata.value;
+        else if (op == NaNMean)
+          out[x] /= count[x];
+      }
+    });
+}
+
+void RegisterPixelFunctions() {
+  GDALAddDerivedBandPixelFuncWithArgs("weighted_sum", WeightedSumPixelFunc, weightedSumMetadata);
+  GDALAddDerivedBandPixelFuncWithArgs("clamp", ClampPixelFunc, clampMetadata);
+  GDALAddDerivedBandPixelFuncWithArgs("lut", LUTPixelFunc, lutMetadata);
+  GDALAddDerivedBandPixelFuncWithArgs("bitmask", BitmaskPixelFunc, bitmaskMetadata);
+  GDALAddDerivedBandPixelFuncWithArgs("nanmin", NaNReducePixelFunc<NaNMin>, nanReduceMetadata);
+  GDALAddDerivedBandPixelFuncWithArgs("nanmax", NaNReducePixelFunc<NaNMax>, nanReduceMetadata);
+  GDALAddDerivedBandPixelFuncWithArgs("nanmean", NaNReducePixelFunc<NaNMean>, nanReduceMetadata);
+}
+
+#else
+
+void RegisterPixelFunctions() {
+}
+
+#endif
+
+} // namespace node_gdal
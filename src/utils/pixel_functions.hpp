@@ -0,0 +1,15 @@
+#ifndef __NODE_GDAL_PIXEL_FUNCTIONS_H__
+#define __NODE_GDAL_PIXEL_FUNCTIONS_H__
+
+namespace node_gdal {
+
+// Native pixel functions for VRTDerivedRasterBand that complement
+// the GDAL builtin ones (documented in lib/wrapVRT.js)
+//
+// They run entirely on the GDAL thread that reads the VRT band,
+// unlike the JS pixel functions created by toPixelFunc()
+void RegisterPixelFunctions();
+
+} // namespace node_gdal
+
+#endif
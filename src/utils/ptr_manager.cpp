@@ -6,9 +6,13 @@
 #include "../gdal_attribute.hpp"
 #include "../gdal_layer.hpp"
 #include "../gdal_rasterband.hpp"
+#include "../gdal_block_cache.hpp"
 
+#include <algorithm>
+#include <chrono>
 #include <sstream>
 #include <thread>
+#include <unordered_map>
 
 // Here used to be dragons, but now there is a shopping mall
 //
@@ -31,30 +35,28 @@
 
 // Async lock semantics:
 //
-// * There is one global master lock, all operations on the ObjectStore structures
-//   must acquire it
-// * There is one async lock per dataset and it is a semaphore because it needs
-//   to support being acquired by the main thread and being unlocked in a worker
-// * Sync operations can sleep on the semaphore as only the main thread can
-//   delete a semaphore
-// * Async operations should sleep on the master_sleep condition as semaphores
-//   can be deleted by the main thread (but this would also mean that someone forgot
-//   to protect his object from the GC)
+// * The ObjectStore structures are modified only by the main thread and the main thread
+//   reads them without locking, the wrappers being created and looked up constantly
+// * The only structure read by the worker threads is the Datasets uid map (when locking),
+//   they acquire the master lock and the main thread acquires it to modify this map
+//   and when disposing objects
+// * There is one async lock per dataset, it is a flag protected by the master lock
+//   because it needs to support being acquired by the main thread and being unlocked in a worker
+// * Each async lock has its own condition on which its waiters sleep with the master lock,
+//   unlocking it wakes only one of them
+// * The async locks are held through a shared_ptr, so a waiter can always safely sleep on
+//   its condition, but when waking, the presence of the dataset must be checked again
+// * Disposing a Dataset waits for its lock and wakes all its waiters, so that they fail
 //   - Failing to protect an object from the GC means that GC could potentially sleep
-//   on a semaphore when disposing
+//   on the lock when disposing
 //   - GC that sleeps -> event loop that does run
-// * Acquiring a semaphore requires acquiring the master look otherwise the
-//   semaphore may disappear
-// * When waking from master_sleep, the presence of the semaphore (isAlive) must be
-//   checked again
-// * When unlocking a semaphore, the master_sleep condition is to be broadcasted
-// * Never acquire the master lock while holding a semaphore (deadlock avoidance)
-// * Multiple datasets are to be locked with .lockDataset which sorts locks (deadlock avoidance)
+// * Multiple datasets are to be locked with .lockDatasets which acquires the locks one by one
+//   in the order of their ids (deadlock avoidance)
 // * Never sleep with the master lock held (performance)
 // * All objects carry the dataset uid
 // * All GDAL operations on a dependant object require locking the parent dataset
 // - This is best accomplished though .lockDataset
-// * Dependant Datasets share a semaphore with their parent through a shared_ptr
+// * Dependant Datasets share a lock with their parent through a shared_ptr
 
 namespace node_gdal {
 
@@ -62,14 +64,28 @@ namespace node_gdal {
 // these two must be here and must have file scope
 // MSVC throws an Internal Compiler Error when specializing templated variables
 // and the linker doesn't use the right address when processing exported symbols
-template <typename GDALPTR> using UidMap = map<long, shared_ptr<ObjectStoreItem<GDALPTR>>>;
-template <typename GDALPTR> using PtrMap = map<GDALPTR, shared_ptr<ObjectStoreItem<GDALPTR>>>;
+template <typename GDALPTR> using UidMap = unordered_map<long, shared_ptr<ObjectStoreItem<GDALPTR>>>;
+template <typename GDALPTR> using PtrMap = unordered_map<GDALPTR, shared_ptr<ObjectStoreItem<GDALPTR>>>;
 template <typename GDALPTR> static UidMap<GDALPTR> uidMap;
 template <typename GDALPTR> static PtrMap<GDALPTR> ptrMap;
 
-void uv_sem_deleter::operator()(uv_sem_t *p) {
-  uv_sem_destroy(p);
-  delete p;
+LockCounters::LockCounters() : acquisitions(0), contended(0), wakeups(0), wait(0), maxWait(0) {
+}
+
+void LockCounters::add(bool was_contended, double us) {
+  acquisitions++;
+  if (!was_contended) return;
+  contended++;
+  wait += us;
+  maxWait = std::max(maxWait, us);
+}
+
+DatasetLock::DatasetLock(long id) : id(id), locked(false), waiting(0), counters() {
+  uv_cond_init(&unlocked);
+}
+
+DatasetLock::~DatasetLock() {
+  uv_cond_destroy(&unlocked);
 }
 
 class uv_scoped_mutex {
@@ -94,12 +110,10 @@ ObjectStore::ObjectStore() : uid(1) {
 #else
   uv_mutex_init(&master_lock);
 #endif
-  uv_cond_init(&master_sleep);
 }
 
 ObjectStore::~ObjectStore() {
   uv_mutex_destroy(&master_lock);
-  uv_cond_destroy(&master_sleep);
 }
 
 bool ObjectStore::isAlive(long uid) {
@@ -114,45 +128,141 @@ bool ObjectStore::isAlive(long uid) {
 }
 
 static inline void sortUnique(vector<long> &uids) {
-  // Avoid deadlocks
+  if (uids.empty()) return;
   sort(uids.begin(), uids.end());
   // Eliminate dupes and 0s
   uids.erase(unique(uids.begin(), uids.end()), uids.end());
   if (uids.front() == 0) uids.erase(uids.begin());
 }
 
+typedef std::chrono::steady_clock LockClock;
+
+// How often a waiter that can be aborted checks its abort flag, in nanoseconds
+static const uint64_t abortPollInterval = 10 * 1000 * 1000;
+
+/*
+ * Acquire a lock, sleeping on its condition until it is free,
+ * throws when the Dataset has been destroyed or when the abort flag
+ * is raised while waiting (called with the master lock held).
+ */
+void ObjectStore::acquire(const AsyncLock &lock, long uid, const int32_t *abort) {
+  if (!lock->locked) {
+    lock->locked = true;
+    lock->counters.add(false, 0);
+    counters.add(false, 0);
+    return;
+  }
+  LockClock::time_point start = LockClock::now();
+  lock->waiting++;
+  auto giveUp = [&lock](const char *msg) {
+    lock->waiting--;
+    // This wakeup could have been meant for another waiter
+    if (!lock->locked && lock->waiting > 0) uv_cond_signal(&lock->unlocked);
+    throw msg;
+  };
+  while (lock->locked) {
+    if (abort == nullptr) {
+      uv_cond_wait(&lock->unlocked, &master_lock);
+    } else if (uv_cond_timedwait(&lock->unlocked, &master_lock, abortPollInterval) != 0) {
+      if (IsAborted(abort)) giveUp(abortedMessage);
+      continue;
+    }
+    lock->counters.wakeups++;
+    counters.wakeups++;
+    if (uidMap<GDALDataset *>.count(uid) == 0) giveUp("Parent Dataset object has already been destroyed");
+  }
+  lock->waiting--;
+  lock->locked = true;
+  double us = std::chrono::duration<double, std::micro>(LockClock::now() - start).count();
+  lock->counters.add(true, us);
+  counters.add(true, us);
+}
+
+/*
+ * Release a lock waking only one of its waiters (called with the master lock held).
+ */
+void ObjectStore::release(const AsyncLock &lock) {
+  lock->locked = false;
+  if (lock->waiting > 0) uv_cond_signal(&lock->unlocked);
+}
+
+/*
+ * Wait until nobody holds a lock without acquiring it, used when disposing
+ * (called with the master lock held).
+ * uv_cond_wait() releases the master lock while sleeping, so the loop checks
+ * the state of the lock again after each wakeup. The object being disposed
+ * must already be removed from the store, so no new job can acquire its lock
+ * and the waiters wake up to find it destroyed.
+ */
+void ObjectStore::waitUnlocked(const AsyncLock &lock, const char *warning) {
+  if (!lock->locked) return;
+  lock->waiting++;
+  MEASURE_EXECUTION_TIME(warning, while (lock->locked) uv_cond_wait(&lock->unlocked, &master_lock));
+  lock->waiting--;
+  // The lock is free but it won't be acquired, pass the wakeup to another waiter
+  if (lock->waiting > 0) uv_cond_signal(&lock->unlocked);
+}
+
+/*
+ * The distinct locks of several Datasets with the uid of one of their Datasets
+ * in their order of acquisition, throws when a Dataset has been destroyed
+ * (called with the master lock held).
+ */
+vector<pair<AsyncLock, long>> ObjectStore::findLocks(const vector<long> &uids) {
+  vector<pair<AsyncLock, long>> locks;
+  for (long uid : uids) {
+    auto ds = uidMap<GDALDataset *>.find(uid);
+    if (ds == uidMap<GDALDataset *>.end()) { throw "Parent Dataset object has already been destroyed"; }
+    locks.push_back({ds->second->async_lock, uid});
+  }
+  // Dependant Datasets share the lock of their parent
+  sort(locks.begin(), locks.end(), [](const pair<AsyncLock, long> &a, const pair<AsyncLock, long> &b) {
+    return a.first->id < b.first->id;
+  });
+  locks.erase(
+    unique(
+      locks.begin(),
+      locks.end(),
+      [](const pair<AsyncLock, long> &a, const pair<AsyncLock, long> &b) { return a.first == b.first; }),
+    locks.end());
+  return locks;
+}
+
 /*
  * Lock a Dataset by uid, throws when the Dataset has been destroyed.
- * There is a single global condition which allows to avoid active spinning.
- * Every time a Dataset releases a lock it must broadcast the condition.
+ * Every Dataset lock has its own condition and when a Dataset releases
+ * its lock, only one of its waiters is woken up.
  */
-AsyncLock ObjectStore::lockDataset(long uid) {
+AsyncLock ObjectStore::lockDataset(long uid, const int32_t *abort) {
   if (uid == 0) return nullptr;
   uv_scoped_mutex lock(&master_lock);
-  while (true) {
-    auto parent = uidMap<GDALDataset *>.find(uid);
-    if (parent == uidMap<GDALDataset *>.end()) { throw "Parent Dataset object has already been destroyed"; }
-    int r = uv_sem_trywait(parent->second->async_lock.get());
-    if (r == 0) { return parent->second->async_lock; }
-    uv_cond_wait(&master_sleep, &master_lock);
-  }
+  auto ds = uidMap<GDALDataset *>.find(uid);
+  if (ds == uidMap<GDALDataset *>.end()) { throw "Parent Dataset object has already been destroyed"; }
+  AsyncLock async_lock = ds->second->async_lock;
+  acquire(async_lock, uid, abort);
+  return async_lock;
 }
 
 /*
  * Lock several Datasets by uid avoiding deadlocks, same semantics as the previous one.
+ * The locks are acquired one by one in the order of their ids, so there can't be a cycle.
  */
-vector<AsyncLock> ObjectStore::lockDatasets(vector<long> uids) {
+vector<AsyncLock> ObjectStore::lockDatasets(vector<long> uids, const int32_t *abort) {
   // There is lots of copying around here but these vectors are never longer than 3 elements
   sortUnique(uids);
   if (uids.size() == 0) return {};
   uv_scoped_mutex lock(&master_lock);
-  while (true) {
-    try {
-      vector<AsyncLock> locks = _tryLockDatasets(uids);
-      if (locks.size() > 0) { return locks; }
-    } catch (const char *msg) { throw msg; }
-    uv_cond_wait(&master_sleep, &master_lock);
+  vector<AsyncLock> locked;
+  try {
+    for (const auto &l : findLocks(uids)) {
+      acquire(l.first, l.second, abort);
+      locked.push_back(l.first);
+    }
+  } catch (const char *msg) {
+    for (const AsyncLock &async_lock : locked) release(async_lock);
+    throw msg;
   }
+  return locked;
 }
 
 /*
@@ -161,47 +271,59 @@ vector<AsyncLock> ObjectStore::lockDatasets(vector<long> uids) {
 AsyncLock ObjectStore::tryLockDataset(long uid) {
   if (uid == 0) return nullptr;
   uv_scoped_mutex lock(&master_lock);
-  auto parent = uidMap<GDALDataset *>.find(uid);
-  if (parent == uidMap<GDALDataset *>.end()) { throw "Parent Dataset object has already been destroyed"; }
-  int r = uv_sem_trywait(parent->second->async_lock.get());
-  if (r == 0) return parent->second->async_lock;
-  return nullptr;
-}
-
-vector<AsyncLock> ObjectStore::_tryLockDatasets(vector<long> uids) {
-  vector<AsyncLock> locks;
-  for (long uid : uids) {
-    auto parent = uidMap<GDALDataset *>.find(uid);
-    if (parent == uidMap<GDALDataset *>.end()) { throw "Parent Dataset object has already been destroyed"; }
-    locks.push_back(parent->second->async_lock);
-  }
-  vector<AsyncLock> locked;
-  int r = 0;
-  for (AsyncLock &async_lock : locks) {
-    r = uv_sem_trywait(async_lock.get());
-    if (r == 0) {
-      locked.push_back(async_lock);
-    } else {
-      // We failed acquiring one of the locks =>
-      // free all acquired locks and start a new cycle
-      for (AsyncLock &lock : locked) { uv_sem_post(lock.get()); }
-      uv_cond_broadcast(&master_sleep);
-      break;
-    }
-  }
-  if (r == 0) return locks;
-  return {};
+  auto ds = uidMap<GDALDataset *>.find(uid);
+  if (ds == uidMap<GDALDataset *>.end()) { throw "Parent Dataset object has already been destroyed"; }
+  AsyncLock async_lock = ds->second->async_lock;
+  if (async_lock->locked) return nullptr;
+  acquire(async_lock, uid);
+  return async_lock;
 }
 
 /*
- * Try to acquire several locks avoiding deadlocks without blocking.
+ * Try to acquire several locks without blocking, all of them or none.
  */
 vector<AsyncLock> ObjectStore::tryLockDatasets(vector<long> uids) {
-  // There is lots of copying around here but these vectors are never longer than 3 elements
   sortUnique(uids);
   if (uids.size() == 0) return {};
   uv_scoped_mutex lock(&master_lock);
-  return _tryLockDatasets(uids);
+  vector<pair<AsyncLock, long>> locks = findLocks(uids);
+  for (const auto &l : locks)
+    if (l.first->locked) return {};
+  vector<AsyncLock> locked;
+  for (const auto &l : locks) {
+    acquire(l.first, l.second);
+    locked.push_back(l.first);
+  }
+  return locked;
+}
+
+void ObjectStore::unlockDataset(AsyncLock lock) {
+  uv_scoped_mutex master(&master_lock);
+  release(lock);
+}
+
+void ObjectStore::unlockDatasets(vector<AsyncLock> locks) {
+  uv_scoped_mutex master(&master_lock);
+  for (const AsyncLock &lock : locks) release(lock);
+}
+
+LockCounters ObjectStore::lockCounters() {
+  uv_scoped_mutex lock(&master_lock);
+  return counters;
+}
+
+bool ObjectStore::lockCounters(long uid, LockCounters &r) {
+  uv_scoped_mutex lock(&master_lock);
+  auto ds = uidMap<GDALDataset *>.find(uid);
+  if (ds == uidMap<GDALDataset *>.end()) return false;
+  r = ds->second->async_lock->counters;
+  return true;
+}
+
+void ObjectStore::resetLockCounters() {
+  uv_scoped_mutex lock(&master_lock);
+  counters = LockCounters();
+  for (const auto &ds : uidMap<GDALDataset *>) ds.second->async_lock->counters = LockCounters();
 }
 
 // The basic unit of the ObjectStore is the ObjectStoreItem<GDALPTR>
@@ -220,58 +342,67 @@ ObjectStoreItem<GDALDataset *>::ObjectStoreItem(Nan::Persistent<Object> &obj) :
 ObjectStoreItem<OGRLayer *>::ObjectStoreItem(Nan::Persistent<Object> &obj) : obj(obj) {
 }
 
-template <typename GDALPTR> long ObjectStore::add(GDALPTR ptr, Nan::Persistent<Object> &obj, long parent_uid) {
-  uv_scoped_mutex lock(&master_lock);
+// Main thread only, without locking, see above
+template <typename GDALPTR>
+shared_ptr<ObjectStoreItem<GDALPTR>> ObjectStore::newItem(GDALPTR ptr, Nan::Persistent<Object> &obj, long parent_uid) {
   shared_ptr<ObjectStoreItem<GDALPTR>> item(new ObjectStoreItem<GDALPTR>(obj));
   item->uid = uid++;
   if (parent_uid) {
-    shared_ptr<ObjectStoreItem<GDALDataset *>> parent = uidMap<GDALDataset *>[parent_uid];
+    // find() as operator[] would modify the map read by the worker threads
+    shared_ptr<ObjectStoreItem<GDALDataset *>> parent = uidMap<GDALDataset *>.find(parent_uid)->second;
     item->parent = parent;
     parent->children.push_back(item->uid);
   } else {
     item->parent = nullptr;
   }
   item->ptr = ptr;
+  LOG("ObjectStore: Add %s [%ld]<[%ld]", typeid(ptr).name(), item->uid, parent_uid);
+  return item;
+}
 
+template <typename GDALPTR> long ObjectStore::add(GDALPTR ptr, Nan::Persistent<Object> &obj, long parent_uid) {
+  shared_ptr<ObjectStoreItem<GDALPTR>> item = newItem(ptr, obj, parent_uid);
   uidMap<GDALPTR>[item->uid] = item;
   ptrMap<GDALPTR>[ptr] = item;
-  LOG("ObjectStore: Add %s [%ld]<[%ld]", typeid(ptr).name(), item->uid, parent_uid);
   return item->uid;
 }
 
 // Creating a Layer object is a special case - it can contain SQL results
 long ObjectStore::add(OGRLayer *ptr, Nan::Persistent<Object> &obj, long parent_uid, bool is_result_set) {
-  long uid = ObjectStore::add<OGRLayer *>(ptr, obj, parent_uid);
-  uidMap<OGRLayer *>[uid] -> is_result_set = is_result_set;
-  return uid;
+  shared_ptr<ObjectStoreItem<OGRLayer *>> item = newItem(ptr, obj, parent_uid);
+  item->is_result_set = is_result_set;
+  uidMap<OGRLayer *>[item->uid] = item;
+  ptrMap<OGRLayer *>[ptr] = item;
+  return item->uid;
 }
 
 // Creating a Dataset object is a special case
 // It contains a lock (unless it is a dependant Dataset)
+// and it becomes visible to the worker threads
 long ObjectStore::add(GDALDataset *ptr, Nan::Persistent<Object> &obj, long parent_uid) {
-  long uid = ObjectStore::add<GDALDataset *>(ptr, obj, parent_uid);
+  shared_ptr<ObjectStoreItem<GDALDataset *>> item = newItem(ptr, obj, parent_uid);
   if (parent_uid == 0) {
-    uidMap<GDALDataset *>[uid] -> async_lock = shared_ptr<uv_sem_t>(new uv_sem_t(), uv_sem_deleter());
-    uv_sem_init(uidMap<GDALDataset *>[uid] -> async_lock.get(), 1);
+    item->async_lock = make_shared<DatasetLock>(item->uid);
   } else {
-    uidMap<GDALDataset *>[uid] -> async_lock = uidMap<GDALDataset *>[parent_uid] -> async_lock;
+    item->async_lock = item->parent->async_lock;
   }
-  return uid;
+  uv_scoped_mutex lock(&master_lock);
+  uidMap<GDALDataset *>[item->uid] = item;
+  ptrMap<GDALDataset *>[ptr] = item;
+  return item->uid;
 }
 
+// Main thread only, without locking, see above
 template <typename GDALPTR> bool ObjectStore::has(GDALPTR ptr) {
-  uv_scoped_mutex lock(&master_lock);
   return ptrMap<GDALPTR>.count(ptr) > 0;
 }
 template <typename GDALPTR> Local<Object> ObjectStore::get(GDALPTR ptr) {
-  uv_scoped_mutex lock(&master_lock);
   Nan::EscapableHandleScope scope;
-  return scope.Escape(Nan::New(ptrMap<GDALPTR>[ptr] -> obj));
+  return scope.Escape(Nan::New(ptrMap<GDALPTR>.find(ptr)->second->obj));
 }
 template <typename GDALPTR> Local<Object> ObjectStore::get(long uid) {
-  uv_scoped_mutex lock(&master_lock);
   Nan::EscapableHandleScope scope;
-  return scope.Escape(Nan::New(uidMap<GDALPTR>[uid] -> obj));
+  return scope.Escape(Nan::New(uidMap<GDALPTR>.find(uid)->second->obj));
 }
 
 // Explicit instantiation:
@@ -310,12 +441,9 @@ template Local<Object> ObjectStore::get(shared_ptr<GDALMDArray>);
 #endif
 
 const char warningGCBug[] =
-  "Sleeping on semaphore in garbage collector, this is a bug in gdal-async, event loop blocked for ";
+  "Sleeping on a dataset lock in garbage collector, this is a bug in gdal-async, event loop blocked for ";
 const char warningManualClose[] =
   "Closing a dataset while background async operations are still running, event loop blocked for ";
-static inline void uv_sem_wait_with_warning(uv_sem_t *sem, const char *warning) {
-  if (uv_sem_trywait(sem) != 0) { MEASURE_EXECUTION_TIME(warning, uv_sem_wait(sem)); }
-}
 
 // dispose is called by the C++ destructor which is called by Nan::ObjectWrap
 // which is called by the WeakCallback of the GC on its Persistent
@@ -324,16 +452,15 @@ static inline void uv_sem_wait_with_warning(uv_sem_t *sem, const char *warning)
 
 // Disposing a Dataset is a special case - it has children (called with the master lock held)
 template <> void ObjectStore::dispose(shared_ptr<ObjectStoreItem<GDALDataset *>> item, bool manual) {
-  uv_sem_wait_with_warning(
-    item->async_lock.get(), manual ? (eventLoopWarn ? warningManualClose : nullptr) : warningGCBug);
   uidMap<GDALDataset *>.erase(item->uid);
   ptrMap<GDALDataset *>.erase(item->ptr);
+  waitUnlocked(item->async_lock, manual ? (eventLoopWarn ? warningManualClose : nullptr) : warningGCBug);
   if (item->parent != nullptr) item->parent->children.remove(item->uid);
 
-  uv_sem_post(item->async_lock.get());
-  uv_cond_broadcast(&master_sleep);
   // Beyond this point the Dataset is not alive anymore ->
-  // anyone who was waiting for this semaphore should fail
+  // anyone who was waiting for this lock should fail
+  // (or go back to sleep if it is the lock of another Dataset)
+  uv_cond_broadcast(&item->async_lock->unlocked);
 
   // All the children are removed from the ObjectStore
   // but the Node/V8 objects still exist
@@ -343,13 +470,15 @@ template <> void ObjectStore::dispose(shared_ptr<ObjectStoreItem<GDALDataset *>>
 
   if (item->ptr) {
     LOG("Closing GDALDataset %ld [%p]", item->uid, item->ptr);
+    // GDAL waits for the locked blocks when closing
+    BlockCache::Unpin(item->uid);
     GDALClose(item->ptr);
     item->ptr = nullptr;
   }
 }
 
 const char warningSQL[] =
-  "Sleeping on semaphore in garbage collector while destroying an SQL results layers, this is a known issue in gdal-async, event loop blocked for ";
+  "Sleeping on a dataset lock in garbage collector while destroying an SQL results layers, this is a known issue in gdal-async, event loop blocked for ";
 // Closing a Layer is a special case - it can contain SQL results
 // This is the only case where we could sleep in the GC:
 //   A Dataset has multiple layers, one of them is an SQL results layer
@@ -362,11 +491,13 @@ template <> void ObjectStore::dispose(shared_ptr<ObjectStoreItem<OGRLayer *>> it
   if (item->is_result_set) {
     LOG("Closing OGRLayer with SQL results [%ld] [%p]", uid, item->ptr);
     if (item->parent) {
-      uv_sem_wait_with_warning(item->parent->async_lock.get(), warningSQL);
+      // The result set has been removed from the store, so no new job can use it,
+      // but jobs on its Dataset can still lock it while waitUnlocked() sleeps,
+      // it returns with the master lock held and the Dataset lock free,
+      // so no job can run on the Dataset before the result set has been released
+      waitUnlocked(item->parent->async_lock, warningSQL);
       GDALDataset *parent_ds = item->parent->ptr;
       parent_ds->ReleaseResultSet(item->ptr);
-      uv_sem_post(item->parent->async_lock.get());
-      uv_cond_broadcast(&object_store.master_sleep);
     }
   }
 }
@@ -17,12 +17,39 @@
 #include <list>
 #include <map>
 
+#include "abort_flag.hpp"
+
 using namespace v8;
 using namespace std;
 
 namespace node_gdal {
 
-typedef shared_ptr<uv_sem_t> AsyncLock;
+// Contention counters of the Dataset locks, times in microseconds
+struct LockCounters {
+  double acquisitions;
+  double contended;
+  double wakeups;
+  double wait;
+  double maxWait;
+  LockCounters();
+  void add(bool contended, double wait);
+};
+
+// The lock of a Dataset, shared with its dependant Datasets
+// All its fields are protected by the master lock
+struct DatasetLock {
+  // The uid of the Dataset that created it, the locks are always acquired in this order
+  const long id;
+  bool locked;
+  // The threads waiting for this lock sleep on its own condition
+  unsigned waiting;
+  uv_cond_t unlocked;
+  LockCounters counters;
+  DatasetLock(long id);
+  ~DatasetLock();
+};
+
+typedef shared_ptr<DatasetLock> AsyncLock;
 
 template <typename GDALPTR> struct ObjectStoreItem {
   long uid;
@@ -51,10 +78,6 @@ template <> struct ObjectStoreItem<GDALDataset *> {
   ObjectStoreItem(Nan::Persistent<Object> &obj);
 };
 
-struct uv_sem_deleter {
-  void operator()(uv_sem_t *p);
-};
-
 class ObjectStore {
     public:
   template <typename GDALPTR> long add(GDALPTR ptr, Nan::Persistent<Object> &obj, long parent_uid);
@@ -63,23 +86,10 @@ class ObjectStore {
 
   void dispose(long uid, bool manual = false);
   bool isAlive(long uid);
-  inline void lockDataset(AsyncLock lock) {
-    uv_sem_wait(lock.get());
-  }
-  inline void unlockDataset(AsyncLock lock) {
-    uv_sem_post(lock.get());
-    uv_mutex_lock(&master_lock);
-    uv_cond_broadcast(&master_sleep);
-    uv_mutex_unlock(&master_lock);
-  }
-  inline void unlockDatasets(vector<AsyncLock> locks) {
-    for (const AsyncLock &l : locks) uv_sem_post(l.get());
-    uv_mutex_lock(&master_lock);
-    uv_cond_broadcast(&master_sleep);
-    uv_mutex_unlock(&master_lock);
-  }
-  AsyncLock lockDataset(long uid);
-  vector<AsyncLock> lockDatasets(vector<long> uids);
+  void unlockDataset(AsyncLock lock);
+  void unlockDatasets(vector<AsyncLock> locks);
+  AsyncLock lockDataset(long uid, const int32_t *abort = nullptr);
+  vector<AsyncLock> lockDatasets(vector<long> uids, const int32_t *abort = nullptr);
   AsyncLock tryLockDataset(long uid);
   vector<AsyncLock> tryLockDatasets(vector<long> uids);
 
@@ -87,6 +97,10 @@ class ObjectStore {
   template <typename GDALPTR> Local<Object> get(GDALPTR ptr);
   template <typename GDALPTR> Local<Object> get(long uid);
 
+  LockCounters lockCounters();
+  bool lockCounters(long uid, LockCounters &counters);
+  void resetLockCounters();
+
   void cleanup();
 
   ObjectStore();
@@ -95,8 +109,13 @@ class ObjectStore {
     private:
   long uid;
   uv_mutex_t master_lock;
-  uv_cond_t master_sleep;
-  vector<AsyncLock> _tryLockDatasets(vector<long> uids);
+  LockCounters counters;
+  vector<pair<AsyncLock, long>> findLocks(const vector<long> &uids);
+  void acquire(const AsyncLock &lock, long uid, const int32_t *abort = nullptr);
+  void release(const AsyncLock &lock);
+  void waitUnlocked(const AsyncLock &lock, const char *warning);
+  template <typename GDALPTR>
+  shared_ptr<ObjectStoreItem<GDALPTR>> newItem(GDALPTR ptr, Nan::Persistent<Object> &obj, long parent_uid);
   template <typename GDALPTR> void dispose(shared_ptr<ObjectStoreItem<GDALPTR>> item, bool manual);
   void do_dispose(long uid, bool manual = false);
 };
@@ -0,0 +1,169 @@
+#include "raster_sampler.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <utility>
+
+namespace node_gdal {
+
+bool ParseSampleInterpolation(const std::string &name, SampleInterpolation &interpolation) {
+  if (name == "nearest") {
+    interpolation = SampleNearest;
+  } else if (name == "bilinear") {
+    interpolation = SampleBilinear;
+  } else if (name == "cubic") {
+    interpolation = SampleCubic;
+  } else {
+    return false;
+  }
+  return true;
+}
+
+// Reads pixels from the blocks of a band, keeping the blocks it has
+// used locked in the block cache until release()
+class BlockFetcher {
+    public:
+  BlockFetcher(GDALRasterBand *band) : band(band), type(band->GetRasterDataType()) {
+    band->GetBlockSize(&bw, &bh);
+    type_size = GDALGetDataTypeSizeBytes(type);
+    int has_nodata = 0;
+    nodata = band->GetNoDataValue(&has_nodata);
+    check_nodata = has_nodata && !std::isnan(nodata);
+  }
+  ~BlockFetcher() {
+    release();
+  }
+
+  // x and y must be inside the raster, returns NaN for noData
+  double get(int x, int y) {
+    const int bx = x / bw, by = y / bh;
+    GDALRasterBlock *block = nullptr;
+    for (const auto &h : held)
+      if (h.first.first == bx && h.first.second == by) {
+        block = h.second;
+        break;
+      }
+    if (block == nullptr) {
+      CPLErrorReset();
+      block = band->GetLockedBlockRef(bx, by);
+      if (block == nullptr) throw CPLGetLastErrorMsg();
+      held.push_back({{bx, by}, block});
+    }
+    const size_t offset = static_cast<size_t>(y - by * bh) * bw + (x - bx * bw);
+    double v;
+    GDALCopyWords(
+      static_cast<GByte *>(block->GetDataRef()) + offset * type_size, type, 0, &v, GDT_Float64, 0, 1);
+    if (check_nodata && v == nodata) return std::numeric_limits<double>::quiet_NaN();
+    return v;
+  }
+
+  void release() {
+    for (const auto &h : held) h.second->DropLock();
+    held.clear();
+  }
+
+    private:
+  GDALRasterBand *band;
+  GDALDataType type;
+  int bw, bh, type_size;
+  double nodata;
+  bool check_nodata;
+  std::vector<std::pair<std::pair<int, int>, GDALRasterBlock *>> held;
+};
+
+// Keys cubic convolution kernel with a = -0.5 (Catmull-Rom), as GDAL's CUBIC resampling
+static inline double cubicWeight(double t) {
+  t = std::fabs(t);
+  if (t < 1) return (1.5 * t - 2.5) * t * t + 1;
+  if (t < 2) return ((-0.5 * t + 2.5) * t - 4) * t + 2;
+  return 0;
+}
+
+static double sampleAt(BlockFetcher &fetcher, int w, int h, double x, double y, SampleInterpolation interpolation) {
+  const double nearest = fetcher.get(static_cast<int>(std::floor(x)), static_cast<int>(std::floor(y)));
+  if (interpolation == SampleNearest) return nearest;
+
+  // The kernel is centered on the pixel centers, clamped at the edges of the raster
+  const double fx = x - 0.5, fy = y - 0.5;
+  const int x0 = static_cast<int>(std::floor(fx)), y0 = static_cast<int>(std::floor(fy));
+  const double dx = fx - x0, dy = fy - y0;
+  const int first = interpolation == SampleBilinear ? 0 : -1;
+  const int last = interpolation == SampleBilinear ? 1 : 2;
+
+  double wx[4], wy[4];
+  for (int k = first; k <= last; k++) {
+    wx[k - first] = interpolation == SampleBilinear ? (k == 0 ? 1 - dx : dx) : cubicWeight(k - dx);
+    wy[k - first] = interpolation == SampleBilinear ? (k == 0 ? 1 - dy : dy) : cubicWeight(k - dy);
+  }
+
+  double sum = 0;
+  for (int j = first; j <= last; j++) {
+    const int py = std::min(std::max(y0 + j, 0), h - 1);
+    double row = 0;
+    for (int i = first; i <= last; i++) {
+      const int px = std::min(std::max(x0 + i, 0), w - 1);
+      const double v = fetcher.get(px, py);
+      if (std::isnan(v)) return nearest;
+      row += wx[i - first] * v;
+    }
+    sum += wy[j - first] * row;
+  }
+  return sum;
+}
+
+void SampleBands(
+  const std::vector<GDALRasterBand *> &bands,
+  const double *xs,
+  const double *ys,
+  size_t n,
+  SampleInterpolation interpolation,
+  double *out) {
+  if (bands.size() == 0) return;
+  const int w = bands[0]->GetXSize();
+  const int h = bands[0]->GetYSize();
+  for (GDALRasterBand *band : bands)
+    if (band->GetXSize() != w || band->GetYSize() != h) throw "All raster bands dimensions must match";
+
+  // Order the samples inside the raster by the block of the first band that contains them
+  int bw, bh;
+  bands[0]->GetBlockSize(&bw, &bh);
+  const size_t blocks_x = static_cast<size_t>((w + bw - 1) / bw);
+  std::vector<std::pair<size_t, size_t>> order;
+  order.reserve(n);
+  for (size_t i = 0; i < n; i++) {
+    const double x = xs[i], y = ys[i];
+    if (!(x >= 0 && x < w && y >= 0 && y < h)) {
+      for (size_t b = 0; b < bands.size(); b++) out[b * n + i] = std::numeric_limits<double>::quiet_NaN();
+      continue;
+    }
+    const size_t block = (static_cast<size_t>(y) / bh) * blocks_x + static_cast<size_t>(x) / bw;
+    order.push_back({block, i});
+  }
+  std::sort(order.begin(), order.end());
+
+  for (size_t b = 0; b < bands.size(); b++) {
+    BlockFetcher fetcher(bands[b]);
+    double *band_out = out + b * n;
+    for (size_t k = 0; k < order.size(); k++) {
+      // The blocks are kept locked only while their samples are processed
+      if (k > 0 && order[k].first != order[k - 1].first) fetcher.release();
+      const size_t i = order[k].second;
+      band_out[i] = sampleAt(fetcher, w, h, xs[i], ys[i], interpolation);
+    }
+  }
+}
+
+void GeoToPixel(GDALDataset *ds, double *xs, double *ys, size_t n) {
+  double gt[6] = {0, 1, 0, 0, 0, 1};
+  ds->GetGeoTransform(gt);
+  double inv[6];
+  if (!GDALInvGeoTransform(gt, inv)) throw "The geotransform of the raster is not invertible";
+  for (size_t i = 0; i < n; i++) {
+    const double x = xs[i], y = ys[i];
+    xs[i] = inv[0] + x * inv[1] + y * inv[2];
+    ys[i] = inv[3] + x * inv[4] + y * inv[5];
+  }
+}
+
+} // namespace node_gdal
@@ -0,0 +1,43 @@
+#ifndef __NODE_GDAL_RASTER_SAMPLER_H__
+#define __NODE_GDAL_RASTER_SAMPLER_H__
+
+// gdal
+#include <gdal_priv.h>
+
+#include <string>
+#include <vector>
+
+namespace node_gdal {
+
+// Point sampling of raster bands
+//
+// The samples are sorted by the block that contains them and each block
+// is fetched once from the block cache for all the samples that need it,
+// instead of one RasterIO of a 1x1 window per sample
+
+enum SampleInterpolation { SampleNearest, SampleBilinear, SampleCubic };
+
+// Returns false if the interpolation is not supported
+bool ParseSampleInterpolation(const std::string &name, SampleInterpolation &interpolation);
+
+// Samples the bands at the n points (xs[i], ys[i]) in pixel/line coordinates,
+// the value of band b at point i is stored in out[b * n + i]
+// The points outside the raster and the noData pixels produce NaN,
+// the interpolation falls back to the nearest pixel when a pixel of its kernel is noData
+// All the bands must have the same size
+// Throws const char * on error
+void SampleBands(
+  const std::vector<GDALRasterBand *> &bands,
+  const double *xs,
+  const double *ys,
+  size_t n,
+  SampleInterpolation interpolation,
+  double *out);
+
+// Converts the n points from georeferenced to pixel/line coordinates in place
+// Throws const char * if the geotransform is not invertible
+void GeoToPixel(GDALDataset *ds, double *xs, double *ys, size_t n);
+
+} // namespace node_gdal
+
+#endif
@@ -0,0 +1,211 @@
+#include "sync_profile.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <map>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace node_gdal {
+
+namespace SyncProfile {
+
+bool enabled = false;
+
+static double threshold = 1000;
+static std::string libPath;
+
+struct SlowCalls {
+  double calls;
+  double total;
+  double max;
+};
+
+// (binding, call site) -> slow calls, bounded to not grow forever with generated code
+static const size_t maxSites = 1024;
+static std::map<std::pair<std::string, std::string>, SlowCalls> slow;
+
+Local<Value> Method(Nan::FunctionCallback method, const char *name) {
+  return Nan::New<External>(new Binding{method, nullptr, name});
+}
+
+Local<Value> Getter(Nan::GetterCallback getter, const char *name) {
+  return Nan::New<External>(new Binding{nullptr, getter, name});
+}
+
+// Class.name, the receiver being an instance, a constructor or the module
+static std::string label(Local<Object> self, const char *name) {
+  std::string cls;
+  if (self->IsFunction()) {
+    cls = *Nan::Utf8String(self.As<Function>()->GetName());
+  } else {
+    cls = *Nan::Utf8String(self->GetConstructorName());
+    if (cls == "Object") cls = "gdal";
+  }
+  return cls + "." + name;
+}
+
+// The first JS frame that is not in lib/
+static std::string callSite() {
+  Isolate *isolate = Isolate::GetCurrent();
+  Local<StackTrace> trace = StackTrace::CurrentStackTrace(isolate, 8, StackTrace::kOverview);
+  for (int i = 0; i < trace->GetFrameCount(); i++) {
+    Local<StackFrame> frame = trace->GetFrame(isolate, i);
+    Local<String> script = frame->GetScriptName();
+    std::string file = script.IsEmpty() ? "<anonymous>" : *Nan::Utf8String(script);
+    if (!libPath.empty() && file.compare(0, libPath.size(), libPath) == 0) continue;
+
+    std::string site = file + ":" + std::to_string(frame->GetLineNumber()) + ":" + std::to_string(frame->GetColumn());
+    Local<String> fn = frame->GetFunctionName();
+    if (!fn.IsEmpty() && fn->Length() > 0) site = std::string(*Nan::Utf8String(fn)) + " (" + site + ")";
+    return site;
+  }
+  return "<native>";
+}
+
+static void record(Local<Object> self, const char *name, double us) {
+  auto key = std::make_pair(label(self, name), callSite());
+  auto it = slow.find(key);
+  if (it == slow.end()) {
+    if (slow.size() >= maxSites) return;
+    it = slow.insert({key, {0, 0, 0}}).first;
+  }
+  it->second.calls++;
+  it->second.total += us;
+  it->second.max = std::max(it->second.max, us);
+}
+
+static inline double elapsed(const std::chrono::steady_clock::time_point &start) {
+  return std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+}
+
+NAN_METHOD(MethodTrampoline) {
+  Binding *binding = reinterpret_cast<Binding *>(info.Data().As<External>()->Value());
+  if (!enabled) {
+    binding->method(info);
+    return;
+  }
+  auto start = std::chrono::steady_clock::now();
+  binding->method(info);
+  double us = elapsed(start);
+  if (us >= threshold) record(info.This(), binding->name, us);
+}
+
+NAN_GETTER(GetterTrampoline) {
+  Binding *binding = reinterpret_cast<Binding *>(info.Data().As<External>()->Value());
+  if (!enabled) {
+    binding->getter(property, info);
+    return;
+  }
+  auto start = std::chrono::steady_clock::now();
+  binding->getter(property, info);
+  double us = elapsed(start);
+  if (us >= threshold) record(info.This(), binding->name, us);
+}
+
+/**
+ * @typedef {object} ProfileSyncOptions
+ * @property {number} [thresholdUs]
+ */
+
+/**
+ * Starts or stops the profiling of the synchronous calls.
+ *
+ * When enabled, every call of a method or a getter of the bindings that
+ * blocks the event loop for longer than `thresholdUs` microseconds is
+ * recorded with the JS location it was called from. Use this to find
+ * the synchronous calls that should be replaced by their async versions.
+ *
+ * Starting the profiler clears the previously recorded calls,
+ * stopping it preserves them for {@link syncProfile}.
+ *
+ * @example
+ * gdal.profileSync({ thresholdUs: 500 })
+ * await handleRequests()
+ * console.table(gdal.syncProfile().slice(0, 10))
+ * gdal.profileSync(false)
+ *
+ * @static
+ * @method profileSync
+ * @param {ProfileSyncOptions|false} options `false` to stop the profiler
+ * @param {number} [options.thresholdUs=1000] The minimum duration of the recorded calls in microseconds
+ * @return {void}
+ */
+NAN_METHOD(profileSync) {
+  if (info.Length() > 0 && info[0]->IsFalse()) {
+    enabled = false;
+    return;
+  }
+
+  double thresholdUs = 1000;
+  if (info.Length() > 0 && !info[0]->IsUndefined() && !info[0]->IsNull()) {
+    if (!info[0]->IsObject()) {
+      Nan::ThrowTypeError("options must be an object or false");
+      return;
+    }
+    Local<Object> options = info[0].As<Object>();
+    Local<Value> val = Nan::Get(options, Nan::New("thresholdUs").ToLocalChecked()).ToLocalChecked();
+    if (!val->IsUndefined()) {
+      if (!val->IsNumber() || Nan::To<double>(val).ToChecked() < 0) {
+        Nan::ThrowTypeError("thresholdUs must be a positive number");
+        return;
+      }
+      thresholdUs = Nan::To<double>(val).ToChecked();
+    }
+  }
+
+  threshold = thresholdUs;
+  slow.clear();
+  enabled = true;
+}
+
+/**
+ * @typedef {object} SyncProfileEntry
+ * @property {string} method
+ * @property {string} site
+ * @property {number} calls
+ * @property {number} total
+ * @property {number} max
+ */
+
+/**
+ * Returns the synchronous calls recorded by {@link profileSync} aggregated
+ * by binding (`Class.method`) and by call site (`function (file:line:column)`),
+ * the slowest first by total time.
+ *
+ * `total` and `max` are in milliseconds. The number of distinct call sites
+ * is limited to 1024, the calls from new sites beyond that are ignored.
+ *
+ * @static
+ * @method syncProfile
+ * @return {SyncProfileEntry[]}
+ */
+NAN_METHOD(syncProfile) {
+  typedef std::pair<const std::pair<std::string, std::string> *, const SlowCalls *> Entry;
+  std::vector<Entry> sorted;
+  for (const auto &entry : slow) sorted.push_back({&entry.first, &entry.second});
+  std::sort(
+    sorted.begin(), sorted.end(), [](const Entry &a, const Entry &b) { return a.second->total > b.second->total; });
+
+  Local<Array> result = Nan::New<Array>(sorted.size());
+  for (size_t i = 0; i < sorted.size(); i++) {
+    Local<Object> obj = Nan::New<Object>();
+    Nan::Set(obj, Nan::New("method").ToLocalChecked(), Nan::New(sorted[i].first->first).ToLocalChecked());
+    Nan::Set(obj, Nan::New("site").ToLocalChecked(), Nan::New(sorted[i].first->second).ToLocalChecked());
+    Nan::Set(obj, Nan::New("calls").ToLocalChecked(), Nan::New<Number>(sorted[i].second->calls));
+    Nan::Set(obj, Nan::New("total").ToLocalChecked(), Nan::New<Number>(sorted[i].second->total / 1000));
+    Nan::Set(obj, Nan::New("max").ToLocalChecked(), Nan::New<Number>(sorted[i].second->max / 1000));
+    Nan::Set(result, i, obj);
+  }
+  info.GetReturnValue().Set(result);
+}
+
+// The frames in lib/ are skipped when looking for the call site
+NAN_METHOD(setLibPath) {
+  libPath = *Nan::Utf8String(info[0]);
+}
+
+} // namespace SyncProfile
+
+} // namespace node_gdal
@@ -0,0 +1,46 @@
+#ifndef __NODE_GDAL_SYNC_PROFILE_H__
+#define __NODE_GDAL_SYNC_PROFILE_H__
+
+// node
+#include <node.h>
+
+// nan
+#include "../nan-wrapper.h"
+
+using namespace v8;
+
+namespace node_gdal {
+
+// Profiler of the time spent on the main thread by the bindings
+//
+// All the methods and getters registered with the Nan__* / ATTR* macros
+// go through a trampoline that receives the real callback in its data,
+// when the profiler is enabled the calls slower than the threshold are
+// aggregated by binding and by JS call site
+
+namespace SyncProfile {
+
+struct Binding {
+  Nan::FunctionCallback method;
+  Nan::GetterCallback getter;
+  const char *name;
+};
+
+extern bool enabled;
+
+// The data of the trampolines, allocated once per registration
+Local<Value> Method(Nan::FunctionCallback method, const char *name);
+Local<Value> Getter(Nan::GetterCallback getter, const char *name);
+
+NAN_METHOD(MethodTrampoline);
+NAN_GETTER(GetterTrampoline);
+
+NAN_METHOD(profileSync);
+NAN_METHOD(syncProfile);
+NAN_METHOD(setLibPath);
+
+} // namespace SyncProfile
+
+} // namespace node_gdal
+
+#endif
@@ -0,0 +1,524 @@
+#include "tile_pyramid.hpp"
+#include "parallel.hpp"
+
+// gdal
+#include <cpl_conv.h>
+#include <cpl_string.h>
+#include <cpl_vsi.h>
+#include <gdal_alg.h>
+#include <gdalwarper.h>
+#include <ogr_spatialref.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstring>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <utility>
+
+#if GDAL_VERSION_MAJOR > 2 || (GDAL_VERSION_MAJOR == 2 && GDAL_VERSION_MINOR >= 3)
+#define GDALDatasetToHandle(x) GDALDataset::ToHandle(x)
+#define GDALDatasetFromHandle(x) GDALDataset::FromHandle(x)
+#else
+#define GDALDatasetToHandle(x) static_cast<GDALDatasetH>(x)
+#define GDALDatasetFromHandle(x) static_cast<GDALDataset *>(x)
+#endif
+
+namespace node_gdal {
+
+// Half of the extent of the EPSG:3857 world
+static const double webMercatorOrigin = 20037508.342789244;
+
+typedef std::pair<int, int> TileXY;
+
+// The tiles covering the source at a zoom level, inclusive
+struct TileRange {
+  int x0, y0, x1, y1;
+
+  TileRange() : x0(0), y0(0), x1(-1), y1(-1) {
+  }
+  size_t count() const {
+    return static_cast<size_t>(x1 - x0 + 1) * (y1 - y0 + 1);
+  }
+  bool contains(int x, int y) const {
+    return x >= x0 && x <= x1 && y >= y0 && y <= y1;
+  }
+};
+
+// Everything that is common to all the threads
+struct TileLayout {
+  int tile_size;
+  // The source bands copied to the first bands of the tiles
+  std::vector<int> src_bands;
+  int src_alpha;
+  // All the bands of a tile, the last one is the alpha band
+  int bands;
+  GDALDataType type;
+  int type_size;
+  std::string src_wkt;
+  std::string dst_wkt;
+  std::vector<double> src_nodata;
+  std::vector<int> src_has_nodata;
+
+  size_t tileBytes() const {
+    return static_cast<size_t>(bands) * tile_size * tile_size * type_size;
+  }
+};
+
+// Everything a thread needs to render and encode tiles,
+// GDAL datasets cannot be shared between threads
+struct TileRenderer {
+  GDALDataset *src;
+  bool owns_src;
+  GDALDataset *mem;
+  void *gen_transformer;
+  void *transformer;
+  std::unique_ptr<GDALWarpOperation> warper;
+  std::string tmp;
+  std::vector<double> in, out;
+
+  TileRenderer() : src(nullptr), owns_src(false), mem(nullptr), gen_transformer(nullptr), transformer(nullptr) {
+  }
+  ~TileRenderer() {
+    warper.reset();
+    if (transformer != nullptr) GDALDestroyApproxTransformer(transformer);
+    if (gen_transformer != nullptr) GDALDestroyGenImgProjTransformer(gen_transformer);
+    if (mem != nullptr) GDALClose(GDALDatasetToHandle(mem));
+    if (owns_src && src != nullptr) GDALClose(GDALDatasetToHandle(src));
+  }
+};
+
+static double tileExtent(int z) {
+  return 2 * webMercatorOrigin / static_cast<double>(1 << z);
+}
+
+static void initRenderer(TileRenderer &r, const TileLayout &layout, const TilePyramidOptions &options) {
+  const int ts = layout.tile_size;
+
+  GDALDriver *mem_driver = GetGDALDriverManager()->GetDriverByName("MEM");
+  if (mem_driver == nullptr) throw "MEM driver not available";
+  r.mem = mem_driver->Create("", ts, ts, layout.bands, layout.type, nullptr);
+  if (r.mem == nullptr) throw CPLGetLastErrorMsg();
+  r.tmp = CPLSPrintf("/vsimem/_node_gdal_tile_%p", static_cast<void *>(&r));
+
+  // The destination geotransform is set for each tile
+  r.gen_transformer = GDALCreateGenImgProjTransformer(
+    GDALDatasetToHandle(r.src), layout.src_wkt.c_str(), nullptr, layout.dst_wkt.c_str(), TRUE, 1000.0, 0);
+  if (r.gen_transformer == nullptr) throw CPLGetLastErrorMsg();
+  // This is the gdalwarp default
+  r.transformer = GDALCreateApproxTransformer(GDALGenImgProjTransform, r.gen_transformer, 0.125);
+  if (r.transformer == nullptr) throw CPLGetLastErrorMsg();
+
+  const int n = static_cast<int>(layout.src_bands.size());
+  GDALWarpOptions *wo = GDALCreateWarpOptions();
+  wo->eResampleAlg = options.resampling;
+  wo->hSrcDS = GDALDatasetToHandle(r.src);
+  wo->hDstDS = GDALDatasetToHandle(r.mem);
+  wo->nBandCount = n;
+  wo->panSrcBands = static_cast<int *>(CPLMalloc(sizeof(int) * n));
+  wo->panDstBands = static_cast<int *>(CPLMalloc(sizeof(int) * n));
+  for (int i = 0; i < n; i++) {
+    wo->panSrcBands[i] = layout.src_bands[i];
+    wo->panDstBands[i] = i + 1;
+    if (layout.src_has_nodata[i]) {
+      if (wo->padfSrcNoDataReal == nullptr) {
+        wo->padfSrcNoDataReal = static_cast<double *>(CPLMalloc(sizeof(double) * n));
+        wo->padfSrcNoDataImag = static_cast<double *>(CPLMalloc(sizeof(double) * n));
+        for (int j = 0; j < n; j++) {
+          wo->padfSrcNoDataReal[j] = -1.1e20;
+          wo->padfSrcNoDataImag[j] = 0.0;
+        }
+      }
+      wo->padfSrcNoDataReal[i] = layout.src_nodata[i];
+    }
+  }
+  wo->nSrcAlphaBand = layout.src_alpha;
+  wo->nDstAlphaBand = layout.bands;
+  // Do not read back the previous tile
+  wo->papszWarpOptions = CSLSetNameValue(nullptr, "INIT_DEST", "0");
+  wo->pfnTransformer = GDALApproxTransform;
+  wo->pTransformerArg = r.transformer;
+
+  r.warper.reset(new GDALWarpOperation());
+  CPLErr err = r.warper->Initialize(wo);
+  // The warp operation has its own copy, the transformer is not destroyed
+  GDALDestroyWarpOptions(wo);
+  if (err != CE_None) throw CPLGetLastErrorMsg();
+}
+
+static void renderTile(TileRenderer &r, const TileLayout &layout, int z, int x, int y, std::vector<GByte> &data) {
+  const int ts = layout.tile_size;
+  const double extent = tileExtent(z);
+  const double gt[6] = {
+    -webMercatorOrigin + x * extent, extent / ts, 0, webMercatorOrigin - y * extent, 0, -extent / ts};
+  GDALSetGenImgProjTransformerDstGeoTransform(r.gen_transformer, gt);
+
+  CPLErrorReset();
+  if (r.warper->ChunkAndWarpImage(0, 0, ts, ts) != CE_None) throw CPLGetLastErrorMsg();
+
+  data.resize(layout.tileBytes());
+  CPLErr err = r.mem->RasterIO(
+    GF_Read, 0, 0, ts, ts, data.data(), ts, ts, layout.type, layout.bands, nullptr, 0, 0, 0, nullptr);
+  if (err != CE_None) throw CPLGetLastErrorMsg();
+}
+
+static bool isTransparent(TileRenderer &r, const TileLayout &layout, const std::vector<GByte> &data) {
+  const size_t plane = static_cast<size_t>(layout.tile_size) * layout.tile_size;
+  r.in.resize(plane);
+  GDALCopyWords(
+    data.data() + (layout.bands - 1) * plane * layout.type_size,
+    layout.type,
+    layout.type_size,
+    r.in.data(),
+    GDT_Float64,
+    sizeof(double),
+    static_cast<int>(plane));
+  for (size_t i = 0; i < plane; i++)
+    if (r.in[i] != 0) return false;
+  return true;
+}
+
+// Produces a tile from its (up to) four children in the deeper zoom level
+// nearest picks the top-left pixel of every 2x2 square, otherwise
+// the pixels are averaged weighted by their alpha
+static void downsampleTile(
+  TileRenderer &r,
+  const TileLayout &layout,
+  const std::map<TileXY, std::vector<GByte>> &children,
+  int x,
+  int y,
+  bool nearest,
+  std::vector<GByte> &data) {
+  const int ts = layout.tile_size;
+  const int half = ts / 2;
+  const int bands = layout.bands;
+  const size_t plane = static_cast<size_t>(ts) * ts;
+  const size_t total = plane * bands;
+
+  r.out.assign(total, 0);
+  r.in.resize(total);
+  for (int dy = 0; dy < 2; dy++) {
+    for (int dx = 0; dx < 2; dx++) {
+      auto child = children.find(TileXY(2 * x + dx, 2 * y + dy));
+      if (child == children.end()) continue;
+      GDALCopyWords(
+        child->second.data(),
+        layout.type,
+        layout.type_size,
+        r.in.data(),
+        GDT_Float64,
+        sizeof(double),
+        static_cast<int>(total));
+
+      const double *in = r.in.data();
+      const double *alpha = in + (bands - 1) * plane;
+      double *out = r.out.data();
+      for (int j = 0; j < half; j++) {
+        for (int i = 0; i < half; i++) {
+          const size_t o = static_cast<size_t>(dy * half + j) * ts + dx * half + i;
+          const size_t s = static_cast<size_t>(2 * j) * ts + 2 * i;
+          if (nearest) {
+            for (int b = 0; b < bands; b++) out[b * plane + o] = in[b * plane + s];
+            continue;
+          }
+          const size_t px[4] = {s, s + 1, s + ts, s + ts + 1};
+          double sum_alpha = 0;
+          for (int k = 0; k < 4; k++) sum_alpha += alpha[px[k]];
+          out[(bands - 1) * plane + o] = sum_alpha / 4;
+          if (sum_alpha == 0) continue;
+          for (int b = 0; b < bands - 1; b++) {
+            double sum = 0;
+            for (int k = 0; k < 4; k++) sum += in[b * plane + px[k]] * alpha[px[k]];
+            out[b * plane + o] = sum / sum_alpha;
+          }
+        }
+      }
+    }
+  }
+
+  data.resize(layout.tileBytes());
+  GDALCopyWords(
+    r.out.data(), GDT_Float64, sizeof(double), data.data(), layout.type, layout.type_size, static_cast<int>(total));
+
+  CPLErr err = r.mem->RasterIO(
+    GF_Write, 0, 0, ts, ts, data.data(), ts, ts, layout.type, bands, nullptr, 0, 0, 0, nullptr);
+  if (err != CE_None) throw CPLGetLastErrorMsg();
+}
+
+// Encodes the tile currently in the MEM dataset of the renderer
+// and writes it to path or to encoded when path is empty
+static void encodeTile(
+  TileRenderer &r,
+  const TilePyramidOptions &options,
+  const std::vector<GByte> &data,
+  const std::string &path,
+  std::vector<GByte> &encoded) {
+  if (options.format == TileRaw) {
+    if (path.empty()) {
+      encoded = data;
+      return;
+    }
+    VSILFILE *f = VSIFOpenL(path.c_str(), "wb");
+    if (f == nullptr) throw CPLSPrintf("Failed writing %s", path.c_str());
+    size_t written = VSIFWriteL(data.data(), 1, data.size(), f);
+    VSIFCloseL(f);
+    if (written != data.size()) throw CPLSPrintf("Failed writing %s", path.c_str());
+    return;
+  }
+
+  GDALDriver *driver = GetGDALDriverManager()->GetDriverByName(options.format == TilePNG ? "PNG" : "WEBP");
+  if (driver == nullptr) throw "Driver not available";
+  const std::string &filename = path.empty() ? r.tmp : path;
+  // No .aux.xml next to the tiles, the caller can have its own thread-local value
+  const char *pam = CPLGetThreadLocalConfigOption("GDAL_PAM_ENABLED", nullptr);
+  const std::string saved = pam != nullptr ? pam : "";
+  CPLSetThreadLocalConfigOption("GDAL_PAM_ENABLED", "NO");
+  GDALDataset *ds = driver->CreateCopy(filename.c_str(), r.mem, FALSE, nullptr, nullptr, nullptr);
+  if (ds != nullptr) GDALClose(GDALDatasetToHandle(ds));
+  CPLSetThreadLocalConfigOption("GDAL_PAM_ENABLED", pam != nullptr ? saved.c_str() : nullptr);
+  if (ds == nullptr) throw CPLGetLastErrorMsg();
+
+  if (path.empty()) {
+    vsi_l_offset len;
+    GByte *buffer = VSIGetMemFileBuffer(r.tmp.c_str(), &len, TRUE);
+    if (buffer == nullptr) throw "Failed encoding tile";
+    encoded.assign(buffer, buffer + len);
+    CPLFree(buffer);
+  }
+}
+
+// Both datasets are the same files opened by the same driver
+static bool sameFiles(GDALDataset *a, GDALDataset *b) {
+  if (a->GetDriver() != b->GetDriver()) return false;
+  char **files_a = a->GetFileList();
+  char **files_b = b->GetFileList();
+  bool same = files_a != nullptr && CSLCount(files_a) == CSLCount(files_b);
+  for (int i = 0; same && files_a[i] != nullptr; i++) same = strcmp(files_a[i], files_b[i]) == 0;
+  CSLDestroy(files_a);
+  CSLDestroy(files_b);
+  return same;
+}
+
+// Opens another copy of a read-only source for another thread, returns nullptr
+// when the source cannot be verifiably reopened: a dataset opened in update mode
+// can have unsaved modifications and a dataset without files (ie MEM) cannot be
+// found again from its description
+static GDALDataset *reopenSource(GDALDataset *src) {
+  const std::string description = src->GetDescription();
+  if (src->GetAccess() != GA_ReadOnly || description.empty()) return nullptr;
+  CPLPushErrorHandler(CPLQuietErrorHandler);
+  GDALDataset *copy = GDALDatasetFromHandle(
+    GDALOpenEx(description.c_str(), GDAL_OF_RASTER | GDAL_OF_READONLY, nullptr, nullptr, nullptr));
+  CPLPopErrorHandler();
+  CPLErrorReset();
+  if (copy == nullptr) return nullptr;
+  if (
+    copy->GetRasterCount() != src->GetRasterCount() || copy->GetRasterXSize() != src->GetRasterXSize() ||
+    copy->GetRasterYSize() != src->GetRasterYSize() || !sameFiles(src, copy)) {
+    GDALClose(GDALDatasetToHandle(copy));
+    return nullptr;
+  }
+  return copy;
+}
+
+size_t BuildTilePyramid(
+  GDALDataset *src,
+  const TilePyramidOptions &options,
+  std::vector<TilePyramidTile> &tiles,
+  const std::function<void(double)> &progress) {
+  TileLayout layout;
+  layout.tile_size = options.tile_size;
+
+  const char *wkt = src->GetProjectionRef();
+  if (wkt == nullptr || *wkt == '\0') throw "Source dataset has no spatial reference";
+  layout.src_wkt = wkt;
+  OGRSpatialReference webMercator;
+  if (webMercator.importFromEPSG(3857) != OGRERR_NONE) throw CPLGetLastErrorMsg();
+  char *dst_wkt = nullptr;
+  webMercator.exportToWkt(&dst_wkt);
+  layout.dst_wkt = dst_wkt;
+  CPLFree(dst_wkt);
+
+  layout.src_alpha = 0;
+  for (int i = 1; i <= src->GetRasterCount(); i++) {
+    if (src->GetRasterBand(i)->GetColorInterpretation() == GCI_AlphaBand)
+      layout.src_alpha = i;
+    else
+      layout.src_bands.push_back(i);
+  }
+  if (layout.src_bands.empty()) throw "Source dataset has no raster bands";
+  if (options.format != TileRaw) {
+    if (layout.src_bands.size() != 1 && layout.src_bands.size() != 3)
+      throw "PNG and WEBP tiles require a source with 1 or 3 bands (plus an optional alpha band)";
+    // WEBP supports only RGB(A)
+    if (options.format == TileWEBP && layout.src_bands.size() == 1)
+      layout.src_bands.assign(3, layout.src_bands[0]);
+    layout.type = GDT_Byte;
+  } else {
+    layout.type = src->GetRasterBand(layout.src_bands[0])->GetRasterDataType();
+  }
+  layout.type_size = GDALGetDataTypeSizeBytes(layout.type);
+  layout.bands = static_cast<int>(layout.src_bands.size()) + 1;
+  for (int band : layout.src_bands) {
+    int has_nodata = 0;
+    layout.src_nodata.push_back(src->GetRasterBand(band)->GetNoDataValue(&has_nodata));
+    layout.src_has_nodata.push_back(has_nodata);
+  }
+
+  // The extent of the source in EPSG:3857
+  double extent[4];
+  {
+    void *transformer = GDALCreateGenImgProjTransformer(
+      GDALDatasetToHandle(src), layout.src_wkt.c_str(), nullptr, layout.dst_wkt.c_str(), TRUE, 1000.0, 0);
+    if (transformer == nullptr) throw CPLGetLastErrorMsg();
+    double gt[6];
+    int w, h;
+    CPLErr err =
+      GDALSuggestedWarpOutput2(GDALDatasetToHandle(src), GDALGenImgProjTransform, transformer, gt, &w, &h, extent, 0);
+    GDALDestroyGenImgProjTransformer(transformer);
+    if (err != CE_None) throw CPLGetLastErrorMsg();
+  }
+
+  // The range of tiles covering the source at a zoom level
+  auto tileRange = [&extent](int z, TileRange &range) {
+    const double e = tileExtent(z);
+    const int last = (1 << z) - 1;
+    range.x0 = std::max(0, std::min(last, static_cast<int>(std::floor((extent[0] + webMercatorOrigin) / e))));
+    range.x1 = std::max(0, std::min(last, static_cast<int>(std::ceil((extent[2] + webMercatorOrigin) / e)) - 1));
+    range.y0 = std::max(0, std::min(last, static_cast<int>(std::floor((webMercatorOrigin - extent[3]) / e))));
+    range.y1 = std::max(0, std::min(last, static_cast<int>(std::ceil((webMercatorOrigin - extent[1]) / e)) - 1));
+  };
+
+  std::vector<TileRange> ranges(options.max_zoom + 1);
+  size_t total = 0;
+  for (int z = options.min_zoom; z <= options.max_zoom; z++) {
+    tileRange(z, ranges[z]);
+    total += ranges[z].count();
+  }
+
+  // Thread 0 uses the source dataset, the others open their own copy,
+  // if this is not possible (ie MEM dataset), there are less threads
+  int threads = GetNumThreads(ranges[options.max_zoom].count(), options.concurrency);
+  std::vector<std::unique_ptr<TileRenderer>> renderers;
+  renderers.emplace_back(new TileRenderer());
+  renderers[0]->src = src;
+  for (int i = 1; i < threads; i++) {
+    GDALDataset *copy = reopenSource(src);
+    if (copy == nullptr) break;
+    renderers.emplace_back(new TileRenderer());
+    renderers.back()->src = copy;
+    renderers.back()->owns_src = true;
+  }
+  threads = static_cast<int>(renderers.size());
+  for (auto &r : renderers) initRenderer(*r, layout, options);
+
+  // Every thread builds whole subtrees depth-first, so that only the children
+  // of the tiles on the current branch are in memory, the subtrees are rooted
+  // at the first zoom level with enough tiles to keep all the threads busy
+  int split = options.min_zoom;
+  while (split < options.max_zoom && ranges[split].count() < static_cast<size_t>(4 * threads)) split++;
+
+  const bool nearest = options.resampling == GRA_NearestNeighbour || options.resampling == GRA_Mode;
+  std::map<TileXY, std::vector<GByte>> level, next;
+  std::mutex lock;
+  std::atomic<size_t> done(0);
+  size_t count = 0;
+
+  auto output = [&](TileRenderer &r, int z, int x, int y, const std::vector<GByte> &data) {
+    std::vector<GByte> encoded;
+    std::string path;
+    if (!options.out_dir.empty()) {
+      std::string dir = options.out_dir + "/" + std::to_string(z) + "/" + std::to_string(x);
+      {
+        std::lock_guard<std::mutex> guard(lock);
+        VSIStatBufL stat;
+        if (VSIStatL(dir.c_str(), &stat) != 0 && VSIMkdirRecursive(dir.c_str(), 0755) != 0)
+          throw CPLSPrintf("Failed creating %s", dir.c_str());
+      }
+      path = dir + "/" + std::to_string(y) + (options.format == TilePNG    ? ".png"
+                                              : options.format == TileWEBP ? ".webp"
+                                                                           : ".raw");
+    }
+    encodeTile(r, options, data, path, encoded);
+
+    std::lock_guard<std::mutex> guard(lock);
+    count++;
+    if (path.empty()) tiles.push_back({z, x, y, std::move(encoded)});
+  };
+
+  auto report = [&](int thread) {
+    size_t completed = ++done;
+    if (thread == 0 && progress) progress(std::min(1.0, static_cast<double>(completed) / total));
+  };
+
+  // Produces the tile and all its descendants, returns false when it is empty
+  std::function<bool(TileRenderer &, int, int, int, int, std::vector<GByte> &)> build =
+    [&](TileRenderer &r, int thread, int z, int x, int y, std::vector<GByte> &data) {
+      if (z == options.max_zoom) {
+        renderTile(r, layout, z, x, y, data);
+        report(thread);
+        if (isTransparent(r, layout, data)) return false;
+      } else {
+        std::map<TileXY, std::vector<GByte>> children;
+        for (int dy = 0; dy < 2; dy++) {
+          for (int dx = 0; dx < 2; dx++) {
+            std::vector<GByte> child;
+            if (
+              ranges[z + 1].contains(2 * x + dx, 2 * y + dy) &&
+              build(r, thread, z + 1, 2 * x + dx, 2 * y + dy, child))
+              children[TileXY(2 * x + dx, 2 * y + dy)] = std::move(child);
+          }
+        }
+        report(thread);
+        if (children.empty()) return false;
+        downsampleTile(r, layout, children, x, y, nearest, data);
+      }
+      output(r, z, x, y, data);
+      return true;
+    };
+
+  std::vector<TileXY> roots;
+  for (int y = ranges[split].y0; y <= ranges[split].y1; y++)
+    for (int x = ranges[split].x0; x <= ranges[split].x1; x++) roots.push_back(TileXY(x, y));
+
+  ParallelFor(roots.size(), threads, 1, [&](size_t begin, size_t end, int thread) {
+    TileRenderer &r = *renderers[thread];
+    for (size_t i = begin; i < end; i++) {
+      std::vector<GByte> data;
+      if (!build(r, thread, split, roots[i].first, roots[i].second, data) || split == options.min_zoom) continue;
+      std::lock_guard<std::mutex> guard(lock);
+      next[roots[i]] = std::move(data);
+    }
+  });
+
+  // There are only a few tiles above the roots of the subtrees
+  for (int z = split - 1; z >= options.min_zoom; z--) {
+    level.swap(next);
+    next.clear();
+
+    std::set<TileXY> parents;
+    for (const auto &child : level) parents.insert(TileXY(child.first.first / 2, child.first.second / 2));
+    std::vector<TileXY> work(parents.begin(), parents.end());
+
+    ParallelFor(work.size(), threads, 1, [&](size_t begin, size_t end, int thread) {
+      TileRenderer &r = *renderers[thread];
+      for (size_t i = begin; i < end; i++) {
+        std::vector<GByte> data;
+        downsampleTile(r, layout, level, work[i].first, work[i].second, nearest, data);
+        output(r, z, work[i].first, work[i].second, data);
+        report(thread);
+        if (z == options.min_zoom) continue;
+        std::lock_guard<std::mutex> guard(lock);
+        next[work[i]] = std::move(data);
+      }
+    });
+  }
+
+  if (progress) progress(1);
+  return count;
+}
+
+} // namespace node_gdal
@@ -0,0 +1,55 @@
+#ifndef __NODE_GDAL_TILE_PYRAMID_H__
+#define __NODE_GDAL_TILE_PYRAMID_H__
+
+// gdal
+#include <gdal_priv.h>
+#include <gdalwarper.h>
+
+#include <functional>
+#include <string>
+#include <vector>
+
+namespace node_gdal {
+
+// Generator of XYZ (Google / OSM) tile pyramids in EPSG:3857
+//
+// The tiles of the deepest zoom level are warped from the source, each thread
+// reusing its own GDALWarpOperation, transformer and destination dataset
+// for all of its tiles, the tiles of the other zoom levels are produced by
+// downsampling their four children
+//
+// Each thread builds whole subtrees depth-first, so the memory usage depends
+// on the number of zoom levels and not on the number of tiles
+
+enum TileFormat { TilePNG, TileWEBP, TileRaw };
+
+struct TilePyramidOptions {
+  int min_zoom;
+  int max_zoom;
+  int tile_size;
+  TileFormat format;
+  GDALResampleAlg resampling;
+  // The tiles are written to out_dir/z/x/y.ext when set, otherwise they are returned
+  std::string out_dir;
+  // Number of threads, 0 for GDAL_NUM_THREADS
+  int concurrency;
+};
+
+struct TilePyramidTile {
+  int z, x, y;
+  std::vector<GByte> data;
+};
+
+// Builds the pyramid and returns the number of produced tiles, fully transparent tiles are skipped
+// tiles receives the encoded tiles when out_dir is not set
+// progress is called only from the calling thread
+// Throws const char * on error
+size_t BuildTilePyramid(
+  GDALDataset *src,
+  const TilePyramidOptions &options,
+  std::vector<TilePyramidTile> &tiles,
+  const std::function<void(double)> &progress);
+
+} // namespace node_gdal
+
+#endif
@@ -0,0 +1,275 @@
+#include "vsi_stats.hpp"
+
+#include <atomic>
+#include <cstring>
+#include <memory>
+#include <mutex>
+
+#ifdef VSI_STATS_SUPPORTED
+#include <cpl_vsi_virtual.h>
+#endif
+
+namespace node_gdal {
+
+namespace VSIStats {
+
+thread_local ThreadIO threadIO = {0, 0};
+
+struct IOCounters {
+  std::atomic<uint64_t> opens;
+  std::atomic<uint64_t> reads;
+  std::atomic<uint64_t> bytesRead;
+  std::atomic<uint64_t> ranges;
+  std::atomic<uint64_t> seeks;
+  std::atomic<uint64_t> writes;
+  std::atomic<uint64_t> bytesWritten;
+
+  IOCounters() {
+    Clear();
+  }
+
+  void Clear() {
+    opens = 0;
+    reads = 0;
+    bytesRead = 0;
+    ranges = 0;
+    seeks = 0;
+    writes = 0;
+    bytesWritten = 0;
+  }
+
+  IOSnapshot Get() const {
+    return {
+      static_cast<double>(opens),
+      static_cast<double>(reads),
+      static_cast<double>(bytesRead),
+      static_cast<double>(ranges),
+      static_cast<double>(seeks),
+      static_cast<double>(writes),
+      static_cast<double>(bytesWritten)};
+  }
+};
+
+// The entries are never removed so that the open handles can keep pointers to them,
+// the number of files is bounded to not grow forever with a server opening new files
+static const size_t maxFiles = 1024;
+static std::map<std::string, std::unique_ptr<IOCounters>> prefixes;
+static std::map<std::string, std::unique_ptr<IOCounters>> files;
+static std::mutex countersLock;
+
+static const char prefix[] = "/vsistats/";
+static const size_t prefixLength = sizeof(prefix) - 1;
+
+// /vsis3/bucket/file.tif -> /vsis3/, /home/user/file.tif -> file
+static std::string innerPrefix(const char *path) {
+  if (strncmp(path, "/vsi", 4) == 0) {
+    const char *end = strchr(path + 1, '/');
+    if (end != nullptr) return std::string(path, end - path + 1);
+  }
+  return "file";
+}
+
+void Snapshot(std::map<std::string, IOSnapshot> &prefixes_out, std::map<std::string, IOSnapshot> &files_out) {
+  std::lock_guard<std::mutex> lock(countersLock);
+  for (const auto &p : prefixes) prefixes_out[p.first] = p.second->Get();
+  for (const auto &f : files) files_out[f.first] = f.second->Get();
+}
+
+void Reset() {
+  std::lock_guard<std::mutex> lock(countersLock);
+  for (const auto &p : prefixes) p.second->Clear();
+  for (const auto &f : files) f.second->Clear();
+}
+
+#ifdef VSI_STATS_SUPPORTED
+
+class VSIStatsHandle : public VSIVirtualHandle {
+    public:
+  VSIStatsHandle(VSIVirtualHandle *inner, IOCounters *prefix, IOCounters *file)
+    : inner(inner), prefix(prefix), file(file), pos(0), next(0) {
+  }
+  ~VSIStatsHandle() override {
+    delete inner;
+  }
+
+  int Seek(vsi_l_offset offset, int whence) override {
+    int r = inner->Seek(offset, whence);
+    vsi_l_offset now = whence == SEEK_SET ? offset : inner->Tell();
+    if (now != pos) count(&IOCounters::seeks, 1);
+    pos = now;
+    return r;
+  }
+  vsi_l_offset Tell() override {
+    return inner->Tell();
+  }
+  size_t Read(void *buffer, size_t size, size_t n) override {
+    size_t r = inner->Read(buffer, size, n);
+    countRead(pos, r * size);
+    pos += r * size;
+    return r;
+  }
+  int ReadMultiRange(int ranges, void **data, const vsi_l_offset *offsets, const size_t *sizes) override {
+    int r = inner->ReadMultiRange(ranges, data, offsets, sizes);
+    size_t bytes = 0;
+    for (int i = 0; i < ranges; i++) bytes += sizes[i];
+    count(&IOCounters::reads, 1);
+    count(&IOCounters::bytesRead, bytes);
+    count(&IOCounters::ranges, ranges);
+    threadIO.reads++;
+    threadIO.bytesRead += bytes;
+    return r;
+  }
+  void AdviseRead(int ranges, const vsi_l_offset *offsets, const size_t *sizes) override {
+    inner->AdviseRead(ranges, offsets, sizes);
+  }
+  size_t Write(const void *buffer, size_t size, size_t n) override {
+    size_t r = inner->Write(buffer, size, n);
+    count(&IOCounters::writes, 1);
+    count(&IOCounters::bytesWritten, r * size);
+    pos += r * size;
+    return r;
+  }
+  int Eof() override {
+    return inner->Eof();
+  }
+  int Flush() override {
+    return inner->Flush();
+  }
+  int Close() override {
+    return inner->Close();
+  }
+  int Truncate(vsi_l_offset size) override {
+    return inner->Truncate(size);
+  }
+  void *GetNativeFileDescriptor() override {
+    return inner->GetNativeFileDescriptor();
+  }
+  VSIRangeStatus GetRangeStatus(vsi_l_offset offset, vsi_l_offset length) override {
+    return inner->GetRangeStatus(offset, length);
+  }
+  bool HasPRead() const override {
+    return inner->HasPRead();
+  }
+  // PRead can be called concurrently, each call counts as a new range
+  size_t PRead(void *buffer, size_t size, vsi_l_offset offset) const override {
+    size_t r = inner->PRead(buffer, size, offset);
+    count(&IOCounters::reads, 1);
+    count(&IOCounters::bytesRead, r);
+    count(&IOCounters::ranges, 1);
+    threadIO.reads++;
+    threadIO.bytesRead += r;
+    return r;
+  }
+
+    private:
+  VSIVirtualHandle *inner;
+  IOCounters *prefix;
+  IOCounters *file;
+  vsi_l_offset pos;
+  // The offset following the last read
+  vsi_l_offset next;
+
+  void count(std::atomic<uint64_t> IOCounters::*counter, uint64_t n) const {
+    (prefix->*counter) += n;
+    if (file != nullptr) (file->*counter) += n;
+  }
+
+  void countRead(vsi_l_offset offset, size_t bytes) {
+    count(&IOCounters::reads, 1);
+    count(&IOCounters::bytesRead, bytes);
+    if (offset != next) count(&IOCounters::ranges, 1);
+    next = offset + bytes;
+    threadIO.reads++;
+    threadIO.bytesRead += bytes;
+  }
+};
+
+class VSIStatsFilesystemHandler : public VSIFilesystemHandler {
+    public:
+  VSIVirtualHandle *Open(const char *filename, const char *access, bool setError, CSLConstList options) override {
+    const char *path = inner(filename);
+    VSIVirtualHandle *handle = VSIFileManager::GetHandler(path)->Open(path, access, setError, options);
+    if (handle == nullptr) return nullptr;
+
+    IOCounters *prefix_counters, *file_counters = nullptr;
+    {
+      std::lock_guard<std::mutex> lock(countersLock);
+      auto &p = prefixes[innerPrefix(path)];
+      if (!p) p.reset(new IOCounters);
+      prefix_counters = p.get();
+      auto f = files.find(path);
+      if (f != files.end()) {
+        file_counters = f->second.get();
+      } else if (files.size() < maxFiles) {
+        file_counters = new IOCounters;
+        files[path].reset(file_counters);
+      }
+    }
+    prefix_counters->opens++;
+    if (file_counters != nullptr) file_counters->opens++;
+    // A file opened in append mode starts at its end
+    VSIStatsHandle *stats = new VSIStatsHandle(handle, prefix_counters, file_counters);
+    if (strchr(access, 'a') != nullptr) stats->Seek(0, SEEK_END);
+    return stats;
+  }
+
+  int Stat(const char *filename, VSIStatBufL *buf, int flags) override {
+    return VSIStatExL(inner(filename), buf, flags);
+  }
+  int Unlink(const char *filename) override {
+    return VSIUnlink(inner(filename));
+  }
+  int Mkdir(const char *dirname, long mode) override {
+    return VSIMkdir(inner(dirname), mode);
+  }
+  int Rmdir(const char *dirname) override {
+    return VSIRmdir(inner(dirname));
+  }
+  char **ReadDirEx(const char *dirname, int maxFiles) override {
+    return VSIReadDirEx(inner(dirname), maxFiles);
+  }
+  char **SiblingFiles(const char *filename) override {
+    return VSISiblingFiles(inner(filename));
+  }
+  int Rename(const char *oldpath, const char *newpath) override {
+    return VSIRename(inner(oldpath), inner(newpath));
+  }
+  int IsCaseSensitive(const char *filename) override {
+    return VSIIsCaseSensitiveFS(inner(filename));
+  }
+  int HasOptimizedReadMultiRange(const char *path) override {
+    return VSIHasOptimizedReadMultiRange(inner(path));
+  }
+  const char *GetActualURL(const char *filename) override {
+    return VSIGetActualURL(inner(filename));
+  }
+  bool IsLocal(const char *path) override {
+    return VSIIsLocal(inner(path));
+  }
+  bool SupportsSequentialWrite(const char *path, bool allowLocalTempFile) override {
+    return VSISupportsSequentialWrite(inner(path), allowLocalTempFile);
+  }
+  bool SupportsRandomWrite(const char *path, bool allowLocalTempFile) override {
+    return VSISupportsRandomWrite(inner(path), allowLocalTempFile);
+  }
+
+    private:
+  static const char *inner(const char *path) {
+    return strncmp(path, prefix, prefixLength) == 0 ? path + prefixLength : path;
+  }
+};
+
+void Install() {
+  VSIFileManager::InstallHandler(prefix, new VSIStatsFilesystemHandler);
+}
+
+#else
+
+void Install() {
+}
+
+#endif
+
+} // namespace VSIStats
+
+} // namespace node_gdal
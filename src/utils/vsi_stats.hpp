@@ -0,0 +1,59 @@
+#ifndef __NODE_GDAL_VSI_STATS_H__
+#define __NODE_GDAL_VSI_STATS_H__
+
+#include <gdal_version.h>
+#include <cpl_vsi.h>
+
+#include <map>
+#include <stdint.h>
+#include <string>
+
+// I/O accounting of the files accessed through /vsistats/
+//
+// /vsistats/ is a pass-through file system: /vsistats//vsis3/bucket/file.tif
+// reads /vsis3/bucket/file.tif and counts the operations per inner
+// file system prefix (/vsis3/, /vsicurl/, /vsimem/... or file for the local files)
+// and per file - the existing handlers cannot be wrapped as GDAL downcasts
+// some of them
+//
+// The counters are atomic and the file handles can be used from any thread
+
+#if GDAL_VERSION_MAJOR > 3 || (GDAL_VERSION_MAJOR == 3 && GDAL_VERSION_MINOR >= 7)
+#define VSI_STATS_SUPPORTED
+#endif
+
+namespace node_gdal {
+
+namespace VSIStats {
+
+struct IOSnapshot {
+  double opens;
+  double reads;
+  double bytesRead;
+  // Reads that do not continue the previous one, a multi-range read counts its ranges
+  double ranges;
+  double seeks;
+  double writes;
+  double bytesWritten;
+};
+
+// The reads made by the current thread, for the attribution to the GDAL jobs
+struct ThreadIO {
+  uint64_t reads;
+  uint64_t bytesRead;
+};
+
+extern thread_local ThreadIO threadIO;
+
+// Installs the /vsistats/ handler, does nothing if not supported
+void Install();
+
+void Snapshot(std::map<std::string, IOSnapshot> &prefixes, std::map<std::string, IOSnapshot> &files);
+
+void Reset();
+
+} // namespace VSIStats
+
+} // namespace node_gdal
+
+#endif
@@ -0,0 +1,335 @@
+#include "zonal_stats.hpp"
+#include "parallel.hpp"
+
+// gdal
+#include <cpl_conv.h>
+#include <gdal_alg.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <map>
+#include <memory>
+#include <mutex>
+
+namespace node_gdal {
+
+// Maximum number of pixels read at once for one zone
+static const size_t zonalStripPixels = 1024 * 1024;
+
+ZonalStatsResult::ZonalStatsResult()
+  : count(0),
+    min(std::numeric_limits<double>::infinity()),
+    max(-std::numeric_limits<double>::infinity()),
+    weight(0),
+    shift(0),
+    sum(0),
+    sum_sq(0),
+    histogram() {
+}
+
+double ZonalStatsResult::Sum() const {
+  return sum + shift * weight;
+}
+
+double ZonalStatsResult::Mean() const {
+  return weight > 0 ? shift + sum / weight : std::numeric_limits<double>::quiet_NaN();
+}
+
+double ZonalStatsResult::StdDev() const {
+  if (!(weight > 0)) return std::numeric_limits<double>::quiet_NaN();
+  const double mean = sum / weight;
+  return std::sqrt(std::max(0.0, sum_sq / weight - mean * mean));
+}
+
+// An edge of a zone in pixel coordinates
+// fill is set for the edges of the rings of polygons, the others are only burned as lines
+struct ZoneEdge {
+  double x0, y0, x1, y1;
+  double ymin, ymax;
+  bool fill;
+};
+
+struct ZonePoint {
+  double x, y;
+};
+
+// The edges and the points of a zone in pixel coordinates
+struct ZoneShape {
+  std::vector<ZoneEdge> edges;
+  std::vector<ZonePoint> points;
+  double minx, miny, maxx, maxy;
+
+  ZoneShape()
+    : minx(std::numeric_limits<double>::infinity()),
+      miny(std::numeric_limits<double>::infinity()),
+      maxx(-std::numeric_limits<double>::infinity()),
+      maxy(-std::numeric_limits<double>::infinity()) {
+  }
+
+  inline ZonePoint toPixel(const double *inv, double x, double y) {
+    ZonePoint p = {inv[0] + x * inv[1] + y * inv[2], inv[3] + x * inv[4] + y * inv[5]};
+    minx = std::min(minx, p.x);
+    maxx = std::max(maxx, p.x);
+    miny = std::min(miny, p.y);
+    maxy = std::max(maxy, p.y);
+    return p;
+  }
+
+  void addCurve(const double *inv, OGRSimpleCurve *curve, bool fill) {
+    const int n = curve->getNumPoints();
+    if (n == 1) points.push_back(toPixel(inv, curve->getX(0), curve->getY(0)));
+    if (n < 2) return;
+    ZonePoint prev = toPixel(inv, curve->getX(0), curve->getY(0));
+    for (int i = 1; i < n; i++) {
+      ZonePoint p = toPixel(inv, curve->getX(i), curve->getY(i));
+      edges.push_back({prev.x, prev.y, p.x, p.y, std::min(prev.y, p.y), std::max(prev.y, p.y), fill});
+      prev = p;
+    }
+  }
+
+  void add(const double *inv, OGRGeometry *geom) {
+    if (geom == nullptr || geom->IsEmpty()) return;
+    if (geom->hasCurveGeometry()) {
+      std::unique_ptr<OGRGeometry> linear(geom->getLinearGeometry());
+      if (linear != nullptr && !linear->hasCurveGeometry()) add(inv, linear.get());
+      return;
+    }
+    switch (wkbFlatten(geom->getGeometryType())) {
+      case wkbPoint: {
+        OGRPoint *point = static_cast<OGRPoint *>(geom);
+        points.push_back(toPixel(inv, point->getX(), point->getY()));
+      } break;
+      case wkbLineString:
+      case wkbLinearRing: addCurve(inv, static_cast<OGRSimpleCurve *>(geom), false); break;
+      case wkbPolygon:
+      case wkbTriangle: {
+        OGRPolygon *poly = static_cast<OGRPolygon *>(geom);
+        if (poly->getExteriorRing() != nullptr) addCurve(inv, poly->getExteriorRing(), true);
+        for (int i = 0; i < poly->getNumInteriorRings(); i++) addCurve(inv, poly->getInteriorRing(i), true);
+      } break;
+      default: {
+        OGRGeometryCollection *coll = dynamic_cast<OGRGeometryCollection *>(geom);
+        if (coll != nullptr) {
+          for (int i = 0; i < coll->getNumGeometries(); i++) add(inv, coll->getGeometryRef(i));
+          break;
+        }
+        OGRPolyhedralSurface *surface = dynamic_cast<OGRPolyhedralSurface *>(geom);
+        if (surface != nullptr) {
+          for (int i = 0; i < surface->getNumGeometries(); i++) add(inv, surface->getGeometryRef(i));
+          break;
+        }
+        throw "Unsupported geometry type";
+      }
+    }
+  }
+};
+
+// The buffers of one thread, reused for all its zones
+struct ZonalScratch {
+  std::vector<double> values;
+  std::vector<double> weights;
+  std::vector<GByte> mask;
+  std::vector<double> crossings;
+  std::vector<size_t> active;
+};
+
+// Marks the columns [c0, c1) of a mask row clipped to [col0, col1)
+static inline void markSpan(GByte *row, int col0, int col1, double c0, double c1) {
+  const int a = static_cast<int>(std::max(c0, static_cast<double>(col0)));
+  const int b = static_cast<int>(std::min(c1, static_cast<double>(col1)));
+  if (b > a) memset(row + (a - col0), 1, b - a);
+}
+
+// Burns the mask of the rows [r0, r0 + rows) of the columns [col0, col1)
+// next and active hold the state of the edge table across successive strips
+static void burnStrip(
+  const ZoneShape &shape,
+  bool all_touched,
+  int col0,
+  int col1,
+  int r0,
+  int rows,
+  size_t &next,
+  ZonalScratch &s) {
+  const int ww = col1 - col0;
+  for (int j = 0; j < rows; j++) {
+    const int r = r0 + j;
+    GByte *row = s.mask.data() + static_cast<size_t>(j) * ww;
+
+    // Update the active edges, the edges are sorted by ymin
+    while (next < shape.edges.size() && shape.edges[next].ymin < r + 1) s.active.push_back(next++);
+    s.active.erase(
+      std::remove_if(s.active.begin(), s.active.end(), [&shape, r](size_t e) { return shape.edges[e].ymax < r; }),
+      s.active.end());
+
+    // Polygons: the pixels whose center is inside, with the even-odd rule
+    const double yc = r + 0.5;
+    s.crossings.clear();
+    for (size_t e : s.active) {
+      const ZoneEdge &edge = shape.edges[e];
+      if (!edge.fill) continue;
+      if ((edge.y0 <= yc && yc < edge.y1) || (edge.y1 <= yc && yc < edge.y0))
+        s.crossings.push_back(edge.x0 + (yc - edge.y0) * (edge.x1 - edge.x0) / (edge.y1 - edge.y0));
+    }
+    std::sort(s.crossings.begin(), s.crossings.end());
+    for (size_t k = 0; k + 1 < s.crossings.size(); k += 2)
+      markSpan(row, col0, col1, std::ceil(s.crossings[k] - 0.5), std::ceil(s.crossings[k + 1] - 0.5));
+
+    // Lines, and the outlines of the polygons with all_touched:
+    // the pixels crossed by the part of the edge within the row
+    for (size_t e : s.active) {
+      const ZoneEdge &edge = shape.edges[e];
+      if (edge.fill && !all_touched) continue;
+      double xa, xb;
+      if (edge.ymax == edge.ymin) {
+        if (edge.ymin < r || edge.ymin >= r + 1) continue;
+        xa = edge.x0;
+        xb = edge.x1;
+      } else {
+        if (edge.ymax <= r) continue;
+        const double ya = std::max(edge.ymin, static_cast<double>(r));
+        const double yb = std::min(edge.ymax, static_cast<double>(r + 1));
+        const double dx = (edge.x1 - edge.x0) / (edge.y1 - edge.y0);
+        xa = edge.x0 + (ya - edge.y0) * dx;
+        xb = edge.x0 + (yb - edge.y0) * dx;
+      }
+      if (xa > xb) std::swap(xa, xb);
+      markSpan(row, col0, col1, std::floor(xa), std::floor(xb) + 1);
+    }
+  }
+
+  for (const ZonePoint &p : shape.points) {
+    const int r = static_cast<int>(std::floor(p.y));
+    const int c = static_cast<int>(std::floor(p.x));
+    if (r >= r0 && r < r0 + rows && c >= col0 && c < col1) s.mask[static_cast<size_t>(r - r0) * ww + (c - col0)] = 1;
+  }
+}
+
+void ComputeZonalStats(
+  GDALRasterBand *band,
+  GDALRasterBand *weights,
+  const std::vector<OGRGeometry *> &zones,
+  const ZonalStatsOptions &options,
+  std::vector<ZonalStatsResult> &results,
+  const std::function<void(double)> &progress) {
+  const int w = band->GetXSize();
+  const int h = band->GetYSize();
+  if (weights != nullptr && (weights->GetXSize() != w || weights->GetYSize() != h))
+    throw "The weights band must have the size of the raster band";
+
+  double gt[6] = {0, 1, 0, 0, 0, 1};
+  if (band->GetDataset() != nullptr) band->GetDataset()->GetGeoTransform(gt);
+  double inv[6];
+  if (!GDALInvGeoTransform(gt, inv)) throw "The geotransform of the raster is not invertible";
+
+  int has_nodata = 0, weights_has_nodata = 0;
+  const double nodata = band->GetNoDataValue(&has_nodata);
+  const double weights_nodata = weights != nullptr ? weights->GetNoDataValue(&weights_has_nodata) : 0;
+  const bool check_nodata = has_nodata && !std::isnan(nodata);
+  const bool check_weights_nodata = weights_has_nodata && !std::isnan(weights_nodata);
+
+  // One lock per dataset, the weights can be in the same dataset
+  std::mutex locks[2];
+  std::mutex &band_lock = locks[0];
+  std::mutex &weights_lock = weights != nullptr && weights->GetDataset() == band->GetDataset() ? locks[0] : locks[1];
+
+  results.assign(zones.size(), ZonalStatsResult());
+  for (ZonalStatsResult &r : results)
+    if (options.bins > 0) r.histogram.assign(options.bins, 0);
+  const double hist_scale = options.bins > 0 && options.hist_max > options.hist_min
+    ? options.bins / (options.hist_max - options.hist_min)
+    : 0;
+
+  const int threads = GetNumThreads(zones.size(), options.concurrency);
+  const size_t grain = std::max<size_t>(1, zones.size() / (static_cast<size_t>(threads) * 8));
+  std::vector<ZonalScratch> scratch(threads);
+  std::atomic<size_t> done(0);
+
+  ParallelFor(zones.size(), threads, grain, [&](size_t begin, size_t end, int thread) {
+    ZonalScratch &s = scratch[thread];
+    for (size_t z = begin; z < end; z++) {
+      ZonalStatsResult &r = results[z];
+      ZoneShape shape;
+      shape.add(inv, zones[z]);
+
+      // The window of the envelope of the zone, empty for an empty zone
+      const int col0 = std::max(0, static_cast<int>(std::floor(std::max(shape.minx, -1.0))));
+      const int col1 = std::min(w, static_cast<int>(std::floor(std::min(shape.maxx, static_cast<double>(w)))) + 1);
+      const int row0 = std::max(0, static_cast<int>(std::floor(std::max(shape.miny, -1.0))));
+      const int row1 = std::min(h, static_cast<int>(std::floor(std::min(shape.maxy, static_cast<double>(h)))) + 1);
+
+      if (col0 < col1 && row0 < row1) {
+        std::sort(shape.edges.begin(), shape.edges.end(), [](const ZoneEdge &a, const ZoneEdge &b) {
+          return a.ymin < b.ymin;
+        });
+        const int ww = col1 - col0;
+        const int strip = static_cast<int>(std::max<size_t>(1, zonalStripPixels / ww));
+        size_t next = 0;
+        s.active.clear();
+
+        for (int r0 = row0; r0 < row1; r0 += strip) {
+          const int rows = std::min(strip, row1 - r0);
+          const size_t count = static_cast<size_t>(ww) * rows;
+          s.mask.assign(count, 0);
+          burnStrip(shape, options.all_touched, col0, col1, r0, rows, next, s);
+
+          bool any = false;
+          for (size_t k = 0; k < count && !any; k++) any = s.mask[k] != 0;
+          if (!any) continue;
+
+          s.values.resize(count);
+          CPLErr err;
+          {
+            std::lock_guard<std::mutex> lock(band_lock);
+            CPLErrorReset();
+            err = band->RasterIO(GF_Read, col0, r0, ww, rows, s.values.data(), ww, rows, GDT_Float64, 0, 0, nullptr);
+          }
+          if (err != CE_None) throw CPLGetLastErrorMsg();
+          if (weights != nullptr) {
+            s.weights.resize(count);
+            std::lock_guard<std::mutex> lock(weights_lock);
+            CPLErrorReset();
+            err =
+              weights->RasterIO(GF_Read, col0, r0, ww, rows, s.weights.data(), ww, rows, GDT_Float64, 0, 0, nullptr);
+          }
+          if (err != CE_None) throw CPLGetLastErrorMsg();
+
+          const double *values = s.values.data();
+          const double *wv = weights != nullptr ? s.weights.data() : nullptr;
+          const GByte *mask = s.mask.data();
+          for (size_t k = 0; k < count; k++) {
+            if (!mask[k]) continue;
+            const double v = values[k];
+            if (std::isnan(v) || (check_nodata && v == nodata)) continue;
+            double wk = 1;
+            if (wv != nullptr) {
+              wk = wv[k];
+              if (std::isnan(wk) || (check_weights_nodata && wk == weights_nodata)) continue;
+            }
+            if (r.count == 0) r.shift = v;
+            r.count++;
+            if (v < r.min) r.min = v;
+            if (v > r.max) r.max = v;
+            const double d = v - r.shift;
+            r.weight += wk;
+            r.sum += wk * d;
+            r.sum_sq += wk * d * d;
+            if (hist_scale > 0 && v >= options.hist_min && v <= options.hist_max)
+              r.histogram[std::min(options.bins - 1, static_cast<int>((v - options.hist_min) * hist_scale))]++;
+          }
+        }
+      }
+
+      size_t completed = ++done;
+      // The progress callback can be called only from the calling thread
+      if (progress && thread == 0) progress(static_cast<double>(completed) / zones.size());
+    }
+  });
+
+  if (progress) progress(1);
+}
+
+} // namespace node_gdal
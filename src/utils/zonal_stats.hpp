@@ -0,0 +1,66 @@
+#ifndef __NODE_GDAL_ZONAL_STATS_H__
+#define __NODE_GDAL_ZONAL_STATS_H__
+
+// gdal
+#include <gdal_priv.h>
+
+// ogr
+#include <ogr_geometry.h>
+
+#include <functional>
+#include <vector>
+
+namespace node_gdal {
+
+// Zonal statistics of a raster band over vector zones
+//
+// Each zone is processed by one thread: the pixels of its envelope are read
+// in strips of rows, a mask is burned for each row by scanline from the
+// edges of the zone in pixel coordinates and the masked pixels are reduced
+// The reading is serialized per dataset, all the threads share the block cache
+
+struct ZonalStatsOptions {
+  // Include all the pixels touched by the zone instead of those whose center is inside
+  bool all_touched;
+  // Histogram of bins buckets over [hist_min, hist_max], values outside are not counted
+  int bins;
+  double hist_min;
+  double hist_max;
+  // Number of threads, 0 for GDAL_NUM_THREADS
+  int concurrency;
+};
+
+struct ZonalStatsResult {
+  // Number of valid pixels
+  GIntBig count;
+  double min;
+  double max;
+  // Sum of the weights, equal to count without a weights band
+  double weight;
+  // Weighted sums of value - shift and of (value - shift)^2, shift being the first value
+  double shift;
+  double sum;
+  double sum_sq;
+  std::vector<GIntBig> histogram;
+
+  ZonalStatsResult();
+  double Sum() const;
+  double Mean() const;
+  double StdDev() const;
+};
+
+// The zones must be in the spatial reference system of the band
+// weights can be nullptr, otherwise it must have the size of the band
+// progress is called only from the calling thread
+// Throws const char * on error
+void ComputeZonalStats(
+  GDALRasterBand *band,
+  GDALRasterBand *weights,
+  const std::vector<OGRGeometry *> &zones,
+  const ZonalStatsOptions &options,
+  std::vector<ZonalStatsResult> &results,
+  const std::function<void(double)> &progress);
+
+} // namespace node_gdal
+
+#endif
@@ -435,6 +435,177 @@ describe('gdal', () => {
     })
   })
 
+  describe('spatialJoin()', () => {
+    let ds: gdal.Dataset, points: gdal.Layer, squares: gdal.Layer
+
+    before(() => {
+      ds = gdal.open('temp', 'w', 'Memory')
+      points = ds.layers.create('points', null, gdal.Point)
+      points.fields.add(new gdal.FieldDefn('id', gdal.OFTInteger))
+      squares = ds.layers.create('squares', null, gdal.Polygon)
+      squares.fields.add(new gdal.FieldDefn('name', gdal.OFTString))
+      // 3 points in the first square, 1 point in the second one and 1 point outside
+      for (const [ x, y ] of [ [ 1, 1 ], [ 2, 2 ], [ 3, 3 ], [ 11, 11 ], [ 25, 25 ] ]) {
+        const f = new gdal.Feature(points)
+        f.fields.set('id', x)
+        f.setGeometry(new gdal.Point(x, y))
+        points.features.add(f)
+      }
+      for (const [ name, x ] of [ [ 'first', 0 ], [ 'second', 10 ] ] as [string, number][]) {
+        const f = new gdal.Feature(squares)
+        f.fields.set('name', name)
+        f.setGeometry(gdal.Geometry.fromWKT(`POLYGON ((${x} ${x}, ${x + 5} ${x}, ${x + 5} ${x + 5}, ${x} ${x + 5}, ${x} ${x}))`))
+        squares.features.add(f)
+      }
+    })
+    after(() => {
+      try {
+        ds.close()
+      } catch (err) {
+        /* ignore */
+      }
+    })
+    it('should return the matching feature ids', () => {
+      const r = gdal.spatialJoin(points, squares, { predicate: 'within' })
+      assert.equal(r.count, 4)
+      assert.lengthOf(r.left as number[], 4)
+      assert.deepEqual(r.right, [ 0, 0, 0, 1 ])
+    })
+    it('should support the contains predicate', () => {
+      const r = gdal.spatialJoin(squares, points, { predicate: 'contains' })
+      assert.equal(r.count, 4)
+      assert.deepEqual(r.left, [ 0, 0, 0, 1 ])
+    })
+    it('should support the dwithin predicate', () => {
+      const r = gdal.spatialJoin(points, squares, { predicate: 'dwithin', distance: 15 })
+      assert.equal(r.count, 9)
+    })
+    it('should write the output layer', () => {
+      const output = ds.layers.create('output', null, gdal.Point)
+      output.fields.add(new gdal.FieldDefn('id', gdal.OFTInteger))
+      output.fields.add(new gdal.FieldDefn('name', gdal.OFTString))
+      return assert.isFulfilled(gdal.spatialJoinAsync(points, squares, {
+        outputLayer: output,
+        fields: [ 'name' ]
+      }).then((r) => {
+        assert.equal(r.count, 4)
+        assert.isUndefined(r.left)
+        assert.equal(output.features.count(), 4)
+        const names = output.features.map((f) => `${f.fields.get('id')}:${f.fields.get('name')}`)
+        assert.sameMembers(names, [ '1:first', '2:first', '3:first', '11:second' ])
+      }))
+    })
+    it('should accept a "progress_cb"', () => {
+      let calls = 0
+      gdal.spatialJoin(points, squares, {
+        progress_cb: () => {
+          calls++
+        }
+      })
+      assert.isAbove(calls, 0)
+    })
+    it('should throw on invalid arguments', () => {
+      assert.throws(() => {
+        gdal.spatialJoin(points, squares, { predicate: 'touches' })
+      }, /predicate must be one of/)
+      assert.throws(() => {
+        gdal.spatialJoin(points, squares, { outputLayer: squares })
+      }, /must be different/)
+    })
+    it('should reject on a missing field', () => {
+      const output = ds.layers.create('output2', null, gdal.Point)
+      return assert.isRejected(gdal.spatialJoinAsync(points, squares, { outputLayer: output, fields: [ 'missing' ] }),
+        /does not exist/)
+    })
+  })
+
+  describe('zonalStats()', () => {
+    let ds: gdal.Dataset, band: gdal.RasterBand, weights: gdal.RasterBand
+    const square = (x0: number, y0: number, x1: number, y1: number) =>
+      gdal.Geometry.fromWKT(`POLYGON ((${x0} ${y0}, ${x1} ${y0}, ${x1} ${y1}, ${x0} ${y1}, ${x0} ${y0}))`)
+
+    before(() => {
+      // 10x10 raster where each pixel is its column
+      ds = gdal.open('temp', 'w', 'MEM', 10, 10, 2, gdal.GDT_Float64)
+      ds.geoTransform = [ 0, 1, 0, 10, 0, -1 ]
+      band = ds.bands.get(1)
+      weights = ds.bands.get(2)
+      const data = new Float64Array(100)
+      for (let i = 0; i < 100; i++) data[i] = i % 10
+      band.pixels.write(0, 0, 10, 10, data)
+      weights.fill(2)
+    })
+    after(() => {
+      try {
+        ds.close()
+      } catch (err) {
+        /* ignore */
+      }
+    })
+    it('should compute the default statistics', () => {
+      const r = gdal.zonalStats(band, [ square(0, 0, 10, 10), square(2, 2, 5, 5) ])
+      assert.deepEqual(r, [
+        { count: 100, mean: 4.5, min: 0, max: 9 },
+        { count: 9, mean: 3, min: 2, max: 4 }
+      ])
+    })
+    it('should return null for an empty zone', () => {
+      const r = gdal.zonalStats(band, [ square(20, 20, 30, 30) ], { stats: [ 'count', 'sum', 'stddev' ] })
+      assert.deepEqual(r, [ { count: 0, sum: null, stddev: null } ])
+    })
+    it('should support allTouched', () => {
+      const zone = square(2.6, 2.6, 4.4, 4.4)
+      assert.equal(gdal.zonalStats(band, [ zone ], { stats: [ 'count' ] })[0].count, 1)
+      assert.equal(gdal.zonalStats(band, [ zone ], { stats: [ 'count' ], allTouched: true })[0].count, 9)
+    })
+    it('should support weights', () => {
+      const r = gdal.zonalStats(band, [ square(0, 0, 10, 10) ], { stats: [ 'sum', 'mean', 'stddev' ], weights })
+      assert.equal(r[0].sum, 900)
+      assert.closeTo(r[0].mean as number, 4.5, 1e-9)
+      assert.closeTo(r[0].stddev as number, Math.sqrt(8.25), 1e-9)
+    })
+    it('should compute histograms', () => {
+      const r = gdal.zonalStats(band, [ square(0, 0, 10, 10) ], {
+        stats: [ 'histogram' ],
+        histogram: { min: 0, max: 10, bins: 5 }
+      })
+      assert.deepEqual(r[0].histogram, [ 20, 20, 20, 20, 20 ])
+    })
+    it('should accept a layer and return the feature ids', () => {
+      const vector = gdal.open('temp', 'w', 'Memory')
+      const layer = vector.layers.create('zones', null, gdal.Polygon)
+      for (const zone of [ square(0, 0, 5, 10), square(5, 0, 10, 10) ]) {
+        const f = new gdal.Feature(layer)
+        f.setGeometry(zone)
+        layer.features.add(f)
+      }
+      return assert.isFulfilled(gdal.zonalStatsAsync(band, layer, { stats: [ 'count', 'max' ], concurrency: 2 })
+        .then((r) => {
+          assert.deepEqual(r, [ { fid: 0, count: 50, max: 4 }, { fid: 1, count: 50, max: 9 } ])
+        }))
+    })
+    it('should accept a "progress_cb"', () => {
+      let calls = 0
+      gdal.zonalStats(band, [ square(0, 0, 5, 5), square(5, 5, 10, 10) ], {
+        progress_cb: () => {
+          calls++
+        }
+      })
+      assert.isAbove(calls, 0)
+    })
+    it('should throw on invalid arguments', () => {
+      assert.throws(() => {
+        gdal.zonalStats(band, [ square(0, 0, 1, 1) ], { stats: [ 'median' ] })
+      }, /stats must contain only/)
+      assert.throws(() => {
+        gdal.zonalStats(band, [ square(0, 0, 1, 1) ], { stats: [ 'histogram' ] })
+      }, /requires the histogram option/)
+      assert.throws(() => {
+        gdal.zonalStats(band, [ {} as gdal.Geometry ])
+      }, /must be Geometry objects/)
+    })
+  })
+
   describe('addPixelFunc()', () => {
     it('should throw with invalid arguments', () => {
       assert.throws(() => {
@@ -613,6 +784,84 @@ describe('gdal', () => {
         assert.closeTo(result[i], input1[i] + input2[i] + 20, 1e-6)
       }
     })
+
+    it('should support evaluating the JS function in worker threads', function () {
+      if (!semver.gte(gdal.version, '3.5.0-git')) this.skip()
+      const sum2 = (sources: gdal.TypedArray[], buffer: gdal.TypedArray) => {
+        for (let i = 0; i < buffer.length; i++) {
+          buffer[i] = sources[0][i] + sources[1][i] + 6
+        }
+      }
+      gdal.addPixelFunc('sum2workers', gdal.toPixelFunc(sum2, { workers: 2 }))
+
+      const vrt = gdal.wrapVRT({
+        bands: [
+          {
+            sources: [ band1, band2 ],
+            pixelFunc: 'sum2workers'
+          }
+        ]
+      })
+      const ds = gdal.open(vrt)
+
+      const input1 = band1.pixels.read(0, 0, ds.rasterSize.x, ds.rasterSize.y)
+      const input2 = band2.pixels.read(0, 0, ds.rasterSize.x, ds.rasterSize.y)
+      const sync = ds.bands.get(1).pixels.read(0, 0, ds.rasterSize.x, ds.rasterSize.y)
+      const q = ds.bands.get(1).pixels.readAsync(0, 0, ds.rasterSize.x, ds.rasterSize.y).then((result) => {
+        for (let i = 0; i < ds.rasterSize.x * ds.rasterSize.y; i += 256) {
+          assert.closeTo(result[i], input1[i] + input2[i] + 6, 1e-6)
+          assert.equal(result[i], sync[i])
+        }
+      })
+      return assert.isFulfilled(q)
+    })
+
+    it('should propagate exceptions from the worker threads', function () {
+      if (!semver.gte(gdal.version, '3.5.0-git')) this.skip()
+      const fail = () => {
+        throw new Error('worker pixel function failed')
+      }
+      gdal.addPixelFunc('failWorkers', gdal.toPixelFunc(fail, { workers: 1 }))
+
+      const vrt = gdal.wrapVRT({
+        bands: [
+          {
+            sources: [ band1, band2 ],
+            pixelFunc: 'failWorkers'
+          }
+        ]
+      })
+      const ds = gdal.open(vrt)
+
+      return assert.isRejected(ds.bands.get(1).pixels.readAsync(0, 0, ds.rasterSize.x, ds.rasterSize.y),
+        /worker pixel function failed/)
+    })
+
+    it('should fail the requests of a worker thread that exits', function () {
+      if (!semver.gte(gdal.version, '3.5.0-git')) this.skip()
+      // process.exit() in a worker thread stops only the worker
+      const exit = () => process.exit(1)
+      gdal.addPixelFunc('exitWorkers', gdal.toPixelFunc(exit, { workers: 1 }))
+
+      const vrt = gdal.wrapVRT({
+        bands: [
+          {
+            sources: [ band1, band2 ],
+            pixelFunc: 'exitWorkers'
+          }
+        ]
+      })
+      const ds = gdal.open(vrt)
+
+      return assert.isRejected(ds.bands.get(1).pixels.readAsync(0, 0, ds.rasterSize.x, ds.rasterSize.y),
+        /worker exited with code 1/)
+    })
+
+    it('should throw on an invalid number of workers', () => {
+      assert.throws(() => {
+        gdal.toPixelFunc(() => undefined, { workers: 0 })
+      }, /workers must be a positive number/)
+    })
   })
 
   describe('createPixelFunc()', () => {
@@ -673,6 +922,31 @@ describe('gdal', () => {
         assert.closeTo(result[i], input1[i] + input2[i] + 5, 0.5, `${input1[i]} + ${input2[i]}`)
       }
     })
+
+    it('should support evaluating the JS function in worker threads', function () {
+      if (!semver.gte(gdal.version, '3.5.0-git')) this.skip()
+
+      gdal.addPixelFunc('createPxFnWorkers', gdal.createPixelFunc((a, b) => a + b + 7, { workers: 2 }))
+
+      const vrt = gdal.wrapVRT({
+        bands: [
+          {
+            sources: [ band1, band2 ],
+            pixelFunc: 'createPxFnWorkers'
+          }
+        ]
+      })
+      const ds = gdal.open(vrt)
+
+      const input1 = band1.pixels.read(0, 0, ds.rasterSize.x, ds.rasterSize.y)
+      const input2 = band2.pixels.read(0, 0, ds.rasterSize.x, ds.rasterSize.y)
+      const q = ds.bands.get(1).pixels.readAsync(0, 0, ds.rasterSize.x, ds.rasterSize.y).then((result) => {
+        for (let i = 0; i < ds.rasterSize.x * ds.rasterSize.y; i += 256) {
+          assert.closeTo(result[i], input1[i] + input2[i] + 7, 1e-6)
+        }
+      })
+      return assert.isFulfilled(q)
+    })
   })
 
   describe('createPixelFuncWithArgs()', () => {
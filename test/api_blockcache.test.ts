@@ -0,0 +1,167 @@
+import * as gdal from 'gdal-async'
+import * as path from 'path'
+import { assert } from 'chai'
+import * as chai from 'chai'
+import * as chaiAsPromised from 'chai-as-promised'
+chai.use(chaiAsPromised)
+
+describe('gdal.blockCache', () => {
+  // eslint-disable-next-line @typescript-eslint/no-non-null-assertion
+  afterEach(global.gc!)
+
+  const sample = path.resolve(__dirname, 'data', 'sample.tif')
+
+  // A read-only GeoTIFF with 2 overview levels
+  const withOverviews = (file: string): gdal.Dataset => {
+    const src = gdal.open('temp', 'w', 'MEM', 256, 256, 1, gdal.GDT_Byte)
+    src.bands.get(1).fill(42)
+    const ds = gdal.drivers.get('GTiff').createCopy(file, src, { TILED: 'YES' })
+    ds.buildOverviews('NEAREST', [ 2, 4 ])
+    ds.close()
+    return gdal.open(file)
+  }
+
+  describe('stats()', () => {
+    it('should return the usage of the cache', () => {
+      const stats = gdal.blockCache.stats()
+      assert.isAbove(stats.maxBytes, 0)
+      assert.isAtLeast(stats.usedBytes, 0)
+      assert.isAtLeast(stats.pinnedBytes, 0)
+      assert.deepEqual(stats.datasets, [])
+    })
+    it('should return the blocks of a dataset', () => {
+      const ds = gdal.open(sample)
+      assert.deepEqual(gdal.blockCache.stats([ ds ]).datasets[0], { blocks: 0, bytes: 0, dirtyBytes: 0, pinnedBytes: 0 })
+      ds.bands.get(1).pixels.get(200, 300)
+      const stats = gdal.blockCache.stats([ ds ]).datasets[0]
+      assert.equal(stats.blocks, 1)
+      assert.equal(stats.bytes, 984 * 8)
+      assert.equal(stats.dirtyBytes, 0)
+    })
+    it('should return the dirty blocks of a dataset', () => {
+      const ds = gdal.open('/vsimem/dirty.tif', 'w', 'GTiff', 64, 64, 1, gdal.GDT_Byte)
+      try {
+        ds.bands.get(1).pixels.set(0, 0, 1)
+        const stats = gdal.blockCache.stats([ ds ]).datasets[0]
+        assert.isAbove(stats.dirtyBytes, 0)
+        assert.equal(stats.dirtyBytes, stats.bytes)
+      } finally {
+        ds.close()
+        gdal.vsimem.release('/vsimem/dirty.tif')
+      }
+    })
+    it('should throw on invalid arguments', () => {
+      assert.throws(() => {
+        gdal.blockCache.stats([ {} as gdal.Dataset ])
+      }, /Dataset/)
+    })
+  })
+
+  describe('statsAsync()', () => {
+    it('should return the blocks of a dataset', async () => {
+      const ds = gdal.open(sample)
+      await ds.bands.get(1).pixels.getAsync(200, 300)
+      const stats = await gdal.blockCache.statsAsync([ ds ])
+      assert.equal(stats.datasets[0].blocks, 1)
+    })
+    it('should return the usage of the cache without datasets', async () => {
+      const stats = await gdal.blockCache.statsAsync()
+      assert.isAbove(stats.maxBytes, 0)
+      assert.deepEqual(stats.datasets, [])
+    })
+  })
+
+  describe('setMaxBytes()', () => {
+    it('should set the size of the cache', () => {
+      const max = gdal.blockCache.stats().maxBytes
+      try {
+        gdal.blockCache.setMaxBytes(64 * 1024 * 1024)
+        assert.equal(gdal.blockCache.stats().maxBytes, 64 * 1024 * 1024)
+      } finally {
+        gdal.blockCache.setMaxBytes(max)
+      }
+    })
+    it('should throw on negative sizes', () => {
+      assert.throws(() => {
+        gdal.blockCache.setMaxBytes(-1)
+      }, RangeError)
+    })
+  })
+
+  describe('flushDataset()', () => {
+    it('should remove the blocks of a dataset', () => {
+      const ds = gdal.open(sample)
+      ds.bands.get(1).pixels.get(200, 300)
+      gdal.blockCache.flushDataset(ds)
+      assert.equal(gdal.blockCache.stats([ ds ]).datasets[0].blocks, 0)
+    })
+    it('should remove the blocks of a dataset (async)', async () => {
+      const ds = gdal.open(sample)
+      ds.bands.get(1).pixels.get(200, 300)
+      await gdal.blockCache.flushDatasetAsync(ds)
+      assert.equal(gdal.blockCache.stats([ ds ]).datasets[0].blocks, 0)
+    })
+  })
+
+  describe('pin()', () => {
+    it('should keep the overviews in the cache', () => {
+      const ds = withOverviews('/vsimem/pin_overviews.tif')
+      try {
+        // 128x128 and 64x64 overviews, one tile each
+        const pinned = gdal.blockCache.pin(ds)
+        assert.isAbove(pinned, 0)
+        const stats = gdal.blockCache.stats([ ds ])
+        assert.equal(stats.datasets[0].pinnedBytes, pinned)
+        assert.equal(stats.datasets[0].bytes, pinned)
+        assert.isAtLeast(stats.pinnedBytes, pinned)
+        assert.equal(stats.datasets[0].blocks, 2)
+        assert.equal(ds.bands.get(1).overviews.get(1).pixels.get(10, 10), 42)
+
+        gdal.blockCache.unpin(ds)
+        assert.equal(gdal.blockCache.stats([ ds ]).datasets[0].pinnedBytes, 0)
+      } finally {
+        ds.close()
+        gdal.vsimem.release('/vsimem/pin_overviews.tif')
+      }
+    })
+    it('should pin only the given overview levels', async () => {
+      const ds = withOverviews('/vsimem/pin_levels.tif')
+      try {
+        const pinned = await gdal.blockCache.pinAsync(ds, [ 1 ])
+        assert.isAbove(pinned, 0)
+        assert.equal(gdal.blockCache.stats([ ds ]).datasets[0].blocks, 1)
+      } finally {
+        ds.close()
+        gdal.vsimem.release('/vsimem/pin_levels.tif')
+      }
+    })
+    it('should release the pinned blocks when flushing', () => {
+      const ds = withOverviews('/vsimem/pin_flush.tif')
+      try {
+        gdal.blockCache.pin(ds)
+        ds.flush()
+        assert.equal(gdal.blockCache.stats([ ds ]).datasets[0].pinnedBytes, 0)
+      } finally {
+        ds.close()
+        gdal.vsimem.release('/vsimem/pin_flush.tif')
+      }
+    })
+    it('should throw on invalid overview levels', () => {
+      const ds = withOverviews('/vsimem/pin_invalid.tif')
+      try {
+        assert.throws(() => {
+          gdal.blockCache.pin(ds, [ 2 ])
+        }, /Invalid overview level/)
+      } finally {
+        ds.close()
+        gdal.vsimem.release('/vsimem/pin_invalid.tif')
+      }
+    })
+    it('should throw on writable datasets', () => {
+      const ds = gdal.open('temp', 'w', 'MEM', 64, 64, 1, gdal.GDT_Byte)
+      assert.throws(() => {
+        gdal.blockCache.pin(ds)
+      }, /read-only/)
+    })
+  })
+})
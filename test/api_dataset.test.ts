@@ -1172,6 +1172,108 @@ describe('gdal.Dataset', () => {
         gdal.vsimem.release(tempFile)
         return assert.isRejected(ds.buildOverviewsAsync('NEAREST', [ 2, 4, 8 ]))
       })
+      describe('w/concurrency option', () => {
+        it('should produce the same overviews as GDAL', async () => {
+          const gdalFile = fileUtils.clone(`${__dirname}/data/multiband.tif`)
+          const parallelFile = fileUtils.clone(`${__dirname}/data/multiband.tif`)
+          const expected = gdal.open(gdalFile, 'r+')
+          const actual = gdal.open(parallelFile, 'r+')
+          await expected.buildOverviewsAsync('AVERAGE', [ 2 ])
+          await actual.buildOverviewsAsync('AVERAGE', [ 2 ], undefined, { concurrency: 4 })
+          for (let b = 1; b <= actual.bands.count(); b++) {
+            const e = expected.bands.get(b).overviews.get(0).pixels.read(0, 0,
+              expected.bands.get(b).overviews.get(0).size.x, expected.bands.get(b).overviews.get(0).size.y)
+            const a = actual.bands.get(b).overviews.get(0).pixels.read(0, 0,
+              actual.bands.get(b).overviews.get(0).size.x, actual.bands.get(b).overviews.get(0).size.y)
+            assert.equal(a.length, e.length)
+            for (let i = 0; i < a.length; i++) assert.closeTo(a[i], e[i], 1)
+          }
+          expected.close()
+          actual.close()
+          gdal.vsimem.release(gdalFile)
+          gdal.vsimem.release(parallelFile)
+        })
+        for (const resampling of [ 'NEAREST', 'AVERAGE', 'MODE', 'GAUSS', 'RMS' ]) {
+          it(`should support ${resampling}`, async () => {
+            const tempFile = fileUtils.clone(`${__dirname}/data/sample.tif`)
+            const ds = gdal.open(tempFile, 'r+')
+            let calls = 0
+            let last = 0
+            await ds.buildOverviewsAsync(resampling, [ 2, 4, 8 ], undefined, {
+              concurrency: 0,
+              progress_cb: (complete) => {
+                calls++
+                assert.isAtLeast(complete, last)
+                last = complete
+              }
+            })
+            assert.isAbove(calls, 0)
+            assert.isAtMost(last, 1)
+            const band = ds.bands.get(1)
+            assert.equal(band.overviews.count(), 3)
+            const stats = band.getStatistics(false, true)
+            const ovrStats = band.overviews.get(2).getStatistics(false, true)
+            assert.isAtLeast(ovrStats.max, stats.min)
+            assert.isAtMost(ovrStats.max, stats.max)
+            assert.isAbove(ovrStats.max, 0)
+            ds.close()
+            gdal.vsimem.release(tempFile)
+          })
+        }
+        it('should keep the NaNs of a floating point band without nodata', async () => {
+          const tempFile = `/vsimem/${String(Math.random()).substring(2)}.tif`
+          const ds = gdal.open(tempFile, 'w', 'GTiff', 4, 4, 1, gdal.GDT_Float32)
+          const data = new Float32Array(16).fill(1)
+          for (const i of [ 0, 1, 4, 5 ]) data[i] = NaN
+          ds.bands.get(1).pixels.write(0, 0, 4, 4, data)
+          await ds.buildOverviewsAsync('AVERAGE', [ 2 ], undefined, { concurrency: 2 })
+          const ovr = ds.bands.get(1).overviews.get(0).pixels.read(0, 0, 2, 2)
+          assert.isNaN(ovr[0])
+          assert.deepEqual(Array.from(ovr.slice(1)), [ 1, 1, 1 ])
+          ds.close()
+          gdal.vsimem.release(tempFile)
+        })
+        it('should reject unsupported resampling methods', () => {
+          const tempFile = fileUtils.clone(`${__dirname}/data/sample.tif`)
+          const ds = gdal.open(tempFile, 'r+')
+          assert.throws(() => {
+            ds.buildOverviews('CUBIC', [ 2 ], undefined, { concurrency: 2 })
+          }, /supports only/)
+          ds.close()
+          gdal.vsimem.release(tempFile)
+        })
+      })
+    })
+    describe('sample()', () => {
+      it('should return the values of all the bands', () => {
+        const ds = gdal.open(`${__dirname}/data/multiband.tif`)
+        const xs = new Float64Array([ 10.5, 20.5, 30.5 ])
+        const ys = new Float64Array([ 5.5, 15.5, 25.5 ])
+        const values = ds.sample(xs, ys)
+        assert.lengthOf(values, 3 * ds.bands.count())
+        ds.bands.forEach((band, b) => {
+          for (let i = 0; i < 3; i++) {
+            assert.equal(values[(b - 1) * 3 + i], band.pixels.get(Math.floor(xs[i]), Math.floor(ys[i])))
+          }
+        })
+      })
+      it('should support the bands option', () => {
+        const ds = gdal.open(`${__dirname}/data/multiband.tif`)
+        const values = ds.sample(new Float64Array([ 10.5 ]), new Float64Array([ 5.5 ]), { bands: [ 3, 1 ] })
+        assert.deepEqual(Array.from(values), [ ds.bands.get(3).pixels.get(10, 5), ds.bands.get(1).pixels.get(10, 5) ])
+        assert.throws(() => {
+          ds.sample(new Float64Array([ 10.5 ]), new Float64Array([ 5.5 ]), { bands: [ 4 ] })
+        }, /invalid band id/)
+      })
+    })
+    describe('sampleAsync()', () => {
+      it('should return the values of the bands', () => {
+        const ds = gdal.open(`${__dirname}/data/multiband.tif`)
+        return assert.isFulfilled(ds.sampleAsync(new Float64Array([ 10.5 ]), new Float64Array([ 5.5 ]), { bands: [ 2 ] })
+          .then((values) => {
+            assert.deepEqual(Array.from(values), [ ds.bands.get(2).pixels.get(10, 5) ])
+          }))
+      })
     })
   })
   describe('setGCPs()', () => {
@@ -1,6 +1,7 @@
 import * as gdal from 'gdal-async'
 import * as fs from 'fs'
 import * as path from 'path'
+import * as semver from 'semver'
 import { assert } from 'chai'
 import * as chai from 'chai'
 import * as chaiAsPromised from 'chai-as-promised'
@@ -55,4 +56,46 @@ describe('gdal.fs', () => {
       assert.isRejected(gdal.fs.readDirAsync(path.resolve(__dirname, 'data2')))
     )
   })
+  describe('ioStats()', () => {
+    const sample = path.resolve(__dirname, 'data', 'sample.tif')
+
+    before(function () {
+      if (!semver.gte(gdal.version, '3.7.0')) this.skip()
+    })
+    beforeEach(() => {
+      gdal.fs.ioStats.reset()
+    })
+
+    it('should count the I/O of the files opened through /vsistats/', () => {
+      const ds = gdal.open(`/vsistats/${sample}`)
+      ds.bands.get(1).pixels.read(0, 0, 984, 804)
+      const stats = gdal.fs.ioStats()
+      assert.isAtLeast(stats.prefixes.file.opens, 1)
+      assert.isAbove(stats.prefixes.file.reads, 0)
+      assert.isAbove(stats.prefixes.file.bytesRead, 0)
+      assert.isAbove(stats.prefixes.file.ranges, 0)
+      assert.equal(stats.prefixes.file.writes, 0)
+      assert.deepEqual(stats.files[sample], stats.prefixes.file)
+    })
+    it('should return the I/O of a dataset', async () => {
+      const ds = gdal.open(`/vsistats/${sample}`)
+      ds.bands.get(1).pixels.read(0, 0, 984, 804)
+      const stats = gdal.fs.ioStats(ds)
+      assert.isAbove(stats.bytesRead, 0)
+      assert.deepEqual(await gdal.fs.ioStatsAsync(ds), stats)
+    })
+    it('should not count the files opened directly', () => {
+      const ds = gdal.open(sample)
+      ds.bands.get(1).pixels.read(0, 0, 984, 804)
+      assert.equal(gdal.fs.ioStats().files[sample]?.reads ?? 0, 0)
+    })
+    it('should attribute the reads to the GDAL jobs', async () => {
+      const ds = gdal.open(`/vsistats/${sample}`)
+      gdal.stats.reset()
+      await ds.bands.get(1).pixels.readAsync(0, 0, 984, 804)
+      const job = gdal.stats()['RasterBandPixels::readAsync']
+      assert.isAbove(job.reads, 0)
+      assert.isAbove(job.bytesRead, 0)
+    })
+  })
 })
@@ -155,6 +155,93 @@ describe('gdal.Geometry', () => {
       }))
     })
   })
+  describe('visit()', () => {
+    const multi = () => gdal.Geometry.fromWKT(
+      'MULTIPOLYGON (((0 0,10 0,10 10,0 10,0 0),(1 1,2 1,2 2,1 1)),((20 20,30 20,30 30,20 20)))')
+    it('should visit all the descendants with the same cursor', () => {
+      const visited = [] as [string, number, number, number][]
+      let cursor: gdal.GeometryCursor | undefined
+      multi().visit((c) => {
+        if (cursor) assert.strictEqual(c, cursor)
+        cursor = c
+        visited.push([ c.name, c.depth, c.index, c.pointCount ])
+      })
+      assert.deepEqual(visited, [
+        [ 'MULTIPOLYGON', 0, 0, 0 ],
+        [ 'POLYGON', 1, 0, 0 ],
+        [ 'LINEARRING', 2, 0, 5 ],
+        [ 'LINEARRING', 2, 1, 4 ],
+        [ 'POLYGON', 1, 1, 0 ],
+        [ 'LINEARRING', 2, 0, 4 ]
+      ])
+    })
+    it('should return the coordinates', () => {
+      const coords = [] as number[][]
+      multi().visit((c) => {
+        if (c.wkbType === gdal.wkbLinearRing) coords.push(Array.from(c.toArray()))
+      })
+      assert.lengthOf(coords, 3)
+      assert.deepEqual(coords[2], [ 20, 20, 30, 20, 30, 30, 20, 20 ])
+    })
+    it('should stop if the callback returns false', () => {
+      let n = 0
+      multi().visit(() => {
+        n++
+        return n < 3
+      })
+      assert.equal(n, 3)
+    })
+    it('should create Geometry objects on demand', () => {
+      const polygons = [] as gdal.Geometry[]
+      multi().visit((c) => {
+        if (c.depth === 1) polygons.push(c.geometry())
+      })
+      assert.lengthOf(polygons, 2)
+      polygons.forEach((p) => assert.instanceOf(p, gdal.Polygon))
+    })
+    it('should throw if the cursor is used outside of the callback', () => {
+      let cursor: gdal.GeometryCursor | undefined
+      multi().visit((c) => {
+        cursor = c
+        return false
+      })
+      assert.throws(() => {
+        // eslint-disable-next-line @typescript-eslint/no-non-null-assertion
+        cursor!.depth
+      }, /only inside/)
+    })
+    it('should skip the geometries removed by the callback', () => {
+      const geom = multi() as gdal.MultiPolygon
+      const visited = [] as [string, number, number][]
+      geom.visit((c) => {
+        visited.push([ c.name, c.depth, c.index ])
+        if (c.depth === 1 && c.index === 0) geom.children.remove(1)
+      })
+      assert.deepEqual(visited, [
+        [ 'MULTIPOLYGON', 0, 0 ],
+        [ 'POLYGON', 1, 0 ],
+        [ 'LINEARRING', 2, 0 ],
+        [ 'LINEARRING', 2, 1 ]
+      ])
+    })
+    it('should stop descending into a geometry emptied by the callback', () => {
+      const geom = multi() as gdal.MultiPolygon
+      const visited = [] as string[]
+      geom.visit((c) => {
+        visited.push(c.name)
+        if (c.depth === 2) geom.empty()
+      })
+      assert.deepEqual(visited, [ 'MULTIPOLYGON', 'POLYGON', 'LINEARRING' ])
+      assert.isTrue(geom.isEmpty())
+    })
+    it('should propagate exceptions', () => {
+      assert.throws(() => {
+        multi().visit(() => {
+          throw new Error('visit error')
+        })
+      }, /visit error/)
+    })
+  })
   describe('fromWKT()', () => {
     it('should return valid result', () => {
       const point2d = gdal.Geometry.fromWKT('POINT (1 2)') as gdal.Point
@@ -191,6 +278,75 @@ describe('gdal.Geometry', () => {
       ]))
     })
   })
+  const wkbColumn = () => {
+    const wkbs = [] as Buffer[]
+    for (let i = 0; i < 50; i++) wkbs.push(new gdal.Point(i, 2 * i).toWKB())
+    // an empty element is a null geometry
+    wkbs.push(Buffer.alloc(0))
+    const offsets = new Uint32Array(wkbs.length + 1)
+    for (let i = 0; i < wkbs.length; i++) offsets[i + 1] = offsets[i] + wkbs[i].length
+    return { buffer: Buffer.concat(wkbs), offsets }
+  }
+  describe('fromWKBArray()', () => {
+    it('should return valid result', () => {
+      const { buffer, offsets } = wkbColumn()
+      const geoms = gdal.Geometry.fromWKBArray(buffer, offsets)
+      assert.lengthOf(geoms, 51)
+      for (let i = 0; i < 50; i++) {
+        assert.instanceOf(geoms[i], gdal.Point)
+        assert.equal((geoms[i] as gdal.Point).x, i)
+        assert.equal((geoms[i] as gdal.Point).y, 2 * i)
+      }
+      assert.isNull(geoms[50])
+    })
+    it('should throw on invalid offsets', () => {
+      const { buffer } = wkbColumn()
+      assert.throws(() => {
+        gdal.Geometry.fromWKBArray(buffer, [ 0, buffer.length + 1 ])
+      }, /offsets/)
+    })
+    for (const [ name, offset ] of [
+      [ 'negative', -1 ], [ 'NaN', NaN ], [ 'infinite', Infinity ], [ 'fractional', 0.5 ], [ 'past the end', 1e20 ]
+    ] as [string, number][]) {
+      it(`should throw on ${name} offsets`, () => {
+        const { buffer } = wkbColumn()
+        assert.throws(() => {
+          gdal.Geometry.fromWKBArray(buffer, [ 0, offset ])
+        }, RangeError, /non-negative integers/)
+        assert.throws(() => {
+          gdal.Geometry.fromWKBArray(buffer, new Float64Array([ 0, offset ]))
+        }, RangeError, /non-negative integers/)
+      })
+    }
+    it('should throw on invalid WKB', () => {
+      assert.throws(() => {
+        gdal.Geometry.fromWKBArray(Buffer.from([ 1, 2, 3, 4, 5, 6, 7, 8 ]), [ 0, 8 ])
+      }, /geometry 0/)
+    })
+  })
+  describe('fromWKBArrayAsync()', () => {
+    it('should return valid result', () => {
+      const { buffer, offsets } = wkbColumn()
+      return gdal.Geometry.fromWKBArrayAsync(buffer, offsets).then((geoms) => {
+        assert.lengthOf(geoms, 51)
+        assert.equal((geoms[49] as gdal.Point).y, 98)
+        assert.isNull(geoms[50])
+      })
+    })
+  })
+  describe('fromWKTArrayAsync()', () => {
+    it('should return valid result', () => {
+      const wkts = [ 'POINT (1 2)', 'LINESTRING (0 0,1 1)', '' ]
+      const offsets = [ 0 ]
+      for (const wkt of wkts) offsets.push(offsets[offsets.length - 1] + wkt.length)
+      return gdal.Geometry.fromWKTArrayAsync(Buffer.from(wkts.join('')), offsets).then((geoms) => {
+        assert.lengthOf(geoms, 3)
+        assert.instanceOf(geoms[0], gdal.Point)
+        assert.instanceOf(geoms[1], gdal.LineString)
+        assert.isNull(geoms[2])
+      })
+    })
+  })
   if (semver.gte(gdal.version, '2.3.0')) {
     describe('fromGeoJson()', () => {
       it('should return valid result', () => {
@@ -0,0 +1,122 @@
+import * as gdal from 'gdal-async'
+import * as chai from 'chai'
+import * as chaiAsPromised from 'chai-as-promised'
+const assert = chai.assert
+chai.use(chaiAsPromised)
+
+describe('gdal.GeometryBatch', () => {
+  // eslint-disable-next-line @typescript-eslint/no-non-null-assertion
+  afterEach(global.gc!)
+
+  const points = () => {
+    const r = [] as gdal.Point[]
+    for (let i = 0; i < 100; i++) r.push(new gdal.Point(i, i))
+    return r
+  }
+
+  describe('constructor', () => {
+    it('should accept an array of geometries', () => {
+      const batch = new gdal.GeometryBatch(points())
+      assert.instanceOf(batch, gdal.GeometryBatch)
+      assert.equal(batch.count(), 100)
+    })
+    it('should be available as gdal.geometryBatch()', () => {
+      const batch = gdal.geometryBatch(points())
+      assert.instanceOf(batch, gdal.GeometryBatch)
+      assert.equal(batch.count(), 100)
+    })
+    it('should throw on non-geometry elements', () => {
+      assert.throws(() => {
+        new gdal.GeometryBatch([ new gdal.Point(1, 2), {} as gdal.Geometry ])
+      }, /must be Geometry objects/)
+    })
+  })
+
+  describe('buffer()', () => {
+    it('should buffer all the geometries', () => {
+      const input = points()
+      const r = gdal.geometryBatch(input).buffer(1)
+      assert.lengthOf(r.geometries, 100)
+      assert.lengthOf(r.errors, 100)
+      r.geometries.forEach((g, i) => {
+        assert.instanceOf(g, gdal.Polygon)
+        assert.isNull(r.errors[i])
+        assert.isTrue((g as gdal.Geometry).contains(input[i]))
+      })
+    })
+    it('should not modify the original geometries', () => {
+      const input = points()
+      gdal.geometryBatch(input).buffer(1)
+      input.forEach((p, i) => assert.equal(p.x, i))
+    })
+  })
+
+  describe('bufferAsync()', () => {
+    it('should buffer all the geometries', () => {
+      const input = points()
+      return gdal.geometryBatch(input).bufferAsync(1).then((r) => {
+        assert.lengthOf(r.geometries, 100)
+        r.geometries.forEach((g, i) => {
+          assert.instanceOf(g, gdal.Polygon)
+          assert.isTrue((g as gdal.Geometry).contains(input[i]))
+        })
+      })
+    })
+  })
+
+  describe('simplifyAsync()', () => {
+    it('should simplify all the geometries', () => {
+      const line = new gdal.LineString()
+      line.points.add(new gdal.Point(0, 0))
+      line.points.add(new gdal.Point(1, 0.01))
+      line.points.add(new gdal.Point(2, 0))
+      return gdal.geometryBatch([ line, line, line ]).simplifyAsync(0.1).then((r) => {
+        assert.lengthOf(r.geometries, 3)
+        r.geometries.forEach((g) => assert.equal((g as gdal.LineString).points.count(), 2))
+      })
+    })
+  })
+
+  describe('centroidAsync()', () => {
+    it('should compute all the centroids', () => {
+      const polygons = points().map((p) => p.buffer(1))
+      return gdal.geometryBatch(polygons).centroidAsync().then((r) => {
+        r.geometries.forEach((g, i) => {
+          assert.instanceOf(g, gdal.Point)
+          assert.closeTo((g as gdal.Point).x, i, 1e-6)
+          assert.closeTo((g as gdal.Point).y, i, 1e-6)
+        })
+      })
+    })
+  })
+
+  describe('makeValidAsync()', () => {
+    it('should report the errors per geometry', () => {
+      const polygon = gdal.Geometry.fromWKT('POLYGON ((0 0, 10 10, 0 10, 10 0, 0 0))')
+      return gdal.geometryBatch([ polygon, new gdal.Point(1, 2) ]).makeValidAsync().then((r) => {
+        assert.lengthOf(r.geometries, 2)
+        assert.lengthOf(r.errors, 2)
+        r.geometries.forEach((g, i) => {
+          if (g === null) assert.isString(r.errors[i])
+          else assert.isTrue(g.isValid())
+        })
+      })
+    })
+  })
+
+  describe('transformAsync()', () => {
+    it('should transform copies of all the geometries', () => {
+      const input = points()
+      const ct = new gdal.CoordinateTransformation(gdal.SpatialReference.fromEPSG(4326),
+        gdal.SpatialReference.fromEPSG(3857))
+      return gdal.geometryBatch(input).transformAsync(ct).then((r) => {
+        r.geometries.forEach((g, i) => {
+          assert.isNull(r.errors[i])
+          assert.instanceOf(g, gdal.Point)
+          assert.equal(input[i].x, i)
+        })
+        assert.closeTo((r.geometries[1] as gdal.Point).y, 111325.14, 1)
+      })
+    })
+  })
+})
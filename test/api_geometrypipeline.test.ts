@@ -0,0 +1,98 @@
+import * as gdal from 'gdal-async'
+import * as path from 'path'
+import * as chai from 'chai'
+import * as chaiAsPromised from 'chai-as-promised'
+const assert = chai.assert
+chai.use(chaiAsPromised)
+
+describe('gdal.GeometryPipeline', () => {
+  // eslint-disable-next-line @typescript-eslint/no-non-null-assertion
+  afterEach(global.gc!)
+
+  const wgs84 = gdal.SpatialReference.fromEPSG(4326)
+  const mercator = gdal.SpatialReference.fromEPSG(3857)
+
+  const point = (x: number, y: number) => {
+    const p = new gdal.Point(x, y)
+    p.srs = wgs84
+    return p
+  }
+
+  describe('geometry.pipeline()', () => {
+    it('should return a GeometryPipeline', () => {
+      assert.instanceOf(new gdal.Point(1, 2).pipeline(), gdal.GeometryPipeline)
+    })
+    it('should run all the steps', () => {
+      const p = point(1, 1)
+      const r = p.pipeline().transformTo(mercator).buffer(10).centroid().run() as gdal.Point
+      assert.instanceOf(r, gdal.Point)
+      assert.closeTo(r.x, 111319.49, 1)
+      // the source is not modified
+      assert.equal(p.x, 1)
+    })
+    it('should produce WKB', () => {
+      const r = new gdal.Point(1, 2).pipeline().swapXY().toWKB('LSB').run() as Buffer
+      assert.instanceOf(r, Buffer)
+      const p = gdal.Geometry.fromWKB(r) as gdal.Point
+      assert.equal(p.x, 2)
+      assert.equal(p.y, 1)
+    })
+    it('should produce WKT', () => {
+      const r = new gdal.Point(1, 2).pipeline().toWKT().run()
+      assert.equal(r, 'POINT (1 2)')
+    })
+    it('should throw on error', () => {
+      assert.throws(() => {
+        new gdal.Point(1, 2).pipeline().transformTo(mercator).run()
+      }, /spatial reference/)
+    })
+    it('should throw on invalid steps', () => {
+      assert.throws(() => {
+        new gdal.Point(1, 2).pipeline().buffer(undefined as unknown as number).run()
+      }, /distance/)
+    })
+  })
+
+  describe('geometry.pipeline().runAsync()', () => {
+    it('should run all the steps', () => {
+      const p = point(1, 1)
+      return assert.isFulfilled(p.pipeline().transformTo(mercator).makeValid().simplify(1).buffer(5).toWKB().runAsync()
+        .then((wkb) => {
+          const r = gdal.Geometry.fromWKB(wkb as Buffer)
+          assert.instanceOf(r, gdal.Polygon)
+        }))
+    })
+    it('should reject on error', () => {
+      return assert.isRejected(new gdal.Point(1, 2).pipeline().transformTo(mercator).runAsync(), /spatial reference/)
+    })
+  })
+
+  describe('gdal.geometryPipeline()', () => {
+    it('should process an array with per-element errors', () => {
+      const input = [ point(1, 1), new gdal.Point(1, 1), point(2, 2) ]
+      return gdal.geometryPipeline(input).transformTo(mercator).runAsync().then((r) => {
+        const { results, errors } = r as gdal.GeometryPipelineResult
+        assert.lengthOf(results, 3)
+        assert.instanceOf(results[0], gdal.Point)
+        assert.isNull(errors[0])
+        assert.isNull(results[1])
+        assert.isString(errors[1])
+        assert.instanceOf(results[2], gdal.Point)
+      })
+    })
+  })
+
+  describe('layer.pipeline()', () => {
+    it('should process all the features', () => {
+      const ds = gdal.open(path.resolve(__dirname, 'data', 'park.geo.json'))
+      const layer = ds.layers.get(0)
+      return layer.pipeline().buffer(0.001).toWKT().runAsync().then((r) => {
+        const { results, errors, fids } = r as gdal.GeometryPipelineResult
+        assert.lengthOf(results, layer.features.count())
+        assert.lengthOf(fids as number[], layer.features.count())
+        assert.isNull(errors[0])
+        assert.match(results[0] as string, /^POLYGON|^MULTIPOLYGON/)
+      })
+    })
+  })
+})
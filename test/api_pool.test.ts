@@ -0,0 +1,110 @@
+import * as gdal from 'gdal-async'
+import * as chai from 'chai'
+import * as path from 'path'
+const assert = chai.assert
+import * as chaiAsPromised from 'chai-as-promised'
+chai.use(chaiAsPromised)
+
+describe('gdal.DatasetPool', () => {
+  // eslint-disable-next-line @typescript-eslint/no-non-null-assertion
+  afterEach(global.gc!)
+
+  const sample = path.resolve(__dirname, 'data', 'sample.tif')
+  const multiband = path.resolve(__dirname, 'data', 'multiband.tif')
+
+  it('should reuse the released datasets', async () => {
+    const pool = new gdal.DatasetPool()
+    const ds1 = await pool.acquire(sample)
+    assert.instanceOf(ds1, gdal.Dataset)
+    pool.release(ds1)
+    const ds2 = await pool.acquire(sample)
+    assert.strictEqual(ds2, ds1)
+    pool.release(ds2)
+    assert.deepEqual(pool.stats(), { size: 1, idle: 1, leased: 0, waiting: 0 })
+    pool.close()
+  })
+
+  it('should open several datasets for the same path up to maxPerKey', async () => {
+    const pool = new gdal.DatasetPool({ maxPerKey: 2 })
+    const ds1 = await pool.acquire(sample)
+    const ds2 = await pool.acquire(sample)
+    assert.notStrictEqual(ds2, ds1)
+    let ds3: gdal.Dataset | undefined
+    const q = pool.acquire(sample).then((ds) => {
+      ds3 = ds
+    })
+    await new Promise((resolve) => setImmediate(resolve))
+    assert.isUndefined(ds3)
+    assert.equal(pool.stats().waiting, 1)
+    pool.release(ds2)
+    await q
+    assert.strictEqual(ds3, ds2)
+    pool.release(ds1)
+    pool.release(ds3 as gdal.Dataset)
+    pool.close()
+  })
+
+  it('should close the least recently used idle dataset when full', async () => {
+    const pool = new gdal.DatasetPool({ max: 1 })
+    const ds1 = await pool.acquire(sample)
+    pool.release(ds1)
+    const ds2 = await pool.acquire(multiband)
+    assert.throws(() => {
+      ds1.bands.count()
+    }, /destroyed/)
+    assert.deepEqual(pool.stats(), { size: 1, idle: 0, leased: 1, waiting: 0 })
+    pool.release(ds2)
+    pool.close()
+  })
+
+  it('should close the idle datasets after idleTimeout', async () => {
+    const pool = new gdal.DatasetPool({ idleTimeout: 10 })
+    const ds = await pool.acquire(sample)
+    pool.release(ds)
+    await new Promise((resolve) => setTimeout(resolve, 50))
+    assert.equal(pool.stats().size, 0)
+    assert.throws(() => {
+      ds.bands.count()
+    }, /destroyed/)
+  })
+
+  it('should release the dataset after use()', async () => {
+    const pool = new gdal.DatasetPool()
+    const count = await pool.use(multiband, (ds) => ds.bands.countAsync())
+    assert.equal(count, 3)
+    await assert.isRejected(pool.use(multiband, () => {
+      throw new Error('failed')
+    }), /failed/)
+    assert.deepEqual(pool.stats(), { size: 1, idle: 1, leased: 0, waiting: 0 })
+    pool.close()
+  })
+
+  it('should reject when the dataset cannot be opened', async () => {
+    const pool = new gdal.DatasetPool()
+    await assert.isRejected(pool.acquire(path.resolve(__dirname, 'data', 'nonexistent.tif')))
+    assert.equal(pool.stats().size, 0)
+  })
+
+  it('should close the destroyed datasets', async () => {
+    const pool = new gdal.DatasetPool()
+    const ds = await pool.acquire(sample)
+    pool.destroy(ds)
+    assert.equal(pool.stats().size, 0)
+    assert.throws(() => {
+      pool.release(ds)
+    }, /not leased/)
+  })
+
+  it('should reject the waiting requests on close()', async () => {
+    const pool = new gdal.DatasetPool({ maxPerKey: 1 })
+    const ds = await pool.acquire(sample)
+    const q = pool.acquire(sample)
+    pool.close()
+    await assert.isRejected(q, /closed/)
+    await assert.isRejected(pool.acquire(sample), /closed/)
+    pool.release(ds)
+    assert.throws(() => {
+      ds.bands.count()
+    }, /destroyed/)
+  })
+})
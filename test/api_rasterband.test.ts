@@ -1467,6 +1467,82 @@ describe('gdal.RasterBand', () => {
         assert.deepEqual(band.pixels.clampBlock(0, 0), { x: 984, y: 8 })
         assert.deepEqual(band.pixels.clampBlock(0, 100), { x: 984, y: 4 })
       })
+      describe('sample()', () => {
+        it('should return the same values as get()', () => {
+          const ds = gdal.open(`${__dirname}/data/sample.tif`)
+          const band = ds.bands.get(1)
+          const xs = new Float64Array(100)
+          const ys = new Float64Array(100)
+          for (let i = 0; i < 100; i++) {
+            xs[i] = (i * 97) % band.size.x + 0.5
+            ys[i] = (i * 31) % band.size.y + 0.5
+          }
+          const values = band.pixels.sample(xs, ys)
+          assert.instanceOf(values, Float64Array)
+          for (let i = 0; i < 100; i++) {
+            assert.equal(values[i], band.pixels.get(Math.floor(xs[i]), Math.floor(ys[i])))
+          }
+        })
+        it('should return NaN outside the raster and for noData', () => {
+          const ds = gdal.open('temp', 'w', 'MEM', 16, 16, 1, gdal.GDT_Byte)
+          const band = ds.bands.get(1)
+          band.noDataValue = 1
+          band.fill(1)
+          band.pixels.set(2, 2, 5)
+          const values = band.pixels.sample(new Float64Array([ -1, 16.5, 2.5, 3.5 ]), new Float64Array([ 0, 0, 2.5, 3.5 ]))
+          assert.isNaN(values[0])
+          assert.isNaN(values[1])
+          assert.equal(values[2], 5)
+          assert.isNaN(values[3])
+        })
+        it('should interpolate', () => {
+          // a linear ramp where each pixel is its column
+          const ds = gdal.open('temp', 'w', 'MEM', 16, 16, 1, gdal.GDT_Float64)
+          const band = ds.bands.get(1)
+          const data = new Float64Array(256)
+          for (let i = 0; i < 256; i++) data[i] = i % 16
+          band.pixels.write(0, 0, 16, 16, data)
+          const xs = new Float64Array([ 4.5, 4.75, 10.2 ])
+          const ys = new Float64Array([ 8, 8, 3.3 ])
+          assert.deepEqual(Array.from(band.pixels.sample(xs, ys)), [ 4, 4, 10 ])
+          const bilinear = band.pixels.sample(xs, ys, { interpolation: 'bilinear' })
+          const cubic = band.pixels.sample(xs, ys, { interpolation: 'cubic' })
+          for (let i = 0; i < 3; i++) {
+            assert.closeTo(bilinear[i], xs[i] - 0.5, 1e-9)
+            assert.closeTo(cubic[i], xs[i] - 0.5, 1e-9)
+          }
+        })
+        it('should support georeferenced coordinates', () => {
+          const ds = gdal.open(`${__dirname}/data/sample.tif`)
+          const band = ds.bands.get(1)
+          const gt = ds.geoTransform as number[]
+          const values = band.pixels.sample(
+            new Float64Array([ gt[0] + 200.5 * gt[1] ]),
+            new Float64Array([ gt[3] + 300.5 * gt[5] ]),
+            { coords: 'geo' })
+          assert.equal(values[0], band.pixels.get(200, 300))
+        })
+        it('should support the async version', () => {
+          const ds = gdal.open(`${__dirname}/data/sample.tif`)
+          const band = ds.bands.get(1)
+          return assert.eventually.deepEqual(
+            band.pixels.sampleAsync(new Float64Array([ 200.5 ]), new Float64Array([ 300.5 ])).then((r) => Array.from(r)),
+            [ 10 ])
+        })
+        it('should throw on invalid arguments', () => {
+          const ds = gdal.open('temp', 'w', 'MEM', 16, 16, 1, gdal.GDT_Byte)
+          const band = ds.bands.get(1)
+          assert.throws(() => {
+            band.pixels.sample([ 1 ] as unknown as Float64Array, new Float64Array([ 1 ]))
+          }, /must be Float64Arrays/)
+          assert.throws(() => {
+            band.pixels.sample(new Float64Array(2), new Float64Array(1))
+          }, /same length/)
+          assert.throws(() => {
+            band.pixels.sample(new Float64Array(1), new Float64Array(1), { interpolation: 'lanczos' })
+          }, /interpolation must be/)
+        })
+      })
     })
     describe('flush()', () => {
       it('should flush the written data', () => {
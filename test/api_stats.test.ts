@@ -0,0 +1,152 @@
+import * as gdal from 'gdal-async'
+import * as chai from 'chai'
+import * as path from 'path'
+import * as diagnostics_channel from 'diagnostics_channel'
+const assert = chai.assert
+import * as chaiAsPromised from 'chai-as-promised'
+chai.use(chaiAsPromised)
+
+describe('gdal.stats()', () => {
+  // eslint-disable-next-line @typescript-eslint/no-non-null-assertion
+  afterEach(global.gc!)
+
+  const sample = path.resolve(__dirname, 'data', 'sample.tif')
+
+  beforeEach(() => {
+    gdal.stats.reset()
+  })
+
+  it('should record the sync and async calls', async () => {
+    const ds = gdal.open(sample)
+    const band = ds.bands.get(1)
+    band.pixels.get(200, 300)
+    band.pixels.get(201, 300)
+    await band.pixels.getAsync(200, 300)
+
+    const stats = gdal.stats()
+    assert.equal(stats['RasterBandPixels::get'].calls, 2)
+    assert.equal(stats['RasterBandPixels::get'].errors, 0)
+    assert.equal(stats['RasterBandPixels::get'].exec.count, 2)
+    assert.equal(stats['RasterBandPixels::get'].queue.count, 0)
+    const async = stats['RasterBandPixels::getAsync']
+    assert.equal(async.calls, 1)
+    assert.equal(async.queue.count, 1)
+    for (const h of [ async.queue, async.lock, async.exec, async.rval ]) {
+      assert.isAtLeast(h.mean, 0)
+      assert.isAtLeast(h.max, h.p50)
+      assert.isAtLeast(h.p99, h.p50)
+    }
+  })
+
+  it('should count the errors', async () => {
+    const ds = gdal.open(sample)
+    const band = ds.bands.get(1)
+    assert.throws(() => {
+      band.pixels.get(-1, -1)
+    })
+    await assert.isRejected(band.pixels.getAsync(-1, -1))
+    const stats = gdal.stats()
+    assert.equal(stats['RasterBandPixels::get'].errors, 1)
+    assert.equal(stats['RasterBandPixels::getAsync'].errors, 1)
+  })
+
+  it('should reset the statistics', () => {
+    const ds = gdal.open(sample)
+    ds.bands.get(1).pixels.get(200, 300)
+    gdal.stats.reset()
+    assert.deepEqual(gdal.stats(), {})
+  })
+
+  it('should publish the jobs on diagnostics_channel', async () => {
+    const ds = gdal.open(sample)
+    const band = ds.bands.get(1)
+    const events: gdal.JobEvent[] = []
+    const listener = (event: unknown) => {
+      events.push(event as gdal.JobEvent)
+    }
+    diagnostics_channel.subscribe('gdal-async:job', listener)
+    gdal.stats.publish(true)
+    try {
+      await band.pixels.getAsync(200, 300)
+    } finally {
+      gdal.stats.publish(false)
+      diagnostics_channel.unsubscribe('gdal-async:job', listener)
+    }
+    band.pixels.get(200, 300)
+    assert.lengthOf(events, 1)
+    assert.equal(events[0].method, 'RasterBandPixels::getAsync')
+    assert.isTrue(events[0].async)
+    assert.isFalse(events[0].error)
+    assert.deepEqual(events[0].datasets, [ ds.uid ])
+    assert.isAtLeast(events[0].exec, 0)
+  })
+
+  it('should count the dataset lock acquisitions', async () => {
+    const ds = gdal.open(sample)
+    const band = ds.bands.get(1)
+    await Promise.all(new Array(16).fill(0).map((_, i) => band.pixels.readAsync(0, i * 8, 984, 8)))
+    const own = gdal.stats.locks(ds)
+    assert.isAtLeast(own.acquisitions, 16)
+    assert.isAtMost(own.contended, own.acquisitions)
+    assert.isAtLeast(own.wakeups, own.contended)
+    assert.isAtLeast(own.wait, own.maxWait)
+    assert.isAtLeast(gdal.stats.locks().acquisitions, own.acquisitions)
+
+    gdal.stats.reset()
+    assert.deepEqual(gdal.stats.locks(ds), { acquisitions: 0, contended: 0, wakeups: 0, wait: 0, maxWait: 0 })
+    ds.close()
+    assert.throws(() => {
+      gdal.stats.locks(ds)
+    })
+  })
+})
+
+describe('gdal.profileSync()', () => {
+  // eslint-disable-next-line @typescript-eslint/no-non-null-assertion
+  afterEach(global.gc!)
+
+  const sample = path.resolve(__dirname, 'data', 'sample.tif')
+
+  afterEach(() => {
+    gdal.profileSync(false)
+  })
+
+  it('should record the slow sync calls with their call site', () => {
+    const ds = gdal.open(sample)
+    gdal.profileSync({ thresholdUs: 0 })
+    ds.bands.get(1).pixels.get(200, 300)
+    assert.isObject(ds.rasterSize)
+    gdal.profileSync(false)
+
+    const profile = gdal.syncProfile()
+    const get = profile.find((e) => e.method === 'RasterBandPixels.get')
+    assert.isDefined(get)
+    assert.equal(get?.calls, 1)
+    assert.include(get?.site, 'api_stats.test')
+    assert.isAtLeast(get?.max as number, 0)
+    assert.equal(get?.total, get?.max)
+    assert.isDefined(profile.find((e) => e.method === 'Dataset.rasterSize'))
+    for (let i = 1; i < profile.length; i++) assert.isAtMost(profile[i].total, profile[i - 1].total)
+  })
+
+  it('should not record the calls below the threshold', () => {
+    const ds = gdal.open(sample)
+    gdal.profileSync({ thresholdUs: 1e9 })
+    ds.bands.get(1).pixels.get(200, 300)
+    assert.deepEqual(gdal.syncProfile(), [])
+  })
+
+  it('should not record anything when stopped', () => {
+    const ds = gdal.open(sample)
+    gdal.profileSync({ thresholdUs: 0 })
+    gdal.profileSync(false)
+    ds.bands.get(1).pixels.get(200, 300)
+    assert.deepEqual(gdal.syncProfile(), [])
+  })
+
+  it('should throw on invalid options', () => {
+    assert.throws(() => {
+      gdal.profileSync({ thresholdUs: -1 })
+    }, /thresholdUs must be a positive number/)
+  })
+})
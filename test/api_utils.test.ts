@@ -95,6 +95,48 @@ describe('gdal_utils', () => {
     })
   })
 
+  describe('translateToBufferAsync', () => {
+    it('should return the output file as a Buffer', async () => {
+      const ds = gdal.open(path.resolve(__dirname, 'data', 'multiband.tif'))
+      const data = await gdal.translateToBufferAsync(ds, 'PNG', [ '-b', '1' ])
+      assert.instanceOf(data, Buffer)
+      // PNG signature
+      assert.equal(data.toString('hex', 0, 8), '89504e470d0a1a0a')
+      const tmpFile = `/vsimem/${String(Math.random()).substring(2)}.png`
+      gdal.vsimem.set(data, tmpFile)
+      const out = gdal.open(tmpFile)
+      assert.equal(out.driver.description, 'PNG')
+      assert.equal(out.bands.count(), 1)
+      assert.deepEqual(out.rasterSize, ds.rasterSize)
+      out.close()
+      gdal.vsimem.release(tmpFile)
+    })
+    it('should support the sync version', () => {
+      const ds = gdal.open(path.resolve(__dirname, 'data', 'multiband.tif'))
+      const data = gdal.translateToBuffer(ds, 'GTiff')
+      assert.instanceOf(data, Buffer)
+      assert.isAbove(data.length, 0)
+    })
+    it('should not leave any files in /vsimem/', async () => {
+      const ds = gdal.open(path.resolve(__dirname, 'data', 'multiband.tif'))
+      await gdal.translateToBufferAsync(ds, 'PNG', [ '-b', '1' ])
+      // /vsimem/ cannot be listed when it is empty
+      const marker = `/vsimem/${String(Math.random()).substring(2)}`
+      gdal.vsimem.copy(Buffer.alloc(1), marker)
+      assert.notInclude(gdal.fs.readDir('/vsimem/').join(), '_node_gdal_output_')
+      gdal.vsimem.release(marker)
+    })
+    it('should reject on invalid format', () => {
+      const ds = gdal.open(path.resolve(__dirname, 'data', 'multiband.tif'))
+      return assert.isRejected(gdal.translateToBufferAsync(ds, 'nosuchformat'), /Invalid format/)
+    })
+    it('should reject when the dataset is already closed', () => {
+      const ds = gdal.open(path.resolve(__dirname, 'data', 'multiband.tif'))
+      ds.close()
+      return assert.isRejected(gdal.translateToBufferAsync(ds, 'PNG'), /already been destroyed/)
+    })
+  })
+
   describe('vectorTranslate', () => {
     it('should accept a destination filename', () => {
       const ds = gdal.open(path.resolve(__dirname, 'data', 'park.geo.json'))
@@ -339,6 +381,25 @@ describe('gdal_utils', () => {
     })
   })
 
+  describe('warpToBufferAsync', () => {
+    it('should return the output file as a Buffer', async () => {
+      const ds = gdal.open(path.resolve(__dirname, 'data', 'sample.tif'))
+      const data = await gdal.warpToBufferAsync([ ds ], 'GTiff', [ '-t_srs', 'epsg:3587' ])
+      assert.instanceOf(data, Buffer)
+      const tmpFile = `/vsimem/${String(Math.random()).substring(2)}.tif`
+      gdal.vsimem.set(data, tmpFile)
+      const out = gdal.open(tmpFile)
+      assert.isTrue(out.srs?.isSame(gdal.SpatialReference.fromEPSG(3587)))
+      out.close()
+      gdal.vsimem.release(tmpFile)
+    })
+    it('should reject on error', () => {
+      const ds = gdal.open(path.resolve(__dirname, 'data', 'sample.tif'))
+      ds.close()
+      return assert.isRejected(gdal.warpToBufferAsync([ ds ], 'GTiff', [ '-t_srs', 'epsg:3587' ]))
+    })
+  })
+
   describe('buildVRT', () => {
     it('should be equivalent to gdalbuildvrt', () => {
       const tmpFile = `/vsimem/${String(Math.random()).substring(2)}.vrt`
@@ -814,4 +875,299 @@ describe('gdal_utils', () => {
       gdal.vsimem.release(tempFile)
     })
   })
+
+  describe('calcExprAsync', () => {
+    it('should perform the given calculation', async () => {
+      const tempFile = `/vsimem/cloudbase_expr_${String(Math.random()).substring(2)}.tiff`
+      const T2m = await gdal.openAsync(path.resolve(__dirname, 'data','AROME_T2m_10.tiff'))
+      const D2m = await gdal.openAsync(path.resolve(__dirname, 'data','AROME_D2m_10.tiff'))
+      const size = await T2m.rasterSizeAsync
+      const cloudBase = await gdal.openAsync(tempFile,
+        'w', 'GTiff', size.x, size.y, 1, gdal.GDT_Float64);
+
+      (await cloudBase.bands.getAsync(1)).noDataValue = -1e38
+
+      let done = 0
+      await gdal.calcExprAsync({
+        t: await T2m.bands.getAsync(1),
+        td: await D2m.bands.getAsync(1)
+      }, await cloudBase.bands.getAsync(1), '125 * (t - td)', {
+        convertNoData: true,
+        progress_cb: (complete) => {
+          done = complete
+        }
+      })
+      assert.closeTo(done, 1, 0.1)
+
+      const t2mData = await (await T2m.bands.getAsync(1)).pixels.readAsync(0, 0, size.x, size.y)
+      const d2mData = await (await D2m.bands.getAsync(1)).pixels.readAsync(0, 0, size.x, size.y)
+      const cbData = await (await cloudBase.bands.getAsync(1)).pixels.readAsync(0, 0, size.x, size.y)
+
+      for (let i = 0; i < cbData.length; i+=1000) {
+        assert.closeTo(cbData[i], 125 * (t2mData[i] - d2mData[i]), 1e-6)
+      }
+      cloudBase.close()
+      gdal.vsimem.release(tempFile)
+    })
+
+    it('should support operators and functions', () => {
+      const ds = gdal.open('temp', 'w', 'MEM', 4, 1, 2, gdal.GDT_Float64)
+      ds.bands.get(1).pixels.write(0, 0, 4, 1, new Float64Array([ 1, 4, 9, 16 ]))
+      const output = gdal.open('temp', 'w', 'MEM', 4, 1, 1, gdal.GDT_Float64).bands.get(1)
+      gdal.calcExpr({ A: ds.bands.get(1) }, output, 'A > 4 ? sqrt(A) : -A^2 % 5 + max(A, 2)')
+      assert.deepEqual(Array.from(output.pixels.read(0, 0, 4, 1)), [ 1, 3, 3, 4 ])
+    })
+
+    it('should support converting NoData values', async () => {
+      const tempFile = `/vsimem/calc_expr_nodata_${String(Math.random()).substring(2)}.tiff`
+      const dem = await gdal.openAsync(path.resolve(__dirname, 'data', 'dem_azimuth50_pa.img'))
+      const size = await dem.rasterSizeAsync
+      const output = await gdal.openAsync(tempFile,
+        'w', 'GTiff', size.x, size.y, 1, gdal.GDT_Float64);
+
+      (await output.bands.getAsync(1)).noDataValue = -100
+
+      await gdal.calcExprAsync({
+        dem: await dem.bands.getAsync(1)
+      }, await output.bands.getAsync(1), 'dem + 1', { convertNoData: true })
+
+      assert.equal(output.bands.get(1).pixels.get(0, 0), -100)
+      output.close()
+      gdal.vsimem.release(tempFile)
+    })
+
+    it('should throw on invalid expressions', () => {
+      const ds = gdal.open('temp', 'w', 'MEM', 4, 1, 1, gdal.GDT_Float64)
+      assert.throws(() => {
+        gdal.calcExpr({ A: ds.bands.get(1) }, ds.bands.get(1), 'A + B')
+      }, /Unknown variable "B"/)
+      assert.throws(() => {
+        gdal.calcExpr({ A: ds.bands.get(1) }, ds.bands.get(1), 'A +')
+      }, /Invalid expression/)
+    })
+
+    it('should reject when raster sizes do not match', () => {
+      const tempFile = `/vsimem/invalid_calc_expr_${String(Math.random()).substring(2)}.tiff`
+      return assert.isRejected(
+        gdal.calcExprAsync({
+          A: gdal.open(path.resolve(__dirname, 'data','AROME_T2m_10.tiff')).bands.get(1),
+          B: gdal.open(path.resolve(__dirname, 'data','sample.tif')).bands.get(1)
+        },
+        gdal.open(tempFile, 'w', 'GTiff', 128, 128, 1, gdal.GDT_Float64).bands.get(1),
+        'A + B'),
+        /dimensions must match/
+      )
+    })
+  })
+
+  describe('processTilesAsync', () => {
+    const cloudBase = async (options: Partial<gdal.ProcessTilesOptions>) => {
+      const tempFile = `/vsimem/cloudbase_tiles_${String(Math.random()).substring(2)}.tiff`
+      const T2m = await gdal.openAsync(path.resolve(__dirname, 'data','AROME_T2m_10.tiff'))
+      const D2m = await gdal.openAsync(path.resolve(__dirname, 'data','AROME_D2m_10.tiff'))
+      const size = await T2m.rasterSizeAsync
+      const output = await gdal.openAsync(tempFile,
+        'w', 'GTiff', size.x, size.y, 1, gdal.GDT_Float64, { TILED: 'YES', BLOCKXSIZE: 32, BLOCKYSIZE: 32 })
+
+      let done = 0
+      await gdal.processTilesAsync({
+        inputs: {
+          t: await T2m.bands.getAsync(1),
+          td: await D2m.bands.getAsync(1)
+        },
+        output: await output.bands.getAsync(1),
+        tileSize: 50,
+        progress_cb: (complete) => {
+          done = complete
+        },
+        ...options
+      })
+      assert.closeTo(done, 1, 1e-6)
+
+      const t2mData = await (await T2m.bands.getAsync(1)).pixels.readAsync(0, 0, size.x, size.y)
+      const d2mData = await (await D2m.bands.getAsync(1)).pixels.readAsync(0, 0, size.x, size.y)
+      const cbData = await (await output.bands.getAsync(1)).pixels.readAsync(0, 0, size.x, size.y)
+
+      for (let i = 0; i < cbData.length; i+=97) {
+        assert.closeTo(cbData[i], 125 * (t2mData[i] - d2mData[i]), 1e-6)
+      }
+      output.close()
+      gdal.vsimem.release(tempFile)
+    }
+
+    it('should evaluate an expression on all the tiles', () =>
+      cloudBase({ expr: '125 * (t - td)', concurrency: 4 }))
+
+    it('should apply a function on all the tiles', () =>
+      cloudBase({
+        fn: ({ t, td }, output, tile) => {
+          assert.isAtMost(tile.width, 64)
+          assert.isAtMost(tile.height, 64)
+          assert.lengthOf(output, tile.width * tile.height)
+          for (let i = 0; i < output.length; i++) output[i] = 125 * (t[i] - td[i])
+        },
+        concurrency: 3
+      }))
+
+    it('should support async functions', () =>
+      cloudBase({
+        fn: async ({ t, td }, output) => {
+          await new Promise((resolve) => setImmediate(resolve))
+          for (let i = 0; i < output.length; i++) output[i] = 125 * (t[i] - td[i])
+        }
+      }))
+
+    it('should support inputs and output in the same dataset', async () => {
+      const ds = gdal.open('temp', 'w', 'MEM', 300, 200, 2, gdal.GDT_Float64)
+      const input = new Float64Array(300 * 200).map((_, i) => i)
+      ds.bands.get(1).pixels.write(0, 0, 300, 200, input)
+      await gdal.processTilesAsync({
+        inputs: { A: ds.bands.get(1) },
+        output: ds.bands.get(2),
+        expr: 'A * 2',
+        tileSize: 16
+      })
+      const result = ds.bands.get(2).pixels.read(0, 0, 300, 200)
+      for (let i = 0; i < result.length; i += 101) {
+        assert.equal(result[i], input[i] * 2)
+      }
+    })
+
+    it('should support converting NoData values', async () => {
+      const dem = gdal.open(path.resolve(__dirname, 'data', 'dem_azimuth50_pa.img'))
+      const size = dem.rasterSize
+      for (const method of [ { expr: 'dem + 1' }, { fn: ({ dem }, output) => {
+        for (let i = 0; i < output.length; i++) output[i] = dem[i] + 1
+      } } ]) {
+        const output = gdal.open('temp', 'w', 'MEM', size.x, size.y, 1, gdal.GDT_Float64)
+        output.bands.get(1).noDataValue = -100
+        await gdal.processTilesAsync({
+          inputs: { dem: dem.bands.get(1) },
+          output: output.bands.get(1),
+          convertNoData: true,
+          ...method
+        })
+        assert.equal(output.bands.get(1).pixels.get(0, 0), -100)
+      }
+    })
+
+    it('should reject on invalid arguments', async () => {
+      const ds = gdal.open('temp', 'w', 'MEM', 4, 1, 1, gdal.GDT_Float64)
+      await assert.isRejected(gdal.processTilesAsync({
+        inputs: { A: ds.bands.get(1) },
+        output: ds.bands.get(1)
+      }), /Exactly one of fn and expr/)
+      await assert.isRejected(gdal.processTilesAsync({
+        inputs: { A: ds.bands.get(1) },
+        output: ds.bands.get(1),
+        expr: 'A +'
+      }), /Invalid expression/)
+      await assert.isRejected(gdal.processTilesAsync({
+        inputs: { A: ds.bands.get(1) },
+        output: ds.bands.get(1),
+        expr: 'A',
+        tileSize: 0
+      }), /tileSize must be a positive number/)
+    })
+
+    it('should reject when the function throws', () => {
+      const ds = gdal.open('temp', 'w', 'MEM', 4, 1, 1, gdal.GDT_Float64)
+      return assert.isRejected(gdal.processTilesAsync({
+        inputs: { A: ds.bands.get(1) },
+        output: ds.bands.get(1),
+        fn: () => {
+          throw new Error('kernel failed')
+        }
+      }), /kernel failed/)
+    })
+  })
+
+  describe('AbortSignal', () => {
+    const upscale = [ '-outsize', '400%', '400%', '-r', 'cubic' ]
+    const assertAborted = (p: Promise<unknown>) => p.then(
+      () => assert.fail('the operation was not aborted'),
+      (err: Error) => assert.equal(err.name, 'AbortError'))
+
+    it('should not affect an operation that is not aborted', async () => {
+      const ds = gdal.open(path.resolve(__dirname, 'data', 'multiband.tif'))
+      const tmpFile = `/vsimem/${String(Math.random()).substring(2)}.tif`
+      const ac = new AbortController()
+      const out = await gdal.translateAsync(tmpFile, ds, [ '-b', '1' ], { signal: ac.signal })
+      assert.equal(out.bands.count(), 1)
+      out.close()
+      gdal.vsimem.release(tmpFile)
+    })
+
+    it('should reject without running when the signal is already aborted', async () => {
+      const ds = gdal.open(path.resolve(__dirname, 'data', 'multiband.tif'))
+      const tmpFile = `/vsimem/${String(Math.random()).substring(2)}.tif`
+      const ac = new AbortController()
+      ac.abort()
+      await assertAborted(gdal.translateAsync(tmpFile, ds, [ '-b', '1' ], { signal: ac.signal }))
+      assert.throws(() => gdal.fs.stat(tmpFile))
+    })
+
+    it('should interrupt a running GDAL operation', async () => {
+      const ds = gdal.open(path.resolve(__dirname, 'data', 'sample.tif'))
+      const tmpFile = `/vsimem/${String(Math.random()).substring(2)}.tif`
+      const ac = new AbortController()
+      let calls = 0
+      await assertAborted(gdal.translateAsync(tmpFile, ds, upscale, {
+        signal: ac.signal,
+        progress_cb: () => {
+          calls++
+          ac.abort()
+        }
+      }))
+      assert.isAbove(calls, 0)
+      // The dataset lock has been released
+      assert.isNumber(ds.bands.get(1).pixels.get(0, 0))
+    })
+
+    it('should drop an operation waiting for its dataset', async () => {
+      const ds = gdal.open(path.resolve(__dirname, 'data', 'sample.tif'))
+      const tmpFile = `/vsimem/${String(Math.random()).substring(2)}.tif`
+      const ac = new AbortController()
+      // The translation holds the lock of the dataset once it has reported its progress
+      let started: () => void = () => undefined
+      const progress = new Promise<void>((resolve) => {
+        started = resolve
+      })
+      const running = gdal.translateAsync(tmpFile, ds, upscale, { progress_cb: () => started() })
+      await progress
+      const queued = ds.bands.get(1).pixels.readAsync(0, 0, 16, 16, undefined, { signal: ac.signal })
+      ac.abort()
+      await assertAborted(queued)
+      const out = await running
+      assert.equal(out.rasterSize.x, ds.rasterSize.x * 4)
+      out.close()
+      gdal.vsimem.release(tmpFile)
+    })
+
+    it('should accept a signal in an additional last argument', async () => {
+      const ds = gdal.open(path.resolve(__dirname, 'data', 'sample.tif'))
+      const ac = new AbortController()
+      ac.abort()
+      const countAsync = ds.bands.countAsync as unknown as (options: { signal: AbortSignal }) => Promise<number>
+      await assertAborted(countAsync.call(ds.bands, { signal: ac.signal }))
+      assert.equal(await ds.bands.countAsync(), 1)
+    })
+
+    it('should call the callback with an AbortError', (done) => {
+      const ds = gdal.open(path.resolve(__dirname, 'data', 'sample.tif'))
+      const tmpFile = `/vsimem/${String(Math.random()).substring(2)}.tif`
+      const ac = new AbortController()
+      gdal.translateAsync(tmpFile, ds, upscale, {
+        signal: ac.signal,
+        progress_cb: () => ac.abort()
+      }, (err) => {
+        try {
+          assert.equal(err?.name, 'AbortError')
+          done()
+        } catch (e) {
+          done(e)
+        }
+      })
+    })
+  })
 })
@@ -457,4 +457,163 @@ describe('gdal', () => {
       })
     })
   })
+
+  describe('buildTilePyramidAsync()', () => {
+    let src: gdal.Dataset
+    beforeEach(() => {
+      src = gdal.open(`${__dirname}/data/sample.tif`)
+    })
+    afterEach(() => {
+      src.close()
+    })
+
+    it('should return the tiles of all the zoom levels', async () => {
+      let done = 0
+      const result = await gdal.buildTilePyramidAsync(src, {
+        minZoom: 0,
+        maxZoom: 4,
+        concurrency: 4,
+        progress_cb: (complete) => {
+          done = complete
+        }
+      })
+      assert.closeTo(done, 1, 1e-6)
+      assert.isArray(result.tiles)
+      const tiles = result.tiles as gdal.PyramidTile[]
+      assert.equal(result.count, tiles.length)
+      const zeroes = tiles.filter((t) => t.z === 0)
+      assert.lengthOf(zeroes, 1)
+      assert.include(zeroes[0], { x: 0, y: 0 })
+      const keys = new Set(tiles.map((t) => `${t.z}/${t.x}/${t.y}`))
+      for (const t of tiles) {
+        assert.instanceOf(t.data, Buffer)
+        // PNG signature
+        assert.equal(t.data.toString('hex', 0, 8), '89504e470d0a1a0a')
+        if (t.z > 0) assert.isTrue(keys.has(`${t.z - 1}/${t.x >> 1}/${t.y >> 1}`))
+      }
+      assert.isAbove(tiles.filter((t) => t.z === 4).length, 0)
+    })
+
+    it('should write the tiles to outDir', async () => {
+      const outDir = `/vsimem/tiles_${String(Math.random()).substring(2)}`
+      const result = await gdal.buildTilePyramidAsync(src, {
+        maxZoom: 2,
+        tileSize: 128,
+        resampling: 'Bilinear',
+        outDir
+      })
+      assert.isUndefined(result.tiles)
+      assert.isAbove(result.count, 2)
+      const tile = gdal.open(`${outDir}/0/0/0.png`)
+      assert.equal(tile.driver.description, 'PNG')
+      assert.deepEqual(tile.rasterSize, { x: 128, y: 128 })
+      // gray + alpha
+      assert.equal(tile.bands.count(), 2)
+      assert.isAbove(tile.bands.get(2).getStatistics(false, true).max, 0)
+      tile.close()
+    })
+
+    it('should support raw tiles', async () => {
+      const result = await gdal.buildTilePyramidAsync(src, { minZoom: 1, maxZoom: 1, tileSize: 64, format: 'raw' })
+      const tiles = result.tiles as gdal.PyramidTile[]
+      assert.isAbove(tiles.length, 0)
+      for (const t of tiles) {
+        assert.equal(t.z, 1)
+        assert.lengthOf(t.data, 2 * 64 * 64)
+      }
+    })
+
+    it('should throw on invalid arguments', () => {
+      assert.throws(() => {
+        gdal.buildTilePyramid(src, { minZoom: 3, maxZoom: 2 })
+      }, /Invalid zoom levels/)
+      assert.throws(() => {
+        gdal.buildTilePyramid(src, { maxZoom: 2, tileSize: 255 })
+      }, /tileSize must be an even number/)
+      assert.throws(() => {
+        gdal.buildTilePyramid(src, { maxZoom: 2, format: 'jpeg' })
+      }, /format must be one of/)
+    })
+  })
+
+  describe('WarpContext', () => {
+    let src: gdal.Dataset
+    let t_srs: gdal.SpatialReference
+    beforeEach(() => {
+      src = gdal.open(`${__dirname}/data/sample.tif`)
+      t_srs = gdal.SpatialReference.fromEPSG(4326)
+    })
+    afterEach(() => {
+      try {
+        src.close()
+      } catch (e) {
+        /* already closed */
+      }
+    })
+
+    it('should render the same pixels as reprojectImage()', () => {
+      const output = gdal.suggestedWarpOutput({ src, s_srs: src.srs as gdal.SpatialReference, t_srs })
+      const { x: w, y: h } = output.rasterSize
+
+      const dst = gdal.open('temp', 'w', 'MEM', w, h, 1, gdal.GDT_Byte)
+      dst.srs = t_srs
+      dst.geoTransform = output.geoTransform
+      gdal.reprojectImage({ src, dst, s_srs: src.srs as gdal.SpatialReference, t_srs, maxError: 0 })
+      const expected = dst.bands.get(1).pixels.read(0, 0, w, h)
+
+      const ctx = new gdal.WarpContext({ src, t_srs, maxError: 0 })
+      assert.equal(ctx.bands, 1)
+      assert.equal(ctx.dataType, gdal.GDT_Byte)
+      const actual = ctx.renderWindow(output.geoTransform, w, h)
+      assert.instanceOf(actual, Uint8Array)
+      assert.lengthOf(actual, w * h)
+
+      let same = 0
+      for (let i = 0; i < actual.length; i++) if (actual[i] === expected[i]) same++
+      assert.isAbove(same / actual.length, 0.99)
+    })
+
+    it('should render windows into the given array', async () => {
+      const ctx = new gdal.WarpContext({ src, t_srs, resampling: gdal.GRA_Bilinear, dataType: gdal.GDT_Float32 })
+      const output = gdal.suggestedWarpOutput({ src, s_srs: src.srs as gdal.SpatialReference, t_srs })
+      const gt = output.geoTransform
+      const data = new Float32Array(64 * 64)
+      const windows = [ 0, 1, 2, 3 ].map((i) => ctx.renderWindowAsync(
+        [ gt[0] + i * 64 * gt[1], gt[1], 0, gt[3] + i * 64 * gt[5], 0, gt[5] ], 64, 64,
+        i === 0 ? data : undefined))
+      const results = await Promise.all(windows)
+      assert.strictEqual(results[0], data)
+      for (const r of results) {
+        assert.instanceOf(r, Float32Array)
+        assert.lengthOf(r, 64 * 64)
+      }
+      assert.isAbove(Math.max(...data), 0)
+    })
+
+    it('should fill the windows outside of the source with dstNodata', () => {
+      const ctx = new gdal.WarpContext({ src, t_srs, dstNodata: 7 })
+      const data = ctx.renderWindow([ 100, 0.01, 0, 10, 0, -0.01 ], 16, 16)
+      assert.deepEqual(Array.from(new Set(data)), [ 7 ])
+    })
+
+    it('should throw on invalid arguments', () => {
+      assert.throws(() => {
+        new gdal.WarpContext({ src } as unknown as gdal.WarpContextOptions)
+      }, /t_srs/)
+      const ctx = new gdal.WarpContext({ src, t_srs })
+      assert.throws(() => {
+        ctx.renderWindow([ 0, 1, 0, 0, 0 ], 16, 16)
+      }, /6 elements/)
+      assert.throws(() => {
+        ctx.renderWindow([ 0, 1, 0, 0, 0, -1 ], 16, 16, new Float64Array(16 * 16))
+      }, /Array type does not match/)
+      assert.throws(() => {
+        ctx.renderWindow([ 0, 1, 0, 0, 0, -1 ], 16, 16, new Uint8Array(16))
+      })
+      src.close()
+      assert.throws(() => {
+        ctx.renderWindow([ 0, 1, 0, 0, 0, -1 ], 16, 16)
+      }, /already been destroyed/)
+    })
+  })
 })
@@ -174,4 +174,116 @@ describe('gdal.wrapVRT()', () => {
         bands: [ { sources: [ {} as gdal.RasterBand ] } ] })
     }, /Dataset must have at least one RasterBand/)
   })
+
+  describe('native pixel functions', () => {
+    before(function () {
+      if (!semver.gte(gdal.version, '3.5.0')) this.skip()
+    })
+
+    const read = (band: gdal.VRTBandDescriptor) => {
+      const ds = gdal.open(gdal.wrapVRT({ bands: [ band ] }))
+      return ds.bands.get(1).pixels.read(0, 0, ds.rasterSize.x, ds.rasterSize.y)
+    }
+    const t2m = () => gdal.open(arome_t2m).bands.get(1)
+    const d2m = () => gdal.open(arome_d2m).bands.get(1)
+
+    it('weighted_sum', () => {
+      const t = t2m().pixels.read(0, 0, t2m().size.x, t2m().size.y)
+      const d = d2m().pixels.read(0, 0, d2m().size.x, d2m().size.y)
+      const r = read({
+        sources: [ t2m(), d2m() ],
+        pixelFunc: 'weighted_sum',
+        pixelFuncArgs: { weights: '125,-125', k: 1 },
+        dataType: gdal.GDT_Float64
+      })
+      for (let i = 0; i < r.length; i += 100) assert.closeTo(r[i], 1 + 125 * (t[i] - d[i]), 1e-6)
+    })
+
+    it('clamp', () => {
+      const r = read({
+        sources: [ t2m() ],
+        pixelFunc: 'clamp',
+        pixelFuncArgs: { min: 10, max: 20 },
+        dataType: gdal.GDT_Float64
+      })
+      for (let i = 0; i < r.length; i++) {
+        assert.isAtLeast(r[i], 10)
+        assert.isAtMost(r[i], 20)
+      }
+    })
+
+    it('clamp with NoData', () => {
+      const v0 = t2m().pixels.get(0, 0)
+      const r = read({
+        sources: [ t2m() ],
+        pixelFunc: 'clamp',
+        pixelFuncArgs: { min: v0 + 1 },
+        noDataValue: v0,
+        dataType: gdal.GDT_Float64
+      })
+      assert.equal(r[0], v0)
+    })
+
+    it('lut', () => {
+      const src = gdal.open(sample).bands.get(1)
+      const data = src.pixels.read(0, 0, src.size.x, src.size.y)
+      const r = read({
+        sources: [ src ],
+        pixelFunc: 'lut',
+        pixelFuncArgs: { lut: '0:0,255:510' },
+        dataType: gdal.GDT_Float64
+      })
+      for (let i = 0; i < r.length; i += 100) assert.closeTo(r[i], data[i] * 2, 1e-6)
+    })
+
+    it('bitmask', () => {
+      const src = gdal.open(sample).bands.get(1)
+      const data = src.pixels.read(0, 0, src.size.x, src.size.y)
+      const r = read({
+        sources: [ src ],
+        pixelFunc: 'bitmask',
+        pixelFuncArgs: { shift: 4, mask: 3 }
+      })
+      for (let i = 0; i < r.length; i += 100) assert.equal(r[i], (data[i] >> 4) & 3)
+    })
+
+    it('bitmask with values out of the integer range', () => {
+      const file = `/vsimem/${String(Math.random()).substring(2)}.tif`
+      const ds = gdal.open(file, 'w', 'GTiff', 4, 1, 1, gdal.GDT_Float64)
+      ds.bands.get(1).pixels.write(0, 0, 4, 1, new Float64Array([ Infinity, -Infinity, 1e300, 7 ]))
+      ds.flush()
+      const r = read({
+        sources: [ ds.bands.get(1) ],
+        pixelFunc: 'bitmask',
+        pixelFuncArgs: { mask: 3 },
+        dataType: gdal.GDT_Float64
+      })
+      assert.deepEqual(Array.from(r), [ 0, 0, 0, 3 ])
+      ds.close()
+      gdal.vsimem.release(file)
+    })
+
+    it('nanmin, nanmax, nanmean', () => {
+      const t = t2m().pixels.read(0, 0, t2m().size.x, t2m().size.y)
+      const d = d2m().pixels.read(0, 0, d2m().size.x, d2m().size.y)
+      const min = read({ sources: [ t2m(), d2m() ], pixelFunc: 'nanmin', dataType: gdal.GDT_Float64 })
+      const max = read({ sources: [ t2m(), d2m() ], pixelFunc: 'nanmax', dataType: gdal.GDT_Float64 })
+      const mean = read({ sources: [ t2m(), d2m() ], pixelFunc: 'nanmean', dataType: gdal.GDT_Float64 })
+      for (let i = 0; i < t.length; i += 100) {
+        assert.closeTo(min[i], Math.min(t[i], d[i]), 1e-6)
+        assert.closeTo(max[i], Math.max(t[i], d[i]), 1e-6)
+        assert.closeTo(mean[i], (t[i] + d[i]) / 2, 1e-6)
+      }
+    })
+
+    it('should work in async mode', async () => {
+      const ds = await gdal.openAsync(gdal.wrapVRT({ bands: [ {
+        sources: [ t2m(), d2m() ],
+        pixelFunc: 'nanmean',
+        dataType: gdal.GDT_Float64
+      } ] }))
+      const r = await ds.bands.get(1).pixels.readAsync(0, 0, ds.rasterSize.x, ds.rasterSize.y)
+      assert.lengthOf(r, ds.rasterSize.x * ds.rasterSize.y)
+    })
+  })
 })